@@ -0,0 +1,524 @@
+#include "connection_pool.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "clas12/ccdb/memory_calibration.hpp"
+#include "clas12/stats.hpp"
+
+namespace clas12
+{
+namespace ccdb
+{
+
+using std::lock_guard;
+using std::move;
+using std::mutex;
+using std::runtime_error;
+using std::stringstream;
+using std::unique_lock;
+
+/**
+ * \brief an empty handle
+ **/
+PooledCalibration::PooledCalibration()
+: _pool(nullptr)
+{}
+
+PooledCalibration::PooledCalibration(
+    ConnectionPool* pool,
+    const string& key,
+    unique_ptr<Calibration> calib)
+: _pool(pool)
+, _key(key)
+, _calib(move(calib))
+{}
+
+PooledCalibration::PooledCalibration(PooledCalibration&& that)
+: _pool(that._pool)
+, _key(move(that._key))
+, _calib(move(that._calib))
+{
+    that._pool = nullptr;
+}
+
+PooledCalibration& PooledCalibration::operator=(PooledCalibration&& that)
+{
+    if (this != &that)
+    {
+        this->reset();
+        _pool = that._pool;
+        _key = move(that._key);
+        _calib = move(that._calib);
+        that._pool = nullptr;
+    }
+    return *this;
+}
+
+PooledCalibration::~PooledCalibration()
+{
+    this->reset();
+}
+
+/**
+ * \brief give the connection back to the pool, leaving this handle
+ * empty
+ **/
+void PooledCalibration::reset()
+{
+    if (_pool && _calib)
+    {
+        _pool->release(_key, move(_calib));
+    }
+    _pool = nullptr;
+    _calib.reset();
+}
+
+/**
+ * \brief make an empty pool
+ * \param [in] max_per_key most connections for each connection
+ *             string, run, variation and timestamp
+ * \param [in] max_idle idle connections older than this are dropped
+ * \param [in] max_total most connections altogether
+ **/
+ConnectionPool::ConnectionPool(
+    size_t max_per_key,
+    clock_type::duration max_idle,
+    size_t max_total)
+: _max_per_key(max_per_key > 0 ? max_per_key : 1)
+, _max_total(max_total > 0 ? max_total : 1)
+, _max_idle(max_idle)
+, _probe("/geometry/dc/dc")
+, _total(0)
+{}
+
+/**
+ * \brief disconnects all idle connections
+ *
+ * All handles must have been given back before the pool is destroyed.
+ **/
+ConnectionPool::~ConnectionPool()
+{
+    this->clear();
+}
+
+/**
+ * \brief the pool shared by all requests in this process
+ * \return reference to a static ConnectionPool
+ **/
+ConnectionPool& ConnectionPool::global()
+{
+    static ConnectionPool pool;
+    return pool;
+}
+
+/**
+ * \brief lease a connection
+ *
+ * An idle connection is reused if it passes the health check.
+ * Otherwise a new one is made as long as there are fewer than
+ * max_per_key() for this constant set. If the pool already holds
+ * max_total() connections, the one idle the longest is closed first.
+ * If none is idle, this waits until a connection is given back.
+ *
+ * The time to obtain a connection is added to the "ccdb pool wait"
+ * stage of this thread's stats; making a new connection is timed as
+ * "ccdb connect".
+ *
+ * \param [in] connstr the database connection string
+ * \param [in] csinfo the run, variation and timestamp
+ * \return handle holding a connected Calibration
+ **/
+PooledCalibration ConnectionPool::acquire(
+    const string& connstr,
+    const ConstantSetInfo& csinfo)
+{
+    const string k = key(connstr, csinfo);
+    const clock_type::time_point start = clock_type::now();
+
+    auto waited = [&]()
+    {
+        std::chrono::duration<double> dt = clock_type::now() - start;
+        stats::thread_stats().add_time("ccdb pool wait", dt.count());
+        return dt.count();
+    };
+
+    unique_lock<mutex> lock(_mutex);
+    bool waiting = false;
+    while (true)
+    {
+        // closed connections are disconnected outside the lock
+        vector<Idle> closed;
+        this->reap(closed);
+        if (!closed.empty())
+        {
+            lock.unlock();
+            closed.clear();
+            lock.lock();
+            continue;
+        }
+
+        // the slot is not erased while it counts a connection taken
+        // here, so this stays valid while unlocked below
+        Slot& slot = _slots[k];
+
+        while (!slot.idle.empty())
+        {
+            Idle entry = move(slot.idle.back());
+            slot.idle.pop_back();
+            clock_type::duration max_idle = _max_idle;
+            string probe = _probe;
+
+            lock.unlock();
+            bool ok = healthy(entry.calib.get(), entry.since, max_idle, probe);
+            if (!ok)
+            {
+                entry.calib.reset();
+            }
+            lock.lock();
+
+            if (ok)
+            {
+                _stats.reused++;
+                _stats.wait_seconds += waited();
+                return PooledCalibration(this, k, move(entry.calib));
+            }
+            _stats.discarded++;
+            slot.total--;
+            _total--;
+        }
+
+        if (slot.total < _max_per_key
+            && (_total < _max_total || this->evict(closed)))
+        {
+            slot.total++;
+            _total++;
+            _stats.wait_seconds += waited();
+            lock.unlock();
+            closed.clear();
+
+            unique_ptr<Calibration> calib;
+            try
+            {
+                stats::ScopedTimer timer("ccdb connect");
+                calib = get_calibration(connstr, csinfo);
+                if (!calib)
+                {
+                    throw runtime_error("could not connect to " + connstr);
+                }
+                if (!dynamic_cast<MemoryCalibration*>(calib.get())
+                    && !calib->IsConnected())
+                {
+                    calib->Connect(calib->GetConnectionString());
+                }
+            }
+            catch (...)
+            {
+                lock.lock();
+                Slot& s = _slots[k];
+                s.total--;
+                _total--;
+                if (s.total == 0)
+                {
+                    _slots.erase(k);
+                }
+                _released.notify_all();
+                throw;
+            }
+
+            lock.lock();
+            _stats.created++;
+            lock.unlock();
+
+            stats::count("ccdb connections");
+            return PooledCalibration(this, k, move(calib));
+        }
+
+        if (slot.total == 0)
+        {
+            // max_total() is reached with everything leased; do not
+            // keep an empty slot for this key while waiting
+            _slots.erase(k);
+        }
+
+        if (!waiting)
+        {
+            waiting = true;
+            _stats.waits++;
+        }
+        _released.wait(lock);
+    }
+}
+
+/**
+ * \brief disconnect and drop all idle connections
+ **/
+void ConnectionPool::clear()
+{
+    vector<Idle> dropped;
+    {
+        lock_guard<mutex> lock(_mutex);
+        for (auto s = _slots.begin(); s != _slots.end(); )
+        {
+            for (auto& entry : s->second.idle)
+            {
+                dropped.push_back(move(entry));
+            }
+            s->second.total -= s->second.idle.size();
+            _total -= s->second.idle.size();
+            s->second.idle.clear();
+            s = (s->second.total == 0) ? _slots.erase(s) : ++s;
+        }
+        _released.notify_all();
+    }
+    // connections are closed here, outside the lock
+}
+
+/**
+ * \brief set the most connections for each constant set
+ *
+ * Lowering it does not close leased connections; they are closed as
+ * they are given back.
+ *
+ * \param [in] n the new maximum (at least 1)
+ **/
+void ConnectionPool::max_per_key(size_t n)
+{
+    lock_guard<mutex> lock(_mutex);
+    _max_per_key = (n > 0) ? n : 1;
+    _released.notify_all();
+}
+
+/**
+ * \brief set the most connections kept altogether
+ *
+ * Lowering it does not close leased connections; they are closed as
+ * they are given back.
+ *
+ * \param [in] n the new maximum (at least 1)
+ **/
+void ConnectionPool::max_total(size_t n)
+{
+    lock_guard<mutex> lock(_mutex);
+    _max_total = (n > 0) ? n : 1;
+    _released.notify_all();
+}
+
+/**
+ * \brief set how long a connection may be idle before it is dropped
+ * \param [in] d the new maximum idle time
+ **/
+void ConnectionPool::max_idle(clock_type::duration d)
+{
+    lock_guard<mutex> lock(_mutex);
+    _max_idle = d;
+}
+
+/**
+ * \brief set the table read to check an idle connection
+ * \param [in] table_path a small table present in every run, or ""
+ *             to only check that the client is connected
+ **/
+void ConnectionPool::probe(const string& table_path)
+{
+    lock_guard<mutex> lock(_mutex);
+    _probe = table_path;
+}
+
+/**
+ * \return number of connections waiting in the pool
+ **/
+size_t ConnectionPool::idle() const
+{
+    lock_guard<mutex> lock(_mutex);
+    size_t n = 0;
+    for (const auto& s : _slots)
+    {
+        n += s.second.idle.size();
+    }
+    return n;
+}
+
+/**
+ * \return number of connections leased by handles
+ **/
+size_t ConnectionPool::in_use() const
+{
+    lock_guard<mutex> lock(_mutex);
+    size_t n = 0;
+    for (const auto& s : _slots)
+    {
+        n += s.second.total - s.second.idle.size();
+    }
+    return n;
+}
+
+/**
+ * \brief identifies the constant set a connection was made for
+ **/
+string ConnectionPool::key(const string& connstr, const ConstantSetInfo& csinfo)
+{
+    stringstream ss;
+    ss << connstr << '\n'
+       << csinfo.run << '\n'
+       << csinfo.variation << '\n'
+       << csinfo.timestamp;
+    return ss.str();
+}
+
+/**
+ * \brief check an idle connection before it is handed out
+ *
+ * Connections idle longer than max_idle are dropped since the server
+ * may have closed them. Disconnected ones are reconnected. Otherwise,
+ * unless it was given back within the last second, the probe table is
+ * read since IsConnected() does not ask the server.
+ *
+ * \return true if the connection can be used
+ **/
+bool ConnectionPool::healthy(
+    Calibration* calib,
+    const clock_type::time_point& since,
+    const clock_type::duration& max_idle,
+    const string& probe)
+{
+    if (dynamic_cast<MemoryCalibration*>(calib))
+    {
+        return true;
+    }
+    clock_type::duration idle = clock_type::now() - since;
+    if (idle > max_idle)
+    {
+        return false;
+    }
+    try
+    {
+        if (!calib->IsConnected())
+        {
+            return calib->Connect(calib->GetConnectionString());
+        }
+        if (probe.empty() || idle < std::chrono::seconds(1))
+        {
+            return true;
+        }
+        stats::ScopedTimer timer("ccdb probe");
+        unique_ptr<Assignment> assignment(calib->GetAssignment(probe, false));
+        return bool(assignment);
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+/**
+ * \brief take back a connection from a handle
+ *
+ * The connection is closed instead of kept if its key or the pool is
+ * over the limit, which happens after max_per_key() or max_total()
+ * were lowered. Expired idle connections of all keys are closed.
+ **/
+void ConnectionPool::release(const string& key, unique_ptr<Calibration> calib)
+{
+    vector<Idle> closed;
+    {
+        lock_guard<mutex> lock(_mutex);
+        Slot& slot = _slots[key];
+        if (slot.total <= _max_per_key && _total <= _max_total)
+        {
+            slot.idle.push_back(Idle{move(calib), clock_type::now()});
+        }
+        else
+        {
+            slot.total--;
+            _total--;
+            if (slot.total == 0)
+            {
+                _slots.erase(key);
+            }
+        }
+        this->reap(closed);
+        _released.notify_all();
+    }
+    // calib, if not kept, and expired connections are closed here
+    // outside the lock
+}
+
+/**
+ * \brief move idle connections older than max_idle() out of the pool
+ *
+ * Memory calibrations are kept since they hold no server connection.
+ * Must be called with the lock held; the connections are closed when
+ * the caller destroys them, after unlocking.
+ *
+ * \param [out] closed receives the expired connections
+ **/
+void ConnectionPool::reap(vector<Idle>& closed)
+{
+    const clock_type::time_point now = clock_type::now();
+    for (auto s = _slots.begin(); s != _slots.end(); )
+    {
+        vector<Idle>& idle = s->second.idle;
+        for (auto i = idle.begin(); i != idle.end(); )
+        {
+            if (now - i->since > _max_idle
+                && !dynamic_cast<MemoryCalibration*>(i->calib.get()))
+            {
+                closed.push_back(move(*i));
+                i = idle.erase(i);
+                s->second.total--;
+                _total--;
+                _stats.discarded++;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        s = (s->second.total == 0) ? _slots.erase(s) : ++s;
+    }
+}
+
+/**
+ * \brief move the connection idle the longest out of the pool
+ *
+ * Must be called with the lock held; the connection is closed when
+ * the caller destroys it, after unlocking.
+ *
+ * \param [out] closed receives the connection
+ * \return false if no connection is idle
+ **/
+bool ConnectionPool::evict(vector<Idle>& closed)
+{
+    auto oldest = _slots.end();
+    for (auto s = _slots.begin(); s != _slots.end(); ++s)
+    {
+        // entries are given back at the end, so the front is oldest
+        if (!s->second.idle.empty()
+            && (oldest == _slots.end()
+                || s->second.idle.front().since < oldest->second.idle.front().since))
+        {
+            oldest = s;
+        }
+    }
+    if (oldest == _slots.end())
+    {
+        return false;
+    }
+
+    vector<Idle>& idle = oldest->second.idle;
+    closed.push_back(move(idle.front()));
+    idle.erase(idle.begin());
+    oldest->second.total--;
+    _total--;
+    _stats.evicted++;
+    if (oldest->second.total == 0)
+    {
+        _slots.erase(oldest);
+    }
+    return true;
+}
+
+} // namespace clas12::ccdb
+} // namespace clas12
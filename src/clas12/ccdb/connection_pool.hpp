@@ -0,0 +1,268 @@
+#ifndef CLAS12_CCDB_CONNECTION_POOL_HPP
+#define CLAS12_CCDB_CONNECTION_POOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "clas12/ccdb/constants_table.hpp"
+
+namespace clas12
+{
+namespace ccdb
+{
+
+using std::map;
+using std::size_t;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * \brief totals kept by a ConnectionPool since it was made
+ **/
+struct PoolStats
+{
+    /// \brief connections made
+    size_t created = 0;
+
+    /// \brief handles served by an idle connection
+    size_t reused = 0;
+
+    /// \brief idle connections dropped (too old or not answering)
+    size_t discarded = 0;
+
+    /// \brief idle connections closed to make room for another
+    /// constant set
+    size_t evicted = 0;
+
+    /// \brief acquire() calls that had to wait for a connection
+    size_t waits = 0;
+
+    /// \brief time spent waiting in acquire()
+    double wait_seconds = 0;
+};
+
+class ConnectionPool;
+
+/**
+ * \brief a connection leased from a ConnectionPool
+ *
+ * The connection is given back to the pool when the handle is
+ * destroyed or reset. Handles can be moved but not copied.
+ **/
+class PooledCalibration
+{
+  public:
+    PooledCalibration();
+    PooledCalibration(PooledCalibration&& that);
+    PooledCalibration& operator=(PooledCalibration&& that);
+    ~PooledCalibration();
+
+    PooledCalibration(const PooledCalibration&) = delete;
+    PooledCalibration& operator=(const PooledCalibration&) = delete;
+
+    Calibration* get() const;
+    Calibration* operator->() const;
+    explicit operator bool() const;
+
+    void reset();
+
+  private:
+    friend class ConnectionPool;
+
+    PooledCalibration(ConnectionPool* pool, const string& key,
+                      unique_ptr<Calibration> calib);
+
+    ConnectionPool* _pool;
+    string _key;
+    unique_ptr<Calibration> _calib;
+};
+
+/**
+ * \brief a bounded set of open database connections shared by
+ * concurrent requests
+ *
+ * Connections are kept per connection string, run, variation and
+ * timestamp. At most max_per_key() connections exist for each of
+ * these and at most max_total() altogether. When a new connection is
+ * needed and the pool is full, the connection idle the longest is
+ * closed; if none is idle, acquire() waits for one to be given back.
+ *
+ * Idle connections older than max_idle() are closed whenever a
+ * connection is leased or given back. Before an idle connection is
+ * handed out, the probe() table is read from it to check that the
+ * server still answers.
+ *
+ * Connections from the pool stay connected, so ConstantsTable does
+ * not connect and disconnect around each table.
+ **/
+class ConnectionPool
+{
+  public:
+    typedef std::chrono::steady_clock clock_type;
+
+    ConnectionPool(size_t max_per_key = 4,
+                   clock_type::duration max_idle = std::chrono::minutes(5),
+                   size_t max_total = 16);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    static ConnectionPool& global();
+
+    PooledCalibration acquire(const string& connstr, const ConstantSetInfo& csinfo);
+
+    void clear();
+
+    size_t max_per_key() const;
+    void max_per_key(size_t n);
+
+    size_t max_total() const;
+    void max_total(size_t n);
+
+    clock_type::duration max_idle() const;
+    void max_idle(clock_type::duration d);
+
+    string probe() const;
+    void probe(const string& table_path);
+
+    size_t idle() const;
+    size_t in_use() const;
+    PoolStats statistics() const;
+
+  private:
+    friend class PooledCalibration;
+
+    struct Idle
+    {
+        unique_ptr<Calibration> calib;
+        clock_type::time_point since;
+    };
+
+    struct Slot
+    {
+        vector<Idle> idle;
+
+        /// \brief connections of this key, idle or leased
+        size_t total = 0;
+    };
+
+    static string key(const string& connstr, const ConstantSetInfo& csinfo);
+
+    static bool healthy(Calibration* calib,
+                        const clock_type::time_point& since,
+                        const clock_type::duration& max_idle,
+                        const string& probe);
+    void release(const string& key, unique_ptr<Calibration> calib);
+
+    void reap(vector<Idle>& closed);
+    bool evict(vector<Idle>& closed);
+
+    size_t _max_per_key;
+    size_t _max_total;
+    clock_type::duration _max_idle;
+    string _probe;
+
+    /// \brief connections of all keys, idle or leased
+    size_t _total;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _released;
+    map<string,Slot> _slots;
+    PoolStats _stats;
+};
+
+// inline methods
+
+/**
+ * \brief the leased calibration
+ * \return pointer to the Calibration or nullptr if empty
+ **/
+inline
+Calibration* PooledCalibration::get() const
+{
+    return _calib.get();
+}
+
+inline
+Calibration* PooledCalibration::operator->() const
+{
+    return _calib.get();
+}
+
+/**
+ * \return true if this handle holds a connection
+ **/
+inline
+PooledCalibration::operator bool() const
+{
+    return bool(_calib);
+}
+
+/**
+ * \brief the most connections kept for one connection string, run,
+ * variation and timestamp
+ * \return copy of ConnectionPool::_max_per_key
+ **/
+inline
+size_t ConnectionPool::max_per_key() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _max_per_key;
+}
+
+/**
+ * \brief the most connections kept altogether
+ * \return copy of ConnectionPool::_max_total
+ **/
+inline
+size_t ConnectionPool::max_total() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _max_total;
+}
+
+/**
+ * \brief how long a connection may be idle before it is dropped
+ * \return copy of ConnectionPool::_max_idle
+ **/
+inline
+ConnectionPool::clock_type::duration ConnectionPool::max_idle() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _max_idle;
+}
+
+/**
+ * \brief the table read to check an idle connection
+ * \return copy of ConnectionPool::_probe
+ **/
+inline
+string ConnectionPool::probe() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _probe;
+}
+
+/**
+ * \brief totals since the pool was made
+ * \return copy of ConnectionPool::_stats
+ **/
+inline
+PoolStats ConnectionPool::statistics() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+} // namespace clas12::ccdb
+} // namespace clas12
+
+#endif // CLAS12_CCDB_CONNECTION_POOL_HPP
@@ -17,6 +17,10 @@ using std::endl;
 #include "CCDB/CalibrationGenerator.h"
 #include "CCDB/Calibration.h"
 
+#include "clas12/ccdb/fingerprint.hpp"
+#include "clas12/ccdb/memory_calibration.hpp"
+#include "clas12/stats.hpp"
+
 namespace clas12
 {
 namespace ccdb
@@ -166,17 +170,40 @@ struct ConstantSetInfo
     }
 };
 
-template <class ConnectionInfoType>
+/** \brief connects to the calibration database
+ *
+ * A connection string starting with "fixture://" is taken as the path
+ * to a fixture file which is read into a MemoryCalibration. The run,
+ * variation and timestamp are then ignored.
+ *
+ * \return the calibration
+ **/
+inline
 unique_ptr<Calibration> get_calibration(
-    const ConnectionInfoType& conn,
+    const string& connstr,
     const ConstantSetInfo& csinfo)
 {
-    string connstr = conn.connection_string();
+    const string fixture = MemoryCalibration::prefix();
+    if (connstr.compare(0, fixture.size(), fixture) == 0)
+    {
+        unique_ptr<MemoryCalibration> calib(new MemoryCalibration);
+        calib->load(connstr.substr(fixture.size()));
+        return unique_ptr<Calibration>(calib.release());
+    }
+
     CalibrationGenerator calibgen;
     return unique_ptr<Calibration>(calibgen.MakeCalibration(
         connstr, csinfo.run, csinfo.variation, csinfo.timestamp ) );
 }
 
+template <class ConnectionInfoType>
+unique_ptr<Calibration> get_calibration(
+    const ConnectionInfoType& conn,
+    const ConstantSetInfo& csinfo)
+{
+    return get_calibration(conn.connection_string(), csinfo);
+}
+
 /** \brief ConstantsTable is a conatiner class for any constants
  *  set. It will connect to the database when load_constants()
  *  is called. Columns can be accessed (and converted to specific
@@ -195,6 +222,9 @@ class ConstantsTable
     /// the types of the columns in string form
     ColumnTypes column_types;
 
+    /// the id of the CCDB assignment the values came from (-1 if unknown)
+    int ccdb_assignment;
+
     /** \brief find the index of the column associated with the name
      *  colname.
      *
@@ -228,6 +258,22 @@ class ConstantsTable
         Calibration* const calib,
         const string& table_path)
     {
+        stats::ScopedTimer timer("ccdb load");
+
+        auto memory = dynamic_cast<const MemoryCalibration*>(calib);
+        if (memory)
+        {
+            const MemoryTable& table = memory->table(table_path);
+            values = table.rows;
+            columns = table.columns;
+            column_types = table.types;
+            ccdb_assignment = table.assignment_id;
+
+            stats::count("ccdb tables");
+            stats::count("ccdb rows", values.size());
+            return;
+        }
+
         bool disconnect = false;
         if (!calib->IsConnected())
         {
@@ -239,19 +285,43 @@ class ConstantsTable
         values = assignment->GetData();
         columns = assignment->GetTypeTable()->GetColumnNames();
         column_types = assignment->GetTypeTable()->GetColumnTypeStrings();
+        ccdb_assignment = assignment->GetId();
 
         if (disconnect)
         {
             calib->Disconnect();
         }
+
+        stats::count("ccdb tables");
+        stats::count("ccdb rows", values.size());
     }
 
     ConstantsTable(const TableData& v, const ColumnNames& c, const ColumnTypes& ct)
     : values(v)
     , columns(c)
     , column_types(ct)
+    , ccdb_assignment(-1)
     {}
 
+    /** \return the id of the CCDB assignment these constants were
+     * loaded from or -1 if they did not come from a database.
+     *
+     **/
+    int assignment_id() const
+    {
+        return ccdb_assignment;
+    }
+
+    /** \return hash of the columns, types and values. Tables with the
+     * same contents have the same fingerprint regardless of the run,
+     * variation or assignment they came from (see table_fingerprint()).
+     *
+     **/
+    string fingerprint() const
+    {
+        return table_fingerprint(columns, column_types, values);
+    }
+
     /** \return number of rows in this data set.
      *
      **/
@@ -0,0 +1,103 @@
+#ifndef CLAS12_CCDB_FINGERPRINT_HPP
+#define CLAS12_CCDB_FINGERPRINT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace clas12
+{
+namespace ccdb
+{
+
+using std::string;
+using std::vector;
+
+/**
+ * \brief running 64-bit FNV-1a hash of strings
+ *
+ * Used to identify the contents of constants tables: two tables with
+ * the same columns, types and values have the same fingerprint no
+ * matter which run, variation or database they were read from.
+ * Every string is followed by a separator so that ("ab","c") and
+ * ("a","bc") differ.
+ **/
+class Fingerprint
+{
+  public:
+    Fingerprint()
+    : _hash(14695981039346656037ULL)
+    {}
+
+    Fingerprint& add(const string& s)
+    {
+        for (unsigned char c : s)
+        {
+            this->add_byte(c);
+        }
+        this->add_byte(0x1f);
+        return *this;
+    }
+
+    Fingerprint& add(const vector<string>& v)
+    {
+        for (const auto& s : v)
+        {
+            this->add(s);
+        }
+        this->add_byte(0x1e);
+        return *this;
+    }
+
+    Fingerprint& add(const vector<vector<string>>& vv)
+    {
+        for (const auto& v : vv)
+        {
+            this->add(v);
+        }
+        this->add_byte(0x1d);
+        return *this;
+    }
+
+    std::uint64_t value() const
+    {
+        return _hash;
+    }
+
+    /// \brief the hash as 16 hexadecimal digits
+    string hex() const
+    {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx",
+                      static_cast<unsigned long long>(_hash));
+        return buf;
+    }
+
+  private:
+    void add_byte(unsigned char c)
+    {
+        _hash ^= c;
+        _hash *= 1099511628211ULL;
+    }
+
+    std::uint64_t _hash;
+};
+
+/**
+ * \brief the fingerprint of one constants table
+ * \return 16 hexadecimal digits
+ **/
+inline
+string table_fingerprint(
+    const vector<string>& columns,
+    const vector<string>& types,
+    const vector<vector<string>>& values)
+{
+    return Fingerprint().add(columns).add(types).add(values).hex();
+}
+
+} // namespace clas12::ccdb
+} // namespace clas12
+
+#endif // CLAS12_CCDB_FINGERPRINT_HPP
@@ -0,0 +1,335 @@
+#ifndef CLAS12_CCDB_MEMORY_CALIBRATION_HPP
+#define CLAS12_CCDB_MEMORY_CALIBRATION_HPP
+
+#include <fstream>
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CCDB/Calibration.h"
+
+#include "clas12/ccdb/fingerprint.hpp"
+
+namespace clas12
+{
+namespace ccdb
+{
+
+using std::ifstream;
+using std::istream;
+using std::map;
+using std::ofstream;
+using std::ostream;
+using std::runtime_error;
+using std::string;
+using std::stringstream;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * \brief one constants table held in memory
+ **/
+struct MemoryTable
+{
+    /// \brief the names of the columns
+    vector<string> columns;
+
+    /// \brief the types of the columns (int, double, string...)
+    vector<string> types;
+
+    /// \brief the values, row by row
+    vector<vector<string>> rows;
+
+    /// \brief id of the CCDB assignment the table was copied from,
+    /// -1 if it was not copied from a database
+    int assignment_id = -1;
+};
+
+/**
+ * \brief the fingerprint of a table's contents
+ * \return 16 hexadecimal digits (see table_fingerprint())
+ **/
+inline
+string fingerprint(const MemoryTable& table)
+{
+    return table_fingerprint(table.columns, table.types, table.rows);
+}
+
+/** \brief a Calibration whose constants tables are held in memory
+ *
+ * ConstantsTable reads from a MemoryCalibration without touching a
+ * database, so geometry can be built where there is no CCDB server,
+ * for example in benchmarks. The tables are filled with add_table(),
+ * copied from another Calibration with copy_tables() or read from a
+ * fixture file written by save().
+ *
+ * Fixture files are plain text. Each table starts with its path in
+ * square brackets followed by a line of "name:type" column headers
+ * and one line per row of whitespace separated values. Lines
+ * starting with '#' are comments:
+ *
+ *     # comment
+ *     [/geometry/dc/dc]
+ *     nsectors:int nregions:int
+ *     6 3
+ *
+ * Values may not contain whitespace.
+ *
+ * The connection string of a fixture is "fixture://" followed by the
+ * path to the file (see get_calibration()).
+ **/
+class MemoryCalibration : public ::ccdb::Calibration
+{
+  public:
+    /// \brief prefix of fixture connection strings
+    static const char* prefix()
+    {
+        return "fixture://";
+    }
+
+    /** \brief add (or replace) a table
+     *
+     * \param [in] path the table path, for example /geometry/dc/dc
+     * \param [in] table the columns and values
+     **/
+    void add_table(const string& path, const MemoryTable& table)
+    {
+        for (const auto& row : table.rows)
+        {
+            if (row.size() != table.columns.size())
+            {
+                throw runtime_error(
+                    "table " + path + ": row size does not match the columns");
+            }
+        }
+        if (table.types.size() != table.columns.size())
+        {
+            throw runtime_error(
+                "table " + path + ": number of types does not match the columns");
+        }
+        _tables[path] = table;
+    }
+
+    /** \return true if the table identified by path is held
+     **/
+    bool has_table(const string& path) const
+    {
+        return _tables.count(path) > 0;
+    }
+
+    /** \return the table identified by path
+     **/
+    const MemoryTable& table(const string& path) const
+    {
+        auto t = _tables.find(path);
+        if (t == _tables.end())
+        {
+            throw runtime_error("no such table in memory calibration: " + path);
+        }
+        return t->second;
+    }
+
+    /** \return all tables held, by path
+     **/
+    const map<string,MemoryTable>& tables() const
+    {
+        return _tables;
+    }
+
+    /** \brief copy tables from another calibration (a database or
+     * another MemoryCalibration)
+     *
+     * \param [in] calib the calibration to copy from
+     * \param [in] paths the tables to copy
+     **/
+    void copy_tables(::ccdb::Calibration* calib, const vector<string>& paths)
+    {
+        auto memory = dynamic_cast<const MemoryCalibration*>(calib);
+        if (memory)
+        {
+            for (const auto& path : paths)
+            {
+                this->add_table(path, memory->table(path));
+            }
+            return;
+        }
+
+        bool disconnect = false;
+        if (!calib->IsConnected())
+        {
+            disconnect = true;
+            calib->Connect(calib->GetConnectionString());
+        }
+
+        for (const auto& path : paths)
+        {
+            unique_ptr<::ccdb::Assignment> assignment(calib->GetAssignment(path, true));
+            MemoryTable t;
+            t.rows = assignment->GetData();
+            t.columns = assignment->GetTypeTable()->GetColumnNames();
+            t.types = assignment->GetTypeTable()->GetColumnTypeStrings();
+            t.assignment_id = assignment->GetId();
+            this->add_table(path, t);
+        }
+
+        if (disconnect)
+        {
+            calib->Disconnect();
+        }
+    }
+
+    /** \brief read tables from a fixture
+     *
+     * \param [in] in the stream to read
+     * \param [in] name used in error messages
+     **/
+    void read(istream& in, const string& name = "fixture")
+    {
+        string line;
+        size_t lineno = 0;
+        string path;
+        MemoryTable table;
+        bool have_header = false;
+
+        auto finish = [&]()
+        {
+            if (!path.empty())
+            {
+                this->add_table(path, table);
+            }
+            path.clear();
+            table = MemoryTable();
+            have_header = false;
+        };
+
+        while (std::getline(in, line))
+        {
+            lineno++;
+
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == string::npos || line[first] == '#')
+            {
+                continue;
+            }
+
+            if (line[first] == '[')
+            {
+                size_t last = line.find(']', first);
+                if (last == string::npos)
+                {
+                    stringstream ss;
+                    ss << name << ":" << lineno << ": missing ']'";
+                    throw runtime_error(ss.str());
+                }
+                finish();
+                path = line.substr(first + 1, last - first - 1);
+                continue;
+            }
+
+            if (path.empty())
+            {
+                stringstream ss;
+                ss << name << ":" << lineno << ": values before a [table] line";
+                throw runtime_error(ss.str());
+            }
+
+            stringstream ss(line);
+            string word;
+            vector<string> words;
+            while (ss >> word)
+            {
+                words.push_back(word);
+            }
+
+            if (!have_header)
+            {
+                for (const auto& w : words)
+                {
+                    size_t colon = w.find(':');
+                    table.columns.push_back(w.substr(0, colon));
+                    table.types.push_back(
+                        (colon == string::npos) ? "string" : w.substr(colon + 1));
+                }
+                have_header = true;
+            }
+            else
+            {
+                if (words.size() != table.columns.size())
+                {
+                    stringstream err;
+                    err << name << ":" << lineno << ": expected "
+                        << table.columns.size() << " values, found "
+                        << words.size();
+                    throw runtime_error(err.str());
+                }
+                table.rows.push_back(words);
+            }
+        }
+        finish();
+    }
+
+    /** \brief read tables from a fixture file
+     *
+     * \param [in] filename the fixture file
+     **/
+    void load(const string& filename)
+    {
+        ifstream fin(filename);
+        if (!fin)
+        {
+            throw runtime_error("could not open fixture: " + filename);
+        }
+        this->read(fin, filename);
+    }
+
+    /** \brief write all tables as a fixture
+     *
+     * \param [out] out the stream to write to
+     **/
+    void save(ostream& out) const
+    {
+        bool first = true;
+        for (const auto& t : _tables)
+        {
+            out << (first ? "" : "\n") << "[" << t.first << "]\n";
+            first = false;
+
+            const MemoryTable& table = t.second;
+            for (size_t c=0; c<table.columns.size(); c++)
+            {
+                out << (c ? " " : "") << table.columns[c] << ":" << table.types[c];
+            }
+            out << "\n";
+
+            for (const auto& row : table.rows)
+            {
+                for (size_t c=0; c<row.size(); c++)
+                {
+                    if (row[c].empty()
+                     || row[c].find_first_of(" \t\r\n") != string::npos)
+                    {
+                        throw runtime_error("table " + t.first +
+                            ": values with whitespace can not be saved: '" +
+                            row[c] + "'");
+                    }
+                    out << (c ? " " : "") << row[c];
+                }
+                out << "\n";
+            }
+        }
+    }
+
+  private:
+    /// \brief the tables by path
+    map<string,MemoryTable> _tables;
+};
+
+} // namespace clas12::ccdb
+} // namespace clas12
+
+#endif // CLAS12_CCDB_MEMORY_CALIBRATION_HPP
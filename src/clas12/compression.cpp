@@ -0,0 +1,390 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <boost/algorithm/string.hpp>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+#include "clas12/stats.hpp"
+
+namespace clas12
+{
+namespace compression
+{
+
+using std::invalid_argument;
+using std::runtime_error;
+
+using boost::to_lower_copy;
+
+/// \brief size of the buffer the streaming codecs write into
+static const size_t chunk_size = 1 << 16;
+
+/**
+ * \brief the codec with a name
+ * \param [in] name none, zlib, zstd or lz4 (any case); empty for none
+ * \return the codec
+ **/
+Codec codec(const string& name)
+{
+    string n = to_lower_copy(name);
+    if (n == "" || n == "none")
+    {
+        return Codec::none;
+    }
+    else if (n == "zlib")
+    {
+        return Codec::zlib;
+    }
+    else if (n == "zstd")
+    {
+        return Codec::zstd;
+    }
+    else if (n == "lz4")
+    {
+        return Codec::lz4;
+    }
+    throw invalid_argument("unknown compression: " + name);
+}
+
+/**
+ * \brief the name of a codec, as accepted by codec()
+ **/
+string name(Codec c)
+{
+    switch (c)
+    {
+        case Codec::zlib: return "zlib";
+        case Codec::zstd: return "zstd";
+        case Codec::lz4:  return "lz4";
+        default:          return "none";
+    }
+}
+
+/**
+ * \return true if this build can compress and decompress with the
+ * codec
+ **/
+bool available(Codec c)
+{
+    switch (c)
+    {
+        case Codec::none:
+            return true;
+        case Codec::zlib:
+#ifdef HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Codec::zstd:
+#ifdef HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        case Codec::lz4:
+#ifdef HAVE_LZ4
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+/**
+ * \return the codecs this build can use, except none
+ **/
+vector<Codec> available_codecs()
+{
+    vector<Codec> codecs;
+    for (Codec c : {Codec::zlib, Codec::zstd, Codec::lz4})
+    {
+        if (available(c))
+        {
+            codecs.push_back(c);
+        }
+    }
+    return codecs;
+}
+
+#ifdef HAVE_ZLIB
+static string zlib_compress(const string& data)
+{
+    z_stream zs = {};
+    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        throw runtime_error("zlib: could not initialize compressor");
+    }
+
+    string out;
+    char buf[chunk_size];
+    size_t pos = 0;
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END)
+    {
+        // feed the input a chunk at a time: avail_in is 32 bits
+        if (zs.avail_in == 0 && pos < data.size())
+        {
+            size_t n = std::min(chunk_size, data.size() - pos);
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + pos));
+            zs.avail_in = uInt(n);
+            pos += n;
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = uInt(sizeof(buf));
+        ret = deflate(&zs, pos < data.size() ? Z_NO_FLUSH : Z_FINISH);
+        if (ret == Z_STREAM_ERROR)
+        {
+            deflateEnd(&zs);
+            throw runtime_error("zlib: compression failed");
+        }
+        out.append(buf, sizeof(buf) - zs.avail_out);
+    }
+    deflateEnd(&zs);
+    return out;
+}
+
+static string zlib_decompress(const string& data)
+{
+    z_stream zs = {};
+    if (inflateInit(&zs) != Z_OK)
+    {
+        throw runtime_error("zlib: could not initialize decompressor");
+    }
+
+    string out;
+    char buf[chunk_size];
+    size_t pos = 0;
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END)
+    {
+        if (zs.avail_in == 0 && pos < data.size())
+        {
+            size_t n = std::min(chunk_size, data.size() - pos);
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + pos));
+            zs.avail_in = uInt(n);
+            pos += n;
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = uInt(sizeof(buf));
+        ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END)
+        {
+            inflateEnd(&zs);
+            throw runtime_error("zlib: corrupt or truncated data");
+        }
+        out.append(buf, sizeof(buf) - zs.avail_out);
+    }
+    inflateEnd(&zs);
+    return out;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static string zstd_compress(const string& data)
+{
+    string out(ZSTD_compressBound(data.size()), '\0');
+    size_t n = ZSTD_compress(&out[0], out.size(), data.data(), data.size(),
+                             ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(n))
+    {
+        throw runtime_error(string("zstd: ") + ZSTD_getErrorName(n));
+    }
+    out.resize(n);
+    return out;
+}
+
+static string zstd_decompress(const string& data)
+{
+    ZSTD_DStream* zds = ZSTD_createDStream();
+    ZSTD_initDStream(zds);
+
+    string out;
+    char buf[chunk_size];
+    ZSTD_inBuffer in = {data.data(), data.size(), 0};
+    size_t ret = 1;
+    while (ret != 0)
+    {
+        ZSTD_outBuffer o = {buf, sizeof(buf), 0};
+        ret = ZSTD_decompressStream(zds, &o, &in);
+        if (ZSTD_isError(ret))
+        {
+            ZSTD_freeDStream(zds);
+            throw runtime_error(string("zstd: ") + ZSTD_getErrorName(ret));
+        }
+        out.append(buf, o.pos);
+        if (ret != 0 && in.pos == in.size && o.pos < o.size)
+        {
+            ZSTD_freeDStream(zds);
+            throw runtime_error("zstd: truncated data");
+        }
+    }
+    ZSTD_freeDStream(zds);
+    return out;
+}
+#endif
+
+#ifdef HAVE_LZ4
+static string lz4_compress(const string& data)
+{
+    LZ4F_preferences_t prefs = {};
+    prefs.frameInfo.contentSize = data.size();
+
+    string out(LZ4F_compressFrameBound(data.size(), &prefs), '\0');
+    size_t n = LZ4F_compressFrame(&out[0], out.size(), data.data(), data.size(), &prefs);
+    if (LZ4F_isError(n))
+    {
+        throw runtime_error(string("lz4: ") + LZ4F_getErrorName(n));
+    }
+    out.resize(n);
+    return out;
+}
+
+static string lz4_decompress(const string& data)
+{
+    LZ4F_dctx* dctx;
+    size_t ret = LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+    if (LZ4F_isError(ret))
+    {
+        throw runtime_error(string("lz4: ") + LZ4F_getErrorName(ret));
+    }
+
+    string out;
+    char buf[chunk_size];
+    const char* src = data.data();
+    size_t left = data.size();
+    ret = 1;
+    while (ret != 0)
+    {
+        size_t dst_size = sizeof(buf);
+        size_t src_size = left;
+        ret = LZ4F_decompress(dctx, buf, &dst_size, src, &src_size, nullptr);
+        if (LZ4F_isError(ret))
+        {
+            LZ4F_freeDecompressionContext(dctx);
+            throw runtime_error(string("lz4: ") + LZ4F_getErrorName(ret));
+        }
+        out.append(buf, dst_size);
+        src += src_size;
+        left -= src_size;
+        if (ret != 0 && left == 0 && dst_size == 0)
+        {
+            LZ4F_freeDecompressionContext(dctx);
+            throw runtime_error("lz4: truncated data");
+        }
+    }
+    LZ4F_freeDecompressionContext(dctx);
+    return out;
+}
+#endif
+
+/**
+ * \brief compress a payload
+ *
+ * The time goes into the stage "compress <codec>" and the size of
+ * the result into the counter "compressed bytes" (see stats).
+ *
+ * \param [in] data the payload
+ * \param [in] c the codec; none returns a copy of data
+ * \return the compressed payload
+ **/
+string compress(const string& data, Codec c)
+{
+    if (c == Codec::none)
+    {
+        return data;
+    }
+    if (!available(c))
+    {
+        throw runtime_error("compression not available in this build: " + name(c));
+    }
+
+    stats::ScopedTimer timer("compress " + name(c));
+    string out;
+    switch (c)
+    {
+#ifdef HAVE_ZLIB
+        case Codec::zlib: out = zlib_compress(data); break;
+#endif
+#ifdef HAVE_ZSTD
+        case Codec::zstd: out = zstd_compress(data); break;
+#endif
+#ifdef HAVE_LZ4
+        case Codec::lz4:  out = lz4_compress(data); break;
+#endif
+        default: break;
+    }
+    stats::count("compressed bytes", out.size());
+    return out;
+}
+
+/**
+ * \brief decompress a payload made by compress()
+ * \param [in] data the compressed payload
+ * \param [in] c the codec it was compressed with
+ * \return the original payload
+ **/
+string decompress(const string& data, Codec c)
+{
+    if (c == Codec::none)
+    {
+        return data;
+    }
+    if (!available(c))
+    {
+        throw runtime_error("compression not available in this build: " + name(c));
+    }
+
+    switch (c)
+    {
+#ifdef HAVE_ZLIB
+        case Codec::zlib: return zlib_decompress(data);
+#endif
+#ifdef HAVE_ZSTD
+        case Codec::zstd: return zstd_decompress(data);
+#endif
+#ifdef HAVE_LZ4
+        case Codec::lz4:  return lz4_decompress(data);
+#endif
+        default: return data;
+    }
+}
+
+/**
+ * \brief the payload compressed with a codec
+ *
+ * The payload is compressed the first time a codec is asked for. All
+ * calls must pass the same payload.
+ *
+ * \param [in] data the payload
+ * \param [in] c the codec
+ * \return reference to the compressed copy
+ **/
+const string& CompressedCopies::get(const string& data, Codec c)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto copy = _copies.find(c);
+    if (copy == _copies.end())
+    {
+        copy = _copies.insert(std::make_pair(c, compress(data, c))).first;
+    }
+    return copy->second;
+}
+
+} // namespace clas12::compression
+} // namespace clas12
@@ -0,0 +1,78 @@
+#ifndef CLAS12_COMPRESSION_HPP
+#define CLAS12_COMPRESSION_HPP
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace clas12
+{
+namespace compression
+{
+
+using std::map;
+using std::string;
+using std::vector;
+
+/**
+ * \brief the compressors a payload can be sent through
+ *
+ * zlib is the zlib format (RFC 1950), zstd and lz4 are the standard
+ * frame formats of those libraries, so the payloads can be read by
+ * any client with the library. Which codecs are available depends on
+ * the libraries found when the project was configured (see
+ * available()).
+ **/
+enum class Codec
+{
+    none,
+    zlib,
+    zstd,
+    lz4
+};
+
+Codec codec(const string& name);
+string name(Codec c);
+bool available(Codec c);
+vector<Codec> available_codecs();
+
+string compress(const string& data, Codec c);
+string decompress(const string& data, Codec c);
+
+/**
+ * \brief compressed copies of one payload, made on first use
+ *
+ * Kept next to a generated payload so that clients asking for the
+ * same payload with the same codec share one compression. Copies are
+ * never removed, so the references returned stay valid for the life
+ * of this object. Thread safe.
+ **/
+class CompressedCopies
+{
+  public:
+    const string& get(const string& data, Codec c);
+
+    // inline methods
+    size_t size() const;
+
+  private:
+    mutable std::mutex _mutex;
+    map<Codec,string> _copies;
+};
+
+/**
+ * \brief number of codecs compressed with so far
+ * \return size of CompressedCopies::_copies
+ **/
+inline
+size_t CompressedCopies::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _copies.size();
+}
+
+} // namespace clas12::compression
+} // namespace clas12
+
+#endif // CLAS12_COMPRESSION_HPP
@@ -0,0 +1,68 @@
+#ifndef CLAS12_GEOMETRY_CCDB_TABLES_HPP
+#define CLAS12_GEOMETRY_CCDB_TABLES_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::map;
+using std::string;
+using std::vector;
+
+/**
+ * \brief the CCDB tables read by each detector's
+ * fetch_nominal_parameters()
+ *
+ * Used to copy the geometry constants into a fixture file (see
+ * clas12::ccdb::MemoryCalibration) and to time the table loading.
+ * This must be kept up to date with the detector classes.
+ *
+ * The HTCC is not listed: its mirror tables are not in the database
+ * (see HighThresholdCerenkov::mirror_tables()).
+ *
+ * \return table paths by detector: bst, dc, ec, ftof and pcal
+ **/
+inline
+const map<string,vector<string>>& ccdb_tables()
+{
+    static const map<string,vector<string>> tables{
+        {"bst", {
+            "/geometry/bst/bst",
+            "/geometry/bst/region",
+            "/geometry/bst/sector"}},
+        {"dc", {
+            "/geometry/dc/dc",
+            "/geometry/dc/region",
+            "/geometry/dc/superlayer",
+            "/geometry/dc/layer"}},
+        {"ec", {
+            "/geometry/ec/ec",
+            "/geometry/ec/Uview",
+            "/geometry/ec/Vview",
+            "/geometry/ec/Wview"}},
+        {"ftof", {
+            "/geometry/ftof/ftof",
+            "/geometry/ftof/panel1a/panel",
+            "/geometry/ftof/panel1b/panel",
+            "/geometry/ftof/panel2/panel",
+            "/geometry/ftof/panel1a/paddles",
+            "/geometry/ftof/panel1b/paddles",
+            "/geometry/ftof/panel2/paddles"}},
+        {"pcal", {
+            "/geometry/pcal/pcal",
+            "/geometry/pcal/Uview",
+            "/geometry/pcal/Vview",
+            "/geometry/pcal/Wview"}},
+    };
+    return tables;
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_CCDB_TABLES_HPP
@@ -5,6 +5,7 @@
 #include "clas12/ccdb/constants_table.hpp"
 
 #include "clas12/geometry/central_tracker.hpp"
+#include "clas12/stats.hpp"
 
 namespace clas12
 {
@@ -40,6 +41,7 @@ BarrelSVT::BarrelSVT(const CentralTracker* svt)
  **/
 BarrelSVT::BarrelSVT(const BarrelSVT& that, const CentralTracker* svt)
 : _svt(svt)
+, _strip_table(that._strip_table)
 {
     for (size_t i=0; i<that._regions.size(); i++)
     {
@@ -61,6 +63,8 @@ BarrelSVT::BarrelSVT(const BarrelSVT& that, const CentralTracker* svt)
 BarrelSVT& BarrelSVT::operator=(const BarrelSVT& that)
 {
     _svt = that._svt;
+    _strip_table = that._strip_table;
+    _regions.clear();
     for (size_t i=0; i<that._regions.size(); i++)
     {
         const Region& region = *that._regions[i];
@@ -80,6 +84,8 @@ BarrelSVT& BarrelSVT::operator=(const BarrelSVT& that)
  **/
 void BarrelSVT::fetch_nominal_parameters(Calibration* calib)
 {
+    stats::ScopedTimer timer("fetch bst");
+
     static const double deg2rad = 3.14159265358979 / 180.;
 
     #ifdef DEBUG
@@ -163,10 +169,15 @@ void BarrelSVT::fetch_nominal_parameters(Calibration* calib)
                     layer._deadZnSenLen1 = deadZnSenLen1;
                     layer._deadZnSenLen2 = deadZnSenLen2;
                     layer._deadZnSenLen3 = deadZnSenLen3;
+                    layer._deadZnSenWid  = deadZnSenWid;
+                    layer._startAngle    = startAngle;
+                    layer._endAngle      = endAngle;
                 }
             }
         }
     }
+
+    _strip_table.fill(*this);
 }
 
 } /* namespace clas12::geometry::central_tracker */
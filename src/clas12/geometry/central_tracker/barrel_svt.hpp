@@ -13,6 +13,7 @@ using std::endl;
 #include "CCDB/Calibration.h"
 
 #include "barrel_svt/region.hpp"
+#include "barrel_svt/strip_table.hpp"
 
 namespace clas12
 {
@@ -32,6 +33,7 @@ using ::ccdb::Calibration;
 
 using ::clas12::geometry::CentralTracker;
 using barrel_svt::Region;
+using barrel_svt::StripTable;
 
 /**
  * \brief the barrel silicone vertex tracker which consists of several regions
@@ -44,6 +46,7 @@ class BarrelSVT
 
     const vector<unique_ptr<Region>>& regions() const;
     const Region& region(const size_t& reg) const;
+    const StripTable& strip_table() const;
 
     // members in cpp file
     void fetch_nominal_parameters(Calibration* calib);
@@ -59,6 +62,10 @@ class BarrelSVT
     /// \brief a sector consists of several regions
     vector<unique_ptr<Region>> _regions;
 
+    /// \brief the end points of all strips, computed once
+    /// the nominal parameters are filled
+    StripTable _strip_table;
+
     /// \brief deleted copy constructor
     BarrelSVT(const BarrelSVT&) = delete;
 
@@ -95,6 +102,15 @@ inline const Region& BarrelSVT::region(const size_t& reg) const
     return *_regions[reg];
 }
 
+/**
+ * \brief Get the end points of all strips in this detector
+ * \return const reference to BarrelSVT::_strip_table
+ **/
+inline const StripTable& BarrelSVT::strip_table() const
+{
+    return _strip_table;
+}
+
 } // namespace clas12::geometry::central_tracker
 } // namespace clas12::geometry
 } // namespace clas12
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 
 #include "geometry/constants.hpp"
@@ -45,22 +47,21 @@ Layer::Layer(const Sector* sector, const size_t& idx)
  *             held by parent Sector.
  **/
 Layer::Layer(const Layer& that, const Sector* sector, const size_t& idx)
-: _activeSenLen(that._activeSenLen)
+: _sector(sector)
+, _idx(idx)
+, _strips(that._strips)
+, _readoutPitch(that._readoutPitch)
+, _siliconWidth(that._siliconWidth)
+, _physSenLen(that._physSenLen)
+, _physSenWid(that._physSenWid)
+, _activeSenLen(that._activeSenLen)
 , _activeSenWid(that._activeSenWid)
 , _deadZnSenLen1(that._deadZnSenLen1)
 , _deadZnSenLen2(that._deadZnSenLen2)
 , _deadZnSenLen3(that._deadZnSenLen3)
 , _deadZnSenWid(that._deadZnSenWid)
-, _endAngle(that._endAngle)
-, _idx(idx)
-, _physSenLen(that._physSenLen)
-, _physSenWid(that._physSenLen)
-, _readoutPitch(that._readoutPitch)
-, _sector(sector)
-, _siliconWidth(that._siliconWidth)
 , _startAngle(that._startAngle)
-, _strips(that._strips)
-
+, _endAngle(that._endAngle)
 {
 }
 
@@ -100,7 +101,7 @@ double Layer::radius() const
  * \brief End point at the hybrid sensor
  * \param [is] is the strip index (starting from zero) in this layer
  *             negative strip index counts from the end.
- * \return (x,y,z) position in sector coordinate system (mm)
+ * \return (x,y,z) position in the local coordinate system (mm)
  **/
 euclid_vector<double,3> Layer::stripFirstPoint(const int& is) const
 {
@@ -113,53 +114,51 @@ euclid_vector<double,3> Layer::stripFirstPoint(const int& is) const
     return euclid_vector<double,3>{b,0,0};
 }
 
+/**
+ * \brief the angle of a strip with respect to strip number 1
+ *
+ * The strips fan out linearly from startAngle() for the first strip
+ * to endAngle() for the last.
+ *
+ * \param [in] is the strip index (starting from zero) in this layer
+ * \return angle (radians)
+ **/
+double Layer::stripAngle(const int& is) const
+{
+    static const double deg2rad = ::geometry::cons::pi<double>() / 180.;
+    double dangle = (_endAngle - _startAngle) / (this->nstrips()-1);
+    return (_startAngle + this->strip_index(is)*dangle) * deg2rad;
+}
+
 /**
  * \brief End point at the far sensor
+ *
+ * In the top layer, the strip is the line x = m z + b with slope
+ * m = tan(stripAngle()) and b = is * readoutPitch(). It ends at the
+ * far end of the module or where it reaches the side of the active
+ * area, whichever comes first. The bottom layer is the mirror image
+ * (x -> activeSenWid - x). See also StripTable which does this for
+ * all strips at once.
+ *
  * \param [in] is the strip index (starting from zero) in this layer
- * \param [in] is the layer index (0 for the bottom, and 1 for the top layer)
- * \return (x,y,z) position in sector coordinate system (mm)
+ * \return (x,y,z) position in the local coordinate system (mm)
  **/
 euclid_vector<double,3> Layer::stripSecondPoint(const int& is) const
 {
-    static const double deg2rad = 180./3.1451926536;
-    double xval;
-    double zval;
-
-    double stripAngle   = this->strip_index(is)*_endAngle/(this->nstrips()-1);
-    double stripInterX  = this->strip_index(is)*_readoutPitch;
     double centerLength = 3*_activeSenLen+_deadZnSenLen2+_deadZnSenLen3;
-    if (_idx == 1) //top
-    {
-        double m = tan(stripAngle*deg2rad);
-        double b = stripInterX;
-        if( (centerLength*m+b) > _activeSenWid)
-        {
-            xval =  double(_activeSenWid);
-            zval = (xval-b)/m;
-        }
-        else
-        {
-            zval = centerLength;
-            xval = m*zval+b;
-        }
-    }
-    else if (_idx == 0) // bottom
+
+    double m = tan(this->stripAngle(is));
+    double b = this->strip_index(is)*_readoutPitch;
+
+    // m = 0 gives +inf and so zval = centerLength
+    double zval = std::min(centerLength, (_activeSenWid-b)/m);
+    double xval = m*zval+b;
+
+    if (_idx == 0) // bottom
     {
-        double m = -tan(stripAngle * deg2rad);
-        double b = _activeSenWid - stripInterX;
-        if(centerLength*m+b < 0)
-        {
-            xval = 0;
-            zval = -b/m;
-        }
-        else
-        {
-            zval = centerLength;
-            xval = m*zval+b;
-        }
+        xval = _activeSenWid - xval;
     }
 
-    clog << _idx<< "  "<<is<<"  "<<xval<<"  "<<zval<<endl;
     return euclid_vector<double,3>{xval,0,zval};
 }
 
@@ -175,7 +174,7 @@ euclid_vector<double,3> Layer::TransformToLAB(const euclid_vector<double,3>& poi
 
 
 // global rotation angle
-   double sector2lab_angle = _sector->phi() + 0.5 *3.14159265359 ;
+   double sector2lab_angle = _sector->phi() + 0.5 * ::geometry::cons::pi<double>();
 
 // gap between the layers
    double gap = _idx * (_sector->layergap() + _siliconWidth);
@@ -191,8 +190,6 @@ euclid_vector<double,3> Layer::TransformToLAB(const euclid_vector<double,3>& poi
    double zval =   point.z() + tz;
    euclid_vector<double,3> v {xval,yval,zval};
 
-   clog<<" rotated "<< xval<< "  "<<yval<<"  "<<zval<<endl;
-
    //euclid_vector<double,3> tv {tx,ty,tz};
    //euclid_vector<double,3> v = point;
    //v.phi(v.phi() + sector2lab_angle) += tv;
@@ -235,6 +232,149 @@ vector<line_segment<double,3>> Layer::siliconStrips() const
     return ret;
 }
 
+/**
+ * \brief Rotate and translate a point in the LAB frame to the local frame
+ *
+ * This is the inverse of TransformToLAB() (with no gap between layers).
+ *
+ * \param [in] point (x,y,z) position in the LAB frame (mm)
+ * \return (x,y,z) position in the local coordinate system (mm)
+ **/
+euclid_vector<double,3> Layer::TransformToLocal(const euclid_vector<double,3>& point) const
+{
+    double phi = _sector->phi();
+    double cphi = cos(phi);
+    double sphi = sin(phi);
+
+    double dx = point.x() - this->radius()*cphi;
+    double dy = point.y() - this->radius()*sphi;
+
+    // the LAB frame is the local frame rotated by phi + pi/2
+    double xval = - dx*sphi + dy*cphi + 0.5*_activeSenWid;
+    double yval = - dx*cphi - dy*sphi;
+    double zval = point.z() - _sector->region().zstart() - 0.5*_deadZnSenLen2;
+
+    return euclid_vector<double,3>{xval,yval,zval};
+}
+
+/**
+ * \brief whether a point lies on the active area of the sensors
+ *
+ * The three sensors of a module are separated along local z by the
+ * dead zones deadZnSenLen2() (hybrid to intermediate sensor) and
+ * deadZnSenLen3() (intermediate to far sensor). The distance of the
+ * point from the plane of the layer (local y) is not checked.
+ *
+ * \param [in] local_point (x,y,z) position in the local frame (mm)
+ * \return true if the point is on one of the three sensors
+ **/
+bool Layer::in_active_area(const euclid_vector<double,3>& local_point) const
+{
+    double x = local_point.x();
+    double z = local_point.z();
+
+    double z1 = _activeSenLen;
+    double z2 = z1 + _deadZnSenLen2;
+    double z3 = z2 + _activeSenLen;
+    double z4 = z3 + _deadZnSenLen3;
+    double z5 = z4 + _activeSenLen;
+
+    return (x >= 0) && (x <= _activeSenWid)
+        && (z >= 0) && (z <= z5)
+        && !(z > z1 && z < z2)
+        && !(z > z3 && z < z4);
+}
+
+/**
+ * \brief the strip closest to a point in the local frame
+ *
+ * A strip is the line x = s p + z tan(a(s)) where p is the readout
+ * pitch and the angle a(s) goes linearly from startAngle() to
+ * endAngle(). This is solved for the (fractional) strip number s
+ * by a few Newton iterations starting from the small-angle solution.
+ *
+ * \param [in] x local x position (mm)
+ * \param [in] z local z position (mm)
+ * \return strip index (counting from zero) or -1 if the point is
+ *         outside the active area
+ **/
+int Layer::hit_strip_local(const double& x, const double& z) const
+{
+    static const double deg2rad = ::geometry::cons::pi<double>() / 180.;
+
+    if (!this->in_active_area(euclid_vector<double,3>{x,0,z}))
+    {
+        return -1;
+    }
+
+    // the bottom layer is the mirror image of the top layer
+    double xtop = (_idx == 0) ? (_activeSenWid - x) : x;
+
+    double a0 = _startAngle * deg2rad;
+    double da = (_endAngle - _startAngle) * deg2rad / (this->nstrips()-1);
+
+    double s = (xtop - z*tan(a0)) / (_readoutPitch + z*da);
+    for (int i=0; i<3; i++)
+    {
+        double t = tan(a0 + s*da);
+        double f = s*_readoutPitch + z*t - xtop;
+        double df = _readoutPitch + z*da*(1. + t*t);
+        s -= f / df;
+    }
+
+    long is = std::lround(s);
+    if (is < 0 || is >= long(this->nstrips()))
+    {
+        return -1;
+    }
+    return int(is);
+}
+
+/**
+ * \brief the strip hit by a track crossing this layer
+ *
+ * \param [in] point the crossing point in the LAB frame (mm)
+ * \return strip index (counting from zero) or -1 if the point is
+ *         outside the active area of this layer
+ **/
+int Layer::hit_strip(const euclid_vector<double,3>& point) const
+{
+    euclid_vector<double,3> local = this->TransformToLocal(point);
+    return this->hit_strip_local(local.x(), local.z());
+}
+
+/**
+ * \brief the strips hit by many tracks crossing this layer
+ *
+ * This is the batch form of hit_strip(): the transformation to the
+ * local frame is set up once for all points.
+ *
+ * \param [in] points the crossing points in the LAB frame (mm)
+ * \return strip index (counting from zero) for each point, -1 if the
+ *         point is outside the active area of this layer
+ **/
+vector<int> Layer::hit_strips(const vector<euclid_vector<double,3>>& points) const
+{
+    double phi = _sector->phi();
+    double cphi = cos(phi);
+    double sphi = sin(phi);
+    double tx = this->radius()*cphi;
+    double ty = this->radius()*sphi;
+    double tz = _sector->region().zstart() + 0.5*_deadZnSenLen2;
+
+    vector<int> ret(points.size());
+    for (size_t i=0; i<points.size(); i++)
+    {
+        double dx = points[i].x() - tx;
+        double dy = points[i].y() - ty;
+        double x = - dx*sphi + dy*cphi + 0.5*_activeSenWid;
+        double z = points[i].z() - tz;
+        ret[i] = this->hit_strip_local(x, z);
+    }
+    return ret;
+}
+
+
 
 
 
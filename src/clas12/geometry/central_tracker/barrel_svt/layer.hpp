@@ -40,6 +40,7 @@ class Layer
   public:
     // inline methods
     const Sector& sector() const;
+    size_t index() const;
 
     const vector<bool>& strips() const;
     bool strip(const size_t& idx) const;
@@ -64,8 +65,14 @@ class Layer
     double radius() const;
     euclid_vector<double,3> stripFirstPoint(const int& is) const;
     euclid_vector<double,3> stripSecondPoint(const int& is) const;
+    double stripAngle(const int& is) const;
     line_segment<double,3> siliconStrip(const int& is) const;
     vector<line_segment<double,3>> siliconStrips() const;
+
+    euclid_vector<double,3> TransformToLocal(const euclid_vector<double,3>& point) const;
+    bool in_active_area(const euclid_vector<double,3>& local_point) const;
+    int hit_strip(const euclid_vector<double,3>& point) const;
+    vector<int> hit_strips(const vector<euclid_vector<double,3>>& points) const;
     //double active_zstart() const;
 
   private:
@@ -125,6 +132,9 @@ class Layer
     /// \brief
     euclid_vector<double,3> TransformToLAB(const euclid_vector<double,3>& point , const double& gapfactor) const;
 
+    /// \brief strip number closest to a point given in the local frame
+    int hit_strip_local(const double& x, const double& z) const;
+
     /// \brief deleted copy constructor
     Layer(const Layer&) = delete;
 
@@ -151,6 +161,19 @@ const Sector& Layer::sector() const
     return *_sector;
 }
 
+/**
+ * \brief get the index of this layer in the parent Sector
+ *
+ * Layer 0 is the bottom layer and layer 1 the top layer.
+ *
+ * \return copy of Layer::_idx
+ **/
+inline
+size_t Layer::index() const
+{
+    return _idx;
+}
+
 /**
  * \brief Get a vector of strips in this layer
  * \return const reference to Layer::_strips
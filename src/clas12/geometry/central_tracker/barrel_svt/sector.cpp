@@ -1,4 +1,7 @@
+#include <cmath>
 #include <cstddef>
+#include <utility>
+#include <vector>
 
 #include "geometry/constants.hpp"
 #include "geometry/direction_vector.hpp"
@@ -88,6 +91,122 @@ double Sector::phi() const
 
 
 
+/**
+ * \brief the point where a strip of the top layer crosses a strip
+ * of the bottom layer
+ *
+ * Both layers share the same local frame (see Layer) in which the
+ * top strip is the line x = b1 + m1 z and the bottom strip is the
+ * line x = W - (b2 + m2 z). The crossing is placed half-way between
+ * the two layers, at the radius of the region.
+ *
+ * \param [in] top_strip strip index (from zero) in the top layer (1)
+ * \param [in] bottom_strip strip index (from zero) in the bottom layer (0)
+ * \param [out] point the crossing point in the LAB frame (mm)
+ * \return true if the strips cross within the active width and
+ *         length of the module. point is not modified otherwise.
+ **/
+bool Sector::strip_crossing(
+    const int& top_strip,
+    const int& bottom_strip,
+    euclid_vector<double,3>& point) const
+{
+    vector<euclid_vector<double,3>> points;
+    vector<pair<size_t,size_t>> pairs;
+    if (this->strip_crossings({top_strip}, {bottom_strip}, points, pairs) == 0)
+    {
+        return false;
+    }
+    point = points.front();
+    return true;
+}
+
+/**
+ * \brief all crossings of a list of top layer strips with a list of
+ * bottom layer strips (the stereo crosses of an event)
+ *
+ * The slope of each strip is computed once and every pair is then
+ * tested. See strip_crossing() for a single pair.
+ *
+ * \param [in] top_strips strip indexes (from zero) hit in the top layer
+ * \param [in] bottom_strips strip indexes (from zero) hit in the bottom layer
+ * \param [out] points the crossing points in the LAB frame (mm)
+ * \param [out] pairs for each crossing point, the index into
+ *              top_strips and the index into bottom_strips
+ * \return the number of crossings found
+ **/
+size_t Sector::strip_crossings(
+    const vector<int>& top_strips,
+    const vector<int>& bottom_strips,
+    vector<euclid_vector<double,3>>& points,
+    vector<pair<size_t,size_t>>& pairs) const
+{
+    const Layer& bottom = *_layers.at(0);
+    const Layer& top = *_layers.at(1);
+
+    double pitch = top.readoutPitch();
+    double width = top.activeSenWid();
+    double length = 3*top.activeSenLen()
+                  + top.deadZnSenLen2()
+                  + top.deadZnSenLen3();
+
+    vector<double> top_b(top_strips.size());
+    vector<double> top_m(top_strips.size());
+    for (size_t i=0; i<top_strips.size(); i++)
+    {
+        top_b[i] = top.strip_index(top_strips[i]) * pitch;
+        top_m[i] = tan(top.stripAngle(top_strips[i]));
+    }
+
+    vector<double> bottom_b(bottom_strips.size());
+    vector<double> bottom_m(bottom_strips.size());
+    for (size_t i=0; i<bottom_strips.size(); i++)
+    {
+        bottom_b[i] = bottom.strip_index(bottom_strips[i]) * pitch;
+        bottom_m[i] = tan(bottom.stripAngle(bottom_strips[i]));
+    }
+
+    // local to LAB at the radius of the region
+    double phi = this->phi();
+    double cphi = cos(phi);
+    double sphi = sin(phi);
+    double tx = _region->radius() * cphi;
+    double ty = _region->radius() * sphi;
+    double tz = _region->zstart() + 0.5*top.deadZnSenLen2();
+
+    points.clear();
+    pairs.clear();
+    for (size_t i=0; i<top_strips.size(); i++)
+    {
+        for (size_t j=0; j<bottom_strips.size(); j++)
+        {
+            double m = top_m[i] + bottom_m[j];
+            if (m <= 0)
+            {
+                // parallel strips
+                continue;
+            }
+
+            double z = (width - top_b[i] - bottom_b[j]) / m;
+            double x = top_b[i] + top_m[i] * z;
+
+            if (z < 0 || z > length || x < 0 || x > width)
+            {
+                continue;
+            }
+
+            double u = x - 0.5*width;
+            points.push_back(euclid_vector<double,3>{
+                tx - u*sphi,
+                ty + u*cphi,
+                tz + z });
+            pairs.emplace_back(i,j);
+        }
+    }
+
+    return points.size();
+}
+
 } /* namespace clas12::geometry::central_tracker::barrel_svt */
 } /* namespace clas12::geometry::central_tracker */
 } /* namespace clas12::geometry */
@@ -8,6 +8,7 @@ using std::endl;
 #include <cmath>
 #include <cstddef>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "geometry/plane.hpp"
@@ -28,6 +29,7 @@ namespace barrel_svt
 
 using std::sin;
 using std::cos;
+using std::pair;
 using std::unique_ptr;
 using std::vector;
 
@@ -65,6 +67,16 @@ class Sector
     line_segment<double,3>     sector_to_clas(const line_segment<double,3>& l    ) const;
     plane<double>              sector_to_clas(const plane<double>& p             ) const;
 
+    bool strip_crossing(
+        const int& top_strip,
+        const int& bottom_strip,
+        euclid_vector<double,3>& point) const;
+    size_t strip_crossings(
+        const vector<int>& top_strips,
+        const vector<int>& bottom_strips,
+        vector<euclid_vector<double,3>>& points,
+        vector<pair<size_t,size_t>>& pairs) const;
+
   private:
     Sector(const Region* region, const size_t& idx);
     Sector(const Sector& that, const Region* region, const size_t& idx);
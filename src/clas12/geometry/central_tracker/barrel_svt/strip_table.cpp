@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "geometry/constants.hpp"
+#include "clas12/geometry/central_tracker.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+namespace central_tracker
+{
+namespace barrel_svt
+{
+
+using std::cos;
+using std::sin;
+using std::tan;
+using std::min;
+
+/**
+ * \brief default constructor: an empty table
+ **/
+StripTable::StripTable()
+{
+    this->clear();
+}
+
+/**
+ * \brief remove all strips from the table
+ **/
+void StripTable::clear()
+{
+    _nsectors.clear();
+    _nlayers.clear();
+    _region_layer.assign(1,0);
+    _layer_strip.assign(1,0);
+
+    _local_first_x.clear();
+    _local_second_x.clear();
+    _local_second_z.clear();
+
+    _first_x.clear();
+    _first_y.clear();
+    _first_z.clear();
+    _second_x.clear();
+    _second_y.clear();
+    _second_z.clear();
+}
+
+/**
+ * \brief calculate the end points of all strips in the BST
+ *
+ * This gives the same numbers as Layer::stripFirstPoint(),
+ * Layer::stripSecondPoint() and Layer::siliconStrip() but computes
+ * whole layers at a time. Each strip is the line x = m z + b in the
+ * local frame of the top layer with slope m = tan(angle) and offset
+ * b = strip * pitch. It ends either at the far end of the module
+ * (z = L) or where it leaves the side of the active area (x = W),
+ * whichever comes first:
+ *
+ *     z = min(L, (W - b) / m)
+ *
+ * The bottom layer is the mirror image: x -> W - x. Written this way
+ * the loop over the strips of a layer has no branches and the
+ * compiler is free to vectorise it.
+ *
+ * \param [in] bst the barrel SVT with its nominal parameters filled
+ **/
+void StripTable::fill(const BarrelSVT& bst)
+{
+    static const double deg2rad = ::geometry::cons::pi<double>() / 180.;
+
+    this->clear();
+
+    // count the strips so the arrays are allocated only once
+    size_t nstrips_total = 0;
+    for (size_t reg=0; reg<bst.regions().size(); reg++)
+    {
+        const Region& region = bst.region(reg);
+        for (size_t sec=0; sec<region.sectors().size(); sec++)
+        {
+            for (const unique_ptr<Layer>& layer : region.sector(sec).layers())
+            {
+                nstrips_total += layer->nstrips();
+            }
+        }
+    }
+
+    _local_first_x.resize(nstrips_total);
+    _local_second_x.resize(nstrips_total);
+    _local_second_z.resize(nstrips_total);
+    _first_x.resize(nstrips_total);
+    _first_y.resize(nstrips_total);
+    _first_z.resize(nstrips_total);
+    _second_x.resize(nstrips_total);
+    _second_y.resize(nstrips_total);
+    _second_z.resize(nstrips_total);
+
+    // slope of each strip in a layer. This only depends on the
+    // number of strips and the start/end angles so it is recomputed
+    // only when these change from one layer to the next.
+    vector<double> slope;
+    double slope_start_angle = 0;
+    double slope_end_angle = 0;
+
+    size_t istrip = 0;
+    for (size_t reg=0; reg<bst.regions().size(); reg++)
+    {
+        const Region& region = bst.region(reg);
+        size_t nsectors = region.sectors().size();
+        size_t nlayers = nsectors > 0 ? region.sector(0).layers().size() : 0;
+
+        _nsectors.push_back(nsectors);
+        _nlayers.push_back(nlayers);
+
+        for (size_t sec=0; sec<nsectors; sec++)
+        {
+            const Sector& sector = region.sector(sec);
+
+            double cphi = cos(sector.phi());
+            double sphi = sin(sector.phi());
+
+            for (size_t lyr=0; lyr<nlayers; lyr++)
+            {
+                const Layer& layer = sector.layer(lyr);
+                size_t n = layer.nstrips();
+
+                if (slope.size() != n
+                 || slope_start_angle != layer.startAngle()
+                 || slope_end_angle != layer.endAngle())
+                {
+                    slope_start_angle = layer.startAngle();
+                    slope_end_angle = layer.endAngle();
+                    double dangle = n > 1 ? (slope_end_angle - slope_start_angle) / (n-1) : 0;
+                    slope.resize(n);
+                    for (size_t s=0; s<n; s++)
+                    {
+                        slope[s] = tan((slope_start_angle + s*dangle) * deg2rad);
+                    }
+                }
+
+                double pitch = layer.readoutPitch();
+                double width = layer.activeSenWid();
+                double length = 3*layer.activeSenLen()
+                              + layer.deadZnSenLen2()
+                              + layer.deadZnSenLen3();
+
+                // x = offset + sign * (strip x in the top layer)
+                double offset = (layer.index() == 0) ? width : 0.;
+                double sign   = (layer.index() == 0) ? -1. : 1.;
+
+                // local to LAB: rotate by phi + pi/2 about z
+                // and translate out to the layer's radius
+                double radius = layer.radius();
+                double tx = radius * cphi;
+                double ty = radius * sphi;
+                double tz = region.zstart() + 0.5*layer.deadZnSenLen2();
+
+                const double* m = slope.data();
+                double* lx0 = _local_first_x.data() + istrip;
+                double* lx1 = _local_second_x.data() + istrip;
+                double* lz1 = _local_second_z.data() + istrip;
+                double* x0 = _first_x.data() + istrip;
+                double* y0 = _first_y.data() + istrip;
+                double* z0 = _first_z.data() + istrip;
+                double* x1 = _second_x.data() + istrip;
+                double* y1 = _second_y.data() + istrip;
+                double* z1 = _second_z.data() + istrip;
+
+                for (size_t s=0; s<n; s++)
+                {
+                    double b = s * pitch;
+
+                    // m = 0 gives +inf and so z = length
+                    double z = min(length, (width - b) / m[s]);
+
+                    lx0[s] = offset + sign * b;
+                    lx1[s] = offset + sign * (m[s]*z + b);
+                    lz1[s] = z;
+
+                    double u0 = lx0[s] - 0.5*width;
+                    double u1 = lx1[s] - 0.5*width;
+
+                    x0[s] = tx - u0*sphi;
+                    y0[s] = ty + u0*cphi;
+                    z0[s] = tz;
+                    x1[s] = tx - u1*sphi;
+                    y1[s] = ty + u1*cphi;
+                    z1[s] = tz + z;
+                }
+
+                istrip += n;
+                _layer_strip.push_back(istrip);
+            }
+        }
+
+        _region_layer.push_back(_region_layer.back() + nsectors * nlayers);
+    }
+}
+
+} /* namespace clas12::geometry::central_tracker::barrel_svt */
+} /* namespace clas12::geometry::central_tracker */
+} /* namespace clas12::geometry */
+} /* namespace clas12 */
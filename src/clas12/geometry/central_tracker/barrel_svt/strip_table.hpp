@@ -0,0 +1,290 @@
+#ifndef CLAS12_GEOMETRY_CENTRAL_TRACKER_BARREL_SVT_STRIP_TABLE_HPP
+#define CLAS12_GEOMETRY_CENTRAL_TRACKER_BARREL_SVT_STRIP_TABLE_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace clas12
+{
+namespace geometry
+{
+namespace central_tracker
+{
+
+class BarrelSVT;
+
+namespace barrel_svt
+{
+
+using std::vector;
+
+/**
+ * \brief the end points of every strip in the barrel SVT (BST)
+ *
+ * All strips of all regions, sectors and layers are computed once
+ * (see StripTable::fill()) and stored as contiguous arrays, one per
+ * coordinate, in both the layer's local frame and the LAB frame.
+ * Strips are ordered by region, then sector, then layer, then strip
+ * number. Use StripTable::begin() to find the first strip of a layer.
+ *
+ * The local frame is the one described in Layer: the origin is at
+ * the hybrid sensor end of the first strip of the top layer, local z
+ * runs along the length of the module and local x across its width.
+ * The first point of each strip is at local z = 0 (and y = 0 always).
+ *
+ * All lengths are in mm.
+ **/
+class StripTable
+{
+  public:
+    StripTable();
+
+    // inline methods
+    size_t size() const;
+    size_t nregions() const;
+    size_t nsectors(const size_t& reg) const;
+    size_t nlayers(const size_t& reg) const;
+
+    size_t layer_index(const size_t& reg, const size_t& sec, const size_t& lyr) const;
+    size_t begin(const size_t& reg, const size_t& sec, const size_t& lyr) const;
+    size_t end(const size_t& reg, const size_t& sec, const size_t& lyr) const;
+    size_t nstrips(const size_t& reg, const size_t& sec, const size_t& lyr) const;
+
+    const vector<double>& local_first_x() const;
+    const vector<double>& local_second_x() const;
+    const vector<double>& local_second_z() const;
+
+    const vector<double>& first_x() const;
+    const vector<double>& first_y() const;
+    const vector<double>& first_z() const;
+    const vector<double>& second_x() const;
+    const vector<double>& second_y() const;
+    const vector<double>& second_z() const;
+
+    // methods in cpp file
+    void fill(const BarrelSVT& bst);
+    void clear();
+
+  private:
+    /// \brief number of sectors in each region
+    vector<size_t> _nsectors;
+
+    /// \brief number of layers per sector in each region
+    vector<size_t> _nlayers;
+
+    /// \brief index (in the flat list of all layers)
+    /// of the first layer of each region
+    vector<size_t> _region_layer;
+
+    /// \brief index of the first strip of each layer in the
+    /// flat list of all layers, plus the total number of strips
+    vector<size_t> _layer_strip;
+
+    /// \brief local x of the hybrid sensor end points
+    vector<double> _local_first_x;
+
+    /// \brief local x of the far end points
+    vector<double> _local_second_x;
+
+    /// \brief local z of the far end points
+    vector<double> _local_second_z;
+
+    /// \brief LAB frame coordinates of the end points
+    vector<double> _first_x;
+    vector<double> _first_y;
+    vector<double> _first_z;
+    vector<double> _second_x;
+    vector<double> _second_y;
+    vector<double> _second_z;
+};
+
+/**
+ * \brief the total number of strips in the table
+ * \return number of elements in each of the coordinate arrays
+ **/
+inline
+size_t StripTable::size() const
+{
+    return _first_x.size();
+}
+
+/**
+ * \brief the number of regions in the table
+ * \return StripTable::_nsectors.size()
+ **/
+inline
+size_t StripTable::nregions() const
+{
+    return _nsectors.size();
+}
+
+/**
+ * \brief the number of sectors in a region
+ * \param [in] reg the region index (counting from zero)
+ * \return StripTable::_nsectors[reg]
+ **/
+inline
+size_t StripTable::nsectors(const size_t& reg) const
+{
+    return _nsectors[reg];
+}
+
+/**
+ * \brief the number of layers in each sector of a region
+ * \param [in] reg the region index (counting from zero)
+ * \return StripTable::_nlayers[reg]
+ **/
+inline
+size_t StripTable::nlayers(const size_t& reg) const
+{
+    return _nlayers[reg];
+}
+
+/**
+ * \brief the index of a layer in the flat list of all layers
+ * \param [in] reg the region index (counting from zero)
+ * \param [in] sec the sector index in the region (counting from zero)
+ * \param [in] lyr the layer index in the sector (counting from zero)
+ * \return index into StripTable::_layer_strip
+ **/
+inline
+size_t StripTable::layer_index(const size_t& reg, const size_t& sec, const size_t& lyr) const
+{
+    return _region_layer[reg] + sec * _nlayers[reg] + lyr;
+}
+
+/**
+ * \brief the index of the first strip of a layer in the coordinate arrays
+ * \param [in] reg the region index (counting from zero)
+ * \param [in] sec the sector index in the region (counting from zero)
+ * \param [in] lyr the layer index in the sector (counting from zero)
+ * \return index into the coordinate arrays
+ **/
+inline
+size_t StripTable::begin(const size_t& reg, const size_t& sec, const size_t& lyr) const
+{
+    return _layer_strip[this->layer_index(reg,sec,lyr)];
+}
+
+/**
+ * \brief one past the index of the last strip of a layer
+ * \param [in] reg the region index (counting from zero)
+ * \param [in] sec the sector index in the region (counting from zero)
+ * \param [in] lyr the layer index in the sector (counting from zero)
+ * \return index into the coordinate arrays
+ **/
+inline
+size_t StripTable::end(const size_t& reg, const size_t& sec, const size_t& lyr) const
+{
+    return _layer_strip[this->layer_index(reg,sec,lyr) + 1];
+}
+
+/**
+ * \brief the number of strips in a layer
+ * \param [in] reg the region index (counting from zero)
+ * \param [in] sec the sector index in the region (counting from zero)
+ * \param [in] lyr the layer index in the sector (counting from zero)
+ * \return number of strips
+ **/
+inline
+size_t StripTable::nstrips(const size_t& reg, const size_t& sec, const size_t& lyr) const
+{
+    return this->end(reg,sec,lyr) - this->begin(reg,sec,lyr);
+}
+
+/**
+ * \brief local x of the hybrid sensor end point of every strip
+ * \return const reference to StripTable::_local_first_x
+ **/
+inline
+const vector<double>& StripTable::local_first_x() const
+{
+    return _local_first_x;
+}
+
+/**
+ * \brief local x of the far end point of every strip
+ * \return const reference to StripTable::_local_second_x
+ **/
+inline
+const vector<double>& StripTable::local_second_x() const
+{
+    return _local_second_x;
+}
+
+/**
+ * \brief local z of the far end point of every strip
+ * \return const reference to StripTable::_local_second_z
+ **/
+inline
+const vector<double>& StripTable::local_second_z() const
+{
+    return _local_second_z;
+}
+
+/**
+ * \brief LAB x of the hybrid sensor end point of every strip
+ * \return const reference to StripTable::_first_x
+ **/
+inline
+const vector<double>& StripTable::first_x() const
+{
+    return _first_x;
+}
+
+/**
+ * \brief LAB y of the hybrid sensor end point of every strip
+ * \return const reference to StripTable::_first_y
+ **/
+inline
+const vector<double>& StripTable::first_y() const
+{
+    return _first_y;
+}
+
+/**
+ * \brief LAB z of the hybrid sensor end point of every strip
+ * \return const reference to StripTable::_first_z
+ **/
+inline
+const vector<double>& StripTable::first_z() const
+{
+    return _first_z;
+}
+
+/**
+ * \brief LAB x of the far end point of every strip
+ * \return const reference to StripTable::_second_x
+ **/
+inline
+const vector<double>& StripTable::second_x() const
+{
+    return _second_x;
+}
+
+/**
+ * \brief LAB y of the far end point of every strip
+ * \return const reference to StripTable::_second_y
+ **/
+inline
+const vector<double>& StripTable::second_y() const
+{
+    return _second_y;
+}
+
+/**
+ * \brief LAB z of the far end point of every strip
+ * \return const reference to StripTable::_second_z
+ **/
+inline
+const vector<double>& StripTable::second_z() const
+{
+    return _second_z;
+}
+
+} // namespace clas12::geometry::central_tracker::barrel_svt
+} // namespace clas12::geometry::central_tracker
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_CENTRAL_TRACKER_BARREL_SVT_STRIP_TABLE_HPP
@@ -0,0 +1,303 @@
+#include "client.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <locale.h>
+
+#include "pugixml.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+namespace client
+{
+
+using std::runtime_error;
+
+using pugi::xml_attribute;
+using pugi::xml_document;
+using pugi::xml_node;
+
+/**
+ * \brief the "C" locale, in which the numbers are written whatever
+ * the locale of the program reading them
+ **/
+static locale_t c_locale()
+{
+    static const locale_t loc = newlocale(LC_ALL_MASK, "C", locale_t(0));
+    return loc;
+}
+
+/**
+ * \brief read a number with strtod() in the "C" locale
+ * \param [in,out] p the text, moved past the number
+ * \param [out] v the number
+ * \return false, leaving p unchanged, if there is no number at p
+ **/
+static bool read_double(const char*& p, double& v)
+{
+    char* end;
+    v = strtod_l(p, &end, c_locale());
+    if (end == p)
+    {
+        return false;
+    }
+    p = end;
+    return true;
+}
+
+/**
+ * \brief read an index with strtoul() in the "C" locale
+ * \see read_double()
+ **/
+static bool read_index(const char*& p, unsigned long& i)
+{
+    char* end;
+    i = strtoul_l(p, &end, 10, c_locale());
+    if (end == p)
+    {
+        return false;
+    }
+    p = end;
+    return true;
+}
+
+/**
+ * \brief throw unless only white space is left of the text
+ * \param [in] p the text not read
+ * \param [in] what what was read, for the message
+ * \param [in] node the node the text belongs to, for the message
+ **/
+static void check_end(const char* p, const char* what, const xml_node& node)
+{
+    p += std::strspn(p, " \t\r\n");
+    if (*p != '\0')
+    {
+        throw runtime_error(string("bad ") + what + " in " + node.name() +
+                            ": '" + string(p).substr(0, 32) + "'");
+    }
+}
+
+/**
+ * \brief the number in the whole of an attribute
+ **/
+static double double_attribute(const xml_node& node, const xml_attribute& attr)
+{
+    const char* p = attr.value();
+    double v;
+    if (!read_double(p, v))
+    {
+        throw runtime_error(string("bad ") + attr.name() + " in " + node.name() +
+                            ": '" + attr.value() + "'");
+    }
+    check_end(p, attr.name(), node);
+    return v;
+}
+
+/**
+ * \brief the index in the whole of an attribute
+ **/
+static unsigned long index_attribute(const xml_node& node, const xml_attribute& attr)
+{
+    const char* p = attr.value();
+    unsigned long i;
+    if (!read_index(p, i))
+    {
+        throw runtime_error(string("bad ") + attr.name() + " in " + node.name() +
+                            ": '" + attr.value() + "'");
+    }
+    check_end(p, attr.name(), node);
+    return i;
+}
+
+/**
+ * \brief read the numbers of a node into the end of a table column
+ *
+ * The text is read in place with strtod() in the "C" locale and must
+ * be numbers separated by white space up to its end. A node in the
+ * parametric encoding (attributes n, origin and stride, residuals as
+ * "index:residual") is expanded as output::get_values() does.
+ *
+ * \return the number of values read
+ **/
+static size_t append_values(const xml_node& node, vector<double>& column)
+{
+    size_t first = column.size();
+    const char* p = node.child_value();
+
+    xml_attribute stride = node.attribute("stride");
+    if (!stride)
+    {
+        double v;
+        while (read_double(p, v))
+        {
+            column.push_back(v);
+        }
+        check_end(p, "value", node);
+        return column.size() - first;
+    }
+
+    size_t n = index_attribute(node, node.attribute("n"));
+    double origin = double_attribute(node, node.attribute("origin"));
+    double step = double_attribute(node, stride);
+    column.resize(first + n);
+    for (size_t i=0; i<n; i++)
+    {
+        column[first + i] = origin + i * step;
+    }
+
+    unsigned long i;
+    while (read_index(p, i))
+    {
+        double residual;
+        if (*p != ':' || i >= n || !read_double(++p, residual))
+        {
+            throw runtime_error(
+                string("bad residual in parametric node: ") + node.name());
+        }
+        column[first + i] += residual;
+    }
+    check_end(p, "residual", node);
+    return n;
+}
+
+/**
+ * \brief read the x, y and z of a node into three table columns
+ * \return the number of points read
+ **/
+static size_t append_points(const xml_node& node, vector<double>* columns)
+{
+    size_t nx = append_values(node.child("x"), columns[0]);
+    size_t ny = append_values(node.child("y"), columns[1]);
+    size_t nz = append_values(node.child("z"), columns[2]);
+    if (nx != ny || nx != nz)
+    {
+        throw runtime_error(
+            string("different number of x, y and z values in ") + node.name());
+    }
+    return nx;
+}
+
+/**
+ * \brief read the layers of wire or strip end points
+ * \param [in] parent the wire_endpoints or strip_endpoints node
+ * \param [in] layer_name the name of the layer nodes
+ * \param [in] first_name the name of the first end point
+ * \param [in] second_name the name of the second end point
+ * \param [out] length_units, coordinate_system, layers, coords
+ *              the members of the SegmentTable read into; layers and
+ *              coords are appended to
+ **/
+static void read_segments(const xml_node& parent,
+                          const char* layer_name,
+                          const char* first_name,
+                          const char* second_name,
+                          string& length_units,
+                          string& coordinate_system,
+                          vector<Layer>& layers,
+                          vector<double>* coords)
+{
+    length_units = parent.attribute("length_units").value();
+    coordinate_system = parent.attribute("coordinate_system").value();
+
+    for (xml_node layer_node : parent.children(layer_name))
+    {
+        Layer layer;
+        layer.sector = layer_node.attribute("sector").as_int();
+        layer.region = layer_node.attribute("region").as_int();
+        layer.superlayer = layer_node.attribute("superlayer").as_int(-1);
+        layer.guard = bool(layer_node.attribute("guardlayer"));
+        layer.layer = layer.guard
+            ? layer_node.attribute("guardlayer").as_int()
+            : layer_node.attribute(layer.superlayer < 0 ? "layer" : "senselayer").as_int();
+
+        layer.begin = coords[0].size();
+        size_t nfirst = append_points(layer_node.child(first_name), coords);
+        size_t nsecond = append_points(layer_node.child(second_name), coords + 3);
+        if (nfirst != nsecond)
+        {
+            throw runtime_error(
+                string("different number of first and second points in ") + layer_name);
+        }
+        layer.end = coords[0].size();
+        layers.push_back(layer);
+    }
+}
+
+/**
+ * \brief parse a document
+ * \param [in] xml the document; it is parsed in place, so pass it
+ *             with std::move() if it is not needed after
+ **/
+Reader::Reader(string xml)
+{
+    xml_document doc;
+    pugi::xml_parse_result result = doc.load_buffer_inplace(
+        &xml[0], xml.size(), pugi::parse_minimal);
+    if (!result)
+    {
+        throw runtime_error(string("could not parse geometry XML: ") + result.description());
+    }
+
+    xml_node geom_node = doc.child("geometry");
+
+    xml_node wire_node = geom_node.child("drift_chamber").child("wire_endpoints");
+    if (wire_node)
+    {
+        read_segments(wire_node, "layer", "left", "right",
+            _wires._length_units, _wires._coordinate_system,
+            _wires._layers, _wires._coords);
+    }
+
+    xml_node strip_node = geom_node.child("barrel_svt").child("strip_endpoints");
+    if (strip_node)
+    {
+        read_segments(strip_node, "strip_endpoints", "first", "second",
+            _strips._length_units, _strips._coordinate_system,
+            _strips._layers, _strips._coords);
+    }
+
+    xml_node panels_node = geom_node.child("forward_tof").child("panels_parms");
+    if (panels_node)
+    {
+        _paddles._length_units = panels_node.attribute("length_units").value();
+        _paddles._coordinate_system = panels_node.attribute("coordinate_system").value();
+
+        for (xml_node panel_node : panels_node.children("panel"))
+        {
+            Panel panel;
+            panel.sector = panel_node.attribute("sector").as_int();
+            panel.name = panel_node.attribute("panel").value();
+            for (xml_attribute a : panel_node.attributes())
+            {
+                if (std::strcmp(a.name(), "sector") != 0 && std::strcmp(a.name(), "panel") != 0)
+                {
+                    panel.parms[a.name()] = double_attribute(panel_node, a);
+                }
+            }
+
+            panel.begin = _paddles._coords[0].size();
+            size_t ncenters = append_points(panel_node.child("paddle_centers"), _paddles._coords);
+            size_t nlengths = append_values(panel_node.child("paddle_lengths"), _paddles._coords[3]);
+            if (ncenters != nlengths)
+            {
+                throw runtime_error("different number of paddle centers and lengths in panel");
+            }
+            panel.end = _paddles._coords[0].size();
+            _paddles._panels.push_back(panel);
+        }
+    }
+}
+
+SegmentTable::SegmentTable()
+{}
+
+PaddleTable::PaddleTable()
+{}
+
+} // namespace clas12::geometry::client
+} // namespace clas12::geometry
+} // namespace clas12
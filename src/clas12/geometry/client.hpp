@@ -0,0 +1,313 @@
+#ifndef CLAS12_GEOMETRY_CLIENT_HPP
+#define CLAS12_GEOMETRY_CLIENT_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace clas12
+{
+namespace geometry
+{
+namespace client
+{
+
+using std::map;
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * \brief a layer of wires or strips and where its segments are in
+ * a SegmentTable
+ **/
+struct Layer
+{
+    /// \brief sector, region and layer as in the XML attributes,
+    /// counting from zero
+    int sector;
+    int region;
+    int layer;
+
+    /// \brief superlayer within the region (DC only, -1 otherwise)
+    int superlayer;
+
+    /// \brief true for a DC guard wire layer
+    bool guard;
+
+    /// \brief index of the first segment and one past the last
+    size_t begin;
+    size_t end;
+};
+
+/**
+ * \brief the end points of wires or strips as contiguous arrays
+ *
+ * Segments are in the order of the document, layer by layer. The
+ * first point is the "left" end of a DC wire or the "first" end of
+ * a BST strip, the second point the "right" or "second" end.
+ **/
+class SegmentTable
+{
+  public:
+    SegmentTable();
+
+    // inline methods
+    size_t size() const;
+    const string& length_units() const;
+    const string& coordinate_system() const;
+    const vector<Layer>& layers() const;
+
+    const vector<double>& first_x() const;
+    const vector<double>& first_y() const;
+    const vector<double>& first_z() const;
+    const vector<double>& second_x() const;
+    const vector<double>& second_y() const;
+    const vector<double>& second_z() const;
+
+  private:
+    string _length_units;
+    string _coordinate_system;
+    vector<Layer> _layers;
+
+    /// \brief first x, y, z then second x, y, z
+    vector<double> _coords[6];
+
+    friend class Reader;
+};
+
+/**
+ * \brief an FTOF panel and where its paddles are in a PaddleTable
+ **/
+struct Panel
+{
+    int sector;
+
+    /// \brief "1a", "1b" or "2"
+    string name;
+
+    /// \brief the numeric attributes of the panel: dist2tgt,
+    /// norm_phi, paddle_width...
+    map<string,double> parms;
+
+    /// \brief index of the first paddle and one past the last
+    size_t begin;
+    size_t end;
+};
+
+/**
+ * \brief the paddle centers and lengths of the FTOF panels as
+ * contiguous arrays
+ **/
+class PaddleTable
+{
+  public:
+    PaddleTable();
+
+    // inline methods
+    size_t size() const;
+    const string& length_units() const;
+    const string& coordinate_system() const;
+    const vector<Panel>& panels() const;
+
+    const vector<double>& center_x() const;
+    const vector<double>& center_y() const;
+    const vector<double>& center_z() const;
+    const vector<double>& length() const;
+
+  private:
+    string _length_units;
+    string _coordinate_system;
+    vector<Panel> _panels;
+
+    /// \brief center x, y, z then length
+    vector<double> _coords[4];
+
+    friend class Reader;
+};
+
+/**
+ * \brief reads the XML served by clas12geom and the GeometryService
+ * into typed tables
+ *
+ * The document is parsed in place, without copying the text of each
+ * node, and the numbers are read straight out of the parser's buffer
+ * into the tables. Both the explicit and the parametric encoding
+ * (see output::set_values()) are understood. Parts of the geometry
+ * not in the document give empty tables.
+ *
+ * Only the DC wire end points, FTOF panel parameters and BST strip
+ * end points are read; volumes are left to the volume map readers.
+ **/
+class Reader
+{
+  public:
+    explicit Reader(string xml);
+
+    // inline methods
+    const SegmentTable& wire_endpoints() const;
+    const SegmentTable& strip_endpoints() const;
+    const PaddleTable& paddles() const;
+
+  private:
+    /// \brief DC wire end points
+    SegmentTable _wires;
+
+    /// \brief BST strip end points
+    SegmentTable _strips;
+
+    /// \brief FTOF paddles
+    PaddleTable _paddles;
+};
+
+/**
+ * \return the number of segments
+ **/
+inline
+size_t SegmentTable::size() const
+{
+    return _coords[0].size();
+}
+
+inline
+const string& SegmentTable::length_units() const
+{
+    return _length_units;
+}
+
+inline
+const string& SegmentTable::coordinate_system() const
+{
+    return _coordinate_system;
+}
+
+inline
+const vector<Layer>& SegmentTable::layers() const
+{
+    return _layers;
+}
+
+inline
+const vector<double>& SegmentTable::first_x() const
+{
+    return _coords[0];
+}
+
+inline
+const vector<double>& SegmentTable::first_y() const
+{
+    return _coords[1];
+}
+
+inline
+const vector<double>& SegmentTable::first_z() const
+{
+    return _coords[2];
+}
+
+inline
+const vector<double>& SegmentTable::second_x() const
+{
+    return _coords[3];
+}
+
+inline
+const vector<double>& SegmentTable::second_y() const
+{
+    return _coords[4];
+}
+
+inline
+const vector<double>& SegmentTable::second_z() const
+{
+    return _coords[5];
+}
+
+/**
+ * \return the number of paddles
+ **/
+inline
+size_t PaddleTable::size() const
+{
+    return _coords[0].size();
+}
+
+inline
+const string& PaddleTable::length_units() const
+{
+    return _length_units;
+}
+
+inline
+const string& PaddleTable::coordinate_system() const
+{
+    return _coordinate_system;
+}
+
+inline
+const vector<Panel>& PaddleTable::panels() const
+{
+    return _panels;
+}
+
+inline
+const vector<double>& PaddleTable::center_x() const
+{
+    return _coords[0];
+}
+
+inline
+const vector<double>& PaddleTable::center_y() const
+{
+    return _coords[1];
+}
+
+inline
+const vector<double>& PaddleTable::center_z() const
+{
+    return _coords[2];
+}
+
+/**
+ * \brief the paddle lengths, which the server sends in cm whatever
+ * the length units of the request
+ **/
+inline
+const vector<double>& PaddleTable::length() const
+{
+    return _coords[3];
+}
+
+/**
+ * \return const reference to Reader::_wires
+ **/
+inline
+const SegmentTable& Reader::wire_endpoints() const
+{
+    return _wires;
+}
+
+/**
+ * \return const reference to Reader::_strips
+ **/
+inline
+const SegmentTable& Reader::strip_endpoints() const
+{
+    return _strips;
+}
+
+/**
+ * \return const reference to Reader::_paddles
+ **/
+inline
+const PaddleTable& Reader::paddles() const
+{
+    return _paddles;
+}
+
+} // namespace clas12::geometry::client
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_CLIENT_HPP
@@ -0,0 +1,202 @@
+#ifndef CLAS12_GEOMETRY_DETECTOR_CACHE_HPP
+#define CLAS12_GEOMETRY_DETECTOR_CACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "clas12/ccdb/constants_table.hpp"
+#include "clas12/ccdb/fingerprint.hpp"
+#include "clas12/ccdb/memory_calibration.hpp"
+#include "clas12/geometry/ccdb_tables.hpp"
+#include "clas12/stats.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::list;
+using std::map;
+using std::shared_ptr;
+using std::size_t;
+using std::string;
+
+using ::ccdb::Calibration;
+
+/**
+ * \brief detector objects shared by all constant sets whose geometry
+ * tables have the same contents
+ *
+ * The geometry constants change only a few times in a run period so
+ * the detector built for one run is, most of the time, identical to
+ * the one built for the next. get() reads the detector's tables (see
+ * ccdb_tables()) once into memory, combines their fingerprints and
+ * returns the detector already built from tables with that
+ * fingerprint. Only when there is none is a new one built, from the
+ * tables in memory so that the database is read once.
+ *
+ * The detectors are const and may be used by many threads. At most
+ * capacity() are kept; the least recently used is dropped first.
+ *
+ * \tparam Detector a detector class constructed from a Calibration*,
+ * for example DriftChamber
+ **/
+template <class Detector>
+class DetectorCache
+{
+  public:
+    /**
+     * \param [in] name the detector's key in ccdb_tables(), for
+     *             example "dc"
+     * \param [in] capacity the most detectors kept
+     **/
+    DetectorCache(const string& name, size_t capacity = 8)
+    : _name(name)
+    , _capacity(capacity > 0 ? capacity : 1)
+    , _hits(0)
+    , _misses(0)
+    {}
+
+    /**
+     * \brief the detector built from the tables of a calibration
+     *
+     * A MemoryCalibration which holds all the tables already is used
+     * as it is; anything else is copied into memory first.
+     *
+     * \param [in] calib the calibration (database connection)
+     * \return shared pointer to the const detector
+     **/
+    shared_ptr<const Detector> get(Calibration* calib)
+    {
+        clas12::ccdb::MemoryCalibration copy;
+        auto memory = dynamic_cast<clas12::ccdb::MemoryCalibration*>(calib);
+        if (!memory || !this->holds_tables(*memory))
+        {
+            copy.copy_tables(calib, ccdb_tables().at(_name));
+            memory = &copy;
+        }
+        clas12::ccdb::MemoryCalibration& tables = *memory;
+        const string key = fingerprint(tables);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto d = _detectors.find(key);
+            if (d != _detectors.end())
+            {
+                _hits++;
+                _order.splice(_order.begin(), _order, d->second.second);
+                stats::count("detector cache hits");
+                return d->second.first;
+            }
+            _misses++;
+        }
+
+        stats::count("detector cache misses");
+        shared_ptr<const Detector> detector(new Detector(&tables));
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto d = _detectors.find(key);
+        if (d != _detectors.end())
+        {
+            // built at the same time by another thread
+            return d->second.first;
+        }
+        _order.push_front(key);
+        _detectors[key] = std::make_pair(detector, _order.begin());
+        while (_detectors.size() > _capacity)
+        {
+            _detectors.erase(_order.back());
+            _order.pop_back();
+        }
+        return detector;
+    }
+
+    /**
+     * \brief the combined fingerprint of the detector's tables
+     * \param [in] tables the tables listed in ccdb_tables() for this
+     *             detector
+     * \return 16 hexadecimal digits
+     **/
+    string fingerprint(const clas12::ccdb::MemoryCalibration& tables) const
+    {
+        clas12::ccdb::Fingerprint fp;
+        for (const auto& path : ccdb_tables().at(_name))
+        {
+            fp.add(path).add(clas12::ccdb::fingerprint(tables.table(path)));
+        }
+        return fp.hex();
+    }
+
+    /// \brief forget all detectors
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _detectors.clear();
+        _order.clear();
+    }
+
+    /// \brief number of detectors kept
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _detectors.size();
+    }
+
+    /// \brief the most detectors kept
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    /// \brief calls of get() answered with a kept detector
+    size_t hits() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _hits;
+    }
+
+    /// \brief calls of get() that built a detector
+    size_t misses() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _misses;
+    }
+
+  private:
+    bool holds_tables(const clas12::ccdb::MemoryCalibration& tables) const
+    {
+        for (const auto& path : ccdb_tables().at(_name))
+        {
+            if (!tables.has_table(path))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief the key of the detector in ccdb_tables()
+    string _name;
+
+    size_t _capacity;
+    size_t _hits;
+    size_t _misses;
+
+    mutable std::mutex _mutex;
+
+    /// \brief fingerprints, most recently used first
+    list<string> _order;
+
+    /// \brief detectors and their place in _order by fingerprint
+    map<string,std::pair<shared_ptr<const Detector>,list<string>::iterator>> _detectors;
+};
+
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_DETECTOR_CACHE_HPP
@@ -0,0 +1,87 @@
+#include "detector_planes.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "clas12/geometry/drift_chamber.hpp"
+#include "clas12/geometry/electromagnetic_cal.hpp"
+#include "clas12/geometry/forward_tof.hpp"
+#include "clas12/geometry/preshower_cal.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+
+/**
+ * \brief the planes of the forward detectors, roughly in the order
+ * a track from the target crosses them
+ *
+ * For each sector: the wire planes of the 36 DC sense layers, the
+ * three FTOF panels (1a, 1b, 2), the front of the PCal and the front
+ * face of the EC.
+ *
+ * The planes are unbounded: a track crossing one in another sector
+ * or far outside of the detector is not inside the detector. Check
+ * the sector at least.
+ *
+ * \param [in] dc the drift chambers
+ * \param [in] ftof the forward time of flight detector
+ * \param [in] pcal the preshower calorimeter
+ * \param [in] ec the electromagnetic calorimeter
+ * \param [in] coordsys the coordinate system: SECTOR or CLAS
+ * \return planes by sector, then detector and layer
+ **/
+vector<DetectorPlane> forward_detector_planes(
+    const DriftChamber& dc,
+    const ForwardTOF& ftof,
+    const PreshowerCal& pcal,
+    const ElectromagneticCal& ec,
+    coordsys_t coordsys)
+{
+    vector<DetectorPlane> planes;
+
+    for (size_t sec=0; sec<dc.sectors().size(); sec++)
+    {
+        size_t lyr = 0;
+        for (const auto& region : dc.sector(sec).regions())
+        {
+            for (const auto& superlayer : region->superlayers())
+            {
+                for (const auto& senselayer : superlayer->senselayers())
+                {
+                    planes.push_back(DetectorPlane{"dc", sec, lyr++,
+                        senselayer->wire_plane(coordsys)});
+                }
+            }
+        }
+
+        if (sec < ftof.sectors().size())
+        {
+            const auto& panels = ftof.sector(sec).panels();
+            for (size_t pan=0; pan<panels.size(); pan++)
+            {
+                planes.push_back(DetectorPlane{"ftof", sec, pan,
+                    panels[pan]->panel_plane(coordsys)});
+            }
+        }
+
+        if (sec < pcal.sectors().size())
+        {
+            planes.push_back(DetectorPlane{"pcal", sec, 0,
+                pcal.sector(sec).face_plane(coordsys)});
+        }
+
+        if (sec < ec.sectors().size())
+        {
+            planes.push_back(DetectorPlane{"ec", sec, 0,
+                ec.sector(sec).face_plane(coordsys)});
+        }
+    }
+
+    return planes;
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
@@ -0,0 +1,59 @@
+#ifndef CLAS12_GEOMETRY_DETECTOR_PLANES_HPP
+#define CLAS12_GEOMETRY_DETECTOR_PLANES_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "geometry/plane.hpp"
+
+#include "clas12/geometry/coordsys.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+using ::geometry::plane;
+
+class DriftChamber;
+class ElectromagneticCal;
+class ForwardTOF;
+class PreshowerCal;
+
+/**
+ * \brief a detector surface a track crosses on its way through
+ * the forward detector
+ **/
+struct DetectorPlane
+{
+    /// \brief dc, ftof, pcal or ec
+    string detector;
+
+    /// \brief sector index (from zero)
+    size_t sector;
+
+    /// \brief DC: sense layer (0 to 35 counting through all
+    /// superlayers), FTOF: panel (0 = 1a, 1 = 1b, 2 = 2),
+    /// PCal, EC: 0
+    size_t layer;
+
+    /// \brief the plane, normal pointing away from the target
+    plane<double> surface;
+};
+
+vector<DetectorPlane> forward_detector_planes(
+    const DriftChamber& dc,
+    const ForwardTOF& ftof,
+    const PreshowerCal& pcal,
+    const ElectromagneticCal& ec,
+    coordsys_t coordsys = COORDSYS::CLAS);
+
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_DETECTOR_PLANES_HPP
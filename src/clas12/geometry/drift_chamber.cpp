@@ -8,6 +8,7 @@
 #include "drift_chamber.hpp"
 
 #include "clas12/log.hpp"
+#include "clas12/stats.hpp"
 
 namespace clas12
 {
@@ -82,6 +83,8 @@ DriftChamber::DriftChamber( Calibration* calib,
  **/
 void DriftChamber::fetch_nominal_parameters(Calibration* calib)
 {
+    stats::ScopedTimer timer("fetch dc");
+
     LOG(debug) << "DriftChamber::fetch_nominal_parameters()...";
 
     static const double deg2rad = 3.14159265358979 / 180.;
@@ -1,6 +1,7 @@
 #include <cstddef>
 #include <stdexcept>
 
+#include "geometry/direction_vector.hpp"
 #include "geometry/euclid_vector.hpp"
 #include "geometry/line.hpp"
 #include "geometry/line_segment.hpp"
@@ -17,6 +18,7 @@ namespace drift_chamber
 
 using std::runtime_error;
 
+using ::geometry::direction_vector;
 using ::geometry::euclid_vector;
 using ::geometry::line;
 using ::geometry::line_segment;
@@ -352,13 +354,34 @@ double Senselayer::wire_length(int w) const
 
 /**
  * \brief this sense layer's wire-plane
- * \return plane(point on plane, normal) in sector coordinate system (cm)
+ *
+ * This is the plane holding all wires of the layer. Its normal is
+ * that of the region: in the sector mid-plane, tilted from the beam
+ * line by the region's tilt angle and pointing away from the target.
+ *
+ * \param [in] coordsys the coordinate system: SECTOR or CLAS
+ * \return plane(point on plane, normal) (cm)
  **/
 plane<double> Senselayer::wire_plane(coordsys_t coordsys) const
 {
+    const Region& region = _superlayer->region();
+    direction_vector<double,3> normal{0., region.thtilt()};
+
+    switch (coordsys)
+    {
+        case COORDSYS::SECTOR:
+            break;
+        case COORDSYS::CLAS:
+            normal = region.sector().sector_to_clas(normal);
+            break;
+        default:
+            throw runtime_error("can not calculate wire plane in "+coord2str(coordsys)+" coordinates");
+            break;
+    }
+
     return plane<double>{
         this->wire_mid(0,coordsys),
-        _superlayer->wire_direction(coordsys)
+        normal
     };
 }
 
@@ -13,6 +13,7 @@ using std::endl;
 #include "electromagnetic_cal.hpp"
 
 #include "clas12/log.hpp"
+#include "clas12/stats.hpp"
 
 namespace clas12
 {
@@ -89,6 +90,8 @@ ElectromagneticCal::ElectromagneticCal( Calibration* calib,
  **/
 void ElectromagneticCal::fetch_nominal_parameters(Calibration* calib)
 {
+    stats::ScopedTimer timer("fetch ec");
+
     LOG(debug) << "ElectromagneticCal::fetch_nominal_parameters()...";
     static const double deg2rad = 3.14159265358979 / 180.;
 
@@ -7,6 +7,7 @@
 #include "clas12/ccdb/constants_table.hpp"
 
 #include "clas12/log.hpp"
+#include "clas12/stats.hpp"
 
 #include "forward_tof.hpp"
 
@@ -85,6 +86,8 @@ ForwardTOF::ForwardTOF( Calibration* calib,
  **/
 void ForwardTOF::fetch_nominal_parameters(Calibration* calib)
 {
+    stats::ScopedTimer timer("fetch ftof");
+
     LOG(debug) << "ForwardTOF::fetch_nominal_parameters()...";
 
     static const double deg2rad = 3.14159265358979 / 180.;
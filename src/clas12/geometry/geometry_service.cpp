@@ -1,6 +1,8 @@
 #include "clas12/geometry/geometry_service.hpp"
 
 #include <algorithm>
+#include <cstdlib>
+#include <exception>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -14,6 +16,8 @@
 #include "pugixml.hpp"
 
 #include "clas12/geometry/request.hpp"
+#include "clas12/geometry/request_executor.hpp"
+#include "clas12/geometry/version.hpp"
 
 #include "clas12/log.hpp"
 
@@ -46,11 +50,26 @@ R"(The CLAS12 Geometry Service. The expected input must be a
 PropertyList. Output will be an error message (string) or
 the geometry parameters as an XML string.
 
+With the property "prewarm" set to a list of run numbers, the
+request is instead built for each of those runs in the background
+and kept so that later requests for them are answered at once.
+
+Every reply carrying geometry has "etag: <hash>" in its data
+description. The hash depends only on the generated output. A
+request with the property "if-none-match" set to the etag of the
+output the client already holds is answered with the short reply
+"Not modified" instead of the geometry when the output would be
+the same.
+
+With the property "compression" set to zlib, zstd or lz4, the XML
+is sent as a byte array compressed with that codec and the data
+description starts with "XML string compressed with <codec>".
+
 )" + Request::desc;
 const string GeometryService::author =
     "Johann Goetz, Yelena Prok";
 const string GeometryService::version =
-    "0.6.1";
+    library_version;
 
 string GeometryService::usage() const
 {
@@ -63,11 +82,99 @@ string GeometryService::usage() const
     return ss.str();
 }
 
+/**
+ * \brief the executor shared by all instances of the service
+ *
+ * The executor is configured with these environment variables:
+ *
+ *     CLAS12_GEOMETRY_WORKERS         threads (default: one per core)
+ *     CLAS12_GEOMETRY_MAX_PENDING     requests waiting for a worker (64)
+ *     CLAS12_GEOMETRY_MAX_CACHED      results kept (16)
+ *     CLAS12_GEOMETRY_PREFETCH_AHEAD  runs prefetched after a request
+ *                                     for a run (1)
+ *
+ * \return reference to a static RequestExecutor
+ **/
+RequestExecutor& GeometryService::executor()
+{
+    auto env = [](const char* name, size_t def)
+    {
+        const char* value = std::getenv(name);
+        if (value)
+        {
+            try
+            {
+                return lexical_cast<size_t>(value);
+            }
+            catch (...)
+            {
+                LOG(warning) << "could not interpret " << name << ": " << value;
+            }
+        }
+        return def;
+    };
+
+    static RequestExecutor exec(
+        env("CLAS12_GEOMETRY_WORKERS", 0),
+        env("CLAS12_GEOMETRY_MAX_PENDING", 64),
+        env("CLAS12_GEOMETRY_MAX_CACHED", 16));
+    static const bool configured = (
+        exec.prefetch_ahead(env("CLAS12_GEOMETRY_PREFETCH_AHEAD", 1)), true);
+    (void) configured;
+    return exec;
+}
+
+/**
+ * \brief queue a request for a list of runs on the executor's
+ * background thread
+ * \param [in] req the request without the run
+ * \param [in] runs comma or space separated run numbers
+ * \return reply saying how many runs were queued
+ **/
+CioSerial::UniquePtr GeometryService::prewarm(
+    const map<string,string>& req,
+    const string& runs)
+{
+    CioSerial::UniquePtr out = make_unique<CioSerial>();
+    try
+    {
+        vector<string> words;
+        split(words, runs, is_any_of(", "), boost::token_compress_on);
+        vector<int> run_numbers;
+        for (const auto& w : words)
+        {
+            if (w != "")
+            {
+                run_numbers.push_back(lexical_cast<int>(w));
+            }
+        }
+
+        size_t n = executor().prewarm(req, run_numbers);
+        LOG(info) << "prewarming " << n << " of " << run_numbers.size()
+                  << " runs: " << runs;
+
+        stringstream ss;
+        ss << "prewarming " << n << " of " << run_numbers.size() << " runs";
+        out->setData(ss.str(), MimeType::STRING);
+        out->setDataDescription("Prewarm");
+        out->setStatus("Success");
+    }
+    catch (std::exception& e)
+    {
+        out->setData(string("Error: Bad prewarm request: ") + e.what(), MimeType::STRING);
+        out->setDataDescription("Error message");
+        out->setStatus("Error");
+    }
+    return out;
+}
+
 CioSerial::UniquePtr GeometryService::executeService(const PropertyList& plist)
 {
     // convert request from PropertyList to map<string,string>
     map<string,string> req;
-    for (const auto& key : {"units", "coordsys", "request"})
+    for (const auto& key : {"units", "coordsys", "request",
+                            "run", "variation", "timestamp",
+                            "encoding", "compression"})
     {
         auto p = plist.findProperty(key);
         if (p != plist.end())
@@ -76,32 +183,54 @@ CioSerial::UniquePtr GeometryService::executeService(const PropertyList& plist)
         }
     }
 
-    // initialize request
-    Request request(req);
+    // prewarm: build the request for upcoming runs in the background
+    auto prewarm = plist.findProperty("prewarm");
+    if (prewarm != plist.end())
+    {
+        return this->prewarm(req, prewarm->getValue());
+    }
 
-    LOG(info) << request.info();
+    // not modified, error or the (compressed) XML
+    auto if_none_match = plist.findProperty("if-none-match");
+    ServiceReply reply = executor().respond(req,
+        (if_none_match != plist.end()) ? if_none_match->getValue() : "");
 
-    string out_str = request.generate_xml();
+    CioSerial::UniquePtr out = make_unique<CioSerial>();
+    out->setDataDescription(reply.description);
 
-    LOG(info) << out_str << endl;
+    if (reply.status == "Not modified")
+    {
+        LOG(info) << reply.description;
+        out->setData(reply.data, MimeType::STRING);
+        out->setStatus("Success");
+        return out;
+    }
 
-    // prepare output
-    CioSerial::UniquePtr out;
-    out = make_unique<CioSerial>();
-    out->setData(out_str, MimeType::STRING);
+    LOG(info) << reply.info;
+    LOG(info) << reply.statistics.report();
+    LOG(debug) << executor().report();
 
-    // the output must not begin with "Error"
-    static const string err_str = "Error";
-    if (equal(err_str.begin(), err_str.end(), out_str.begin()))
+    if (reply.status == "Error")
     {
-        out->setDataDescription("Error message");
+        out->setData(reply.data, MimeType::STRING);
         out->setStatus("Error");
+        return out;
+    }
+
+    if (reply.codec != compression::Codec::none)
+    {
+        LOG(info) << "compressed with " << compression::name(reply.codec)
+                  << " to " << reply.data.size() << " bytes";
+        out->setData(vector<unsigned char>(reply.data.begin(), reply.data.end()),
+                     MimeType::BYTE_ARRAY);
     }
     else
     {
-        out->setDataDescription("XML string");
-        out->setStatus("Success");
+        // the xml can be several MB: only written at trace level
+        LOG(trace) << reply.data;
+        out->setData(reply.data, MimeType::STRING);
     }
+    out->setStatus("Success");
 
     return out;
 }
@@ -23,6 +23,8 @@ using std::vector;
 
 using namespace clara;
 
+class RequestExecutor;
+
 class GeometryService : public CService
 {
   private:
@@ -33,6 +35,10 @@ class GeometryService : public CService
 
     string usage() const;
 
+    static RequestExecutor& executor();
+
+    CioSerial::UniquePtr prewarm(const map<string,string>& req, const string& runs);
+
     CioSerial::UniquePtr executeService(const PropertyList&);
 
     void configure(const CioSerial::SharedPtr&) {};
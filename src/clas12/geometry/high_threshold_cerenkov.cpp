@@ -1,9 +1,11 @@
 #include <cstddef>
 #include <numeric>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "clas12/ccdb/constants_table.hpp"
+#include "clas12/stats.hpp"
 
 #include "high_threshold_cerenkov.hpp"
 
@@ -12,9 +14,12 @@ namespace clas12
 namespace geometry
 {
 
+using std::runtime_error;
 using std::string;
 using std::vector;
 
+using ::geometry::direction_vector;
+
 using clas12::ccdb::ConstantsTable;
 
 /**
@@ -76,6 +81,10 @@ HighThresholdCerenkov::HighThresholdCerenkov( Calibration* calib,
  * it is expected that additional alignment paramters will be
  * obtained from the database in a later method-call.
  *
+ * The HTCC mirror and PMT constants are not in the database yet, so
+ * nothing is read here and the sectors are left empty. See
+ * fetch_mirror_parameters().
+ *
  * \param [in] dataprovider the ccdb::DataProvider object
  **/
 void HighThresholdCerenkov::fetch_nominal_parameters(Calibration* calib)
@@ -84,5 +93,131 @@ void HighThresholdCerenkov::fetch_nominal_parameters(Calibration* calib)
     using namespace high_threshold_cerenkov;
 }
 
+/**
+ * \brief the tables read by fetch_mirror_parameters()
+ *
+ * This is a proposed layout for the HTCC mirror and PMT constants;
+ * these tables do not exist in the CLAS12 database.
+ *
+ * \return the paths of the nsectors/nrings table, the mirror table
+ *         and the PMT table
+ **/
+const vector<string>& HighThresholdCerenkov::mirror_tables()
+{
+    static const vector<string> tables{
+        "/geometry/htcc/htcc",
+        "/geometry/htcc/mirrors",
+        "/geometry/htcc/pmts"};
+    return tables;
+}
+
+/**
+ * \brief fills the sectors with mirror facets and PMTs from tables in
+ * the layout of mirror_tables()
+ *
+ * Opt-in: nothing calls this implicitly, since the tables are not in
+ * the CLAS12 database. Use it with a calibration which has them, for
+ * example a clas12::ccdb::MemoryCalibration, to feed the
+ * high_threshold_cerenkov::RayTracer.
+ *
+ * The htcc table holds nsectors and nrings. The mirrors table has one
+ * row per facet of a sector: ring, half (0 left, 1 right), vertex_x/y/z
+ * (cm), axis_phi/theta (deg), radius (cm), conic, thmin/thmax and
+ * phimin/phimax (deg). The pmts table has one row per PMT: ring, half,
+ * x/y/z (cm), normal_phi/theta (deg) and radius (cm).
+ *
+ * \param [in] calib the calibration holding the tables
+ **/
+void HighThresholdCerenkov::fetch_mirror_parameters(Calibration* calib)
+{
+    stats::ScopedTimer timer("fetch htcc");
+
+    static const double deg2rad = 3.14159265358979 / 180.;
+    using namespace high_threshold_cerenkov;
+
+    ConstantsTable table_htcc(calib,mirror_tables()[0]);
+    ConstantsTable table_m(calib,mirror_tables()[1]);
+    ConstantsTable table_p(calib,mirror_tables()[2]);
+
+    size_t nsectors = table_htcc.elem<size_t>("nsectors"); // n
+    size_t nrings   = table_htcc.elem<size_t>("nrings");   // n
+
+    // one row per mirror facet in a sector
+    // half: 0 = left, 1 = right
+    vector<size_t> m_ring   = table_m.col<size_t>("ring");       // n
+    vector<size_t> m_half   = table_m.col<size_t>("half");       // n
+    vector<double> vertex_x = table_m.col<double>("vertex_x");   // cm
+    vector<double> vertex_y = table_m.col<double>("vertex_y");   // cm
+    vector<double> vertex_z = table_m.col<double>("vertex_z");   // cm
+    vector<double> axis_phi = table_m.col<double>("axis_phi");   // deg
+    vector<double> axis_th  = table_m.col<double>("axis_theta"); // deg
+    vector<double> radius   = table_m.col<double>("radius");     // cm
+    vector<double> conic    = table_m.col<double>("conic");      // unitless
+    vector<double> thmin    = table_m.col<double>("thmin");      // deg
+    vector<double> thmax    = table_m.col<double>("thmax");      // deg
+    vector<double> phimin   = table_m.col<double>("phimin");     // deg
+    vector<double> phimax   = table_m.col<double>("phimax");     // deg
+
+    // one row per PMT in a sector
+    vector<size_t> p_ring   = table_p.col<size_t>("ring");         // n
+    vector<size_t> p_half   = table_p.col<size_t>("half");         // n
+    vector<double> pmt_x    = table_p.col<double>("x");            // cm
+    vector<double> pmt_y    = table_p.col<double>("y");            // cm
+    vector<double> pmt_z    = table_p.col<double>("z");            // cm
+    vector<double> pmt_nphi = table_p.col<double>("normal_phi");   // deg
+    vector<double> pmt_nth  = table_p.col<double>("normal_theta"); // deg
+    vector<double> pmt_r    = table_p.col<double>("radius");       // cm
+
+    if (m_ring.size() != 2*nrings || p_ring.size() != 2*nrings)
+    {
+        throw runtime_error("HTCC mirror and PMT tables must have one row per ring and half-sector");
+    }
+
+    // Now we fill the sectors object which holds all these
+    // core parameters. The nominal geometry is the same for
+    // every sector.
+    _sectors.clear();
+    for (size_t sec=0; sec<nsectors; sec++)
+    {
+        _sectors.emplace_back(new HTCCSector(this,sec));
+        HTCCSector& sector = *_sectors[sec];
+
+        for (size_t r=0; r<nrings; r++)
+        {
+            sector._mirrors_left.emplace_back(new Mirror(&sector,r));
+            sector._mirrors_right.emplace_back(new Mirror(&sector,r));
+        }
+
+        for (size_t row=0; row<m_ring.size(); row++)
+        {
+            vector<unique_ptr<Mirror>>& mirrors =
+                m_half[row] == 0 ? sector._mirrors_left : sector._mirrors_right;
+            Mirror& mirror = *mirrors.at(m_ring[row]);
+
+            mirror._vertex = {vertex_x[row], vertex_y[row], vertex_z[row]};
+            mirror._axis   = direction_vector<double,3>{
+                axis_phi[row] * deg2rad, axis_th[row] * deg2rad };
+            mirror._radius = radius[row];
+            mirror._conic  = conic[row];
+            mirror._thmin  = thmin[row] * deg2rad;
+            mirror._thmax  = thmax[row] * deg2rad;
+            mirror._phimin = phimin[row] * deg2rad;
+            mirror._phimax = phimax[row] * deg2rad;
+        }
+
+        for (size_t row=0; row<p_ring.size(); row++)
+        {
+            vector<unique_ptr<Mirror>>& mirrors =
+                p_half[row] == 0 ? sector._mirrors_left : sector._mirrors_right;
+            Mirror& mirror = *mirrors.at(p_ring[row]);
+
+            mirror._pmt_center = {pmt_x[row], pmt_y[row], pmt_z[row]};
+            mirror._pmt_normal = direction_vector<double,3>{
+                pmt_nphi[row] * deg2rad, pmt_nth[row] * deg2rad };
+            mirror._pmt_radius = pmt_r[row];
+        }
+    }
+}
+
 } // namespace clas12::geometry
 } // namespace clas12
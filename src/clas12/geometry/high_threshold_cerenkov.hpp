@@ -26,11 +26,15 @@ typedef high_threshold_cerenkov::Sector HTCCSector;
 /**
  * \brief The high threshold cerenkov geometry class for CLAS12
  *
- * The DC consists of six sectors, each with three regions.
- * Each region consists of two superlayers which hold the 22
- * wire-planes: There are six sense-wire planes in a superlayer
- * surrounded by two guard-wire planes, and between each of these
- * there are two "field-wire" planes.
+ * The HTCC consists of six sectors, each with a left and a right
+ * half. Each half holds one mirror facet per ring, and each facet
+ * focuses light onto its own PMT. The mirror and PMT parameters are
+ * given in the local sector coordinate system (see Mirror).
+ *
+ * The mirror and PMT constants are not in the database yet: the
+ * sectors are only filled by an explicit call of
+ * fetch_mirror_parameters(). Photons can then be traced through the
+ * mirrors to the PMTs with high_threshold_cerenkov::RayTracer.
  **/
 class HighThresholdCerenkov
 {
@@ -48,9 +52,12 @@ class HighThresholdCerenkov
 
     // members in cpp file
     void fetch_nominal_parameters(Calibration* calib);
+    void fetch_mirror_parameters(Calibration* calib);
+
+    static const vector<string>& mirror_tables();
 
   private:
-    /// \brief the sectors of the DC
+    /// \brief the sectors of the HTCC
     vector<unique_ptr<HTCCSector>> _sectors;
 
 };
@@ -66,7 +73,7 @@ const vector<unique_ptr<HTCCSector>>& HighThresholdCerenkov::sectors() const
 }
 
 /**
- * \brief Get a sector in the DC
+ * \brief Get a sector in the HTCC
  * \param [in] sec The sector index within the high threshold cerenkov (counting from zero)
  * \return const reference to HighThresholdCerenkov::_sectors[sec]
  **/
@@ -52,6 +52,17 @@ Mirror::Mirror(const Sector* sector, size_t idx)
 Mirror::Mirror(const Mirror& that, const Sector* sector, size_t idx)
 : _sector(sector)
 , _idx(idx)
+, _vertex(that._vertex)
+, _axis(that._axis)
+, _radius(that._radius)
+, _conic(that._conic)
+, _thmin(that._thmin)
+, _thmax(that._thmax)
+, _phimin(that._phimin)
+, _phimax(that._phimax)
+, _pmt_center(that._pmt_center)
+, _pmt_normal(that._pmt_normal)
+, _pmt_radius(that._pmt_radius)
 {
 }
 
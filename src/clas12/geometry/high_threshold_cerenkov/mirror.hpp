@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <vector>
 
+#include "geometry/direction_vector.hpp"
 #include "geometry/euclid_vector.hpp"
 #include "geometry/line_segment.hpp"
 #include "geometry/plane.hpp"
@@ -20,6 +21,7 @@ namespace high_threshold_cerenkov
 
 using std::vector;
 
+using ::geometry::direction_vector;
 using ::geometry::euclid_vector;
 using ::geometry::line_segment;
 using ::geometry::plane;
@@ -27,12 +29,42 @@ using ::geometry::plane;
 class Sector;
 
 /**
+ * \brief a mirror facet of the HTCC and the PMT it focuses onto
+ *
+ * Each facet is a section of a conic surface of revolution (ellipsoid
+ * or hyperboloid). In the facet's own frame, with the origin at the
+ * vertex and z along the axis of revolution, the surface is:
+ *
+ *     x^2 + y^2 + (1+k) z^2 - 2 R z = 0
+ *
+ * where R is the radius of curvature at the vertex and k is the conic
+ * constant (-1 < k < 0 for a prolate ellipsoid, k = -1 for a
+ * paraboloid and k < -1 for a hyperboloid). The facet is the part of
+ * this surface seen from the target (the origin) between the polar
+ * angles thmin and thmax and the azimuthal angles phimin and phimax.
+ *
+ * All positions and directions are in the sector coordinate system.
+ * Lengths are in cm and angles in radians.
  **/
 class Mirror
 {
   public:
     // inline methods
     const Sector& sector() const;
+    size_t index() const;
+
+    const euclid_vector<double,3>& vertex() const;
+    const direction_vector<double,3>& axis() const;
+    const double& radius() const;
+    const double& conic() const;
+    const double& thmin() const;
+    const double& thmax() const;
+    const double& phimin() const;
+    const double& phimax() const;
+
+    const euclid_vector<double,3>& pmt_center() const;
+    const direction_vector<double,3>& pmt_normal() const;
+    const double& pmt_radius() const;
 
   private:
     Mirror(const Sector* sector, size_t idx);
@@ -45,6 +77,39 @@ class Mirror
     /// object held by the Sector parent class
     size_t _idx;
 
+    /// \brief vertex of the conic surface (cm)
+    euclid_vector<double,3> _vertex;
+
+    /// \brief axis of revolution of the conic surface
+    /// pointing from the vertex into the concave side
+    direction_vector<double,3> _axis;
+
+    /// \brief radius of curvature at the vertex (cm)
+    double _radius;
+
+    /// \brief conic constant
+    double _conic;
+
+    /// \brief polar angle range of the facet as seen
+    /// from the target (rad)
+    double _thmin;
+    double _thmax;
+
+    /// \brief azimuthal angle range of the facet as seen
+    /// from the target (rad)
+    double _phimin;
+    double _phimax;
+
+    /// \brief center of the PMT window (cm)
+    euclid_vector<double,3> _pmt_center;
+
+    /// \brief normal to the PMT window pointing
+    /// towards the mirror
+    direction_vector<double,3> _pmt_normal;
+
+    /// \brief radius of the PMT window (cm)
+    double _pmt_radius;
+
     // inline methods
     /// \brief deleted copy constructor
     Mirror(const Mirror&) = delete;
@@ -72,6 +137,126 @@ const Sector& Mirror::sector() const
     return *_sector;
 }
 
+/**
+ * \brief get the index of this mirror (ring) in its half-sector
+ * \return copy of Mirror::_idx
+ **/
+inline
+size_t Mirror::index() const
+{
+    return _idx;
+}
+
+/**
+ * \brief get the vertex of the conic surface (cm)
+ * \return const reference to Mirror::_vertex
+ **/
+inline
+const euclid_vector<double,3>& Mirror::vertex() const
+{
+    return _vertex;
+}
+
+/**
+ * \brief get the axis of revolution of the conic surface
+ * \return const reference to Mirror::_axis
+ **/
+inline
+const direction_vector<double,3>& Mirror::axis() const
+{
+    return _axis;
+}
+
+/**
+ * \brief get the radius of curvature at the vertex (cm)
+ * \return const reference to Mirror::_radius
+ **/
+inline
+const double& Mirror::radius() const
+{
+    return _radius;
+}
+
+/**
+ * \brief get the conic constant of the mirror surface
+ * \return const reference to Mirror::_conic
+ **/
+inline
+const double& Mirror::conic() const
+{
+    return _conic;
+}
+
+/**
+ * \brief get the minimum polar angle of the facet seen from the target (rad)
+ * \return const reference to Mirror::_thmin
+ **/
+inline
+const double& Mirror::thmin() const
+{
+    return _thmin;
+}
+
+/**
+ * \brief get the maximum polar angle of the facet seen from the target (rad)
+ * \return const reference to Mirror::_thmax
+ **/
+inline
+const double& Mirror::thmax() const
+{
+    return _thmax;
+}
+
+/**
+ * \brief get the minimum azimuthal angle of the facet seen from the target (rad)
+ * \return const reference to Mirror::_phimin
+ **/
+inline
+const double& Mirror::phimin() const
+{
+    return _phimin;
+}
+
+/**
+ * \brief get the maximum azimuthal angle of the facet seen from the target (rad)
+ * \return const reference to Mirror::_phimax
+ **/
+inline
+const double& Mirror::phimax() const
+{
+    return _phimax;
+}
+
+/**
+ * \brief get the center of the PMT window (cm)
+ * \return const reference to Mirror::_pmt_center
+ **/
+inline
+const euclid_vector<double,3>& Mirror::pmt_center() const
+{
+    return _pmt_center;
+}
+
+/**
+ * \brief get the normal to the PMT window
+ * \return const reference to Mirror::_pmt_normal
+ **/
+inline
+const direction_vector<double,3>& Mirror::pmt_normal() const
+{
+    return _pmt_normal;
+}
+
+/**
+ * \brief get the radius of the PMT window (cm)
+ * \return const reference to Mirror::_pmt_radius
+ **/
+inline
+const double& Mirror::pmt_radius() const
+{
+    return _pmt_radius;
+}
+
 } // namespace clas12::geometry::high_threshold_cerenkov
 } // namespace clas12::geometry
 } // namespace clas12
@@ -0,0 +1,689 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "geometry/constants.hpp"
+
+#include "clas12/geometry/high_threshold_cerenkov.hpp"
+#include "ray_tracer.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+namespace high_threshold_cerenkov
+{
+
+using std::cos;
+using std::sin;
+using std::sqrt;
+using std::fabs;
+using std::max;
+using std::min;
+using std::numeric_limits;
+using std::runtime_error;
+
+namespace
+{
+    /// \brief distance along a reflected photon before it can
+    /// hit anything (cm). Avoids finding the mirror it just left.
+    const double reflection_tolerance = 1.e-6;
+
+    /// \brief number of points sampled along each edge of a mirror
+    /// facet when finding its bounding box
+    const int nbox_samples = 9;
+
+    inline double dot(const double a[3], const double b[3])
+    {
+        return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+    }
+
+    inline void normalize(double a[3])
+    {
+        double l = sqrt(dot(a,a));
+        a[0] /= l;
+        a[1] /= l;
+        a[2] /= l;
+    }
+
+    /**
+     * \brief rotate a vector in sector coordinates about the z-axis
+     * into CLAS coordinates
+     **/
+    inline void sector_to_clas(const double cphi, const double sphi,
+                               const double in[3], double out[3])
+    {
+        out[0] = cphi*in[0] - sphi*in[1];
+        out[1] = sphi*in[0] + cphi*in[1];
+        out[2] = in[2];
+    }
+
+    /**
+     * \brief fill u and v so that (u,v,w) is a right-handed
+     * orthonormal frame
+     **/
+    inline void make_frame(const double w[3], double u[3], double v[3])
+    {
+        double a[3] = {0,0,0};
+        a[fabs(w[0]) < 0.9 ? 0 : 1] = 1;
+
+        // u = a x w
+        u[0] = a[1]*w[2] - a[2]*w[1];
+        u[1] = a[2]*w[0] - a[0]*w[2];
+        u[2] = a[0]*w[1] - a[1]*w[0];
+        normalize(u);
+
+        // v = w x u
+        v[0] = w[1]*u[2] - w[2]*u[1];
+        v[1] = w[2]*u[0] - w[0]*u[2];
+        v[2] = w[0]*u[1] - w[1]*u[0];
+    }
+
+    /**
+     * \brief the roots of a t^2 + b t + c = 0 in increasing order
+     * \return the number of real roots (0, 1 or 2)
+     **/
+    inline int solve_quadratic(double a, double b, double c, double t[2])
+    {
+        if (fabs(a) < 1.e-12)
+        {
+            if (b == 0)
+            {
+                return 0;
+            }
+            t[0] = -c / b;
+            return 1;
+        }
+
+        double disc = b*b - 4*a*c;
+        if (disc < 0)
+        {
+            return 0;
+        }
+
+        double q = -0.5 * (b + std::copysign(sqrt(disc), b));
+        t[0] = q / a;
+        t[1] = (q != 0) ? (c / q) : t[0];
+        if (t[1] < t[0])
+        {
+            std::swap(t[0], t[1]);
+        }
+        return 2;
+    }
+
+    /**
+     * \brief the roots of the conic surface along a ray, where
+     * o and d are given in the surface's own frame.
+     **/
+    inline int conic_roots(double R, double k1,
+                           const double o[3], const double d[3], double t[2])
+    {
+        double a = d[0]*d[0] + d[1]*d[1] + k1*d[2]*d[2];
+        double b = 2 * (o[0]*d[0] + o[1]*d[1] + k1*o[2]*d[2] - R*d[2]);
+        double c = o[0]*o[0] + o[1]*o[1] + k1*o[2]*o[2] - 2*R*o[2];
+        return solve_quadratic(a, b, c, t);
+    }
+
+    inline void to_local(const double u[3], const double v[3], const double w[3],
+                         const double in[3], double out[3])
+    {
+        out[0] = dot(u,in);
+        out[1] = dot(v,in);
+        out[2] = dot(w,in);
+    }
+}
+
+/// \brief size of the traversal stack of nearest()
+static const int max_stack = 64;
+
+/**
+ * \brief constructor: builds the surfaces and the BVH
+ *
+ * \param [in] htcc the HTCC with its nominal parameters filled
+ * \param [in] max_reflections photons reflected more often than
+ *             this are dropped
+ **/
+RayTracer::RayTracer(const HighThresholdCerenkov& htcc, int max_reflections)
+: _depth(0)
+, _max_reflections(max_reflections)
+{
+    static const double sector_phi = ::geometry::cons::pi<double>() / 3.;
+
+    for (const unique_ptr<HTCCSector>& sector : htcc.sectors())
+    {
+        double cphi = cos(sector->index() * sector_phi);
+        double sphi = sin(sector->index() * sector_phi);
+
+        for (int half=0; half<2; half++)
+        {
+            const vector<unique_ptr<Mirror>>& mirrors =
+                half == 0 ? sector->mirrors_left() : sector->mirrors_right();
+
+            for (const unique_ptr<Mirror>& mirror : mirrors)
+            {
+                double tmp[3];
+
+                Surface m;
+                m.type = MIRROR;
+                m.sector = sector->index();
+                m.half = half;
+                m.ring = mirror->index();
+
+                tmp[0] = mirror->vertex().x();
+                tmp[1] = mirror->vertex().y();
+                tmp[2] = mirror->vertex().z();
+                sector_to_clas(cphi, sphi, tmp, m.o);
+
+                tmp[0] = mirror->axis().x();
+                tmp[1] = mirror->axis().y();
+                tmp[2] = mirror->axis().z();
+                sector_to_clas(cphi, sphi, tmp, m.w);
+                normalize(m.w);
+                make_frame(m.w, m.u, m.v);
+
+                m.radius = mirror->radius();
+                m.k1 = 1 + mirror->conic();
+
+                double phimin = mirror->phimin() + sector->index() * sector_phi;
+                double phimax = mirror->phimax() + sector->index() * sector_phi;
+                m.costhmax = cos(mirror->thmax());
+                m.costhmin = cos(mirror->thmin());
+                m.cphimin = cos(phimin);
+                m.sphimin = sin(phimin);
+                m.cphimax = cos(phimax);
+                m.sphimax = sin(phimax);
+
+                this->add_mirror_box(m, mirror->thmin(), mirror->thmax(), phimin, phimax);
+                _surfaces.push_back(m);
+
+                Surface p;
+                p.type = PMT;
+                p.sector = m.sector;
+                p.half = half;
+                p.ring = m.ring;
+
+                tmp[0] = mirror->pmt_center().x();
+                tmp[1] = mirror->pmt_center().y();
+                tmp[2] = mirror->pmt_center().z();
+                sector_to_clas(cphi, sphi, tmp, p.o);
+
+                tmp[0] = mirror->pmt_normal().x();
+                tmp[1] = mirror->pmt_normal().y();
+                tmp[2] = mirror->pmt_normal().z();
+                sector_to_clas(cphi, sphi, tmp, p.w);
+                normalize(p.w);
+                make_frame(p.w, p.u, p.v);
+
+                p.radius = mirror->pmt_radius();
+                p.k1 = 0;
+                p.costhmax = p.costhmin = 0;
+                p.cphimin = p.sphimin = p.cphimax = p.sphimax = 0;
+
+                // exact box of a disk
+                for (int i=0; i<3; i++)
+                {
+                    double e = p.radius * sqrt(max(0., 1. - p.w[i]*p.w[i]));
+                    p.lo[i] = p.o[i] - e;
+                    p.hi[i] = p.o[i] + e;
+                }
+                _surfaces.push_back(p);
+            }
+        }
+    }
+
+    _order.resize(_surfaces.size());
+    for (size_t i=0; i<_order.size(); i++)
+    {
+        _order[i] = i;
+    }
+
+    _nodes.clear();
+    if (!_surfaces.empty())
+    {
+        this->build(0, _surfaces.size(), 0);
+    }
+
+    // nearest() keeps at most one node per level on its stack
+    if (_depth + 1 > max_stack)
+    {
+        throw runtime_error("HTCC bounding volume hierarchy too deep to traverse");
+    }
+}
+
+/**
+ * \brief set the bounding box of a mirror facet
+ *
+ * Points on the facet are found along a grid of directions from the
+ * target covering the facet's polar and azimuthal range. The box of
+ * these points is then enlarged by a margin which covers the bulge
+ * of the surface between the sampled points.
+ **/
+void RayTracer::add_mirror_box(Surface& s, double thmin, double thmax,
+                               double phimin, double phimax) const
+{
+    static const double origin[3] = {0,0,0};
+
+    for (int i=0; i<3; i++)
+    {
+        s.lo[i] = numeric_limits<double>::max();
+        s.hi[i] = -numeric_limits<double>::max();
+    }
+
+    double ol[3];
+    double rel[3] = {origin[0]-s.o[0], origin[1]-s.o[1], origin[2]-s.o[2]};
+    to_local(s.u, s.v, s.w, rel, ol);
+
+    int npoints = 0;
+    for (int i=0; i<nbox_samples; i++)
+    {
+        double th = thmin + i * (thmax - thmin) / (nbox_samples-1);
+        for (int j=0; j<nbox_samples; j++)
+        {
+            double ph = phimin + j * (phimax - phimin) / (nbox_samples-1);
+            double d[3] = {sin(th)*cos(ph), sin(th)*sin(ph), cos(th)};
+
+            double dl[3];
+            to_local(s.u, s.v, s.w, d, dl);
+
+            double t[2];
+            int nroots = conic_roots(s.radius, s.k1, ol, dl, t);
+            double tpos = -1;
+            for (int r=0; r<nroots; r++)
+            {
+                if (t[r] > 0)
+                {
+                    tpos = t[r];
+                    break;
+                }
+            }
+            if (tpos < 0)
+            {
+                continue;
+            }
+
+            for (int k=0; k<3; k++)
+            {
+                s.lo[k] = min(s.lo[k], origin[k] + tpos*d[k]);
+                s.hi[k] = max(s.hi[k], origin[k] + tpos*d[k]);
+            }
+            npoints++;
+        }
+    }
+
+    if (npoints == 0)
+    {
+        throw runtime_error("HTCC mirror facet is not seen from the target");
+    }
+
+    double diag2 = 0;
+    for (int k=0; k<3; k++)
+    {
+        diag2 += (s.hi[k] - s.lo[k]) * (s.hi[k] - s.lo[k]);
+    }
+    double margin = 0.05 * sqrt(diag2) + 0.1;
+    for (int k=0; k<3; k++)
+    {
+        s.lo[k] -= margin;
+        s.hi[k] += margin;
+    }
+}
+
+/**
+ * \brief build the BVH node for _order[first] ... _order[first+count-1]
+ *
+ * Surfaces are split at the median of their box centers along the
+ * axis where the centers are most spread out.
+ *
+ * \param [in] depth the number of nodes above this one
+ * \return the index of the new node in RayTracer::_nodes
+ **/
+int RayTracer::build(int first, int count, int depth)
+{
+    static const int max_leaf_size = 2;
+
+    int inode = _nodes.size();
+    _nodes.push_back(Node());
+
+    Node node;
+    double clo[3];
+    double chi[3];
+    for (int k=0; k<3; k++)
+    {
+        node.lo[k] = clo[k] = numeric_limits<double>::max();
+        node.hi[k] = chi[k] = -numeric_limits<double>::max();
+    }
+    for (int i=first; i<first+count; i++)
+    {
+        const Surface& s = _surfaces[_order[i]];
+        for (int k=0; k<3; k++)
+        {
+            node.lo[k] = min(node.lo[k], s.lo[k]);
+            node.hi[k] = max(node.hi[k], s.hi[k]);
+            double c = 0.5 * (s.lo[k] + s.hi[k]);
+            clo[k] = min(clo[k], c);
+            chi[k] = max(chi[k], c);
+        }
+    }
+
+    if (count <= max_leaf_size)
+    {
+        node.first = first;
+        node.count = count;
+        node.right = -1;
+        _nodes[inode] = node;
+        _depth = max(_depth, depth);
+        return inode;
+    }
+
+    int axis = 0;
+    for (int k=1; k<3; k++)
+    {
+        if ((chi[k] - clo[k]) > (chi[axis] - clo[axis]))
+        {
+            axis = k;
+        }
+    }
+
+    int nleft = count / 2;
+    const vector<Surface>& surfaces = _surfaces;
+    std::nth_element(
+        _order.begin() + first,
+        _order.begin() + first + nleft,
+        _order.begin() + first + count,
+        [&surfaces,axis](int a, int b)
+        {
+            return (surfaces[a].lo[axis] + surfaces[a].hi[axis])
+                 < (surfaces[b].lo[axis] + surfaces[b].hi[axis]);
+        });
+
+    node.first = first;
+    node.count = 0;
+
+    // the left child is always the next node
+    this->build(first, nleft, depth + 1);
+    node.right = this->build(first + nleft, count - nleft, depth + 1);
+
+    _nodes[inode] = node;
+    return inode;
+}
+
+/**
+ * \brief intersection of a ray with a surface
+ *
+ * \param [in] s the surface
+ * \param [in] o origin of the ray (CLAS coordinates)
+ * \param [in] d unit direction of the ray
+ * \param [in] tmin only intersections further than this are considered
+ * \param [out] t distance along the ray to the intersection
+ * \return true if the ray hits the surface
+ **/
+bool RayTracer::intersect(const Surface& s, const double o[3], const double d[3],
+                          double tmin, double& t) const
+{
+    double rel[3] = {o[0]-s.o[0], o[1]-s.o[1], o[2]-s.o[2]};
+
+    if (s.type == PMT)
+    {
+        double dn = dot(d, s.w);
+        if (dn == 0)
+        {
+            return false;
+        }
+        double tp = -dot(rel, s.w) / dn;
+        if (tp <= tmin)
+        {
+            return false;
+        }
+        double p[3] = {rel[0]+tp*d[0], rel[1]+tp*d[1], rel[2]+tp*d[2]};
+        if (dot(p,p) > s.radius*s.radius)
+        {
+            return false;
+        }
+        t = tp;
+        return true;
+    }
+
+    double ol[3];
+    double dl[3];
+    to_local(s.u, s.v, s.w, rel, ol);
+    to_local(s.u, s.v, s.w, d, dl);
+
+    double roots[2];
+    int nroots = conic_roots(s.radius, s.k1, ol, dl, roots);
+    for (int r=0; r<nroots; r++)
+    {
+        if (roots[r] <= tmin)
+        {
+            continue;
+        }
+
+        double p[3] = {o[0]+roots[r]*d[0], o[1]+roots[r]*d[1], o[2]+roots[r]*d[2]};
+
+        // polar angle as seen from the target
+        double pr = sqrt(dot(p,p));
+        double costh = p[2] / pr;
+        if (costh < s.costhmax || costh > s.costhmin)
+        {
+            continue;
+        }
+
+        // azimuthal angle: between phimin and phimax (less than pi apart)
+        if ((s.cphimin*p[1] - s.sphimin*p[0]) < 0
+         || (s.cphimax*p[1] - s.sphimax*p[0]) > 0
+         || ((s.cphimin+s.cphimax)*p[0] + (s.sphimin+s.sphimax)*p[1]) < 0)
+        {
+            continue;
+        }
+
+        t = roots[r];
+        return true;
+    }
+    return false;
+}
+
+/**
+ * \brief the nearest surface along a ray
+ *
+ * \param [in] o origin of the ray (CLAS coordinates)
+ * \param [in] d unit direction of the ray
+ * \param [in] tmin only intersections further than this are considered
+ * \param [out] t distance along the ray to the surface
+ * \return index into RayTracer::_surfaces or -1 if nothing is hit
+ **/
+int RayTracer::nearest(const double o[3], const double d[3], double tmin, double& t) const
+{
+    double inv[3] = {1./d[0], 1./d[1], 1./d[2]};
+
+    int best = -1;
+    double tbest = numeric_limits<double>::max();
+
+    // deep enough for the tree: checked by the constructor
+    int stack[max_stack];
+    int sp = 0;
+    stack[sp++] = 0;
+
+    while (sp > 0)
+    {
+        int inode = stack[--sp];
+        const Node& node = _nodes[inode];
+
+        // slab test against the node's box
+        double tnear = tmin;
+        double tfar = tbest;
+        for (int k=0; k<3; k++)
+        {
+            double t0 = (node.lo[k] - o[k]) * inv[k];
+            double t1 = (node.hi[k] - o[k]) * inv[k];
+            tnear = max(tnear, min(t0,t1));
+            tfar = min(tfar, max(t0,t1));
+        }
+        if (tnear > tfar)
+        {
+            continue;
+        }
+
+        if (node.count > 0)
+        {
+            for (int i=node.first; i<node.first+node.count; i++)
+            {
+                double ts;
+                if (this->intersect(_surfaces[_order[i]], o, d, tmin, ts) && ts < tbest)
+                {
+                    tbest = ts;
+                    best = _order[i];
+                }
+            }
+        }
+        else
+        {
+            stack[sp++] = node.right;
+            stack[sp++] = inode + 1;
+        }
+    }
+
+    t = tbest;
+    return best;
+}
+
+/**
+ * \brief trace one photon to the PMTs
+ *
+ * \param [in] origin where the photon is emitted (cm, CLAS coordinates)
+ * \param [in] direction the initial direction of the photon (unit vector)
+ * \param [out] hit where the photon ended up. Only filled on success.
+ * \return true if the photon reached a PMT window
+ **/
+bool RayTracer::trace(
+    const double origin[3],
+    const double direction[3],
+    PhotonHit& hit) const
+{
+    if (_nodes.empty())
+    {
+        return false;
+    }
+
+    double o[3] = {origin[0], origin[1], origin[2]};
+    double d[3] = {direction[0], direction[1], direction[2]};
+    normalize(d);
+
+    double path_length = 0;
+    double tmin = 0;
+
+    for (int nreflections=0; nreflections<=_max_reflections; nreflections++)
+    {
+        double t;
+        int isurf = this->nearest(o, d, tmin, t);
+        if (isurf < 0)
+        {
+            return false;
+        }
+
+        const Surface& s = _surfaces[isurf];
+
+        for (int k=0; k<3; k++)
+        {
+            o[k] += t * d[k];
+        }
+        path_length += t;
+
+        if (s.type == PMT)
+        {
+            hit.sector = s.sector;
+            hit.half = s.half;
+            hit.ring = s.ring;
+            hit.nreflections = nreflections;
+            hit.x = o[0];
+            hit.y = o[1];
+            hit.z = o[2];
+            hit.path_length = path_length;
+            return true;
+        }
+
+        // reflect off the mirror: the normal is the gradient
+        // of the conic surface in its own frame
+        double rel[3] = {o[0]-s.o[0], o[1]-s.o[1], o[2]-s.o[2]};
+        double pl[3];
+        to_local(s.u, s.v, s.w, rel, pl);
+        double nl2 = s.k1 * pl[2] - s.radius;
+        double n[3];
+        for (int k=0; k<3; k++)
+        {
+            n[k] = pl[0]*s.u[k] + pl[1]*s.v[k] + nl2*s.w[k];
+        }
+        normalize(n);
+
+        double dn = dot(d, n);
+        for (int k=0; k<3; k++)
+        {
+            d[k] -= 2 * dn * n[k];
+        }
+
+        tmin = reflection_tolerance;
+    }
+
+    return false;
+}
+
+/**
+ * \brief trace one photon to the PMTs
+ *
+ * \param [in] origin where the photon is emitted (cm, CLAS coordinates)
+ * \param [in] direction the initial direction of the photon
+ * \param [out] hit where the photon ended up. Only filled on success.
+ * \return true if the photon reached a PMT window
+ **/
+bool RayTracer::trace(
+    const euclid_vector<double,3>& origin,
+    const direction_vector<double,3>& direction,
+    PhotonHit& hit) const
+{
+    double o[3] = {origin.x(), origin.y(), origin.z()};
+    double d[3] = {direction.x(), direction.y(), direction.z()};
+    return this->trace(o, d, hit);
+}
+
+/**
+ * \brief trace many photons to the PMTs
+ *
+ * \param [in] origins (x,y,z) of each photon, one after the other
+ *             (cm, CLAS coordinates)
+ * \param [in] directions (x,y,z) of each photon's direction
+ * \param [out] hits one entry per photon. Photons that did not reach
+ *              a PMT have sector = -1.
+ * \return the number of photons that reached a PMT
+ **/
+size_t RayTracer::trace(
+    const vector<double>& origins,
+    const vector<double>& directions,
+    vector<PhotonHit>& hits) const
+{
+    if (origins.size() != directions.size() || origins.size() % 3 != 0)
+    {
+        throw runtime_error("photon origins and directions must be (x,y,z) triplets");
+    }
+
+    size_t nphotons = origins.size() / 3;
+    hits.resize(nphotons);
+
+    size_t nhits = 0;
+    for (size_t i=0; i<nphotons; i++)
+    {
+        if (this->trace(&origins[3*i], &directions[3*i], hits[i]))
+        {
+            nhits++;
+        }
+        else
+        {
+            hits[i].sector = -1;
+        }
+    }
+    return nhits;
+}
+
+} // namespace clas12::geometry::high_threshold_cerenkov
+} // namespace clas12::geometry
+} // namespace clas12
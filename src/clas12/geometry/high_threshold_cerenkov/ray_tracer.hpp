@@ -0,0 +1,216 @@
+#ifndef CLAS12_GEOMETRY_HIGH_THRESHOLD_CERENKOV_RAY_TRACER_HPP
+#define CLAS12_GEOMETRY_HIGH_THRESHOLD_CERENKOV_RAY_TRACER_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "geometry/direction_vector.hpp"
+#include "geometry/euclid_vector.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+
+class HighThresholdCerenkov;
+
+namespace high_threshold_cerenkov
+{
+
+using std::vector;
+
+using ::geometry::direction_vector;
+using ::geometry::euclid_vector;
+
+/**
+ * \brief where a photon ended up on the HTCC PMTs
+ **/
+struct PhotonHit
+{
+    /// \brief sector index (from zero)
+    int sector;
+
+    /// \brief half-sector: 0 = left, 1 = right
+    int half;
+
+    /// \brief mirror ring (and PMT) index (from zero)
+    int ring;
+
+    /// \brief number of mirror reflections before the PMT
+    int nreflections;
+
+    /// \brief position on the PMT window (cm, CLAS coordinates)
+    double x;
+    double y;
+    double z;
+
+    /// \brief path length from the origin of the photon (cm)
+    double path_length;
+};
+
+/**
+ * \brief traces Cherenkov photons through the HTCC mirrors to the PMTs
+ *
+ * All mirror facets and PMT windows of all sectors are copied into a
+ * flat list of surfaces in CLAS coordinates and sorted into a
+ * bounding volume hierarchy (BVH) of axis-aligned boxes. A photon is
+ * traced by finding the nearest surface along its path through the
+ * BVH, reflecting off mirrors until it reaches a PMT window, leaves
+ * the detector or has been reflected too many times.
+ *
+ * The tracer holds no reference to the HighThresholdCerenkov object
+ * it was made from and tracing does not allocate memory, so one
+ * tracer can be shared by many threads.
+ *
+ * The boxes of the mirror facets are found by sampling points on the
+ * facets and adding a margin: a box may be slightly larger than the
+ * facet but never smaller for smooth facets.
+ **/
+class RayTracer
+{
+  public:
+    RayTracer(const HighThresholdCerenkov& htcc, int max_reflections = 4);
+
+    // inline methods
+    size_t nsurfaces() const;
+    size_t nnodes() const;
+    const int& max_reflections() const;
+
+    // methods in cpp file
+    bool trace(
+        const euclid_vector<double,3>& origin,
+        const direction_vector<double,3>& direction,
+        PhotonHit& hit) const;
+
+    bool trace(
+        const double origin[3],
+        const double direction[3],
+        PhotonHit& hit) const;
+
+    size_t trace(
+        const vector<double>& origins,
+        const vector<double>& directions,
+        vector<PhotonHit>& hits) const;
+
+  private:
+    enum SurfaceType
+    {
+        MIRROR,
+        PMT
+    };
+
+    /**
+     * \brief a mirror facet or PMT window in CLAS coordinates
+     *
+     * For a mirror, o is the vertex, w the axis of revolution and
+     * u, v complete the frame. For a PMT, o is the center of the
+     * window and w its normal.
+     **/
+    struct Surface
+    {
+        SurfaceType type;
+        int sector;
+        int half;
+        int ring;
+
+        double o[3];
+        double u[3];
+        double v[3];
+        double w[3];
+
+        /// \brief mirror: radius of curvature, PMT: window radius
+        double radius;
+
+        /// \brief mirror: 1 + conic constant
+        double k1;
+
+        /// \brief mirror: cos(thmax), cos(thmin)
+        double costhmax;
+        double costhmin;
+
+        /// \brief mirror: phi limits as (cos,sin) in CLAS coordinates
+        double cphimin;
+        double sphimin;
+        double cphimax;
+        double sphimax;
+
+        /// \brief bounding box
+        double lo[3];
+        double hi[3];
+    };
+
+    /**
+     * \brief a node of the bounding volume hierarchy
+     *
+     * Leaves have count > 0 and hold the surfaces
+     * _order[first] ... _order[first+count-1]. The children of an
+     * inner node are the next node in the list and the node at
+     * index "right".
+     **/
+    struct Node
+    {
+        double lo[3];
+        double hi[3];
+        int first;
+        int count;
+        int right;
+    };
+
+    /// \brief all mirror facets and PMT windows
+    vector<Surface> _surfaces;
+
+    /// \brief surface indexes ordered by BVH leaf
+    vector<int> _order;
+
+    /// \brief the BVH, root first
+    vector<Node> _nodes;
+
+    /// \brief the number of levels of the BVH below the root
+    int _depth;
+
+    /// \brief maximum number of reflections to follow
+    int _max_reflections;
+
+    void add_mirror_box(Surface& s, double thmin, double thmax,
+                        double phimin, double phimax) const;
+    int build(int first, int count, int depth);
+    bool intersect(const Surface& s, const double o[3], const double d[3],
+                   double tmin, double& t) const;
+    int nearest(const double o[3], const double d[3], double tmin, double& t) const;
+};
+
+/**
+ * \brief the number of surfaces (mirror facets and PMT windows)
+ * \return RayTracer::_surfaces.size()
+ **/
+inline
+size_t RayTracer::nsurfaces() const
+{
+    return _surfaces.size();
+}
+
+/**
+ * \brief the number of nodes in the bounding volume hierarchy
+ * \return RayTracer::_nodes.size()
+ **/
+inline
+size_t RayTracer::nnodes() const
+{
+    return _nodes.size();
+}
+
+/**
+ * \brief the maximum number of mirror reflections followed
+ * \return const reference to RayTracer::_max_reflections
+ **/
+inline
+const int& RayTracer::max_reflections() const
+{
+    return _max_reflections;
+}
+
+} // namespace clas12::geometry::high_threshold_cerenkov
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_HIGH_THRESHOLD_CERENKOV_RAY_TRACER_HPP
@@ -1,11 +1,13 @@
 #ifndef CLAS12_GEOMETRY_OUTPUT_HPP
 #define CLAS12_GEOMETRY_OUTPUT_HPP
 
+#include "output/bst_strip_endpoints.hpp"
 #include "output/dc_wire_endpoints.hpp"
 #include "output/dc_volumes.hpp"
 #include "output/dc_core_params.hpp"
 #include "output/ftof_panels_parms.hpp"
 #include "output/ftof_volumes.hpp"
+#include "output/pcal_volumes.hpp"
 
 #include "preshower_cal.hpp"
 #include "high_threshold_cerenkov.hpp"
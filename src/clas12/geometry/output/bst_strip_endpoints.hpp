@@ -10,7 +10,13 @@
 #include "geometry/euclid_vector.hpp"
 #include "geometry/line_segment.hpp"
 
-#include "clas12/geometry.hpp"
+#include "pugixml.hpp"
+
+#include "clas12/geometry/central_tracker.hpp"
+#include "clas12/geometry/selection.hpp"
+#include "clas12/stats.hpp"
+
+#include "parametric.hpp"
 
 namespace clas12
 {
@@ -35,12 +41,8 @@ using namespace clas12::geometry::central_tracker;
 
 void bst_basic_parameters_xml(xml_document& doc, const BarrelSVT& bst, const string& coordsys="LAB", const string& units="mm")
 {
-double length_conversion = 1;
-    if (units == "cm")
-    {
-        length_conversion = 0.1;
-    }
-    else if (units != "mm")
+    // only angles are written: the units are checked but not used
+    if (units != "mm" && units != "cm")
     {
         throw runtime_error(string("can not convert to units: ") + units);
     }
@@ -82,7 +84,14 @@ double length_conversion = 1;
 
 
 
-void bst_strip_endpoints_xml(xml_document& doc, const BarrelSVT& bst, const string& coordsys="LAB", const string& units="mm")
+/**
+ * \brief the end points of every strip, by layer
+ * \param [in] sel limits the output by region, sector or layer
+ * \param [in] parametric if true, each coordinate of a layer is sent
+ *             as a line in the strip index plus residuals (see
+ *             set_values())
+ **/
+void bst_strip_endpoints_xml(xml_document& doc, const BarrelSVT& bst, const string& coordsys="LAB", const string& units="mm", const Selection& sel=Selection(), bool parametric=false)
 {
     double length_conversion = 1;
     if (units == "cm")
@@ -93,6 +102,8 @@ void bst_strip_endpoints_xml(xml_document& doc, const BarrelSVT& bst, const stri
     {
         throw runtime_error(string("can not convert to units: ") + units);
     }
+    // parametric_tolerance is in cm
+    double tolerance = parametric_tolerance * 10 * length_conversion;
 
     if (coordsys != "LAB")
     {
@@ -122,24 +133,36 @@ void bst_strip_endpoints_xml(xml_document& doc, const BarrelSVT& bst, const stri
     strip_node.attribute("length_units") = units.c_str();
     strip_node.attribute("coordinate_system") = coordsys.c_str();
 
-    for (int reg=0; reg<bst.regions().size(); reg++)
-    {
-        const barrel_svt::Region& bst_region = bst.region(reg);
-
-        //for (int sec=0; sec<bst_region.sectors().size(); sec++)
-        for (int sec=0; sec<2; sec++)
-        {
-            const barrel_svt::Sector& bst_sector = bst_region.sector(sec);
+    const barrel_svt::StripTable& table = bst.strip_table();
 
-            for (int lyr=0; lyr<bst_sector.layers().size(); lyr++)
-            {
-                const barrel_svt::Layer& bst_layer = bst_sector.layer(lyr);
+    const vector<const vector<double>*> coords{
+        &table.first_x(),  &table.first_y(),  &table.first_z(),
+        &table.second_x(), &table.second_y(), &table.second_z() };
 
+    size_t nstrips = 0;
 
+    for (size_t reg=0; reg<table.nregions(); reg++)
+    {
+        if (!sel.selects("region", reg))
+        {
+            continue;
+        }
+        for (size_t sec=0; sec<table.nsectors(reg); sec++)
+        {
+            if (!sel.selects("sector", sec))
+            {
+                continue;
+            }
+            for (size_t lyr=0; lyr<table.nlayers(reg); lyr++)
+            {
+                if (!sel.selects("layer", lyr))
+                {
+                    continue;
+                }
                 xml_node strip_endpoints_node = strip_node.append_child("strip_endpoints");
-                strip_endpoints_node.append_attribute("sector") = sec;
-                strip_endpoints_node.append_attribute("region") = reg;
-                strip_endpoints_node.append_attribute("layer")  = lyr;
+                strip_endpoints_node.append_attribute("sector") = unsigned(sec);
+                strip_endpoints_node.append_attribute("region") = unsigned(reg);
+                strip_endpoints_node.append_attribute("layer")  = unsigned(lyr);
 
                 xml_node left_node = strip_endpoints_node.append_child("first");
                 vector<xml_node> endpoint_nodes;
@@ -152,28 +175,27 @@ void bst_strip_endpoints_xml(xml_document& doc, const BarrelSVT& bst, const stri
                 endpoint_nodes.push_back(right_node.append_child("y"));
                 endpoint_nodes.push_back(right_node.append_child("z"));
 
-                vector<stringstream> endpoints(6);
-                for (line_segment<double,3> st : bst_layer.siliconStrips())
+                size_t begin = table.begin(reg,sec,lyr);
+                size_t end = table.end(reg,sec,lyr);
+                nstrips += end - begin;
+
+                for (size_t i=0; i<coords.size(); i++)
                 {
-                    euclid_vector<double,3> endpt = st.end_point();
-                    endpoints[0] << " " << st.begin_point().x() * length_conversion;
-                    endpoints[1] << " " << st.begin_point().y() * length_conversion;
-                    endpoints[2] << " " << st.begin_point().z() * length_conversion;
-                    endpoints[3] << " " << endpt.x() * length_conversion;
-                    endpoints[4] << " " << endpt.y() * length_conversion;
-                    endpoints[5] << " " << endpt.z() * length_conversion;
-                }
+                    const vector<double>& coord = *coords[i];
 
+                    vector<double> values(end - begin);
+                    for (size_t s=begin; s<end; s++)
+                    {
+                        values[s - begin] = coord[s] * length_conversion;
+                    }
 
-                for (int i=0; i<endpoints.size(); i++)
-                {
-                    endpoint_nodes[i].append_child(pugi::node_pcdata).set_value(
-                        endpoints[i].str().erase(0,1).c_str());
+                    set_values(endpoint_nodes[i], values, parametric, tolerance);
                 }
-
             }
         }
     }
+
+    stats::count("bst strips", nstrips);
 }
 
 } // namespace clas12::geometry::output
@@ -17,6 +17,9 @@ using std::endl;
 #include "geometry/constants.hpp"
 
 #include "clas12/geometry/drift_chamber.hpp"
+#include "clas12/geometry/output/volume_placements.hpp"
+#include "clas12/geometry/selection.hpp"
+#include "clas12/stats.hpp"
 
 namespace clas12
 {
@@ -55,9 +58,12 @@ typedef map<string, map<string,string> > volmap_t;
  *     pAlp2   Angle with respect to the y axis from the centre of the
  *             side at y=-pDy2 to the centre at y=+pDy2 of the face at +pDz
  *
+ * \param [in] sel limits the volumes by region or superlayer
+ *             (numbered 1 to 6 across the regions); a region is kept
+ *             if any of its superlayers is selected
  * \return map of map of strings: ret[volume_name][param_name] = value
  **/
-volmap_t dc_sector_volumes_map(const drift_chamber::Sector& sector)
+volmap_t dc_sector_volumes_map(const drift_chamber::Sector& sector, const Selection& sel=Selection())
 {
     using namespace std;
     using namespace ::geometry;
@@ -93,6 +99,17 @@ volmap_t dc_sector_volumes_map(const drift_chamber::Sector& sector)
     {
         const drift_chamber::Region& region = sector.region(reg);
 
+        const size_t nslyrs = region.superlayers().size();
+        bool any_superlayer = false;
+        for (size_t slyr=0; slyr<nslyrs; slyr++)
+        {
+            any_superlayer = any_superlayer || sel.selects("superlayer", reg*nslyrs + slyr);
+        }
+        if (!sel.selects("region", reg) || !any_superlayer)
+        {
+            continue;
+        }
+
         stringstream region_name_ss;
         region_name_ss << "R" << reg+1 << "_S" << sector.index()+1;
         string region_name = region_name_ss.str();
@@ -178,6 +195,10 @@ volmap_t dc_sector_volumes_map(const drift_chamber::Sector& sector)
 
         for(size_t slyr=0; slyr<region.superlayers().size(); slyr++)
         {
+            if (!sel.selects("superlayer", reg*nslyrs + slyr))
+            {
+                continue;
+            }
             const drift_chamber::Superlayer& superlayer = region.superlayer(slyr);
 
             for (size_t lyr=0; lyr<2 /*superlayer.senselayers().size()*/; lyr++)
@@ -359,20 +380,37 @@ vols[layer_name] = {
 }
 
 
-volmap_t dc_volumes_map(const DriftChamber& dc)
+/**
+ * \brief generate the volumes of all DC sectors for input into gemc/geant4
+ * \param [in] placements if true, identical volumes are emitted
+ *             once and placed as copies (see volume_placements())
+ * \param [in] sel limits the volumes by sector, region or superlayer
+ * \return map of map of strings: ret[volume_name][param_name] = value
+ **/
+volmap_t dc_volumes_map(const DriftChamber& dc, bool placements=false, const Selection& sel=Selection())
 {
     volmap_t vmap;
 
     for (const unique_ptr<drift_chamber::Sector>& sector : dc.sectors())
     {
-        volmap_t secmap = dc_sector_volumes_map(*sector);
+        if (!sel.selects("sector", sector->index()))
+        {
+            continue;
+        }
+        volmap_t secmap = dc_sector_volumes_map(*sector, sel);
         vmap.insert(secmap.begin(), secmap.end());
     }
 
+    if (placements)
+    {
+        vmap = volume_placements(vmap);
+    }
+
+    stats::count("volumes", vmap.size());
     return vmap;
 }
 
-void dc_volumes_xml(xml_document& doc, const DriftChamber& dc)
+void dc_volumes_xml(xml_document& doc, const DriftChamber& dc, bool placements=false, const Selection& sel=Selection())
 {
     // start building up the XML document
     xml_node geom_node = doc.child("geometry");
@@ -391,7 +429,7 @@ void dc_volumes_xml(xml_document& doc, const DriftChamber& dc)
         vol_node = dc_node.append_child("volumes");
     }
 
-    for (auto k1 : dc_volumes_map(dc))
+    for (auto k1 : dc_volumes_map(dc, placements, sel))
     {
         xml_node n1 = vol_node.append_child(k1.first.c_str());
 
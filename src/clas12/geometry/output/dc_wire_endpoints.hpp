@@ -11,8 +11,11 @@
 #include "geometry/line_segment.hpp"
 
 #include "clas12/geometry/drift_chamber.hpp"
+#include "clas12/geometry/selection.hpp"
+#include "clas12/stats.hpp"
 
 #include "detail/length_conversion.hpp"
+#include "parametric.hpp"
 
 namespace clas12
 {
@@ -35,9 +38,18 @@ using ::geometry::euclid_vector;
 
 using clas12::geometry::DriftChamber;
 
-void dc_wire_endpoints_xml(xml_document& doc, const DriftChamber& dc, const string& coordsys="sector", const string& units="cm")
+/**
+ * \brief the end points of every wire, by layer
+ * \param [in] sel limits the output by sector, region or superlayer;
+ *             wires of parts not selected are not computed
+ * \param [in] parametric if true, each coordinate of a layer is sent
+ *             as a line in the wire index plus residuals (see
+ *             set_values())
+ **/
+void dc_wire_endpoints_xml(xml_document& doc, const DriftChamber& dc, const string& coordsys="sector", const string& units="cm", const Selection& sel=Selection(), bool parametric=false)
 {
     double lconv = length_conversion(units);
+    double tolerance = parametric_tolerance * lconv;
 
     if (coordsys != "sector" && coordsys != "clas")
     {
@@ -68,16 +80,31 @@ void dc_wire_endpoints_xml(xml_document& doc, const DriftChamber& dc, const stri
     wire_node.attribute("length_units") = units.c_str();
     wire_node.attribute("coordinate_system") = coordsys.c_str();
 
+    size_t nwires = 0;
+
     for (int sec=0; sec<dc.sectors().size(); sec++)
     {
+        if (!sel.selects("sector", sec))
+        {
+            continue;
+        }
         const drift_chamber::Sector& dc_sector = dc.sector(sec);
 
         for (int reg=0; reg<dc_sector.regions().size(); reg++)
         {
+            if (!sel.selects("region", reg))
+            {
+                continue;
+            }
             const drift_chamber::Region& dc_region = dc_sector.region(reg);
 
             for (int slyr=0; slyr<dc_region.superlayers().size(); slyr++)
             {
+                // superlayers are numbered 1 to 6 across the regions
+                if (!sel.selects("superlayer", reg*dc_region.superlayers().size() + slyr))
+                {
+                    continue;
+                }
                 const drift_chamber::Superlayer& dc_superlayer = dc_region.superlayer(slyr);
 
                 for (int lyr=0; lyr<dc_superlayer.senselayers().size(); lyr++)
@@ -101,22 +128,22 @@ void dc_wire_endpoints_xml(xml_document& doc, const DriftChamber& dc, const stri
                     endpoint_nodes.push_back(right_node.append_child("y"));
                     endpoint_nodes.push_back(right_node.append_child("z"));
 
-                    vector<stringstream> endpoints(6);
+                    vector<vector<double>> endpoints(6);
                     for (line_segment<double,3> w : dc_senselayer.wires(coord))
                     {
                         euclid_vector<double,3> endpt = w.end_point();
-                        endpoints[0] << " " << w.begin_point().x() * lconv;
-                        endpoints[1] << " " << w.begin_point().y() * lconv;
-                        endpoints[2] << " " << w.begin_point().z() * lconv;
-                        endpoints[3] << " " << endpt.x() * lconv;
-                        endpoints[4] << " " << endpt.y() * lconv;
-                        endpoints[5] << " " << endpt.z() * lconv;
+                        endpoints[0].push_back(w.begin_point().x() * lconv);
+                        endpoints[1].push_back(w.begin_point().y() * lconv);
+                        endpoints[2].push_back(w.begin_point().z() * lconv);
+                        endpoints[3].push_back(endpt.x() * lconv);
+                        endpoints[4].push_back(endpt.y() * lconv);
+                        endpoints[5].push_back(endpt.z() * lconv);
+                        nwires++;
                     }
 
                     for (int i=0; i<endpoints.size(); i++)
                     {
-                        endpoint_nodes[i].append_child(pugi::node_pcdata).set_value(
-                            endpoints[i].str().erase(0,1).c_str());
+                        set_values(endpoint_nodes[i], endpoints[i], parametric, tolerance);
                     }
                 }
 
@@ -141,27 +168,29 @@ void dc_wire_endpoints_xml(xml_document& doc, const DriftChamber& dc, const stri
                     endpoint_nodes.push_back(right_node.append_child("y"));
                     endpoint_nodes.push_back(right_node.append_child("z"));
 
-                    vector<stringstream> endpoints(6);
+                    vector<vector<double>> endpoints(6);
                     for (line_segment<double,3> w : dc_guardlayer.wires(coord))
                     {
                         euclid_vector<double,3> endpt = w.end_point();
-                        endpoints[0] << " " << w.begin_point().x() * lconv;
-                        endpoints[1] << " " << w.begin_point().y() * lconv;
-                        endpoints[2] << " " << w.begin_point().z() * lconv;
-                        endpoints[3] << " " << endpt.x() * lconv;
-                        endpoints[4] << " " << endpt.y() * lconv;
-                        endpoints[5] << " " << endpt.z() * lconv;
+                        endpoints[0].push_back(w.begin_point().x() * lconv);
+                        endpoints[1].push_back(w.begin_point().y() * lconv);
+                        endpoints[2].push_back(w.begin_point().z() * lconv);
+                        endpoints[3].push_back(endpt.x() * lconv);
+                        endpoints[4].push_back(endpt.y() * lconv);
+                        endpoints[5].push_back(endpt.z() * lconv);
+                        nwires++;
                     }
 
                     for (int i=0; i<endpoints.size(); i++)
                     {
-                        endpoint_nodes[i].append_child(pugi::node_pcdata).set_value(
-                            endpoints[i].str().erase(0,1).c_str());
+                        set_values(endpoint_nodes[i], endpoints[i], parametric, tolerance);
                     }
                 }
             }
         }
     }
+
+    stats::count("dc wires", nwires);
 }
 
 } // namespace clas12::geometry::output
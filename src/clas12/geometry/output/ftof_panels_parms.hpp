@@ -12,8 +12,10 @@
 #include "geometry/direction_vector.hpp"
 
 #include "clas12/geometry.hpp"
+#include "clas12/geometry/selection.hpp"
 
 #include "detail/length_conversion.hpp"
+#include "parametric.hpp"
 
 namespace clas12
 {
@@ -37,9 +39,17 @@ using ::geometry::direction_vector;
 
 using clas12::geometry::ForwardTOF;
 
-void ftof_panels_parms_xml(xml_document& doc, const ForwardTOF& ftof, const string& coordsys="clas", const string& units="cm")
+/**
+ * \brief the core parameters and paddle positions of every panel
+ * \param [in] sel limits the output by sector or panel (1a, 1b, 2)
+ * \param [in] parametric if true, the paddle centers and lengths of a
+ *             panel are sent as a line in the paddle index plus
+ *             residuals (see set_values())
+ **/
+void ftof_panels_parms_xml(xml_document& doc, const ForwardTOF& ftof, const string& coordsys="clas", const string& units="cm", const Selection& sel=Selection(), bool parametric=false)
 {
     double lconv = length_conversion(units);
+    double tolerance = parametric_tolerance * lconv;
 
     if (coordsys != "sector" && coordsys != "clas")
     {
@@ -73,10 +83,18 @@ void ftof_panels_parms_xml(xml_document& doc, const ForwardTOF& ftof, const stri
 
     for (int sec=0; sec<ftof.sectors().size(); sec++)
     {
+        if (!sel.selects("sector", sec))
+        {
+            continue;
+        }
         const forward_tof::Sector& ftof_sector = ftof.sector(sec);
 
         for (int pan=0; pan<ftof_sector.panels().size(); pan++)
         {
+            if (!sel.selects("panel", ftof_sector.panel_name(pan)))
+            {
+                continue;
+            }
             const forward_tof::Panel& panel = ftof_sector.panel(pan);
 
             xml_node panel_node = panels_node.append_child("panel");
@@ -106,27 +124,25 @@ void ftof_panels_parms_xml(xml_document& doc, const ForwardTOF& ftof, const stri
             paddle_centers_node.push_back(center_node.append_child("y"));
             paddle_centers_node.push_back(center_node.append_child("z"));
 
-            vector<stringstream> centers(3);
+            vector<vector<double>> centers(3);
             for (auto cntr : panel.paddle_centers(coord))
             {
-                centers[0] << " " << cntr.x() * lconv;
-                centers[1] << " " << cntr.y() * lconv;
-                centers[2] << " " << cntr.z() * lconv;
+                centers[0].push_back(cntr.x() * lconv);
+                centers[1].push_back(cntr.y() * lconv);
+                centers[2].push_back(cntr.z() * lconv);
             }
             for (int i=0; i<paddle_centers_node.size(); i++)
             {
-                paddle_centers_node[i].append_child(pugi::node_pcdata).set_value(
-                    centers[i].str().erase(0,1).c_str());
+                set_values(paddle_centers_node[i], centers[i], parametric, tolerance);
             }
 
             xml_node length_node = panel_node.append_child("paddle_lengths");
-            stringstream lengths;
+            vector<double> lengths;
             for (auto lngth : panel.paddle_lengths())
             {
-                lengths << " " << lngth;
+                lengths.push_back(lngth);
             }
-            length_node.append_child(pugi::node_pcdata).set_value(
-                lengths.str().erase(0,1).c_str());
+            set_values(length_node, lengths, parametric, parametric_tolerance);
         }
     }
 }
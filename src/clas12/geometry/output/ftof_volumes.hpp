@@ -18,6 +18,9 @@ using std::endl;
 #include "geometry/constants.hpp"
 
 #include "clas12/geometry/forward_tof.hpp"
+#include "clas12/geometry/output/volume_placements.hpp"
+#include "clas12/geometry/selection.hpp"
+#include "clas12/stats.hpp"
 
 namespace clas12
 {
@@ -47,13 +50,16 @@ typedef map<string, map<string,string> > volmap_t;
  *     pDy     Half-length along y
  *     pDz     Half-length along z
  *
+ * \param [in] placements if true, identical volumes are emitted
+ *             once and placed as copies (see volume_placements())
+ * \param [in] sel limits the volumes by sector or panel (1a, 1b, 2)
  * \return map of map of strings: ret[volume_name][param_name] = value
  **/
  // 4 mm gap between panel's mother volume and daughter volumes
 static const double mothergap = 0.4; //cm
 
 
-volmap_t ftof_volumes_map(const ForwardTOF& ftof)
+volmap_t ftof_volumes_map(const ForwardTOF& ftof, bool placements=false, const Selection& sel=Selection())
 {
     using namespace std;
     using namespace ::geometry;
@@ -74,6 +80,10 @@ volmap_t ftof_volumes_map(const ForwardTOF& ftof)
 
     for (size_t sec=0; sec<ftof.sectors().size(); sec++)
     {
+        if (!sel.selects("sector", sec))
+        {
+            continue;
+        }
         const forward_tof::Sector& sector = ftof.sector(sec);
 
         stringstream sector_name_ss;
@@ -86,6 +96,10 @@ volmap_t ftof_volumes_map(const ForwardTOF& ftof)
 
         for (size_t pan=0; pan<sector.panels().size(); pan++)
         {
+            if (!sel.selects("panel", sector.panel_name(pan)))
+            {
+                continue;
+            }
             const forward_tof::Panel& panel = sector.panel(pan);
 
             stringstream panel_name_ss;
@@ -226,10 +240,16 @@ volmap_t ftof_volumes_map(const ForwardTOF& ftof)
 
     } // loop over sectors
 
+    if (placements)
+    {
+        vols = volume_placements(vols);
+    }
+
+    stats::count("volumes", vols.size());
     return vols;
 }
 
-void ftof_volumes_xml(xml_document& doc, const ForwardTOF& ftof)
+void ftof_volumes_xml(xml_document& doc, const ForwardTOF& ftof, bool placements=false, const Selection& sel=Selection())
 {
     // start building up the XML document
     xml_node geom_node = doc.child("geometry");
@@ -248,7 +268,7 @@ void ftof_volumes_xml(xml_document& doc, const ForwardTOF& ftof)
         vol_node = dc_node.append_child("volumes");
     }
 
-    for (auto k1 : ftof_volumes_map(ftof))
+    for (auto k1 : ftof_volumes_map(ftof, placements, sel))
     {
         xml_node n1 = vol_node.append_child(k1.first.c_str());
 
@@ -0,0 +1,239 @@
+#ifndef CLAS12_GEOMETRY_OUTPUT_PARAMETRIC_HPP
+#define CLAS12_GEOMETRY_OUTPUT_PARAMETRIC_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "pugixml.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+namespace output
+{
+
+using std::runtime_error;
+using std::size_t;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+using pugi::xml_node;
+
+/// \brief how far (in cm) a value may be from the fitted line before
+/// it is sent as a residual in the parametric encoding
+const double parametric_tolerance = 1.e-6;
+
+namespace detail
+{
+
+/**
+ * \brief a number written with enough digits to be read back exactly
+ **/
+inline
+string exact_str(double value)
+{
+    stringstream ss;
+    ss.precision(std::numeric_limits<double>::max_digits10);
+    ss << value;
+    return ss.str();
+}
+
+/**
+ * \brief the median of a list of numbers, which is not empty
+ **/
+inline
+double median(vector<double> v)
+{
+    auto mid = v.begin() + v.size() / 2;
+    std::nth_element(v.begin(), mid, v.end());
+    return *mid;
+}
+
+} // namespace clas12::geometry::output::detail
+
+/**
+ * \brief write a list of numbers as the text of a node
+ *
+ * The explicit encoding is the numbers separated by spaces:
+ *
+ *     <x>1.5 2.5 3.5 4.6</x>
+ *
+ * The parametric encoding is for lists which, like the wire end
+ * points of a layer, are affine in the element index. It writes the
+ * number of values, the value of element zero and the step between
+ * elements, all at full precision, and the index and difference of
+ * any element further than tolerance from that line:
+ *
+ *     <x n="4" origin="1.5" stride="1">3:0.1</x>
+ *
+ * so element i is origin + i * stride, plus its residual if it has
+ * one. The step and origin are medians, so a few elements off the
+ * line (alignment, dead wires) do not spoil the fit of the others.
+ * Lists with residuals for more than a quarter of their elements are
+ * written explicitly instead.
+ * get_values() and expand_parametric() read both encodings back.
+ *
+ * \param [in] node the node to write into
+ * \param [in] values the numbers
+ * \param [in] parametric if false, the numbers are written explicitly
+ * \param [in] tolerance largest difference from the line that is not
+ *             sent, in the units of the values
+ **/
+inline
+void set_values(xml_node node, const vector<double>& values, bool parametric=false, double tolerance=parametric_tolerance)
+{
+    stringstream ss;
+
+    if (!parametric)
+    {
+        for (size_t i=0; i<values.size(); i++)
+        {
+            ss << (i == 0 ? "" : " ") << values[i];
+        }
+        node.append_child(pugi::node_pcdata).set_value(ss.str().c_str());
+        return;
+    }
+
+    double origin = 0;
+    double stride = 0;
+    if (values.size() > 1)
+    {
+        vector<double> steps(values.size() - 1);
+        for (size_t i=0; i<steps.size(); i++)
+        {
+            steps[i] = values[i+1] - values[i];
+        }
+        stride = detail::median(steps);
+    }
+    if (values.size() > 0)
+    {
+        vector<double> origins(values.size());
+        for (size_t i=0; i<values.size(); i++)
+        {
+            origins[i] = values[i] - i * stride;
+        }
+        origin = detail::median(origins);
+    }
+
+    // origin and stride are read back exactly, so the expander
+    // computes the same line as is checked here
+    bool first = true;
+    size_t nresiduals = 0;
+    for (size_t i=0; i<values.size(); i++)
+    {
+        double residual = values[i] - (origin + i * stride);
+        if (std::fabs(residual) > tolerance)
+        {
+            ss << (first ? "" : " ") << i << ":" << detail::exact_str(residual);
+            first = false;
+            nresiduals++;
+        }
+    }
+
+    // a list which is not close to a line is shorter written out
+    if (nresiduals > values.size() / 4)
+    {
+        set_values(node, values);
+        return;
+    }
+
+    node.append_attribute("n") = unsigned(values.size());
+    node.append_attribute("origin") = detail::exact_str(origin).c_str();
+    node.append_attribute("stride") = detail::exact_str(stride).c_str();
+    if (!first)
+    {
+        node.append_child(pugi::node_pcdata).set_value(ss.str().c_str());
+    }
+}
+
+/**
+ * \brief the numbers written into a node by set_values(), in
+ * either encoding
+ **/
+inline
+vector<double> get_values(const xml_node& node)
+{
+    vector<double> values;
+    stringstream ss(node.child_value());
+
+    if (!node.attribute("stride"))
+    {
+        double v;
+        while (ss >> v)
+        {
+            values.push_back(v);
+        }
+        return values;
+    }
+
+    size_t n = node.attribute("n").as_uint();
+    double origin = node.attribute("origin").as_double();
+    double stride = node.attribute("stride").as_double();
+    values.resize(n);
+    for (size_t i=0; i<n; i++)
+    {
+        values[i] = origin + i * stride;
+    }
+
+    size_t i;
+    char colon;
+    double residual;
+    while (ss >> i >> colon >> residual)
+    {
+        if (colon != ':' || i >= n)
+        {
+            throw runtime_error(
+                string("bad residual in parametric node: ") + node.name());
+        }
+        values[i] += residual;
+    }
+    return values;
+}
+
+/**
+ * \brief rewrite every parametric node in a document explicitly
+ *
+ * This is all a client needs to read a document generated with the
+ * parametric encoding as if it had been generated explicitly.
+ *
+ * \param [in] node the document or any node in it; the node and all
+ *             nodes below it are expanded
+ **/
+inline
+void expand_parametric(xml_node node)
+{
+    for (xml_node child : node.children())
+    {
+        if (child.type() == pugi::node_element)
+        {
+            expand_parametric(child);
+        }
+    }
+
+    if (node.attribute("stride"))
+    {
+        vector<double> values = get_values(node);
+        node.remove_attribute("n");
+        node.remove_attribute("origin");
+        node.remove_attribute("stride");
+        while (node.first_child())
+        {
+            node.remove_child(node.first_child());
+        }
+        set_values(node, values);
+    }
+}
+
+} // namespace clas12::geometry::output
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_OUTPUT_PARAMETRIC_HPP
@@ -18,6 +18,8 @@ using std::endl;
 #include "geometry/constants.hpp"
 
 #include "clas12/geometry/preshower_cal.hpp"
+#include "clas12/geometry/output/volume_placements.hpp"
+#include "clas12/stats.hpp"
 
 namespace clas12
 {
@@ -46,13 +48,15 @@ typedef map<string, map<string,string> > volmap_t;
  *     pDy     Half-length along y
  *     pDz     Half-length along z
  *
+ * \param [in] placements if true, identical volumes are emitted
+ *             once and placed as copies (see volume_placements())
  * \return map of map of strings: ret[volume_name][param_name] = value
  **/
 
 
 
 
-volmap_t pcal_volumes_map(const PreshowerCal& pcal)
+volmap_t pcal_volumes_map(const PreshowerCal& pcal, bool placements=false)
 {
     using namespace std;
     using namespace ::geometry;
@@ -391,7 +395,7 @@ volmap_t pcal_volumes_map(const PreshowerCal& pcal)
 
 
             /* posy = position of the strip relative to its mother volume (U view)*/
-            double y = -0.5*pcal_active_uheight + (is-0.5)*sector.layer(0).strip_width();
+            double y = -0.5*pcal_active_uheight + (is-0.5)*sector.layer(0).strip_width()
                                         + (2*is-1)*sector.layer(0).wrapper_thick();
 
             euclid_vector<> posy = {0,y,0};
@@ -560,7 +564,7 @@ volmap_t pcal_volumes_map(const PreshowerCal& pcal)
 
 
             /* posy = position of the strip relative to its mother volume (V view)*/
-            double y = 0.5*pcal_vw_height - (is-0.5)*sector.layer(0).strip_width();
+            double y = 0.5*pcal_vw_height - (is-0.5)*sector.layer(0).strip_width()
                                         - (2*is-1)*sector.layer(0).wrapper_thick();
 
             double x = -y*tan(gamma);
@@ -730,7 +734,7 @@ volmap_t pcal_volumes_map(const PreshowerCal& pcal)
 
 
             /* posy = position of the strip relative to its mother volume (W view)*/
-            double y = -0.5*pcal_active_vheight + (is-0.5)*sector.layer(0).strip_width();
+            double y = -0.5*pcal_active_vheight + (is-0.5)*sector.layer(0).strip_width()
                                         + (2*is-1)*sector.layer(0).wrapper_thick();
 
             double x = -y*tan(gamma);
@@ -798,10 +802,16 @@ volmap_t pcal_volumes_map(const PreshowerCal& pcal)
 
     } // loop over sectors
 
+    if (placements)
+    {
+        vols = volume_placements(vols);
+    }
+
+    stats::count("volumes", vols.size());
     return vols;
 }
 
-void pcal_volumes_xml(xml_document& doc, const PreshowerCal& pcal)
+void pcal_volumes_xml(xml_document& doc, const PreshowerCal& pcal, bool placements=false)
 {
     // start building up the XML document
     xml_node geom_node = doc.child("geometry");
@@ -820,7 +830,7 @@ void pcal_volumes_xml(xml_document& doc, const PreshowerCal& pcal)
         vol_node = pcal_node.append_child("volumes");
     }
 
-    for (auto k1 : pcal_volumes_map(pcal))
+    for (auto k1 : pcal_volumes_map(pcal, placements))
     {
         xml_node n1 = vol_node.append_child(k1.first.c_str());
 
@@ -0,0 +1,287 @@
+#ifndef CLAS12_GEOMETRY_OUTPUT_VOLUME_PLACEMENTS_HPP
+#define CLAS12_GEOMETRY_OUTPUT_VOLUME_PLACEMENTS_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clas12/hash.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+namespace output
+{
+
+using std::deque;
+using std::map;
+using std::set;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+typedef map<string, map<string,string> > volmap_t;
+
+namespace detail
+{
+
+/**
+ * \brief parameters that describe where a volume is placed or what it
+ * is called rather than what it is. These are left out when deciding
+ * if two volumes share a logical volume.
+ **/
+inline
+bool is_placement_param(const string& param)
+{
+    static const set<string> params{
+        "mother", "description", "pos", "rotation", "ncopy" };
+    return params.count(param) > 0;
+}
+
+/**
+ * \brief the sector number in a volume name, counting from one
+ *
+ * The generators name the volumes of a sector "sector<n>..." or
+ * "sec<n>..." (FTOF, PCAL) or end them with "_S<n>" (DC regions and
+ * layers).
+ *
+ * \return the sector number or 0 if the name has none
+ **/
+inline
+size_t sector_number(const string& name)
+{
+    auto digits = [&name](size_t pos)
+    {
+        size_t n = 0;
+        size_t end = pos;
+        while (end < name.size() && std::isdigit(name[end]))
+        {
+            n = 10 * n + (name[end] - '0');
+            end++;
+        }
+        return std::make_pair(n, end);
+    };
+
+    for (const string prefix : {"sector", "sec"})
+    {
+        if (name.compare(0, prefix.size(), prefix) == 0)
+        {
+            auto n = digits(prefix.size());
+            if (n.second > prefix.size())
+            {
+                return n.first;
+            }
+        }
+    }
+
+    for (size_t pos = name.find("_S"); pos != string::npos; pos = name.find("_S", pos + 1))
+    {
+        auto n = digits(pos + 2);
+        if (n.second > pos + 2 && (n.second == name.size() || name[n.second] == '_'))
+        {
+            return n.first;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief whether the identifiers of a volume take a value from its
+ * copy number, as "sector ncopy 0" does
+ **/
+inline
+bool uses_copy_number(const map<string,string>& params)
+{
+    auto ids = params.find("identifiers");
+    if (ids == params.end())
+    {
+        return false;
+    }
+    stringstream ss(ids->second);
+    string word;
+    while (ss >> word)
+    {
+        if (word == "ncopy")
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * \brief a key identifying the shape of a volume and everything placed
+ * inside of it (its daughters, their positions and their shapes).
+ *
+ * Two volumes with the same key can be represented by one Geant4
+ * logical volume with two placements.
+ *
+ * The daughters of a placement are those of its prototype, with the
+ * prototype's copy numbers. A volume whose identifiers take the sector
+ * from its copy number therefore has the sector in its key, and so
+ * does every volume it is inside of.
+ **/
+inline
+string logical_volume_key(
+    const string& name,
+    const volmap_t& vols,
+    const map<string,vector<string>>& daughters,
+    map<string,string>& keys)
+{
+    auto k = keys.find(name);
+    if (k != keys.end())
+    {
+        return k->second;
+    }
+
+    stringstream ss;
+    for (const auto& param : vols.at(name))
+    {
+        if (!is_placement_param(param.first))
+        {
+            ss << param.first << "=" << param.second << "\n";
+        }
+    }
+    if (uses_copy_number(vols.at(name)))
+    {
+        ss << "sector=" << sector_number(name) << "\n";
+    }
+
+    auto d = daughters.find(name);
+    if (d != daughters.end())
+    {
+        vector<string> dkeys;
+        for (const string& daughter : d->second)
+        {
+            const map<string,string>& params = vols.at(daughter);
+            dkeys.push_back(
+                params.at("pos") + "|" + params.at("rotation") + "|"
+                + logical_volume_key(daughter, vols, daughters, keys) );
+        }
+        std::sort(dkeys.begin(), dkeys.end());
+        for (const string& dk : dkeys)
+        {
+            ss << "daughter=" << dk << "\n";
+        }
+    }
+
+    string key = hash::hex(hash::fnv1a(ss.str()));
+    keys[name] = key;
+    return key;
+}
+
+} // namespace clas12::geometry::output::detail
+
+/**
+ * \brief convert a volume map into one logical volume per distinct
+ * shape and a list of placements
+ *
+ * The generators emit every volume of every sector explicitly. Here,
+ * volumes which are identical (same shape, material, sensitivity,
+ * identifiers and identical daughters at identical positions) are
+ * reduced to a single prototype. Every other instance is emitted as
+ * a placement of the prototype using gemc's "CopyOf" type, keeping
+ * its own mother, position and rotation. The daughters of a placement
+ * are not emitted since they come with the prototype's logical volume.
+ *
+ * The copy number (ncopy) of a volume of a sector is the sector number
+ * (see detail::sector_number()), since the identifiers "sector ncopy 0"
+ * take the sector from it. It stays right when some sectors are
+ * selected out or differ from the others. Volumes with no sector in
+ * their name are counted from one in name order.
+ *
+ * Sensitive volumes with such identifiers, the DC layers, FTOF paddles
+ * and EC/PCAL strips, are never shared between sectors and neither
+ * are their mothers (see detail::logical_volume_key()): a placement of
+ * the DC region R1_S1 as R1_S2 would record the hits in its layers as
+ * sector 1. Volumes without them, such as identical supports, become
+ * one prototype and a placement per sector.
+ *
+ * \param [in] vols map of volumes as returned by the *_volumes_map()
+ *             generators
+ * \return map of volumes: ret[volume_name][param_name] = value
+ **/
+inline
+volmap_t volume_placements(const volmap_t& vols)
+{
+    // daughters of every volume (sorted by name since vols is sorted)
+    map<string,vector<string>> daughters;
+    vector<string> roots;
+    for (const auto& vol : vols)
+    {
+        auto m = vol.second.find("mother");
+        if (m != vol.second.end() && vols.count(m->second))
+        {
+            daughters[m->second].push_back(vol.first);
+        }
+        else
+        {
+            roots.push_back(vol.first);
+        }
+    }
+
+    map<string,string> keys;
+
+    // prototype[key] = name of first volume with this key
+    map<string,string> prototype;
+    // number of instances seen for each key
+    map<string,size_t> ninstances;
+
+    volmap_t ret;
+
+    // walk the volume tree from the top so that a mother is always
+    // reduced before its daughters are considered.
+    deque<string> todo(roots.begin(), roots.end());
+    while (!todo.empty())
+    {
+        string name = todo.front();
+        todo.pop_front();
+
+        string key = detail::logical_volume_key(name, vols, daughters, keys);
+        size_t ninstance = ++ninstances[key];
+        size_t ncopy = detail::sector_number(name);
+        if (ncopy == 0)
+        {
+            ncopy = ninstance;
+        }
+
+        map<string,string> params = vols.at(name);
+
+        if (ninstance == 1)
+        {
+            prototype[key] = name;
+
+            auto d = daughters.find(name);
+            if (d != daughters.end())
+            {
+                todo.insert(todo.end(), d->second.begin(), d->second.end());
+            }
+        }
+        else
+        {
+            params["type"] = "CopyOf " + prototype[key];
+        }
+
+        stringstream ncopy_ss;
+        ncopy_ss << ncopy;
+        params["ncopy"] = ncopy_ss.str();
+
+        ret[name] = params;
+    }
+
+    return ret;
+}
+
+} // namespace clas12::geometry::output
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_OUTPUT_VOLUME_PLACEMENTS_HPP
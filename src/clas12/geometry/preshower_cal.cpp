@@ -13,6 +13,7 @@ using std::endl;
 #include "preshower_cal.hpp"
 
 #include "clas12/log.hpp"
+#include "clas12/stats.hpp"
 
 namespace clas12
 {
@@ -89,6 +90,8 @@ PreshowerCal::PreshowerCal( Calibration* calib,
  **/
 void PreshowerCal::fetch_nominal_parameters(Calibration* calib)
 {
+    stats::ScopedTimer timer("fetch pcal");
+
     LOG(debug) << "PreshowerCal::fetch_nominal_parameters()...";
     static const double deg2rad = 3.14159265358979 / 180.;
 
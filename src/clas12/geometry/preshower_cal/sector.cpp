@@ -1,4 +1,6 @@
+#include <cmath>
 #include <cstddef>
+#include <stdexcept>
 
 #include "clas12/geometry/preshower_cal.hpp"
 
@@ -9,6 +11,10 @@ namespace geometry
 namespace preshower_cal
 {
 
+using std::cos;
+using std::sin;
+using std::runtime_error;
+
 using ::clas12::geometry::PreshowerCal;
 
 /**
@@ -108,6 +114,39 @@ plane<double> Sector::sector_to_clas(const plane<double>& p) const
         this->sector_to_clas(p.normal()) };
 }
 
+/**
+ * \brief the plane of the front of the PCal in this sector
+ *
+ * The plane passes through the PCal coordinate center, at dist2tgt
+ * from the target along the normal which is in the sector mid-plane
+ * and tilted from the beam line by thtilt.
+ *
+ * \param [in] coordsys the coordinate system: SECTOR or CLAS
+ * \return plane(point on plane, normal) (cm)
+ **/
+plane<double> Sector::face_plane(coordsys_t coordsys) const
+{
+    direction_vector<double,3> normal{0., _thtilt};
+    euclid_vector<double,3> point{
+        _dist2tgt * sin(_thtilt),
+        0.,
+        _dist2tgt * cos(_thtilt) };
+    plane<double> p{point, normal};
+
+    switch (coordsys)
+    {
+        case COORDSYS::SECTOR:
+            break;
+        case COORDSYS::CLAS:
+            p = this->sector_to_clas(p);
+            break;
+        default:
+            throw runtime_error("can not calculate face plane in "+coord2str(coordsys)+" coordinates");
+            break;
+    }
+    return p;
+}
+
 
 } // namespace clas12::geometry::preshower_cal
 } // namespace clas12::geometry
@@ -71,6 +71,8 @@ class Sector
     line_segment<double,3>     sector_to_clas(const line_segment<double,3>& l    ) const;
     plane<double>              sector_to_clas(const plane<double>& p             ) const;
 
+    plane<double> face_plane(coordsys_t coordsys=COORDSYS::SECTOR) const;
+
 
   private:
     Sector(const PreshowerCal* pcal, size_t idx);
@@ -1,5 +1,6 @@
 #include "request.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <ctime>
 #include <sstream>
@@ -15,8 +16,12 @@
 
 #include "clas12/geometry.hpp"
 #include "clas12/geometry/coordsys.hpp"
+#include "clas12/geometry/detector_cache.hpp"
 #include "clas12/geometry/output.hpp"
+#include "clas12/geometry/version.hpp"
 
+#include "clas12/ccdb/fingerprint.hpp"
+#include "clas12/ccdb/memory_calibration.hpp"
 #include "clas12/ccdb/parse_timestamp.hpp"
 
 namespace clas12
@@ -47,6 +52,76 @@ using ccdb::ConstantSetInfo;
 
 using clas12::ccdb::parse_timestamp;
 
+/**
+ * \brief split a list of request items, leaving selectors whole
+ * \param [in] items for example "dc/volumes[sector=1,region=2] ftof/volumes"
+ * \return the items with their selectors
+ **/
+static vector<string> split_items(const string& items)
+{
+    static const string separators = " ,;:|";
+
+    vector<string> ret;
+    string current;
+    int depth = 0;
+    for (char c : items)
+    {
+        if (c == '[')
+        {
+            depth++;
+        }
+        else if (c == ']')
+        {
+            depth--;
+        }
+
+        if (depth == 0 && separators.find(c) != string::npos)
+        {
+            if (current != "")
+            {
+                ret.push_back(current);
+            }
+            current.clear();
+        }
+        else
+        {
+            current += c;
+        }
+    }
+    if (current != "")
+    {
+        ret.push_back(current);
+    }
+    return ret;
+}
+
+/**
+ * \brief the keys the selector of each request item may use
+ * \return map of "system/item" to keys
+ **/
+static const map<string,vector<string>>& selector_keys()
+{
+    static const map<string,vector<string>> keys{
+        {"dc/wire_endpoints", {"sector", "region", "superlayer"}},
+        {"dc/volumes", {"sector", "region", "superlayer"}},
+        {"ftof/panels_parms", {"sector", "panel"}},
+        {"ftof/volumes", {"sector", "panel"}},
+        {"bst/strip_endpoints", {"region", "sector", "layer"}} };
+    return keys;
+}
+
+/**
+ * \brief the detectors shared by all requests in this process
+ * \param [in] name the detector's key in ccdb_tables()
+ * \return reference to a static DetectorCache
+ **/
+template <class Detector>
+DetectorCache<Detector>& detector_cache(const string& name)
+{
+    static DetectorCache<Detector> cache(name);
+    return cache;
+}
+
 const string Request::desc =
 R"(Returns the expanded geometry parameters as an XML string.
 The request can be a list (comma or space separated) of those
@@ -56,25 +131,65 @@ Note that volumes are always in CLAS coordinates and in cm, and
 therefore the units and coordsys arguments are ignored for
 requests like dc/volumes
 
+An item may be followed by a selector in brackets which limits it
+to part of the detector, for example:
+
+    dc/wire_endpoints[sector=2,superlayer=3-4]
+    ftof/volumes[panel=1b]
+    dc/volumes[sector=1|4]
+
+Only the selected part is computed and returned. Sectors, regions,
+superlayers (1 to 6 across the DC regions) and layers count from
+one. The keys each item accepts are:
+
+    dc/wire_endpoints, dc/volumes:       sector, region, superlayer
+    ftof/panels_parms, ftof/volumes:     sector, panel (1a, 1b, 2)
+    bst/strip_endpoints:                 region, sector, layer
+
+With compression set, the XML is compressed for transport by the
+caller (the service or clas12geom). The result is the same XML, and
+requests differing only in compression share one computation.
+
+With encoding set to parametric, the coordinates of the DC wire end
+points, FTOF paddle centers and lengths and BST strip end points of
+each layer (or panel) are sent as a line in the element index
+(attributes n, origin and stride) plus the residuals of elements off
+that line by more than 1e-6 cm ("index:residual" as text). Element i
+is origin + i * stride plus its residual. Other items are not
+affected. Clients can expand such a document with
+clas12::geometry::output::expand_parametric().
+
+With placements set, volumes which are identical in all sectors
+are listed once and every other sector gets a placement of type
+"CopyOf <volume>" with its own position and copy number (ncopy).
+Sensitive volumes which take the sector from their copy number, and
+the volumes they are in, are listed for every sector.
+
 The run number, variation and timestamp default to the standard
 CCDB defaults: i.e. the last run number, "default" variation,
 and current time.
 
-The sqlite and mysql options are mutually exclusive and not
-all the mysql options need to be used - only those you wish
+The sqlite, fixture and mysql options are mutually exclusive and
+not all the mysql options need to be used - only those you wish
 to change. The sqlite option is not set by default (mysql is
 used) and the mysql-password is blank as the default user,
-clas12reader, does not have an associated password.
+clas12reader, does not have an associated password. A fixture
+is a file of geometry tables written by clas12-ccdb-fixture.
 
 Input options:
     units:    (m|cm|mm)         [default: cm]
     coordsys: (clas|sector)     [default: clas]
+    placements: (true|false)    [default: false]
+    encoding: (explicit|parametric) [default: explicit]
+    compression: (none|zlib|zstd|lz4) [default: none]
     request:
               dc/wire_endpoints
               dc/volumes
               dc/core_params
               ftof/panels_parms
               ftof/volumes
+              pcal/volumes
+              bst/strip_endpoints   (clas coordinates, mm or cm only)
 
     run:      <int>             [default: <blank>]
     variation <string>          [default: default]
@@ -82,6 +197,8 @@ Input options:
 
     sqlite:
               /path/to/file     [default: <not set>]
+    fixture:
+              /path/to/file     [default: <not set>]
 
     mysql-host: hostname        [default: clasdb.jlab.org]
     mysql-user: username        [default: clas12reader]
@@ -98,13 +215,17 @@ Request::Request(const map<string,string>& req)
     // defaults
     units = "cm";
     coords = "clas";
+    placements = false;
+    parametric = false;
+    output_codec = compression::Codec::none;
 
     bool mysql_info = false;
     bool sqlite_info = false;
+    bool fixture_info = false;
+    string fixture_path;
 
     ConnectionInfoMySQL conninfo_mysql;
     ConnectionInfoSQLite conninfo_sqlite;
-    ConstantSetInfo csinfo;
 
     map<string,string> reqs = this->to_lower(req);
 
@@ -118,17 +239,68 @@ Request::Request(const map<string,string>& req)
         {
             coords = r.second;
         }
+        else if (r.first == "placements")
+        {
+            placements = (r.second == "true" || r.second == "yes" || r.second == "1");
+        }
+        else if (r.first == "encoding")
+        {
+            if (r.second != "explicit" && r.second != "parametric")
+            {
+                throw invalid_argument("unknown encoding: " + r.second);
+            }
+            parametric = (r.second == "parametric");
+        }
+        else if (r.first == "compression")
+        {
+            output_codec = compression::codec(r.second);
+            if (!compression::available(output_codec))
+            {
+                throw invalid_argument(
+                    "compression not available in this build: " + r.second);
+            }
+        }
         else if (r.first == "request")
         {
-            vector<string> items;
-            split(items, r.second, is_any_of(" ,;:|"));
-
-            for (const auto& i : items)
+            for (const auto& i : split_items(r.second))
             {
+                string name = i;
+                Selection sel;
+                size_t open = i.find('[');
+                if (open != string::npos)
+                {
+                    if (i.back() != ']')
+                    {
+                        throw invalid_argument("unterminated selector in request: " + i);
+                    }
+                    name = i.substr(0, open);
+                    sel = Selection(i.substr(open + 1, i.size() - open - 2));
+                }
+
                 vector<string> item;
-                split(item, i, is_any_of("/."));
+                split(item, name, is_any_of("/."));
+                if (item.size() != 2)
+                {
+                    throw invalid_argument("bad request item: " + i);
+                }
 
-                request[item[0]].push_back(item[1]);
+                const string key = item[0] + "/" + item[1];
+                vector<string>& items = request[item[0]];
+                bool requested = std::find(items.begin(), items.end(), item[1]) != items.end();
+                if (requested && (!sel.all() || selections.count(key)))
+                {
+                    throw invalid_argument(
+                        "selectors of " + key + " must be given in one item");
+                }
+
+                if (!sel.all())
+                {
+                    auto keys = selector_keys().find(key);
+                    sel.check_keys(key, keys == selector_keys().end()
+                        ? vector<string>() : keys->second);
+                    selections[key] = sel;
+                }
+                items.push_back(item[1]);
             }
         }
         else if (r.first == "run")
@@ -162,6 +334,18 @@ Request::Request(const map<string,string>& req)
             sqlite_info = true;
             conninfo_sqlite.filepath = r.second;
         }
+        else if (r.first == "fixture")
+        {
+            // the path as given: to_lower() changed its case
+            fixture_info = true;
+            for (const auto& o : req)
+            {
+                if (to_lower_copy(o.first) == "fixture")
+                {
+                    fixture_path = o.second;
+                }
+            }
+        }
         else if (r.first == "mysql-user")
         {
             mysql_info = true;
@@ -177,6 +361,11 @@ Request::Request(const map<string,string>& req)
             mysql_info = true;
             conninfo_mysql.host = r.second;
         }
+        else if (r.first == "mysql-database")
+        {
+            mysql_info = true;
+            conninfo_mysql.database = r.second;
+        }
         else if (r.first == "mysql-port")
         {
             mysql_info = true;
@@ -191,20 +380,87 @@ Request::Request(const map<string,string>& req)
         }
     }
 
-    if (sqlite_info && mysql_info)
+    if (int(sqlite_info) + int(mysql_info) + int(fixture_info) > 1)
+    {
+        throw invalid_argument("mysql, sqlite and fixture options are mutually exclusive.");
+    }
+    else if (fixture_info)
     {
-        throw invalid_argument("mysql and sqlite options are mutually exclusive.");
+        connstr = ccdb::MemoryCalibration::prefix() + fixture_path;
+        connid = connstr;
     }
     else if (sqlite_info)
     {
-        this->calib = get_calibration(conninfo_sqlite, csinfo);
+        connstr = conninfo_sqlite.connection_string();
+        connid = connstr;
     }
     else // MySQL
     {
-        this->calib = get_calibration(conninfo_mysql, csinfo);
+        connstr = conninfo_mysql.connection_string();
+        conninfo_mysql.password = "";
+        connid = conninfo_mysql.connection_string();
     }
 }
 
+/**
+ * \brief the calibration (database connection) used by this request
+ *
+ * The connection is taken from ccdb::ConnectionPool::global() on
+ * first use so that a request which is served from a cache never
+ * touches the database. It is given back when the request is
+ * destroyed.
+ *
+ * \return pointer to the Calibration held by Request::calib
+ **/
+Calibration* Request::calibration()
+{
+    if (!calib)
+    {
+        calib = ccdb::ConnectionPool::global().acquire(connstr, csinfo);
+    }
+    return calib.get();
+}
+
+/**
+ * \brief the tables of one detector, read into memory
+ *
+ * Tables are read from calibration() the first time they are asked
+ * for and kept in Request::tables, so etag() and the generate
+ * methods read each table once.
+ *
+ * \param [in] sys the detector's key in ccdb_tables(), for example "dc"
+ * \return pointer to Request::tables
+ **/
+Calibration* Request::geometry_tables(const string& sys)
+{
+    vector<string> missing;
+    for (const auto& path : ccdb_tables().at(sys))
+    {
+        if (!tables.has_table(path))
+        {
+            missing.push_back(path);
+        }
+    }
+    if (missing.size() > 0)
+    {
+        tables.copy_tables(this->calibration(), missing);
+    }
+    return &tables;
+}
+
+/**
+ * \brief the selector of a request item
+ * \param [in] sys the system, for example "dc"
+ * \param [in] item the item, for example "volumes"
+ * \return the Selection, which selects everything if there is none
+ **/
+const Selection& Request::selection(const string& sys, const string& item) const
+{
+    static const Selection everything;
+    auto s = selections.find(sys + "/" + item);
+    return s == selections.end() ? everything : s->second;
+}
+
 map<string,string> Request::to_lower(const map<string,string>& request)
 {
     map<string,string> translated_request;
@@ -220,6 +476,9 @@ string Request::generate_xml()
 {
     using namespace output;
 
+    stats::Collector collector(req_stats);
+    stats::ScopedTimer timer("generate_xml");
+
     try
     {
         if (request.size() < 1)
@@ -235,13 +494,16 @@ string Request::generate_xml()
 
             if (sys == "dc")
             {
-                DriftChamber dc(calib.get());
+                auto shared_dc = detector_cache<DriftChamber>("dc").get(this->geometry_tables("dc"));
+                const DriftChamber& dc = *shared_dc;
 
                 for (const auto& item : req.second)
                 {
+                    stats::ScopedTimer output_timer("output " + sys + "/" + item);
+
                     if (item == "wire_endpoints")
                     {
-                        dc_wire_endpoints_xml(doc, dc, coords, units);
+                        dc_wire_endpoints_xml(doc, dc, coords, units, this->selection(sys, item), parametric);
                     }
                     else if (item == "core_params")
                     {
@@ -249,7 +511,7 @@ string Request::generate_xml()
                     }
                     else if (item == "volumes")
                     {
-                        dc_volumes_xml(doc, dc);
+                        dc_volumes_xml(doc, dc, placements, this->selection(sys, item));
                     }
                     else
                     {
@@ -261,12 +523,39 @@ string Request::generate_xml()
                     }
                 }
             }
+            else if (sys == "bst")
+            {
+                auto shared_svt = detector_cache<CentralTracker>("bst").get(this->geometry_tables("bst"));
+                const CentralTracker& svt = *shared_svt;
+
+                for (const auto& item : req.second)
+                {
+                    stats::ScopedTimer output_timer("output " + sys + "/" + item);
+
+                    if (item == "strip_endpoints" && coords == "clas")
+                    {
+                        // the BST's LAB frame is the CLAS frame
+                        bst_strip_endpoints_xml(doc, svt.bst(), "LAB", units, this->selection(sys, item), parametric);
+                    }
+                    else
+                    {
+                        string err = "Error: Bad request for BST geometry:"
+                            " bst/" + item +
+                            ", " + coords + " coordinates"
+                            ", " + units + "\n";
+                        return err;
+                    }
+                }
+            }
             else if (sys == "pcal")
             {
-                PreshowerCal pcal(calib.get());
+                auto shared_pcal = detector_cache<PreshowerCal>("pcal").get(this->geometry_tables("pcal"));
+                const PreshowerCal& pcal = *shared_pcal;
 
                 for (const auto& item : req.second)
                 {
+                    stats::ScopedTimer output_timer("output " + sys + "/" + item);
+
                     if (item == "strip_endpoints")
                     {
                         //strip_wire_endpoints_xml(doc, pcal, coords, units);
@@ -277,7 +566,7 @@ string Request::generate_xml()
                     }
                     else if (item == "volumes")
                     {
-                        //pcal_volumes_xml(doc, pcal);
+                        pcal_volumes_xml(doc, pcal, placements);
                     }
                     else
                     {
@@ -291,17 +580,20 @@ string Request::generate_xml()
             }
             else if (sys == "ftof")
             {
-                ForwardTOF ftof(calib.get());
+                auto shared_ftof = detector_cache<ForwardTOF>("ftof").get(this->geometry_tables("ftof"));
+                const ForwardTOF& ftof = *shared_ftof;
 
                 for (const auto& item : req.second)
                 {
+                    stats::ScopedTimer output_timer("output " + sys + "/" + item);
+
                     if (item == "panels_parms")
                     {
-                        ftof_panels_parms_xml(doc, ftof, coords, units);
+                        ftof_panels_parms_xml(doc, ftof, coords, units, this->selection(sys, item), parametric);
                     }
                     else if (item == "volumes")
                     {
-                        ftof_volumes_xml(doc, ftof);
+                        ftof_volumes_xml(doc, ftof, placements, this->selection(sys, item));
                     }
                     else
                     {
@@ -321,9 +613,12 @@ string Request::generate_xml()
             }
         }
 
+        stats::ScopedTimer serialize_timer("xml serialize");
         stringstream doc_ss;
         doc.save(doc_ss); // serialize XML doc to string
-        return doc_ss.str();
+        string xml = doc_ss.str();
+        stats::count("xml bytes", xml.size());
+        return xml;
     }
     catch (runtime_error& e)
     {
@@ -345,6 +640,9 @@ volmap_t Request::generate_volmap()
 {
     using namespace output;
 
+    stats::Collector collector(req_stats);
+    stats::ScopedTimer timer("generate_volmap");
+
     try
     {
         if (request.size() < 1)
@@ -360,13 +658,16 @@ volmap_t Request::generate_volmap()
 
             if (sys == "dc")
             {
-                DriftChamber dc(calib.get());
+                auto shared_dc = detector_cache<DriftChamber>("dc").get(this->geometry_tables("dc"));
+                const DriftChamber& dc = *shared_dc;
 
                 for (const auto& item : req.second)
                 {
+                    stats::ScopedTimer output_timer("output " + sys + "/" + item);
+
                     if (item == "volumes")
                     {
-                        volmap_t tmp = dc_volumes_map(dc);
+                        volmap_t tmp = dc_volumes_map(dc, placements, this->selection(sys, item));
                         vmap.insert(tmp.begin(), tmp.end());
                     }
                     else
@@ -377,18 +678,42 @@ volmap_t Request::generate_volmap()
                     }
                 }
             }
+            else if (sys == "pcal")
+            {
+                auto shared_pcal = detector_cache<PreshowerCal>("pcal").get(this->geometry_tables("pcal"));
+                const PreshowerCal& pcal = *shared_pcal;
+
+                for (const auto& item : req.second)
+                {
+                    stats::ScopedTimer output_timer("output " + sys + "/" + item);
+
+                    if (item == "volumes")
+                    {
+                        volmap_t tmp = pcal_volumes_map(pcal, placements);
+                        vmap.insert(tmp.begin(), tmp.end());
+                    }
+                    else
+                    {
+                        string err = "Error: Bad request for PCAL geometry:"
+                            " pcal/" + item + "\n";
+                        throw runtime_error(err);
+                    }
+                }
+            }
             else if (sys == "ftof")
             {
                 cout << "fetching FTOF geometry...\n";
-                ForwardTOF ftof(calib.get());
+                auto shared_ftof = detector_cache<ForwardTOF>("ftof").get(this->geometry_tables("ftof"));
+                const ForwardTOF& ftof = *shared_ftof;
                 cout << "done.\n";
 
                 for (const auto& item : req.second)
                 {
+                    stats::ScopedTimer output_timer("output " + sys + "/" + item);
 
                     if (item == "volumes")
                     {
-                        volmap_t tmp = ftof_volumes_map(ftof);
+                        volmap_t tmp = ftof_volumes_map(ftof, placements, this->selection(sys, item));
                         vmap.insert(tmp.begin(), tmp.end());
                     }
                     else
@@ -425,6 +750,96 @@ volmap_t Request::generate_volmap()
 }
 
 
+/**
+ * \brief a key which uniquely identifies the output of this request
+ *
+ * The key contains the requested items with their selectors,
+ * coordinate system, units, encoding, database (without password) and
+ * constant set. It is used to store and find the generated geometry
+ * in caches.
+ *
+ * \return the key as a string with one "name=value" per line
+ **/
+string Request::cache_key() const
+{
+    stringstream ss;
+
+    ss << "request=";
+    bool first = true;
+    for (const auto& sys : request)
+    {
+        for (const auto& item : sys.second)
+        {
+            ss << (first ? "" : ",") << sys.first << "/" << item
+               << this->selection(sys.first, item).str();
+            first = false;
+        }
+    }
+    ss << "\n";
+
+    ss << "coordsys=" << coords << "\n";
+    ss << "units=" << units << "\n";
+    ss << "placements=" << placements << "\n";
+    ss << "encoding=" << (parametric ? "parametric" : "explicit") << "\n";
+    ss << "connection=" << connid << "\n";
+    ss << "run=" << csinfo.run << "\n";
+    ss << "variation=" << csinfo.variation << "\n";
+    ss << "timestamp=" << csinfo.timestamp << "\n";
+
+    return ss.str();
+}
+
+/**
+ * \brief a hash of the geometry this request generates
+ *
+ * The hash combines the library version, the requested items,
+ * coordinate system, units, placements and encoding, and the
+ * fingerprints of the contents of the tables the requested detectors
+ * are built from (see ccdb::fingerprint()). It does not depend on the run, variation,
+ * timestamp or database: two requests get the same etag exactly when
+ * they generate the same output. Only the tables are read, so this is
+ * much cheaper than generate_xml() and lets a client which holds the
+ * output already skip fetching it again.
+ *
+ * Systems which are not known are hashed by name only;
+ * generate_xml() returns an error for them.
+ *
+ * \return 16 hexadecimal digits
+ **/
+string Request::etag()
+{
+    stats::Collector collector(req_stats);
+    stats::ScopedTimer timer("etag");
+
+    ccdb::Fingerprint fp;
+    fp.add(library_version);
+    fp.add(coords);
+    fp.add(units);
+    fp.add(placements ? "placements" : "");
+    fp.add(parametric ? "parametric" : "");
+
+    for (const auto& sys : request)
+    {
+        fp.add(sys.first);
+        for (const auto& item : sys.second)
+        {
+            fp.add(item + this->selection(sys.first, item).str());
+        }
+
+        auto paths = ccdb_tables().find(sys.first);
+        if (paths != ccdb_tables().end())
+        {
+            this->geometry_tables(sys.first);
+            for (const auto& path : paths->second)
+            {
+                fp.add(path).add(ccdb::fingerprint(tables.table(path)));
+            }
+        }
+    }
+
+    return fp.hex();
+}
+
 string Request::info()
 {
     stringstream ss;
@@ -432,13 +847,15 @@ string Request::info()
 
     ss << "  coords: " << coords << "\n";
     ss << "  units:  " << units << "\n";
+    ss << "  placements: " << boolalpha << placements << noboolalpha << "\n";
+    ss << "  encoding: " << (parametric ? "parametric" : "explicit") << "\n";
 
     for (auto i : request)
     {
         ss << "  system: " << i.first << "\n";
         for (auto j : i.second)
         {
-            ss << "    " << j << "\n";
+            ss << "    " << j << this->selection(i.first, j).str() << "\n";
         }
     }
 
@@ -6,7 +6,12 @@
 #include <string>
 #include <vector>
 
+#include "clas12/ccdb/connection_pool.hpp"
 #include "clas12/ccdb/constants_table.hpp"
+#include "clas12/ccdb/memory_calibration.hpp"
+#include "clas12/compression.hpp"
+#include "clas12/geometry/selection.hpp"
+#include "clas12/stats.hpp"
 
 namespace clas12
 {
@@ -33,19 +38,89 @@ class Request
     volmap_t generate_volmap();
 
     string info();
+    string cache_key() const;
+    string etag();
+    const ConstantSetInfo& constant_set() const;
+    compression::Codec codec() const;
+    const stats::Stats& statistics() const;
 
   private:
     map<string,vector<string>> request;
 
+    /// \brief selectors of the request items by "system/item";
+    /// items not listed are not limited
+    map<string,Selection> selections;
+
     string coords;
     string units;
 
-    unique_ptr<Calibration> calib;
+    /// \brief emit identical volumes once plus placements
+    bool placements;
+
+    /// \brief send wire and strip positions as lines in the element
+    /// index plus residuals (see output::set_values())
+    bool parametric;
+
+    /// \brief how the output is to be compressed for transport
+    compression::Codec output_codec;
+
+    /// \brief database connection string
+    string connstr;
+
+    /// \brief connection string without the password,
+    /// used to identify the database in cache keys
+    string connid;
+
+    /// \brief connection leased from the global pool on first use
+    ccdb::PooledCalibration calib;
     ConstantSetInfo csinfo;
 
+    /// \brief geometry tables read so far, shared by etag() and
+    /// the generate methods so that each is read once
+    ccdb::MemoryCalibration tables;
+
+    /// \brief timers and counters of the generate methods
+    stats::Stats req_stats;
+
+    Calibration* calibration();
+    Calibration* geometry_tables(const string& sys);
+    const Selection& selection(const string& sys, const string& item) const;
+
     map<string,string> to_lower(const map<string,string>& req);
 };
 
+/**
+ * \brief the run, variation and timestamp of this request
+ * \return const reference to Request::csinfo
+ **/
+inline
+const ConstantSetInfo& Request::constant_set() const
+{
+    return csinfo;
+}
+
+/**
+ * \brief the compression asked for; generate_xml() itself always
+ * returns the plain XML
+ * \return copy of Request::output_codec
+ **/
+inline
+compression::Codec Request::codec() const
+{
+    return output_codec;
+}
+
+/**
+ * \brief time spent in each stage and things counted by
+ * generate_xml() and generate_volmap(), summed over all calls
+ * \return const reference to Request::req_stats
+ **/
+inline
+const stats::Stats& Request::statistics() const
+{
+    return req_stats;
+}
+
 } // namespace clas12::geometry
 } // namespace clas12
 
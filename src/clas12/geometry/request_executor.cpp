@@ -0,0 +1,646 @@
+#include "request_executor.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <exception>
+#include <stdexcept>
+#include <sstream>
+#include <utility>
+
+#include <boost/algorithm/string.hpp>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::lock_guard;
+using std::move;
+using std::mutex;
+using std::stringstream;
+using std::unique_lock;
+
+/**
+ * \brief start the worker threads and the prefetch thread
+ * \param [in] nworkers number of threads, 0 for one per core
+ * \param [in] max_pending most distinct requests waiting for a worker
+ * \param [in] max_cached most results kept, 0 to keep none
+ * \param [in] max_age how long a result is kept
+ **/
+RequestExecutor::RequestExecutor(
+    size_t nworkers,
+    size_t max_pending,
+    size_t max_cached,
+    clock_type::duration max_age)
+: _max_pending(max_pending > 0 ? max_pending : 1)
+, _max_cached(max_cached)
+, _max_age(max_age)
+, _prefetch_ahead(0)
+, _stopping(false)
+{
+    if (nworkers == 0)
+    {
+        nworkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i=0; i<nworkers; i++)
+    {
+        _workers.emplace_back(&RequestExecutor::work, this);
+    }
+    _prefetcher = std::thread(&RequestExecutor::prefetch_work, this);
+}
+
+/**
+ * \brief finish the submitted requests, drop the prefetches and stop
+ * the threads
+ **/
+RequestExecutor::~RequestExecutor()
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _have_task.notify_all();
+    _have_room.notify_all();
+    _have_prefetch.notify_all();
+    for (auto& w : _workers)
+    {
+        w.join();
+    }
+    _prefetcher.join();
+}
+
+/**
+ * \brief look for a cached or in-flight result, with the lock held
+ *
+ * A prefetch that was not yet started is moved to the workers' queue
+ * since it is now waited for.
+ *
+ * \param [in] key the normalized request
+ * \param [in] start when the request was submitted
+ * \param [out] future set to the result if found
+ * \return true if found
+ **/
+bool RequestExecutor::find(
+    const string& key,
+    const clock_type::time_point& start,
+    future_type& future)
+{
+    auto c = _cache.find(key);
+    if (c != _cache.end())
+    {
+        if (start - c->second.done <= _max_age)
+        {
+            _stats.cached++;
+            _cache_order.splice(_cache_order.begin(), _cache_order, c->second.order);
+            _latency.record(std::chrono::duration<double>(clock_type::now() - start).count());
+            future = c->second.future;
+            return true;
+        }
+        _cache_order.erase(c->second.order);
+        _cache.erase(c);
+    }
+
+    auto f = _in_flight.find(key);
+    if (f != _in_flight.end())
+    {
+        _stats.coalesced++;
+        f->second.submitted.push_back(start);
+        future = f->second.future;
+
+        auto p = std::find_if(_prefetch_queue.begin(), _prefetch_queue.end(),
+            [&key](const Task& t) { return t.key == key; });
+        if (p != _prefetch_queue.end())
+        {
+            _stats.promoted++;
+            p->prefetch = false;
+            _queue.push_back(move(*p));
+            _prefetch_queue.erase(p);
+            _have_task.notify_one();
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * \brief queue a request or join an identical one in flight
+ *
+ * The request is parsed here so that invalid input throws at once,
+ * as it does when constructing a Request.
+ *
+ * \param [in] req the request options (see Request::desc)
+ * \return future holding the result
+ **/
+RequestExecutor::future_type RequestExecutor::submit(const map<string,string>& req)
+{
+    const clock_type::time_point start = clock_type::now();
+
+    std::unique_ptr<Request> request(new Request(req));
+    string key = request->cache_key();
+
+    unique_lock<mutex> lock(_mutex);
+    _stats.submitted++;
+
+    future_type future;
+    if (this->find(key, start, future))
+    {
+        return future;
+    }
+
+    if (_queue.size() >= _max_pending)
+    {
+        _stats.throttled++;
+        _have_room.wait(lock, [this]()
+        {
+            return _stopping || _queue.size() < _max_pending;
+        });
+        if (_stopping)
+        {
+            throw std::runtime_error("request executor is shutting down");
+        }
+
+        // an identical request may have been queued while waiting
+        if (this->find(key, start, future))
+        {
+            return future;
+        }
+    }
+
+    Task task;
+    task.key = key;
+    task.options = req;
+    task.request = move(request);
+
+    InFlight& in_flight = _in_flight[key];
+    in_flight.future = task.promise.get_future().share();
+    in_flight.submitted.push_back(start);
+    future = in_flight.future;
+
+    _queue.push_back(move(task));
+    lock.unlock();
+    _have_task.notify_one();
+
+    return future;
+}
+
+/**
+ * \brief submit a request and wait for its result
+ * \param [in] req the request options (see Request::desc)
+ * \return the result
+ **/
+RequestResult RequestExecutor::execute(const map<string,string>& req)
+{
+    return this->submit(req).get();
+}
+
+/**
+ * \brief the hash of the output of a request (see Request::etag())
+ *
+ * A kept result gives its etag at once; otherwise only the constants
+ * tables are read, in the calling thread.
+ *
+ * \param [in] req the request options (see Request::desc)
+ * \return 16 hexadecimal digits
+ **/
+string RequestExecutor::etag(const map<string,string>& req)
+{
+    Request request(req);
+    future_type kept;
+    {
+        lock_guard<mutex> lock(_mutex);
+        auto c = _cache.find(request.cache_key());
+        if (c != _cache.end()
+            && clock_type::now() - c->second.done <= _max_age)
+        {
+            kept = c->second.future;
+        }
+    }
+
+    // the result may be kept an instant before it is set
+    if (kept.valid())
+    {
+        return kept.get().etag;
+    }
+    return request.etag();
+}
+
+/**
+ * \brief answer a request as the geometry services do
+ *
+ * This is shared by the GeometryService and the SocketServer, which
+ * only differ in how the reply is sent. If if_none_match is the etag
+ * of the output, the reply is "Not modified" and nothing is
+ * generated. Invalid requests and failed generation give an "Error"
+ * reply whose data is the message; nothing is thrown. Otherwise the
+ * data is the XML, compressed if the request asks for it, and the
+ * description holds the etag and a summary of the stats.
+ *
+ * \param [in] req the request options (see Request::desc)
+ * \param [in] if_none_match etag of the output the client holds
+ *             already, optionally in quotes, or ""
+ * \return the reply
+ **/
+ServiceReply RequestExecutor::respond(
+    const map<string,string>& req,
+    const string& if_none_match)
+{
+    ServiceReply reply;
+
+    // not modified: the client holds this output already
+    string held = boost::trim_copy_if(if_none_match, boost::is_any_of("\" "));
+    if (held != "")
+    {
+        try
+        {
+            string tag = this->etag(req);
+            if (tag == held)
+            {
+                reply.status = "Not modified";
+                reply.description = "Not modified; etag: " + tag;
+                reply.data = "Not modified";
+                return reply;
+            }
+        }
+        catch (std::exception&)
+        {
+            // the full request reports the error
+        }
+    }
+
+    // identical requests from many clients share one computation
+    RequestResult result;
+    try
+    {
+        result = this->execute(req);
+    }
+    catch (std::exception& e)
+    {
+        result.xml = string("Error: Bad request for geometry.\n") + e.what();
+    }
+    reply.info = move(result.info);
+    reply.statistics = move(result.statistics);
+
+    // the output must not begin with "Error"
+    if (result.xml.compare(0, 5, "Error") == 0)
+    {
+        reply.status = "Error";
+        reply.description = "Error message";
+        reply.data = move(result.xml);
+        return reply;
+    }
+
+    // the request was accepted so the codec name is valid
+    auto c = req.find("compression");
+    if (c != req.end())
+    {
+        reply.codec = compression::codec(c->second);
+    }
+
+    // stage timings and counters ride along in the description
+    string description = "; etag: " + result.etag
+                       + "; stats: " + reply.statistics.summary();
+    if (reply.codec != compression::Codec::none && result.compressed)
+    {
+        reply.data = result.compressed->get(result.xml, reply.codec);
+        reply.description = "XML string compressed with "
+                          + compression::name(reply.codec) + description;
+    }
+    else
+    {
+        reply.codec = compression::Codec::none;
+        reply.data = move(result.xml);
+        reply.description = "XML string" + description;
+    }
+    reply.status = "Success";
+    return reply;
+}
+
+/**
+ * \brief compute a request in the background and keep the result
+ *
+ * Nothing is done if the result is already kept or in flight, if the
+ * request is invalid, or if max_pending() prefetches are already
+ * waiting: prefetching never blocks the caller.
+ *
+ * \param [in] req the request options (see Request::desc)
+ * \return true if the request was queued
+ **/
+bool RequestExecutor::prefetch(const map<string,string>& req)
+{
+    std::unique_ptr<Request> request;
+    try
+    {
+        request.reset(new Request(req));
+    }
+    catch (std::exception&)
+    {
+        return false;
+    }
+    string key = request->cache_key();
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        if (_stopping
+            || _in_flight.count(key)
+            || _prefetch_queue.size() >= _max_pending)
+        {
+            return false;
+        }
+        auto c = _cache.find(key);
+        if (c != _cache.end()
+            && clock_type::now() - c->second.done <= _max_age)
+        {
+            return false;
+        }
+
+        Task task;
+        task.key = key;
+        task.options = req;
+        task.request = move(request);
+        task.prefetch = true;
+
+        _in_flight[key].future = task.promise.get_future().share();
+        _prefetch_queue.push_back(move(task));
+        _stats.prefetched++;
+    }
+    _have_prefetch.notify_one();
+    return true;
+}
+
+/**
+ * \brief prefetch a request for each of a list of runs
+ * \param [in] req the request options (see Request::desc); the run
+ *             option is replaced
+ * \param [in] runs the upcoming run numbers
+ * \return number of runs queued
+ **/
+size_t RequestExecutor::prewarm(
+    const map<string,string>& req,
+    const vector<int>& runs)
+{
+    size_t n = 0;
+    for (int run : runs)
+    {
+        map<string,string> r = req;
+        r["run"] = std::to_string(run);
+        if (this->prefetch(r))
+        {
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * \brief set how many of the following runs are prefetched after a
+ * request for a run
+ * \param [in] n number of runs, 0 to turn it off
+ **/
+void RequestExecutor::prefetch_ahead(size_t n)
+{
+    lock_guard<mutex> lock(_mutex);
+    _prefetch_ahead = n;
+}
+
+/**
+ * \brief forget all kept results
+ **/
+void RequestExecutor::clear_cache()
+{
+    lock_guard<mutex> lock(_mutex);
+    _cache.clear();
+    _cache_order.clear();
+}
+
+/**
+ * \brief compute a task, keep the result and wake everyone waiting
+ **/
+void RequestExecutor::run(Task& task)
+{
+    RequestResult result;
+    std::exception_ptr error;
+    try
+    {
+        result.xml = task.request->generate_xml();
+        result.compressed = std::make_shared<compression::CompressedCopies>();
+        if (result.xml.compare(0, 5, "Error") != 0)
+        {
+            // the tables are in memory already
+            result.etag = task.request->etag();
+        }
+        result.info = task.request->info();
+        result.statistics = task.request->statistics();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    const int run = task.request->constant_set().run;
+
+    // give back the database connection before the next task
+    task.request.reset();
+
+    // errors are not kept so that they are retried
+    const bool ok = !error && result.xml.compare(0, 5, "Error") != 0;
+
+    // the result is kept before anyone is woken, so that a request
+    // made as soon as it is received is answered from the cache
+    size_t ahead = 0;
+    {
+        lock_guard<mutex> lock(_mutex);
+        auto f = _in_flight.find(task.key);
+        const clock_type::time_point now = clock_type::now();
+        for (const auto& t : f->second.submitted)
+        {
+            _latency.record(std::chrono::duration<double>(now - t).count());
+        }
+
+        if (ok && _max_cached > 0)
+        {
+            auto c = _cache.find(task.key);
+            if (c != _cache.end())
+            {
+                _cache_order.erase(c->second.order);
+            }
+            _cache_order.push_front(task.key);
+            _cache[task.key] = Cached{f->second.future, now, _cache_order.begin()};
+            while (_cache.size() > _max_cached)
+            {
+                _cache.erase(_cache_order.back());
+                _cache_order.pop_back();
+            }
+        }
+
+        _in_flight.erase(f);
+        _stats.completed++;
+
+        if (ok && !task.prefetch && run != INT_MAX)
+        {
+            ahead = _prefetch_ahead;
+        }
+    }
+
+    if (error)
+    {
+        task.promise.set_exception(error);
+    }
+    else
+    {
+        task.promise.set_value(move(result));
+    }
+
+    // the next runs are likely to be asked for soon
+    for (size_t i=1; i<=ahead; i++)
+    {
+        map<string,string> next = task.options;
+        next["run"] = std::to_string(run + int(i));
+        this->prefetch(next);
+    }
+}
+
+/**
+ * \brief the loop run by each worker thread
+ **/
+void RequestExecutor::work()
+{
+    while (true)
+    {
+        Task task;
+        {
+            unique_lock<mutex> lock(_mutex);
+            _have_task.wait(lock, [this]()
+            {
+                return _stopping || !_queue.empty();
+            });
+            if (_queue.empty())
+            {
+                return; // stopping
+            }
+            task = move(_queue.front());
+            _queue.pop_front();
+        }
+        _have_room.notify_one();
+        _have_prefetch.notify_one();
+
+        this->run(task);
+    }
+}
+
+/**
+ * \brief the loop run by the prefetch thread
+ *
+ * Prefetches are taken only while no submitted request is waiting,
+ * and the thread runs at a lower scheduling priority where the system
+ * allows it.
+ **/
+void RequestExecutor::prefetch_work()
+{
+#ifdef __linux__
+    // on Linux the nice value is per thread
+    setpriority(PRIO_PROCESS, pid_t(syscall(SYS_gettid)), 10);
+#endif
+
+    while (true)
+    {
+        Task task;
+        {
+            unique_lock<mutex> lock(_mutex);
+            _have_prefetch.wait(lock, [this]()
+            {
+                return _stopping || (!_prefetch_queue.empty() && _queue.empty());
+            });
+            if (_stopping)
+            {
+                break;
+            }
+            task = move(_prefetch_queue.front());
+            _prefetch_queue.pop_front();
+        }
+        this->run(task);
+    }
+
+    // drop what was not prefetched
+    unique_lock<mutex> lock(_mutex);
+    while (!_prefetch_queue.empty())
+    {
+        Task task = move(_prefetch_queue.front());
+        _prefetch_queue.pop_front();
+        _in_flight.erase(task.key);
+        task.promise.set_exception(std::make_exception_ptr(
+            std::runtime_error("request executor is shutting down")));
+    }
+}
+
+/**
+ * \return number of requests waiting for a worker
+ **/
+size_t RequestExecutor::pending() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _queue.size();
+}
+
+/**
+ * \return number of distinct requests queued or running
+ **/
+size_t RequestExecutor::in_flight() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _in_flight.size();
+}
+
+/**
+ * \brief counts since the executor was made
+ * \return copy of RequestExecutor::_stats
+ **/
+ExecutorStats RequestExecutor::statistics() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _stats;
+}
+
+/**
+ * \brief time from submission to result of all requests
+ * \return copy of RequestExecutor::_latency
+ **/
+stats::Histogram RequestExecutor::latency() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _latency;
+}
+
+/**
+ * \brief the counts and the latency histogram
+ * \return multi-line report as a string
+ **/
+string RequestExecutor::report() const
+{
+    lock_guard<mutex> lock(_mutex);
+    stringstream ss;
+    ss << "RequestExecutor: "
+       << _workers.size() << " workers, "
+       << _queue.size() << " pending, "
+       << _prefetch_queue.size() << " prefetches pending, "
+       << _in_flight.size() << " in flight, "
+       << _cache.size() << " results kept\n"
+       << "  submitted: " << _stats.submitted
+       << ", coalesced: " << _stats.coalesced
+       << ", cached: " << _stats.cached
+       << ", completed: " << _stats.completed
+       << ", prefetched: " << _stats.prefetched
+       << ", promoted: " << _stats.promoted
+       << ", throttled: " << _stats.throttled << "\n"
+       << "  latency: " << _latency.summary() << "\n"
+       << _latency.report();
+    return ss.str();
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
@@ -0,0 +1,295 @@
+#ifndef CLAS12_GEOMETRY_REQUEST_EXECUTOR_HPP
+#define CLAS12_GEOMETRY_REQUEST_EXECUTOR_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clas12/compression.hpp"
+#include "clas12/geometry/request.hpp"
+#include "clas12/stats.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::list;
+using std::map;
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * \brief what one call of Request::generate_xml() produced
+ **/
+struct RequestResult
+{
+    /// \brief the XML, or an error message starting with "Error"
+    string xml;
+
+    /// \brief compressed copies of xml, shared by all copies of this
+    /// result so that each codec compresses it once
+    std::shared_ptr<compression::CompressedCopies> compressed;
+
+    /// \brief Request::etag() of the request, empty on error
+    string etag;
+
+    /// \brief Request::info() of the request
+    string info;
+
+    /// \brief Request::statistics() after generate_xml()
+    stats::Stats statistics;
+};
+
+/**
+ * \brief the answer of the geometry services to one request (see
+ * RequestExecutor::respond())
+ **/
+struct ServiceReply
+{
+    /// \brief "Success", "Not modified" or "Error"
+    string status;
+
+    /// \brief what the data is, for example
+    /// "XML string; etag: ...; stats: ..."
+    string description;
+
+    /// \brief the XML (possibly compressed) or the error message
+    string data;
+
+    /// \brief the codec data is compressed with
+    compression::Codec codec = compression::Codec::none;
+
+    /// \brief Request::info() of the request, empty if it was not run
+    string info;
+
+    /// \brief Request::statistics() after generate_xml()
+    stats::Stats statistics;
+};
+
+/**
+ * \brief counts kept by a RequestExecutor since it was made
+ **/
+struct ExecutorStats
+{
+    /// \brief calls of submit()
+    size_t submitted = 0;
+
+    /// \brief submissions joined to an identical request in flight
+    size_t coalesced = 0;
+
+    /// \brief requests computed
+    size_t completed = 0;
+
+    /// \brief submissions that waited for room in the queue
+    size_t throttled = 0;
+
+    /// \brief submissions answered from the result cache
+    size_t cached = 0;
+
+    /// \brief requests queued by prefetch()
+    size_t prefetched = 0;
+
+    /// \brief prefetches moved to the workers' queue because the
+    /// same request was submitted before they were started
+    size_t promoted = 0;
+};
+
+/**
+ * \brief runs geometry requests on a pool of worker threads
+ *
+ * Identical requests, after normalization (see
+ * Request::cache_key()), submitted while one is queued or running
+ * share its result instead of computing it again. This way a burst
+ * of identical requests, such as every worker asking for the
+ * geometry at the start of a run, makes one trip to the database.
+ *
+ * At most max_pending() distinct requests wait for a worker; submit()
+ * blocks until there is room. The time from submission to result of
+ * every request, coalesced or not, goes into a latency histogram.
+ *
+ * Requests differing only in compression share a result: the result
+ * holds the plain XML and its compressed copies (see
+ * RequestResult::compressed).
+ *
+ * Successful results are kept for max_age() so that a request that
+ * was prefetched, or asked for recently, is answered at once. The
+ * most recently used max_cached() results are kept.
+ *
+ * etag() gives the hash of the output of a request, from a kept
+ * result or by reading the constants tables only, so that a client
+ * which holds the output already can be told so without generating
+ * it again.
+ *
+ * prefetch() queues a request for a single background thread which
+ * runs at a lower priority and only while no submitted request is
+ * waiting. A prefetch not yet started when the same request is
+ * submitted is moved to the workers' queue, so the caller does not
+ * wait behind other prefetches. Reconstruction goes through runs in
+ * order so, with
+ * prefetch_ahead() set, every request for run N also prefetches the
+ * same request for the next runs.
+ **/
+class RequestExecutor
+{
+  public:
+    typedef std::shared_future<RequestResult> future_type;
+
+    typedef std::chrono::steady_clock clock_type;
+
+    RequestExecutor(size_t nworkers = 0,
+                    size_t max_pending = 64,
+                    size_t max_cached = 16,
+                    clock_type::duration max_age = std::chrono::minutes(10));
+    ~RequestExecutor();
+
+    RequestExecutor(const RequestExecutor&) = delete;
+    RequestExecutor& operator=(const RequestExecutor&) = delete;
+
+    future_type submit(const map<string,string>& req);
+    RequestResult execute(const map<string,string>& req);
+    string etag(const map<string,string>& req);
+
+    ServiceReply respond(const map<string,string>& req,
+                         const string& if_none_match = "");
+
+    bool prefetch(const map<string,string>& req);
+    size_t prewarm(const map<string,string>& req, const vector<int>& runs);
+
+    void prefetch_ahead(size_t n);
+    void clear_cache();
+
+    // inline methods
+    size_t nworkers() const;
+    size_t max_pending() const;
+    size_t max_cached() const;
+    clock_type::duration max_age() const;
+
+    // methods in cpp file
+    size_t pending() const;
+    size_t in_flight() const;
+    ExecutorStats statistics() const;
+    stats::Histogram latency() const;
+    string report() const;
+
+  private:
+    struct Task
+    {
+        string key;
+
+        /// \brief the options the request was made from
+        map<string,string> options;
+
+        std::unique_ptr<Request> request;
+        std::promise<RequestResult> promise;
+
+        /// \brief queued by prefetch()
+        bool prefetch = false;
+    };
+
+    struct InFlight
+    {
+        future_type future;
+
+        /// \brief submission times of everyone waiting on the result
+        vector<clock_type::time_point> submitted;
+    };
+
+    struct Cached
+    {
+        future_type future;
+        clock_type::time_point done;
+
+        /// \brief place in RequestExecutor::_cache_order
+        list<string>::iterator order;
+    };
+
+    void work();
+    void prefetch_work();
+    void run(Task& task);
+    bool find(const string& key,
+              const clock_type::time_point& start,
+              future_type& future);
+
+    size_t _max_pending;
+    size_t _max_cached;
+    clock_type::duration _max_age;
+    size_t _prefetch_ahead;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _have_task;
+    std::condition_variable _have_room;
+    std::condition_variable _have_prefetch;
+    bool _stopping;
+
+    std::deque<Task> _queue;
+    std::deque<Task> _prefetch_queue;
+    map<string,InFlight> _in_flight;
+
+    /// \brief finished results by key
+    map<string,Cached> _cache;
+
+    /// \brief keys of _cache, most recently used first
+    list<string> _cache_order;
+
+    ExecutorStats _stats;
+    stats::Histogram _latency;
+
+    vector<std::thread> _workers;
+    std::thread _prefetcher;
+};
+
+/**
+ * \brief number of worker threads
+ * \return size of RequestExecutor::_workers
+ **/
+inline
+size_t RequestExecutor::nworkers() const
+{
+    return _workers.size();
+}
+
+/**
+ * \brief most distinct requests waiting for a worker
+ * \return copy of RequestExecutor::_max_pending
+ **/
+inline
+size_t RequestExecutor::max_pending() const
+{
+    return _max_pending;
+}
+
+/**
+ * \brief most results kept
+ * \return copy of RequestExecutor::_max_cached
+ **/
+inline
+size_t RequestExecutor::max_cached() const
+{
+    return _max_cached;
+}
+
+/**
+ * \brief how long a result is kept
+ * \return copy of RequestExecutor::_max_age
+ **/
+inline
+RequestExecutor::clock_type::duration RequestExecutor::max_age() const
+{
+    return _max_age;
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_REQUEST_EXECUTOR_HPP
@@ -0,0 +1,163 @@
+#include "selection.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::invalid_argument;
+using std::stringstream;
+
+using boost::is_any_of;
+using boost::lexical_cast;
+using boost::split;
+using boost::trim_copy;
+
+/// \brief the most values a range may expand to
+static const int max_range = 1000;
+
+/**
+ * \brief a selection of everything
+ **/
+Selection::Selection()
+{}
+
+/**
+ * \brief parse a selector
+ * \param [in] selector for example "sector=2,superlayer=3-4", without
+ *             the brackets; empty to select everything
+ **/
+Selection::Selection(const string& selector)
+{
+    vector<string> terms;
+    split(terms, selector, is_any_of(","));
+    for (const auto& t : terms)
+    {
+        string term = trim_copy(t);
+        if (term == "")
+        {
+            continue;
+        }
+
+        size_t eq = term.find('=');
+        if (eq == string::npos || eq == 0 || eq + 1 == term.size())
+        {
+            throw invalid_argument("bad selector: " + term + " (expected key=value)");
+        }
+        string key = trim_copy(term.substr(0, eq));
+        set<string>& values = _values[key];
+
+        vector<string> alternatives;
+        split(alternatives, term.substr(eq + 1), is_any_of("|"));
+        for (const auto& a : alternatives)
+        {
+            string value = trim_copy(a);
+            size_t dash = value.find('-');
+            if (dash == string::npos)
+            {
+                values.insert(value);
+                continue;
+            }
+
+            int first, last;
+            try
+            {
+                first = lexical_cast<int>(value.substr(0, dash));
+                last = lexical_cast<int>(value.substr(dash + 1));
+            }
+            catch (...)
+            {
+                throw invalid_argument("bad range in selector: " + term);
+            }
+            if (first > last || last - first >= max_range)
+            {
+                throw invalid_argument("bad range in selector: " + term);
+            }
+            for (int i=first; i<=last; i++)
+            {
+                values.insert(lexical_cast<string>(i));
+            }
+        }
+    }
+}
+
+/**
+ * \param [in] key for example "sector"
+ * \param [in] index the index counted from zero as in the detector
+ *             classes; the selector counts from one
+ * \return true if the part is selected
+ **/
+bool Selection::selects(const string& key, size_t index) const
+{
+    return this->selects(key, lexical_cast<string>(index + 1));
+}
+
+/**
+ * \param [in] key for example "panel"
+ * \param [in] name for example "1b"
+ * \return true if the part is selected
+ **/
+bool Selection::selects(const string& key, const string& name) const
+{
+    auto v = _values.find(key);
+    return v == _values.end() || v->second.count(name) > 0;
+}
+
+/**
+ * \brief make sure the selector only uses keys an output understands
+ * \param [in] item the request item, for example "dc/volumes", used
+ *             in the error message
+ * \param [in] keys the keys the output understands
+ **/
+void Selection::check_keys(const string& item, const vector<string>& keys) const
+{
+    for (const auto& v : _values)
+    {
+        if (std::find(keys.begin(), keys.end(), v.first) == keys.end())
+        {
+            string known = boost::join(keys, ", ");
+            throw invalid_argument(
+                "can not select by " + v.first + " in " + item
+                + " (known: " + known + ")");
+        }
+    }
+}
+
+/**
+ * \brief the selector in a normalized form: keys and values sorted,
+ * ranges expanded
+ * \return for example "[sector=2,superlayer=3|4]", or empty for all
+ **/
+string Selection::str() const
+{
+    if (this->all())
+    {
+        return "";
+    }
+    stringstream ss;
+    ss << "[";
+    bool first_key = true;
+    for (const auto& v : _values)
+    {
+        ss << (first_key ? "" : ",") << v.first << "=";
+        first_key = false;
+        bool first_value = true;
+        for (const auto& value : v.second)
+        {
+            ss << (first_value ? "" : "|") << value;
+            first_value = false;
+        }
+    }
+    ss << "]";
+    return ss.str();
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
@@ -0,0 +1,69 @@
+#ifndef CLAS12_GEOMETRY_SELECTION_HPP
+#define CLAS12_GEOMETRY_SELECTION_HPP
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::map;
+using std::set;
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * \brief the part of a detector an output generator is limited to
+ *
+ * Made from the selector of a request item, the text between the
+ * brackets of "dc/wire_endpoints[sector=2,superlayer=3-4]". The
+ * selector is a comma separated list of key=value where the value is
+ * a number, a range of numbers "first-last" or a name (for example
+ * the FTOF panel "1b"). Several values of a key are given by
+ * repeating it or by joining them with "|": "sector=1|4" and
+ * "sector=1,sector=4" are the same. A key which is not given selects
+ * everything.
+ *
+ * Numbers count from one, as in the volume names (sector1, R1_S1,
+ * ...), although the XML attributes of some outputs count from zero.
+ **/
+class Selection
+{
+  public:
+    Selection();
+    explicit Selection(const string& selector);
+
+    bool selects(const string& key, size_t index) const;
+    bool selects(const string& key, const string& name) const;
+
+    void check_keys(const string& item, const vector<string>& keys) const;
+
+    string str() const;
+
+    // inline methods
+    bool all() const;
+
+  private:
+    /// \brief the values selected by key, ranges expanded
+    map<string,set<string>> _values;
+};
+
+/**
+ * \return true if nothing is excluded
+ **/
+inline
+bool Selection::all() const
+{
+    return _values.empty();
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_SELECTION_HPP
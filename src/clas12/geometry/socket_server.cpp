@@ -0,0 +1,667 @@
+#include "socket_server.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "clas12/log.hpp"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::invalid_argument;
+using std::runtime_error;
+
+using boost::lexical_cast;
+using boost::to_lower_copy;
+using boost::trim_copy;
+
+/// \brief longest line of a request or reply header
+static const size_t max_line = 1 << 16;
+
+/// \brief most lines in a request or reply header
+static const size_t max_lines = 64;
+
+/// \brief connections waiting to be accepted
+static const int backlog = 128;
+
+const string SocketServer::desc =
+R"(Serves geometry requests over a local socket. The address is
+"unix:/path/to/socket" or "tcp:host:port".
+
+A request is a list of "key: value" lines ended by an empty line.
+The keys are the input options of the geometry request (below),
+except for the database options which are set by the server, and
+"if-none-match" which may be set to the etag of output the client
+already holds. A reply is:
+
+    status: Success | Not modified | Error
+    description: XML string; etag: <hash>; stats: <timings>
+    length: <number of bytes>
+
+    <the XML, compressed if asked for, or an error message>
+
+Any number of requests may be sent on one connection. A connection
+on which no request arrives within the server's idle timeout is
+closed.
+)";
+
+static string errno_str(const string& what)
+{
+    return what + ": " + std::strerror(errno);
+}
+
+/**
+ * \brief split a TCP address
+ * \param [in] address for example "tcp:localhost:5555"
+ * \return the host and port
+ **/
+static std::pair<string,string> tcp_host_port(const string& address)
+{
+    string hp = address.substr(4);
+    size_t colon = hp.rfind(':');
+    if (colon == string::npos || colon + 1 == hp.size())
+    {
+        throw invalid_argument("bad address, expected tcp:host:port: " + address);
+    }
+    return std::make_pair(hp.substr(0, colon), hp.substr(colon + 1));
+}
+
+/**
+ * \brief the path of a Unix domain socket address
+ * \param [in] address for example "unix:/tmp/clas12geom.sock"
+ * \param [out] sa the socket address
+ **/
+static void unix_address(const string& address, sockaddr_un& sa)
+{
+    string path = address.substr(5);
+    if (path == "" || path.size() >= sizeof(sa.sun_path))
+    {
+        throw invalid_argument("bad socket path: " + address);
+    }
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    std::strncpy(sa.sun_path, path.c_str(), sizeof(sa.sun_path) - 1);
+}
+
+static bool is_unix(const string& address)
+{
+    return address.compare(0, 5, "unix:") == 0;
+}
+
+static bool is_tcp(const string& address)
+{
+    return address.compare(0, 4, "tcp:") == 0;
+}
+
+/**
+ * \brief open a socket and connect or bind it to an address
+ * \param [in] address unix:path or tcp:host:port
+ * \param [in] listening bind and listen instead of connecting
+ * \param [out] bound the address, with the port chosen by the system
+ * \return the file descriptor
+ **/
+static int open_socket(const string& address, bool listening, string& bound)
+{
+    bound = address;
+
+    if (is_unix(address))
+    {
+        sockaddr_un sa;
+        unix_address(address, sa);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            throw runtime_error(errno_str("could not open socket"));
+        }
+
+        if (listening)
+        {
+            // a socket file left by a server which was killed
+            struct stat st;
+            if (stat(sa.sun_path, &st) == 0 && S_ISSOCK(st.st_mode))
+            {
+                unlink(sa.sun_path);
+            }
+        }
+
+        int ret = listening
+            ? bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa))
+            : connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa));
+        if (ret != 0 || (listening && listen(fd, backlog) != 0))
+        {
+            string err = errno_str("could not " + string(listening ? "listen on " : "connect to ") + address);
+            close(fd);
+            throw runtime_error(err);
+        }
+        return fd;
+    }
+
+    if (!is_tcp(address))
+    {
+        throw invalid_argument("bad address, expected unix:path or tcp:host:port: " + address);
+    }
+
+    auto hp = tcp_host_port(address);
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+
+    addrinfo* addrs;
+    int err = getaddrinfo(hp.first.c_str(), hp.second.c_str(), &hints, &addrs);
+    if (err != 0)
+    {
+        throw runtime_error("could not resolve " + address + ": " + gai_strerror(err));
+    }
+
+    int fd = -1;
+    for (addrinfo* a = addrs; a != nullptr && fd < 0; a = a->ai_next)
+    {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        bool ok;
+        if (listening)
+        {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            ok = bind(fd, a->ai_addr, a->ai_addrlen) == 0 && listen(fd, backlog) == 0;
+        }
+        else
+        {
+            ok = connect(fd, a->ai_addr, a->ai_addrlen) == 0;
+        }
+
+        if (!ok)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addrs);
+
+    if (fd < 0)
+    {
+        throw runtime_error(errno_str("could not " + string(listening ? "listen on " : "connect to ") + address));
+    }
+
+    if (listening)
+    {
+        sockaddr_storage sa;
+        socklen_t len = sizeof(sa);
+        getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len);
+        char port[NI_MAXSERV];
+        if (getnameinfo(reinterpret_cast<sockaddr*>(&sa), len, nullptr, 0,
+                        port, sizeof(port), NI_NUMERICSERV) == 0)
+        {
+            bound = "tcp:" + hp.first + ":" + port;
+        }
+    }
+    return fd;
+}
+
+static void write_all(int fd, const char* data, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t w = send(fd, data, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (w <= 0)
+        {
+            throw runtime_error(errno_str("could not write to socket"));
+        }
+        data += w;
+        n -= w;
+    }
+}
+
+/**
+ * \brief read more bytes into a buffer
+ * \return false if the peer closed the connection
+ **/
+static bool fill(int fd, string& buffer)
+{
+    char buf[1 << 16];
+    while (true)
+    {
+        ssize_t r = recv(fd, buf, sizeof(buf), 0);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            throw runtime_error("connection idle too long");
+        }
+        if (r < 0)
+        {
+            throw runtime_error(errno_str("could not read from socket"));
+        }
+        buffer.append(buf, r);
+        return r > 0;
+    }
+}
+
+/**
+ * \brief read the "key: value" lines up to an empty line
+ * \param [in] fd the socket
+ * \param [in,out] buffer bytes read but not used yet
+ * \param [out] fields the values by key (lower case)
+ * \return false if the peer closed the connection before the first line
+ **/
+static bool read_header(int fd, string& buffer, map<string,string>& fields)
+{
+    fields.clear();
+    size_t nlines = 0;
+    while (true)
+    {
+        size_t eol = buffer.find('\n');
+        if (eol == string::npos)
+        {
+            if (buffer.size() > max_line)
+            {
+                throw invalid_argument("header line too long");
+            }
+            if (!fill(fd, buffer))
+            {
+                if (buffer.empty() && nlines == 0)
+                {
+                    return false;
+                }
+                throw runtime_error("connection closed in the middle of a header");
+            }
+            continue;
+        }
+
+        string line = trim_copy(buffer.substr(0, eol));
+        buffer.erase(0, eol + 1);
+        if (line == "")
+        {
+            if (nlines == 0)
+            {
+                // blank lines between requests
+                continue;
+            }
+            return true;
+        }
+        if (++nlines > max_lines)
+        {
+            throw invalid_argument("too many header lines");
+        }
+
+        size_t colon = line.find(':');
+        if (colon == string::npos)
+        {
+            throw invalid_argument("bad header line, expected key: value: " + line);
+        }
+        fields[to_lower_copy(trim_copy(line.substr(0, colon)))] = trim_copy(line.substr(colon + 1));
+    }
+}
+
+static void write_reply(int fd, const SocketReply& reply)
+{
+    string header = "status: " + reply.status + "\n"
+                  + "description: " + reply.description + "\n"
+                  + "length: " + lexical_cast<string>(reply.data.size()) + "\n\n";
+    write_all(fd, header.data(), header.size());
+    write_all(fd, reply.data.data(), reply.data.size());
+}
+
+/**
+ * \brief listen on an address
+ *
+ * Nothing is accepted until serve() is called.
+ *
+ * \param [in] executor runs the requests
+ * \param [in] address unix:/path/to/socket or tcp:host:port
+ * \param [in] defaults options added to every request, for example
+ *             the database (sqlite, mysql-host, ...)
+ * \param [in] nconnections number of connections served at once
+ * \param [in] idle_timeout connections are closed when no complete
+ *             request arrives, or a reply can not be sent, for this
+ *             long; 0 for no limit
+ **/
+SocketServer::SocketServer(RequestExecutor& executor,
+                           const string& address,
+                           const map<string,string>& defaults,
+                           size_t nconnections,
+                           std::chrono::seconds idle_timeout)
+: _executor(executor)
+, _defaults(defaults)
+, _idle_timeout(idle_timeout)
+, _listen_fd(-1)
+, _stopping(false)
+, _served(0)
+{
+    _listen_fd = open_socket(address, true, _address);
+    if (is_unix(address))
+    {
+        _path = address.substr(5);
+    }
+
+    for (size_t i=0; i<std::max(nconnections, size_t(1)); i++)
+    {
+        _handlers.emplace_back(&SocketServer::handle, this);
+    }
+}
+
+/**
+ * \brief stop, close all connections and remove the socket file
+ **/
+SocketServer::~SocketServer()
+{
+    this->stop();
+    for (auto& t : _handlers)
+    {
+        t.join();
+    }
+    close(_listen_fd);
+    if (_path != "")
+    {
+        unlink(_path.c_str());
+    }
+}
+
+/**
+ * \brief accept connections until stop() is called
+ **/
+void SocketServer::serve()
+{
+    while (true)
+    {
+        int fd = accept(_listen_fd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stopping)
+            {
+                return;
+            }
+            if (errno != EINTR && errno != ECONNABORTED)
+            {
+                LOG(error) << errno_str("could not accept connection");
+            }
+            continue;
+        }
+
+        if (is_tcp(_address))
+        {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        // idle clients must not hold on to a connection thread
+        if (_idle_timeout.count() > 0)
+        {
+            timeval tv{};
+            tv.tv_sec = _idle_timeout.count();
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopping)
+        {
+            close(fd);
+            return;
+        }
+        _waiting.push_back(fd);
+        _have_connection.notify_one();
+    }
+}
+
+/**
+ * \brief make serve() return and close all connections; requests
+ * being computed are finished by the executor but not answered
+ **/
+void SocketServer::stop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopping)
+    {
+        return;
+    }
+    _stopping = true;
+
+    // wakes up accept() and the handlers reading from connections
+    shutdown(_listen_fd, SHUT_RDWR);
+    for (int fd : _open)
+    {
+        shutdown(fd, SHUT_RDWR);
+    }
+    for (int fd : _waiting)
+    {
+        close(fd);
+    }
+    _waiting.clear();
+    _have_connection.notify_all();
+}
+
+/**
+ * \brief number of requests answered
+ * \return copy of SocketServer::_served
+ **/
+size_t SocketServer::served() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _served;
+}
+
+/**
+ * \brief answer one request as the GeometryService does (see
+ * RequestExecutor::respond())
+ * \param [in] req the options of Request and "if-none-match"
+ * \return the reply
+ **/
+SocketReply SocketServer::respond(const map<string,string>& req)
+{
+    static const set<string> options{
+        "units", "coordsys", "request", "placements", "encoding",
+        "compression", "run", "variation", "timestamp" };
+
+    SocketReply reply;
+
+    map<string,string> r = _defaults;
+    string held;
+    for (const auto& kv : req)
+    {
+        if (kv.first == "if-none-match")
+        {
+            held = kv.second;
+        }
+        else if (options.count(kv.first))
+        {
+            r[kv.first] = kv.second;
+        }
+        else
+        {
+            reply.status = "Error";
+            reply.description = "Error message";
+            reply.data = "Error: unknown option: " + kv.first;
+            return reply;
+        }
+    }
+
+    ServiceReply answer = _executor.respond(r, held);
+    reply.status = std::move(answer.status);
+    reply.description = std::move(answer.description);
+    reply.data = std::move(answer.data);
+    return reply;
+}
+
+/**
+ * \brief the loop of a connection thread
+ **/
+void SocketServer::handle()
+{
+    while (true)
+    {
+        int fd;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _have_connection.wait(lock, [this]()
+            {
+                return _stopping || !_waiting.empty();
+            });
+            if (_stopping)
+            {
+                return;
+            }
+            fd = _waiting.front();
+            _waiting.pop_front();
+            _open.insert(fd);
+        }
+
+        this->converse(fd);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _open.erase(fd);
+        close(fd);
+    }
+}
+
+/**
+ * \brief answer the requests of one connection until it is closed
+ **/
+void SocketServer::converse(int fd)
+{
+    string buffer;
+    map<string,string> req;
+    try
+    {
+        while (read_header(fd, buffer, req))
+        {
+            SocketReply reply = this->respond(req);
+            LOG(debug) << "socket request: " << reply.status << "; " << reply.description;
+
+            // counted before the client can read the reply
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _served++;
+            }
+            write_reply(fd, reply);
+        }
+    }
+    catch (invalid_argument& e)
+    {
+        // the rest of the stream can not be trusted: answer and close
+        SocketReply reply;
+        reply.status = "Error";
+        reply.description = "Error message";
+        reply.data = string("Error: ") + e.what();
+        try
+        {
+            write_reply(fd, reply);
+        }
+        catch (std::exception&)
+        {}
+    }
+    catch (std::exception& e)
+    {
+        LOG(debug) << "socket connection closed: " << e.what();
+    }
+}
+
+/**
+ * \brief connect to a SocketServer
+ * \param [in] address unix:/path/to/socket or tcp:host:port
+ **/
+SocketClient::SocketClient(const string& address)
+{
+    string bound;
+    _fd = open_socket(address, false, bound);
+}
+
+SocketClient::~SocketClient()
+{
+    close(_fd);
+}
+
+/**
+ * \brief send a request and wait for the reply
+ * \param [in] req the options of the request; keys may not contain
+ *             ":" and neither keys nor values may contain new lines
+ * \return the reply
+ **/
+SocketReply SocketClient::request(const map<string,string>& req)
+{
+    string header;
+    for (const auto& kv : req)
+    {
+        if (kv.first.find_first_of(":\n") != string::npos
+            || kv.second.find('\n') != string::npos)
+        {
+            throw invalid_argument("bad request option: " + kv.first);
+        }
+        header += kv.first + ": " + kv.second + "\n";
+    }
+    header += "\n";
+    write_all(_fd, header.data(), header.size());
+
+    map<string,string> fields;
+    if (!read_header(_fd, _buffer, fields))
+    {
+        throw runtime_error("connection closed by the server");
+    }
+
+    SocketReply reply;
+    reply.status = fields["status"];
+    reply.description = fields["description"];
+
+    size_t length;
+    try
+    {
+        length = lexical_cast<size_t>(fields["length"]);
+    }
+    catch (...)
+    {
+        throw runtime_error("bad reply: no length");
+    }
+
+    while (_buffer.size() < length)
+    {
+        if (!fill(_fd, _buffer))
+        {
+            throw runtime_error("connection closed in the middle of a reply");
+        }
+    }
+    reply.data = _buffer.substr(0, length);
+    _buffer.erase(0, length);
+    return reply;
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
@@ -0,0 +1,191 @@
+#ifndef CLAS12_GEOMETRY_SOCKET_SERVER_HPP
+#define CLAS12_GEOMETRY_SOCKET_SERVER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clas12/geometry/request_executor.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::map;
+using std::set;
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * \brief one reply of a SocketServer
+ **/
+struct SocketReply
+{
+    /// \brief "Success", "Not modified" or "Error"
+    string status;
+
+    /// \brief what the data is, as in the GeometryService, for
+    /// example "XML string; etag: ...; stats: ..."
+    string description;
+
+    /// \brief the XML (possibly compressed) or the error message
+    string data;
+};
+
+/**
+ * \brief serves geometry requests over a local socket
+ *
+ * The server listens on a Unix domain socket ("unix:/path/to/socket")
+ * or a TCP socket ("tcp:host:port"; port 0 picks a free port) and
+ * answers requests with a RequestExecutor, so identical requests are
+ * computed once and recent results are kept.
+ *
+ * A request is a list of "key: value" lines, ended by an empty line.
+ * The keys are the options of Request (units, coordsys, request, run,
+ * ...) and, as in the GeometryService, "if-none-match". The database
+ * is set by the server, never by the client. A reply is
+ *
+ *     status: Success
+ *     description: XML string; etag: ...; stats: ...
+ *     length: <number of bytes of data>
+ *
+ *     <data>
+ *
+ * Any number of requests may be sent on one connection, one after
+ * the other. Each connection is served by one of nconnections()
+ * threads; further connections wait to be accepted. A connection on
+ * which no request arrives for idle_timeout() is closed, so idle
+ * clients do not keep others waiting.
+ **/
+class SocketServer
+{
+  public:
+    static const string desc;
+
+    SocketServer(RequestExecutor& executor,
+                 const string& address,
+                 const map<string,string>& defaults = map<string,string>(),
+                 size_t nconnections = 16,
+                 std::chrono::seconds idle_timeout = std::chrono::seconds(60));
+    ~SocketServer();
+
+    SocketServer(const SocketServer&) = delete;
+    SocketServer& operator=(const SocketServer&) = delete;
+
+    void serve();
+    void stop();
+
+    SocketReply respond(const map<string,string>& req);
+
+    // inline methods
+    const string& address() const;
+    size_t nconnections() const;
+    std::chrono::seconds idle_timeout() const;
+
+    // methods in cpp file
+    size_t served() const;
+
+  private:
+    void handle();
+    void converse(int fd);
+
+    RequestExecutor& _executor;
+
+    /// \brief options added to every request (the database)
+    map<string,string> _defaults;
+
+    /// \brief how long a connection may wait for a request
+    std::chrono::seconds _idle_timeout;
+
+    /// \brief the address listened on, with the port chosen
+    string _address;
+
+    /// \brief the socket file of a Unix domain socket, removed
+    /// when the server is destroyed
+    string _path;
+
+    int _listen_fd;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _have_connection;
+    bool _stopping;
+
+    /// \brief accepted connections waiting for a thread
+    std::deque<int> _waiting;
+
+    /// \brief connections being served
+    set<int> _open;
+
+    /// \brief requests answered
+    size_t _served;
+
+    vector<std::thread> _handlers;
+};
+
+/**
+ * \brief a connection to a SocketServer
+ *
+ * Not thread safe: use one per thread.
+ **/
+class SocketClient
+{
+  public:
+    explicit SocketClient(const string& address);
+    ~SocketClient();
+
+    SocketClient(const SocketClient&) = delete;
+    SocketClient& operator=(const SocketClient&) = delete;
+
+    SocketReply request(const map<string,string>& req);
+
+  private:
+    int _fd;
+
+    /// \brief bytes read but not used yet
+    string _buffer;
+};
+
+/**
+ * \brief the address the server listens on; for TCP with the port
+ * that was chosen if it was given as 0
+ * \return const reference to SocketServer::_address
+ **/
+inline
+const string& SocketServer::address() const
+{
+    return _address;
+}
+
+/**
+ * \brief number of connections served at once
+ * \return size of SocketServer::_handlers
+ **/
+inline
+size_t SocketServer::nconnections() const
+{
+    return _handlers.size();
+}
+
+/**
+ * \brief how long a connection may be idle before it is closed
+ * \return copy of SocketServer::_idle_timeout
+ **/
+inline
+std::chrono::seconds SocketServer::idle_timeout() const
+{
+    return _idle_timeout;
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_SOCKET_SERVER_HPP
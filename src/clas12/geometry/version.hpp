@@ -0,0 +1,23 @@
+#ifndef CLAS12_GEOMETRY_VERSION_HPP
+#define CLAS12_GEOMETRY_VERSION_HPP
+
+#include <string>
+
+namespace clas12
+{
+namespace geometry
+{
+
+/**
+ * \brief version of the geometry library
+ *
+ * This must be kept in sync with VERSION in the top-level wscript.
+ * It is part of every cache key so that geometry generated by an
+ * older version of the library is never served by a newer one.
+ **/
+static const std::string library_version = "0.6.1";
+
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_VERSION_HPP
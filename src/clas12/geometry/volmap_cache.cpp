@@ -0,0 +1,322 @@
+#include "volmap_cache.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/hash.hpp"
+#include "clas12/log.hpp"
+
+#include "version.hpp"
+
+namespace clas12
+{
+namespace geometry
+{
+
+namespace fs = boost::filesystem;
+
+using std::endl;
+using std::ofstream;
+using std::ios;
+using std::runtime_error;
+using std::uint32_t;
+using std::uint64_t;
+
+namespace
+{
+    const char magic[8] = {'C','1','2','V','M','A','P','1'};
+
+    void write_u32(ofstream& fout, uint32_t n)
+    {
+        fout.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+
+    void write_str(ofstream& fout, const string& s)
+    {
+        write_u32(fout, s.size());
+        fout.write(s.data(), s.size());
+    }
+
+    /**
+     * \brief bounds-checked reader over a memory-mapped entry
+     **/
+    class Reader
+    {
+      public:
+        Reader(const char* begin, const char* end)
+        : _pos(begin)
+        , _end(end)
+        {}
+
+        bool u32(uint32_t& n)
+        {
+            if (size_t(_end - _pos) < sizeof(n))
+            {
+                return false;
+            }
+            std::memcpy(&n, _pos, sizeof(n));
+            _pos += sizeof(n);
+            return true;
+        }
+
+        bool str(string& s)
+        {
+            uint32_t n;
+            if (!this->u32(n) || size_t(_end - _pos) < n)
+            {
+                return false;
+            }
+            s.assign(_pos, n);
+            _pos += n;
+            return true;
+        }
+
+        bool at_end() const
+        {
+            return _pos == _end;
+        }
+
+      private:
+        const char* _pos;
+        const char* _end;
+    };
+
+    bool parse_entry(const char* data, size_t size, const string& key, volmap_t& vmap)
+    {
+        if (size < sizeof(magic) || std::memcmp(data, magic, sizeof(magic)) != 0)
+        {
+            return false;
+        }
+
+        Reader rd(data + sizeof(magic), data + size);
+
+        string stored_key;
+        if (!rd.str(stored_key) || stored_key != key)
+        {
+            return false;
+        }
+
+        uint32_t nvols;
+        if (!rd.u32(nvols))
+        {
+            return false;
+        }
+
+        volmap_t ret;
+        for (uint32_t v=0; v<nvols; v++)
+        {
+            string name;
+            uint32_t nparams;
+            if (!rd.str(name) || !rd.u32(nparams))
+            {
+                return false;
+            }
+            map<string,string>& params = ret[name];
+            for (uint32_t p=0; p<nparams; p++)
+            {
+                string param, value;
+                if (!rd.str(param) || !rd.str(value))
+                {
+                    return false;
+                }
+                params[param] = value;
+            }
+        }
+
+        if (!rd.at_end())
+        {
+            return false;
+        }
+
+        vmap.swap(ret);
+        return true;
+    }
+}
+
+/**
+ * \brief constructor
+ * \param [in] directory where the cache entries are kept. It is
+ *             created when the first entry is stored.
+ **/
+VolmapCache::VolmapCache(const string& directory)
+: _directory(directory)
+{
+}
+
+/**
+ * \brief the default cache directory
+ *
+ * This is the first of the following that is set:
+ *     $CLAS12_GEOMETRY_CACHE_DIR
+ *     $XDG_CACHE_HOME/clas12_geometry
+ *     $HOME/.cache/clas12_geometry
+ * falling back to a directory under the system temporary path.
+ *
+ * \return path to the cache directory
+ **/
+string VolmapCache::default_directory()
+{
+    if (const char* dir = std::getenv("CLAS12_GEOMETRY_CACHE_DIR"))
+    {
+        return dir;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"))
+    {
+        return (fs::path(xdg) / "clas12_geometry").string();
+    }
+    if (const char* home = std::getenv("HOME"))
+    {
+        return (fs::path(home) / ".cache" / "clas12_geometry").string();
+    }
+    return (fs::temp_directory_path() / "clas12_geometry").string();
+}
+
+/**
+ * \brief the file holding the entry for a given key
+ *
+ * The file name is the hash of the key and the library version.
+ *
+ * \param [in] key identifies the contents of the entry, for example
+ *             Request::etag()
+ * \return path to the cache entry
+ **/
+string VolmapCache::path(const string& key) const
+{
+    uint64_t h = hash::fnv1a(library_version + "\n" + key);
+    return (fs::path(_directory) / (hash::hex(h) + ".volmap")).string();
+}
+
+/**
+ * \brief load a volume map from the cache
+ *
+ * \param [in] key identifies the contents of the entry, for example
+ *             Request::etag()
+ * \param [out] vmap filled with the cached volumes on success
+ * \return true if the entry was found and is valid
+ **/
+bool VolmapCache::load(const string& key, volmap_t& vmap) const
+{
+    string filename = this->path(key);
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = st.st_size;
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return false;
+    }
+
+    bool ok = parse_entry(static_cast<const char*>(addr), size, key, vmap);
+    ::munmap(addr, size);
+
+    if (!ok)
+    {
+        LOG(warning) << "ignoring corrupt volume cache entry: " << filename;
+    }
+    return ok;
+}
+
+/**
+ * \brief store a volume map in the cache
+ *
+ * The entry is written to a temporary file with a unique name (see
+ * mkstemp(3)) which is renamed into place once complete. Failures are logged and otherwise ignored:
+ * a cache that can not be written must never stop a job.
+ *
+ * \param [in] key identifies the contents of the entry, for example
+ *             Request::etag()
+ * \param [in] vmap the volumes to store
+ **/
+void VolmapCache::store(const string& key, const volmap_t& vmap) const
+{
+    string filename = this->path(key);
+    string tmpname;
+
+    try
+    {
+        fs::create_directories(_directory);
+
+        // unique among all threads and processes storing this entry
+        string pattern = filename + ".tmp.XXXXXX";
+        int fd = ::mkstemp(&pattern[0]);
+        if (fd < 0)
+        {
+            throw runtime_error("could not create file: " + pattern
+                                + ": " + std::strerror(errno));
+        }
+        tmpname = pattern;
+        ::fchmod(fd, 0644);
+        ::close(fd);
+
+        {
+            ofstream fout(tmpname, ios::binary | ios::trunc);
+            if (!fout.is_open())
+            {
+                throw runtime_error("could not open file: " + tmpname);
+            }
+
+            fout.write(magic, sizeof(magic));
+            write_str(fout, key);
+            write_u32(fout, vmap.size());
+            for (const auto& vol : vmap)
+            {
+                write_str(fout, vol.first);
+                write_u32(fout, vol.second.size());
+                for (const auto& param : vol.second)
+                {
+                    write_str(fout, param.first);
+                    write_str(fout, param.second);
+                }
+            }
+
+            if (!fout.flush())
+            {
+                throw runtime_error("could not write file: " + tmpname);
+            }
+        }
+
+        if (std::rename(tmpname.c_str(), filename.c_str()) != 0)
+        {
+            throw runtime_error("could not rename " + tmpname + " to " + filename);
+        }
+
+        LOG(debug) << "stored volume cache entry: " << filename;
+    }
+    catch (std::exception& e)
+    {
+        if (tmpname != "")
+        {
+            std::remove(tmpname.c_str());
+        }
+        LOG(warning) << "could not store volume cache entry: " << e.what();
+    }
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
@@ -0,0 +1,73 @@
+#ifndef CLAS12_GEOMETRY_VOLMAP_CACHE_HPP
+#define CLAS12_GEOMETRY_VOLMAP_CACHE_HPP
+
+#include <map>
+#include <string>
+
+namespace clas12
+{
+namespace geometry
+{
+
+using std::map;
+using std::string;
+
+typedef map<string, map<string,string> > volmap_t;
+
+/**
+ * \brief content-addressed on-disk cache of volume maps
+ *
+ * Each entry is a single compact binary file whose name is the
+ * hash of the key and the library version. The full key is also
+ * stored in the file and compared on load so that a hash collision
+ * can never return the wrong geometry. Keys should identify the
+ * contents, such as Request::etag() which hashes the constants
+ * tables, so that an entry never has to expire.
+ *
+ * Entries are read with mmap() and written to a uniquely named
+ * temporary file in the same directory which is then renamed into
+ * place, so readers
+ * never see a partially written entry, even with many processes
+ * populating the cache at the same time.
+ *
+ * File layout (native byte order, all integers are uint32):
+ *
+ *     magic "C12VMAP1"
+ *     key
+ *     nvolumes
+ *     nvolumes x { name, nparams, nparams x { param, value } }
+ *
+ * where every string is stored as its length followed by its bytes.
+ **/
+class VolmapCache
+{
+  public:
+    VolmapCache(const string& directory = VolmapCache::default_directory());
+
+    static string default_directory();
+
+    const string& directory() const;
+    string path(const string& key) const;
+
+    bool load(const string& key, volmap_t& vmap) const;
+    void store(const string& key, const volmap_t& vmap) const;
+
+  private:
+    /// \brief directory holding the cache entries
+    string _directory;
+};
+
+/**
+ * \brief the directory holding the cache entries
+ * \return const reference to VolmapCache::_directory
+ **/
+inline
+const string& VolmapCache::directory() const
+{
+    return _directory;
+}
+
+} // namespace clas12::geometry
+} // namespace clas12
+
+#endif // CLAS12_GEOMETRY_VOLMAP_CACHE_HPP
@@ -0,0 +1,78 @@
+#ifndef CLAS12_HASH_HPP
+#define CLAS12_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace clas12
+{
+namespace hash
+{
+
+using std::size_t;
+using std::string;
+using std::uint64_t;
+
+/// \brief FNV-1a 64-bit offset basis
+static const uint64_t fnv1a_basis = 14695981039346656037ULL;
+
+/// \brief FNV-1a 64-bit prime
+static const uint64_t fnv1a_prime = 1099511628211ULL;
+
+/**
+ * \brief FNV-1a hash of a block of memory
+ *
+ * This is not a cryptographic hash. It is used to build short,
+ * stable keys for caches and content identifiers.
+ *
+ * \param [in] data pointer to the first byte
+ * \param [in] size number of bytes
+ * \param [in] h initial value (use to chain several blocks)
+ * \return 64-bit hash
+ **/
+inline
+uint64_t fnv1a(const void* data, size_t size, uint64_t h = fnv1a_basis)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i=0; i<size; i++)
+    {
+        h ^= p[i];
+        h *= fnv1a_prime;
+    }
+    return h;
+}
+
+/**
+ * \brief FNV-1a hash of a string
+ * \param [in] str the string to hash
+ * \param [in] h initial value (use to chain several strings)
+ * \return 64-bit hash
+ **/
+inline
+uint64_t fnv1a(const string& str, uint64_t h = fnv1a_basis)
+{
+    return fnv1a(str.data(), str.size(), h);
+}
+
+/**
+ * \brief fixed-width (16 character) lower-case hexadecimal
+ * representation of a 64-bit hash
+ **/
+inline
+string hex(uint64_t h)
+{
+    static const char digits[] = "0123456789abcdef";
+    string ret(16, '0');
+    for (int i=15; i>=0; i--)
+    {
+        ret[i] = digits[h & 0xf];
+        h >>= 4;
+    }
+    return ret;
+}
+
+} // namespace clas12::hash
+} // namespace clas12
+
+#endif // CLAS12_HASH_HPP
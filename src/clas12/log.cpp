@@ -1,5 +1,13 @@
 #include "log.hpp"
 
+namespace clas12
+{
+namespace logging
+{
+    std::atomic<int> threshold(info);
+}
+}
+
 #ifdef HAVE_BOOST_LOG
 
 #include <boost/log/core.hpp>
@@ -71,6 +79,7 @@ namespace logging
 
     void minimum_severity(severity_level min)
     {
+        threshold = min;
         core::get()->set_filter(severity >= min);
     }
 }
@@ -78,37 +87,64 @@ namespace logging
 
 #else // if not HAVE_BOOST_LOG
 
+#include <fstream>
+#include <memory>
+#include <mutex>
+
 namespace clas12
 {
 namespace logging
 {
-    void print_warning()
+    static const char* severity_names[] = {
+        "trace", "debug", "info", "warning", "error", "fatal"
+    };
+
+    static std::mutex sink_mutex;
+    static std::ostream* sink = &std::clog;
+    static std::unique_ptr<std::ofstream> file_sink;
+
+    void remove_all_sinks()
     {
-        static bool already_printed = false;
-        if (!already_printed)
-        {
-            std::clog << R"(
-#### NOTICE ####
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        sink = nullptr;
+        file_sink.reset();
+    }
 
-    this library was not compiled with Boost.Log.
-    probably because your version of Boost is out-
-    of-date. To gain control of the logging
-    mechanism, please upgrade your version of Boost
-    to at least 1.54
+    void add_file_log(const std::string& filename)
+    {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        file_sink.reset(new std::ofstream(filename, std::ios::app));
+        sink = file_sink.get();
+    }
+
+    void add_console_log(std::ostream& os)
+    {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        sink = &os;
+        file_sink.reset();
+    }
+
+    void minimum_severity(severity_level min)
+    {
+        threshold = min;
+    }
 
-################
+    Record::~Record()
+    {
+        std::string msg = _ss.str();
+        if (msg.empty() || msg.back() != '\n')
+        {
+            msg += '\n';
+        }
 
-            )";
-            already_printed = true;
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        if (sink)
+        {
+            *sink << "[" << severity_names[_level] << "] " << msg << std::flush;
         }
     }
-    void remove_all_sinks() {print_warning();}
-    void add_file_log(const std::string& filename) {print_warning();}
-    void add_console_log(std::ostream& os) {print_warning();}
-    void minimum_severity(severity_level min) {print_warning();}
 }
 }
 
 
 #endif
-
@@ -1,14 +1,25 @@
 #ifndef CLAS12_LOG_HPP
 #define CLAS12_LOG_HPP
 
+#include <atomic>
 #include <iostream>
+#include <sstream>
 #include <string>
 
+/**
+ * Messages below this severity are removed at compile time: the
+ * condition in LOG(x) is a constant and the statement is discarded by
+ * the optimizer. Set with "waf configure --log-level=<level>".
+ **/
+#ifndef CLAS12_LOG_LEVEL
+#define CLAS12_LOG_LEVEL 0
+#endif
+
 #ifdef HAVE_BOOST_LOG
 
 #include <boost/log/trivial.hpp>
 
-#define LOG(x) BOOST_LOG_TRIVIAL(x)
+#define CLAS12_LOG_STREAM(x) BOOST_LOG_TRIVIAL(x)
 
 namespace clas12
 {
@@ -36,7 +47,7 @@ namespace logging
 
 #else // if not HAVE_BOOST_LOG
 
-#define LOG(x) std::clog
+#define CLAS12_LOG_STREAM(x) clas12::logging::Record(clas12::logging::x).stream()
 
 namespace clas12
 {
@@ -56,10 +67,62 @@ namespace logging
     void add_file_log(const std::string& filename);
     void add_console_log(std::ostream& os);
     void minimum_severity(severity_level min);
+
+    /**
+     * \brief one message, written to the sink as a single line when
+     * it goes out of scope (at the end of the LOG statement)
+     **/
+    class Record
+    {
+      public:
+        Record(severity_level level)
+        : _level(level)
+        {}
+
+        ~Record();
+
+        std::ostream& stream()
+        {
+            return _ss;
+        }
+
+      private:
+        severity_level _level;
+        std::ostringstream _ss;
+    };
 }
 }
 
-
 #endif
 
+namespace clas12
+{
+namespace logging
+{
+    /// \brief the runtime minimum severity, set by minimum_severity()
+    extern std::atomic<int> threshold;
+
+    /**
+     * \brief check if messages of a severity are written
+     *
+     * LOG(x) calls this before anything is formatted, so arguments of
+     * suppressed messages are never evaluated. Use it directly to skip
+     * preparing expensive messages.
+     *
+     * \param [in] level the severity of the message
+     * \return true if the message would be written
+     **/
+    inline
+    bool enabled(severity_level level)
+    {
+        return int(level) >= CLAS12_LOG_LEVEL
+            && int(level) >= threshold.load(std::memory_order_relaxed);
+    }
+}
+}
+
+#define LOG(x) \
+    if (!clas12::logging::enabled(clas12::logging::x)) {} \
+    else CLAS12_LOG_STREAM(x)
+
 #endif // CLAS12_LOG_HPP
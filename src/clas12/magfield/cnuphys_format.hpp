@@ -0,0 +1,251 @@
+#ifndef CLAS12_MAGFIELD_CNUPHYS_FORMAT_HPP
+#define CLAS12_MAGFIELD_CNUPHYS_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "field_map_store.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+namespace cnuphys
+{
+
+using std::size_t;
+using std::int32_t;
+using std::uint16_t;
+using std::uint32_t;
+
+/// \brief size of the file header in bytes
+const size_t header_size = 80;
+
+/// \brief number of 32-bit words in the file header
+const size_t header_words = header_size / 4;
+
+/// \brief magic number at the start of the file
+const int32_t magic_number = 0xced;
+
+/// \brief header words holding the hash of a cache key
+/// (the first two of the "reserved" words)
+const size_t key_word = 17;
+
+/// \brief header word holding the type of the field values
+/// (the last "reserved" word, zero in files written by cnuphys)
+const size_t value_type_word = 19;
+
+/// \brief types of the field values following the header
+enum ValueType
+{
+    /// \brief IEEE single precision (the cnuphys format)
+    FLOAT32 = 0,
+
+    /// \brief IEEE half precision (derived maps only)
+    FLOAT16 = 1
+};
+
+/**
+ * \brief number of bytes used by one field value
+ * \param [in] type the value type
+ * \return 4 or 2
+ **/
+inline
+size_t value_size(ValueType type)
+{
+    return (type == FLOAT16) ? 2 : 4;
+}
+
+inline
+uint32_t swap32(uint32_t v)
+{
+    return ((v & 0x000000ffu) << 24)
+         | ((v & 0x0000ff00u) <<  8)
+         | ((v & 0x00ff0000u) >>  8)
+         | ((v & 0xff000000u) >> 24);
+}
+
+inline
+uint16_t swap16(uint16_t v)
+{
+    return uint16_t((v << 8) | (v >> 8));
+}
+
+/**
+ * \brief convert a half precision value to single precision
+ **/
+inline
+float half_to_float(uint16_t h)
+{
+    uint32_t sign = uint32_t(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1fu;
+    uint32_t mantissa = h & 0x3ffu;
+
+    uint32_t bits;
+    if (exponent == 0x1f)
+    {
+        // infinity or nan
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0)
+    {
+        bits = sign;
+    }
+    else
+    {
+        // subnormal: normalize the mantissa
+        exponent = 113;
+        while (!(mantissa & 0x400u))
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+
+    float f;
+    std::memcpy(&f, &bits, 4);
+    return f;
+}
+
+/**
+ * \brief convert a single precision value to half precision,
+ * rounding to nearest even
+ *
+ * Values too large for half precision become infinity.
+ **/
+inline
+uint16_t float_to_half(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, 4);
+
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t abs = bits & 0x7fffffffu;
+
+    if (abs >= 0x7f800000u)
+    {
+        // infinity or nan
+        return uint16_t(sign | 0x7c00u | ((abs > 0x7f800000u) ? 0x200u : 0u));
+    }
+    if (abs >= 0x477ff000u)
+    {
+        // rounds to more than 65504
+        return uint16_t(sign | 0x7c00u);
+    }
+    if (abs < 0x33000001u)
+    {
+        // rounds to zero
+        return uint16_t(sign);
+    }
+
+    int32_t exponent = int32_t(abs >> 23) - 112;
+    uint32_t mantissa = (abs & 0x7fffffu) | 0x800000u;
+    int shift = 13;
+    if (exponent <= 0)
+    {
+        // subnormal result
+        shift += 1 - exponent;
+        exponent = 0;
+    }
+
+    // for subnormals the implicit bit lands in the mantissa
+    uint32_t h = (uint32_t(exponent) << 10) | ((mantissa >> shift) & 0x3ffu);
+    if (exponent == 0)
+    {
+        h = mantissa >> shift;
+    }
+
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t half_way = 1u << (shift - 1);
+    if (rest > half_way || (rest == half_way && (h & 1u)))
+    {
+        // may carry into the exponent, which is the correct result
+        h++;
+    }
+    return uint16_t(sign | h);
+}
+
+/**
+ * \brief reads the words of a field map in the file's byte order
+ **/
+class WordReader
+{
+  public:
+    WordReader(const byte* data, bool swap)
+    : _data(data)
+    , _swap(swap)
+    {}
+
+    uint32_t word(size_t i) const
+    {
+        uint32_t v;
+        std::memcpy(&v, _data + 4*i, 4);
+        return _swap ? swap32(v) : v;
+    }
+
+    int32_t integer(size_t i) const
+    {
+        uint32_t v = this->word(i);
+        int32_t r;
+        std::memcpy(&r, &v, 4);
+        return r;
+    }
+
+    float real(size_t i) const
+    {
+        uint32_t v = this->word(i);
+        float r;
+        std::memcpy(&r, &v, 4);
+        return r;
+    }
+
+    /// \brief the i'th half precision value counted from the
+    /// start of the file
+    float half(size_t i) const
+    {
+        uint16_t v;
+        std::memcpy(&v, _data + 2*i, 2);
+        return half_to_float(_swap ? swap16(v) : v);
+    }
+
+    /// \brief the i'th field value of the given type counted
+    /// from the end of the header
+    float value(ValueType type, size_t i) const
+    {
+        return (type == FLOAT16) ? this->half(header_size/2 + i)
+                                 : this->real(header_words + i);
+    }
+
+  private:
+    const byte* _data;
+    bool _swap;
+};
+
+/**
+ * \brief a reader for the file's byte order, found from the magic number
+ *
+ * \param [in] data the start of the file (at least 4 bytes)
+ * \param [out] valid false if the magic number is not found
+ *              in either byte order
+ **/
+inline
+WordReader reader(const byte* data, bool& valid)
+{
+    WordReader native(data, false);
+    bool swap = (native.integer(0) != magic_number);
+    WordReader in(data, swap);
+    valid = (in.integer(0) == magic_number);
+    return in;
+}
+
+} // namespace clas12::magfield::cnuphys
+} // namespace clas12::magfield
+} // namespace clas12
+
+#endif // CLAS12_MAGFIELD_CNUPHYS_FORMAT_HPP
@@ -0,0 +1,429 @@
+#include "composite_field.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/hash.hpp"
+
+#include "field_map_store.hpp"
+#include "request.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+namespace fs = boost::filesystem;
+
+using std::cos;
+using std::sin;
+using std::ios;
+using std::make_shared;
+using std::max;
+using std::min;
+using std::ofstream;
+using std::runtime_error;
+using std::setprecision;
+using std::stringstream;
+using std::uint32_t;
+using std::uint64_t;
+
+namespace
+{
+    const double deg2rad = M_PI / 180.;
+
+    /// \brief number of 32-bit words in the cnuphys header
+    const size_t header_words = 20;
+
+    /// \brief header words holding the hash of the cache key
+    /// (the first two of the "reserved" words)
+    const size_t key_word = 17;
+
+    void put_word(vector<byte>& buf, size_t i, uint32_t v)
+    {
+        std::memcpy(&buf[4*i], &v, 4);
+    }
+
+    void put_int(vector<byte>& buf, size_t i, int32_t v)
+    {
+        std::memcpy(&buf[4*i], &v, 4);
+    }
+
+    void put_float(vector<byte>& buf, size_t i, float v)
+    {
+        std::memcpy(&buf[4*i], &v, 4);
+    }
+
+    uint32_t get_word(const byte* data, size_t i)
+    {
+        uint32_t v;
+        std::memcpy(&v, data + 4*i, 4);
+        return v;
+    }
+
+    /**
+     * \brief number of grid points covering [lo, hi] with
+     * at most the given spacing
+     **/
+    size_t npoints(double lo, double hi, double spacing)
+    {
+        if (spacing <= 0)
+        {
+            return 2;
+        }
+        return max(size_t(2), size_t(std::ceil((hi - lo) / spacing - 1.e-6)) + 1);
+    }
+}
+
+/**
+ * \brief the combined field of the torus and solenoid maps served
+ * by the magfield Request
+ *
+ * \param [in] torus_scale factor applied to the torus field
+ * \param [in] solenoid_scale factor applied to the solenoid field
+ **/
+CompositeField::CompositeField(double torus_scale, double solenoid_scale)
+: _torus(make_shared<FieldMap>(Request("torus").view()))
+, _solenoid(make_shared<FieldMap>(Request("solenoid").view()))
+, _torus_scale(torus_scale)
+, _solenoid_scale(solenoid_scale)
+{
+}
+
+/**
+ * \brief the combined field of two field maps
+ *
+ * \param [in] torus the torus field map
+ * \param [in] solenoid the solenoid field map
+ * \param [in] torus_scale factor applied to the torus field
+ * \param [in] solenoid_scale factor applied to the solenoid field
+ **/
+CompositeField::CompositeField(
+    const shared_ptr<const FieldMap>& torus,
+    const shared_ptr<const FieldMap>& solenoid,
+    double torus_scale,
+    double solenoid_scale)
+: _torus(torus)
+, _solenoid(solenoid)
+, _torus_scale(torus_scale)
+, _solenoid_scale(solenoid_scale)
+{
+    if (!_torus || !_solenoid)
+    {
+        throw runtime_error("CompositeField needs both a torus and a solenoid field map");
+    }
+}
+
+/**
+ * \brief where precomputed grids are kept unless told otherwise
+ * \return cache_directory()
+ **/
+string CompositeField::default_directory()
+{
+    return cache_directory();
+}
+
+/**
+ * \brief a grid covering both maps
+ *
+ * The grid spans one sector in phi at the torus map's phi spacing and
+ * the union of both maps in rho and z at the coarser of their two
+ * spacings. The solenoid map is usually much finer than the torus;
+ * pass a finer grid to precompute() where its detail matters more
+ * than the size of the grid.
+ *
+ * \return the default grid for CompositeField::precompute()
+ **/
+CompositeField::Grid CompositeField::default_grid() const
+{
+    const FieldMap& t = *_torus;
+    const FieldMap& s = *_solenoid;
+
+    double dphi = (t.nphi() > 1) ? (t.phimax() - t.phimin()) / (t.nphi() - 1) : 1.;
+    double drho = max((t.rhomax() - t.rhomin()) / (t.nrho() - 1),
+                      (s.rhomax() - s.rhomin()) / (s.nrho() - 1));
+    double dz   = max((t.zmax() - t.zmin()) / (t.nz() - 1),
+                      (s.zmax() - s.zmin()) / (s.nz() - 1));
+
+    Grid grid;
+    grid.phimin = 0;
+    grid.phimax = 60;
+    grid.nphi = npoints(0, 60, dphi);
+    grid.rhomin = min(t.rhomin(), s.rhomin());
+    grid.rhomax = max(t.rhomax(), s.rhomax());
+    grid.nrho = npoints(grid.rhomin, grid.rhomax, drho);
+    grid.zmin = min(t.zmin(), s.zmin());
+    grid.zmax = max(t.zmax(), s.zmax());
+    grid.nz = npoints(grid.zmin, grid.zmax, dz);
+    return grid;
+}
+
+/**
+ * \brief the key identifying a precomputed grid
+ *
+ * \param [in] grid the grid to tabulate the field on
+ * \return string built from the input maps, scale factors and grid
+ **/
+string CompositeField::cache_key(const Grid& grid) const
+{
+    stringstream ss;
+    ss << setprecision(17)
+       << "torus=" << hash::hex(_torus->checksum()) << "\n"
+       << "solenoid=" << hash::hex(_solenoid->checksum()) << "\n"
+       << "torus_scale=" << _torus_scale << "\n"
+       << "solenoid_scale=" << _solenoid_scale << "\n"
+       << "phi=" << grid.phimin << "," << grid.phimax << "," << grid.nphi << "\n"
+       << "rho=" << grid.rhomin << "," << grid.rhomax << "," << grid.nrho << "\n"
+       << "z=" << grid.zmin << "," << grid.zmax << "," << grid.nz << "\n";
+    return ss.str();
+}
+
+/**
+ * \brief tabulate the summed field on the default grid
+ * \param [in] directory where the grid is cached
+ **/
+void CompositeField::precompute(const string& directory)
+{
+    this->precompute(this->default_grid(), directory);
+}
+
+/**
+ * \brief tabulate the summed field on a grid
+ *
+ * If the grid for this combination of maps, scale factors and grid is
+ * found in the cache directory it is mapped from there. Otherwise it
+ * is computed and written to the cache. Failing to write the cache is
+ * not an error: the grid is then only kept in memory. An empty
+ * directory disables the cache.
+ *
+ * \param [in] grid the grid to tabulate the field on
+ * \param [in] directory where the grid is cached
+ **/
+void CompositeField::precompute(const Grid& grid, const string& directory)
+{
+    if (grid.nphi < 2 || grid.nrho < 2 || grid.nz < 2)
+    {
+        throw runtime_error("precomputed field grid is too small");
+    }
+
+    string key = this->cache_key(grid);
+    uint64_t key_hash = hash::fnv1a(key);
+
+    string filename;
+    if (!directory.empty())
+    {
+        filename = (fs::path(directory) / ("composite_" + hash::hex(key_hash) + ".dat")).string();
+
+        if (fs::exists(filename))
+        {
+            try
+            {
+                FieldMapView view = FieldMapStore::instance().get(filename);
+                if (view.size() >= 4*header_words
+                 && get_word(view.data(), key_word) == uint32_t(key_hash >> 32)
+                 && get_word(view.data(), key_word+1) == uint32_t(key_hash))
+                {
+                    _combined = make_shared<FieldMap>(view);
+                    return;
+                }
+                FieldMapStore::instance().release(filename);
+            }
+            catch (runtime_error&)
+            {
+                // unreadable or corrupt: recompute below
+                FieldMapStore::instance().release(filename);
+            }
+        }
+    }
+
+    vector<byte> buf = this->tabulate(grid, key);
+    _combined = make_shared<FieldMap>(buf.data(), buf.size());
+
+    if (filename.empty())
+    {
+        return;
+    }
+
+    // write to a temporary file and rename into place
+    // so other processes never see a partial grid
+    stringstream tmpname;
+    tmpname << filename << ".tmp." << ::getpid();
+    try
+    {
+        fs::create_directories(directory);
+        {
+            ofstream fout(tmpname.str(), ios::binary | ios::trunc);
+            fout.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+            if (!fout.flush())
+            {
+                throw runtime_error("could not write file: " + tmpname.str());
+            }
+        }
+        if (std::rename(tmpname.str().c_str(), filename.c_str()) != 0)
+        {
+            throw runtime_error("could not rename " + tmpname.str() + " to " + filename);
+        }
+    }
+    catch (std::exception&)
+    {
+        std::remove(tmpname.str().c_str());
+    }
+}
+
+/**
+ * \brief the summed field on a grid in the cnuphys binary format
+ *
+ * The file is written in the native byte order with a cylindrical
+ * grid, cartesian field components, cm, degrees and kG. The hash of
+ * the cache key is kept in the first two reserved header words.
+ **/
+vector<byte> CompositeField::tabulate(const Grid& grid, const string& key) const
+{
+    size_t npoints = grid.nphi * grid.nrho * grid.nz;
+    vector<byte> buf(4 * (header_words + 3*npoints));
+
+    uint64_t key_hash = hash::fnv1a(key);
+    uint64_t now = uint64_t(std::time(nullptr)) * 1000;
+
+    put_int(buf, 0, 0xced);
+    put_int(buf, 1, 0);
+    put_int(buf, 2, 1);
+    put_int(buf, 3, 0);
+    put_int(buf, 4, 0);
+    put_int(buf, 5, 0);
+    put_float(buf, 6, grid.phimin);
+    put_float(buf, 7, grid.phimax);
+    put_int(buf, 8, grid.nphi);
+    put_float(buf, 9, grid.rhomin);
+    put_float(buf, 10, grid.rhomax);
+    put_int(buf, 11, grid.nrho);
+    put_float(buf, 12, grid.zmin);
+    put_float(buf, 13, grid.zmax);
+    put_int(buf, 14, grid.nz);
+    put_word(buf, 15, uint32_t(now >> 32));
+    put_word(buf, 16, uint32_t(now));
+    put_word(buf, key_word, uint32_t(key_hash >> 32));
+    put_word(buf, key_word+1, uint32_t(key_hash));
+    put_word(buf, 19, 0);
+
+    double dphi = (grid.phimax - grid.phimin) / (grid.nphi - 1);
+    double drho = (grid.rhomax - grid.rhomin) / (grid.nrho - 1);
+    double dz = (grid.zmax - grid.zmin) / (grid.nz - 1);
+
+    vector<double> x(grid.nz), y(grid.nz), z(grid.nz);
+    vector<double> bx(grid.nz), by(grid.nz), bz(grid.nz);
+    for (size_t iz=0; iz<grid.nz; iz++)
+    {
+        z[iz] = grid.zmin + iz * dz;
+    }
+
+    size_t iword = header_words;
+    for (size_t ip=0; ip<grid.nphi; ip++)
+    {
+        double phi = (grid.phimin + ip * dphi) * deg2rad;
+        double cphi = cos(phi);
+        double sphi = sin(phi);
+
+        for (size_t ir=0; ir<grid.nrho; ir++)
+        {
+            double rho = grid.rhomin + ir * drho;
+            std::fill(x.begin(), x.end(), rho * cphi);
+            std::fill(y.begin(), y.end(), rho * sphi);
+
+            this->sum(grid.nz, x.data(), y.data(), z.data(), bx.data(), by.data(), bz.data());
+
+            for (size_t iz=0; iz<grid.nz; iz++)
+            {
+                put_float(buf, iword++, bx[iz]);
+                put_float(buf, iword++, by[iz]);
+                put_float(buf, iword++, bz[iz]);
+            }
+        }
+    }
+
+    return buf;
+}
+
+/**
+ * \brief the combined magnetic field at a point
+ *
+ * \param [in] x,y,z position (cm)
+ * \param [out] bx,by,bz magnetic field (kG)
+ **/
+void CompositeField::B(const double& x, const double& y, const double& z,
+                       double& bx, double& by, double& bz) const
+{
+    if (_combined)
+    {
+        _combined->B(x, y, z, bx, by, bz);
+        return;
+    }
+
+    double tx, ty, tz;
+    double sx, sy, sz;
+    _torus->B(x, y, z, tx, ty, tz);
+    _solenoid->B(x, y, z, sx, sy, sz);
+    bx = _torus_scale * tx + _solenoid_scale * sx;
+    by = _torus_scale * ty + _solenoid_scale * sy;
+    bz = _torus_scale * tz + _solenoid_scale * sz;
+}
+
+/**
+ * \brief the combined magnetic field at many points
+ *
+ * \param [in] n number of points
+ * \param [in] x,y,z arrays of n positions (cm)
+ * \param [out] bx,by,bz arrays of n field values (kG)
+ **/
+void CompositeField::B(size_t n,
+                       const double* x, const double* y, const double* z,
+                       double* bx, double* by, double* bz) const
+{
+    if (_combined)
+    {
+        _combined->B(n, x, y, z, bx, by, bz);
+    }
+    else
+    {
+        this->sum(n, x, y, z, bx, by, bz);
+    }
+}
+
+/**
+ * \brief the scaled sum of the two field maps at many points,
+ * ignoring any precomputed grid
+ **/
+void CompositeField::sum(size_t n,
+                         const double* x, const double* y, const double* z,
+                         double* bx, double* by, double* bz) const
+{
+    _torus->B(n, x, y, z, bx, by, bz);
+
+    vector<double> sx(n), sy(n), sz(n);
+    _solenoid->B(n, x, y, z, sx.data(), sy.data(), sz.data());
+
+    for (size_t i=0; i<n; i++)
+    {
+        bx[i] = _torus_scale * bx[i] + _solenoid_scale * sx[i];
+        by[i] = _torus_scale * by[i] + _solenoid_scale * sy[i];
+        bz[i] = _torus_scale * bz[i] + _solenoid_scale * sz[i];
+    }
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
@@ -0,0 +1,165 @@
+#ifndef CLAS12_MAGFIELD_COMPOSITE_FIELD_HPP
+#define CLAS12_MAGFIELD_COMPOSITE_FIELD_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "field_map.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+/**
+ * \brief the sum of the torus and solenoid fields, each scaled to
+ * the current in its magnet
+ *
+ * By default, the field at a point is the scaled sum of the two
+ * interpolated maps. After CompositeField::precompute(), the summed
+ * field is tabulated on a single grid and each evaluation is one
+ * interpolation instead of two.
+ *
+ * The solenoid field is axially symmetric but, unlike the torus, not
+ * mirror symmetric about the middle of a sector in the same sense, so
+ * the combined grid covers a whole sector: phi = 0 to 60 degrees.
+ *
+ * The precomputed grid is stored in the cnuphys binary format in a
+ * cache directory, in a file named after a hash of the two input maps,
+ * the scale factors and the grid. Later processes asking for the same
+ * combination map the file instead of recomputing it.
+ **/
+class CompositeField
+{
+  public:
+    /**
+     * \brief extent and number of points of a grid in (phi, rho, z)
+     * in degrees and cm
+     **/
+    struct Grid
+    {
+        float phimin;
+        float phimax;
+        size_t nphi;
+        float rhomin;
+        float rhomax;
+        size_t nrho;
+        float zmin;
+        float zmax;
+        size_t nz;
+    };
+
+    CompositeField(double torus_scale = 1., double solenoid_scale = 1.);
+    CompositeField(
+        const shared_ptr<const FieldMap>& torus,
+        const shared_ptr<const FieldMap>& solenoid,
+        double torus_scale = 1.,
+        double solenoid_scale = 1.);
+
+    static string default_directory();
+
+    // inline methods
+    const double& torus_scale() const;
+    const double& solenoid_scale() const;
+    bool precomputed() const;
+    const FieldMap& torus() const;
+    const FieldMap& solenoid() const;
+
+    // methods in cpp file
+    Grid default_grid() const;
+    string cache_key(const Grid& grid) const;
+
+    void precompute(const string& directory = CompositeField::default_directory());
+    void precompute(const Grid& grid,
+                    const string& directory = CompositeField::default_directory());
+
+    void B(const double& x, const double& y, const double& z,
+           double& bx, double& by, double& bz) const;
+
+    void B(size_t n,
+           const double* x, const double* y, const double* z,
+           double* bx, double* by, double* bz) const;
+
+  private:
+    /// \brief the torus field map
+    shared_ptr<const FieldMap> _torus;
+
+    /// \brief the solenoid field map
+    shared_ptr<const FieldMap> _solenoid;
+
+    /// \brief factor applied to the torus field
+    double _torus_scale;
+
+    /// \brief factor applied to the solenoid field
+    double _solenoid_scale;
+
+    /// \brief the precomputed sum (null until precompute() is called)
+    shared_ptr<const FieldMap> _combined;
+
+    vector<byte> tabulate(const Grid& grid, const string& key) const;
+
+    void sum(size_t n,
+             const double* x, const double* y, const double* z,
+             double* bx, double* by, double* bz) const;
+};
+
+/**
+ * \brief factor applied to the torus field
+ * \return const reference to CompositeField::_torus_scale
+ **/
+inline
+const double& CompositeField::torus_scale() const
+{
+    return _torus_scale;
+}
+
+/**
+ * \brief factor applied to the solenoid field
+ * \return const reference to CompositeField::_solenoid_scale
+ **/
+inline
+const double& CompositeField::solenoid_scale() const
+{
+    return _solenoid_scale;
+}
+
+/**
+ * \brief check if the summed field has been tabulated
+ * \return true after a successful call to CompositeField::precompute()
+ **/
+inline
+bool CompositeField::precomputed() const
+{
+    return bool(_combined);
+}
+
+/**
+ * \brief the torus field map (unscaled)
+ * \return const reference to the torus FieldMap
+ **/
+inline
+const FieldMap& CompositeField::torus() const
+{
+    return *_torus;
+}
+
+/**
+ * \brief the solenoid field map (unscaled)
+ * \return const reference to the solenoid FieldMap
+ **/
+inline
+const FieldMap& CompositeField::solenoid() const
+{
+    return *_solenoid;
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
+
+#endif // CLAS12_MAGFIELD_COMPOSITE_FIELD_HPP
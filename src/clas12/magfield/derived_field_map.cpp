@@ -0,0 +1,718 @@
+#include "derived_field_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "clas12/hash.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+namespace fs = boost::filesystem;
+
+using std::ceil;
+using std::floor;
+using std::ios;
+using std::lock_guard;
+using std::make_shared;
+using std::map;
+using std::max;
+using std::min;
+using std::mutex;
+using std::ofstream;
+using std::runtime_error;
+using std::setprecision;
+using std::sqrt;
+using std::stringstream;
+using std::uint16_t;
+using std::uint32_t;
+
+using boost::is_any_of;
+using boost::lexical_cast;
+using boost::split;
+using boost::to_lower_copy;
+using boost::trim_copy;
+
+using cnuphys::header_size;
+using cnuphys::header_words;
+using cnuphys::WordReader;
+
+namespace
+{
+    const double rad2deg = 180. / M_PI;
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    /// \brief region edges within this fraction of the grid spacing
+    /// of a grid point are taken to be on it
+    const double grid_tolerance = 1.e-6;
+
+    /// \brief the grid points kept along one axis
+    struct Selection
+    {
+        size_t first;
+        size_t count;
+    };
+
+    /**
+     * \brief choose the grid points covering [lo, hi] along one axis
+     *
+     * The range is extended outwards to the nearest grid points and,
+     * with a stride, further out so that the kept points still cover
+     * it where the grid allows.
+     *
+     * \param [in] qmin,qmax,n the axis in the file's units
+     * \param [in] lo,hi the range to keep in the file's units
+     * \param [in] stride keep every stride'th point
+     * \param [in] name of the axis for error messages
+     **/
+    Selection select(double qmin, double qmax, size_t n,
+                     double lo, double hi, size_t stride,
+                     const string& name)
+    {
+        Selection sel = {0, 1};
+        if (n == 1)
+        {
+            return sel;
+        }
+
+        double d = (qmax - qmin) / (n - 1);
+        double ulo = max(0., (lo - qmin) / d);
+        double uhi = min(double(n - 1), (hi - qmin) / d);
+        if (!(uhi > ulo))
+        {
+            throw runtime_error("region does not overlap the field map in " + name);
+        }
+
+        size_t i0 = size_t(floor(ulo + grid_tolerance));
+        size_t i1 = size_t(ceil(uhi - grid_tolerance));
+        if (i1 <= i0)
+        {
+            i1 = i0 + 1;
+        }
+
+        size_t k = (i1 - i0 + stride - 1) / stride;
+        if (i0 + k*stride > n-1)
+        {
+            if (k*stride <= n-1)
+            {
+                // move the start down to keep the end
+                i0 = n-1 - k*stride;
+            }
+            else
+            {
+                i0 = 0;
+                k = (n-1) / stride;
+            }
+        }
+
+        if (k < 1)
+        {
+            stringstream ss;
+            ss << "stride " << stride << " leaves fewer than two grid points in " << name;
+            throw runtime_error(ss.str());
+        }
+
+        sel.first = i0;
+        sel.count = k + 1;
+        return sel;
+    }
+
+    void put_word(vector<byte>& buf, size_t i, uint32_t v)
+    {
+        std::memcpy(&buf[4*i], &v, 4);
+    }
+
+    void put_int(vector<byte>& buf, size_t i, int32_t v)
+    {
+        std::memcpy(&buf[4*i], &v, 4);
+    }
+
+    void put_float(vector<byte>& buf, size_t i, float v)
+    {
+        std::memcpy(&buf[4*i], &v, 4);
+    }
+
+    /**
+     * \brief write a file by writing a temporary file and
+     * renaming it into place, so readers never see part of it
+     **/
+    void write_file(const string& filename, const vector<byte>& buf)
+    {
+        stringstream tmpname;
+        tmpname << filename << ".tmp." << ::getpid();
+        try
+        {
+            {
+                ofstream fout(tmpname.str(), ios::binary | ios::trunc);
+                fout.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+                if (!fout.flush())
+                {
+                    throw runtime_error("could not write file: " + tmpname.str());
+                }
+            }
+            if (std::rename(tmpname.str().c_str(), filename.c_str()) != 0)
+            {
+                throw runtime_error("could not rename " + tmpname.str() + " to " + filename);
+            }
+        }
+        catch (...)
+        {
+            std::remove(tmpname.str().c_str());
+            throw;
+        }
+    }
+
+    /**
+     * \brief check that a derived map was made with the given key
+     **/
+    bool has_key(const FieldMapView& view, uint64_t key_hash)
+    {
+        if (view.size() < header_size)
+        {
+            return false;
+        }
+        bool valid;
+        WordReader in = cnuphys::reader(view.data(), valid);
+        return valid
+            && in.word(cnuphys::key_word) == uint32_t(key_hash >> 32)
+            && in.word(cnuphys::key_word+1) == uint32_t(key_hash);
+    }
+
+    /// \brief derived maps already made by this process by key hash
+    map<uint64_t, FieldMapView> derived_maps;
+
+    /// \brief guards derived_maps
+    mutex derived_maps_mutex;
+}
+
+/**
+ * \brief default options: the full map at its own precision
+ **/
+DerivedMapOptions::DerivedMapOptions()
+: precision(cnuphys::FLOAT32)
+, stride(1)
+, phimin(-infinity)
+, phimax(infinity)
+, rhomin(-infinity)
+, rhomax(infinity)
+, zmin(-infinity)
+, zmax(infinity)
+{
+}
+
+/**
+ * \brief set the type of the stored field values
+ * \param [in] precision "float32" or "float16" (also "float" and "half")
+ **/
+void DerivedMapOptions::set_precision(const string& precision)
+{
+    string p = to_lower_copy(trim_copy(precision));
+    if (p == "float32" || p == "float")
+    {
+        this->precision = cnuphys::FLOAT32;
+    }
+    else if (p == "float16" || p == "half")
+    {
+        this->precision = cnuphys::FLOAT16;
+    }
+    else
+    {
+        throw runtime_error("unknown field map precision: " + precision);
+    }
+}
+
+/**
+ * \brief set the stride along each axis of the grid
+ * \param [in] stride a positive integer
+ **/
+void DerivedMapOptions::set_stride(const string& stride)
+{
+    int s;
+    try
+    {
+        s = lexical_cast<int>(trim_copy(stride));
+    }
+    catch (...)
+    {
+        throw runtime_error("could not convert stride to integer: " + stride);
+    }
+    if (s < 1)
+    {
+        throw runtime_error("stride must be at least 1: " + stride);
+    }
+    this->stride = s;
+}
+
+/**
+ * \brief set the part of the grid to keep
+ *
+ * The region is a list of ranges separated by commas or spaces, each
+ * of the form axis:min:max where axis is phi (deg), rho (cm) or z
+ * (cm). Axes not listed are kept whole. Example:
+ *
+ *     rho:0:300,z:100:500
+ *
+ * \param [in] region the ranges to keep
+ **/
+void DerivedMapOptions::set_region(const string& region)
+{
+    vector<string> items;
+    string r = to_lower_copy(trim_copy(region));
+    split(items, r, is_any_of(" ,;|"), boost::token_compress_on);
+
+    for (const auto& item : items)
+    {
+        if (item.empty())
+        {
+            continue;
+        }
+
+        vector<string> parts;
+        split(parts, item, is_any_of(":"));
+        if (parts.size() != 3)
+        {
+            throw runtime_error("region must be a list of axis:min:max, got: " + item);
+        }
+
+        double lo, hi;
+        try
+        {
+            lo = lexical_cast<double>(parts[1]);
+            hi = lexical_cast<double>(parts[2]);
+        }
+        catch (...)
+        {
+            throw runtime_error("could not convert region limits to numbers: " + item);
+        }
+        if (!(hi > lo))
+        {
+            throw runtime_error("region is empty: " + item);
+        }
+
+        if (parts[0] == "phi")
+        {
+            phimin = lo;
+            phimax = hi;
+        }
+        else if (parts[0] == "rho")
+        {
+            rhomin = lo;
+            rhomax = hi;
+        }
+        else if (parts[0] == "z")
+        {
+            zmin = lo;
+            zmax = hi;
+        }
+        else
+        {
+            throw runtime_error("unknown region axis (phi, rho or z): " + parts[0]);
+        }
+    }
+}
+
+/**
+ * \brief check if the options describe the full map unchanged
+ * \return true for float32 values, a stride of 1 and no region
+ **/
+bool DerivedMapOptions::identity() const
+{
+    return precision == cnuphys::FLOAT32 && stride == 1 && this->full_region();
+}
+
+/**
+ * \brief check if no region is set
+ * \return true if the region is unbounded along all axes
+ **/
+bool DerivedMapOptions::full_region() const
+{
+    return phimin == -infinity && phimax == infinity
+        && rhomin == -infinity && rhomax == infinity
+        && zmin == -infinity && zmax == infinity;
+}
+
+/**
+ * \brief a string identifying the options, for cache keys and logs
+ * \return e.g. "precision=float16 stride=2 region=rho:0:300"
+ **/
+string DerivedMapOptions::key() const
+{
+    stringstream ss;
+    ss << setprecision(17)
+       << "precision=" << ((precision == cnuphys::FLOAT16) ? "float16" : "float32")
+       << " stride=" << stride;
+
+    stringstream rg;
+    rg << setprecision(17);
+    if (phimin != -infinity || phimax != infinity)
+    {
+        rg << ",phi:" << phimin << ":" << phimax;
+    }
+    if (rhomin != -infinity || rhomax != infinity)
+    {
+        rg << ",rho:" << rhomin << ":" << rhomax;
+    }
+    if (zmin != -infinity || zmax != infinity)
+    {
+        rg << ",z:" << zmin << ":" << zmax;
+    }
+    if (!rg.str().empty())
+    {
+        ss << " region=" << rg.str().substr(1);
+    }
+    return ss.str();
+}
+
+/**
+ * \brief a smaller field map made from a full one
+ *
+ * The result is in the cnuphys binary format, in the native byte
+ * order, with the same coordinate systems and units as the input.
+ * Half precision values are marked in the value type header word
+ * (see FieldMap).
+ *
+ * A region on a map with sector symmetry restricts the map to that
+ * region: the field is zero elsewhere. Without a region in phi, the
+ * stride must divide the number of phi intervals so that the map
+ * keeps its symmetry.
+ *
+ * \param [in] data the contents of a field map file
+ * \param [in] size number of bytes in data
+ * \param [in] opts what to keep
+ * \param [in] key_hash stored in the first two reserved header words
+ * \return the derived field map file
+ **/
+vector<byte> derive_field_map(const byte* data, size_t size,
+                              const DerivedMapOptions& opts,
+                              uint64_t key_hash)
+{
+    if (size < header_size)
+    {
+        throw runtime_error("field map too short for its header");
+    }
+
+    bool valid;
+    WordReader in = cnuphys::reader(data, valid);
+    if (!valid)
+    {
+        throw runtime_error("not a field map: bad magic number");
+    }
+
+    int32_t value_type = in.integer(cnuphys::value_type_word);
+    if (value_type != cnuphys::FLOAT32 && value_type != cnuphys::FLOAT16)
+    {
+        throw runtime_error("unknown field map value type");
+    }
+    cnuphys::ValueType vtype = cnuphys::ValueType(value_type);
+
+    // the region is given in cm and deg
+    double length_scale = (in.integer(3) == 1) ? 100. : 1.;
+    double angle_scale = (in.integer(4) == 1) ? rad2deg : 1.;
+
+    float phimin = in.real(6);
+    float phimax = in.real(7);
+    int32_t nphi = in.integer(8);
+    float rhomin = in.real(9);
+    float rhomax = in.real(10);
+    int32_t nrho = in.integer(11);
+    float zmin = in.real(12);
+    float zmax = in.real(13);
+    int32_t nz = in.integer(14);
+
+    if (nphi < 1 || nrho < 2 || nz < 2)
+    {
+        throw runtime_error("field map grid is too small");
+    }
+    if (size < header_size + 3 * cnuphys::value_size(vtype) * nphi * nrho * nz)
+    {
+        throw runtime_error("field map is truncated");
+    }
+
+    size_t s = opts.stride;
+    Selection sphi = select(phimin, phimax, nphi,
+                            opts.phimin / angle_scale, opts.phimax / angle_scale,
+                            s, "phi");
+    Selection srho = select(rhomin, rhomax, nrho,
+                            opts.rhomin / length_scale, opts.rhomax / length_scale,
+                            s, "rho");
+    Selection sz = select(zmin, zmax, nz,
+                          opts.zmin / length_scale, opts.zmax / length_scale,
+                          s, "z");
+
+    if (nphi > 1 && opts.phimin == -infinity && opts.phimax == infinity
+     && (sphi.first != 0 || sphi.first + (sphi.count-1)*s != size_t(nphi-1)))
+    {
+        stringstream ss;
+        ss << "stride " << s << " does not divide the " << (nphi-1)
+           << " phi intervals of the field map";
+        throw runtime_error(ss.str());
+    }
+
+    // the edges of the kept grid, exact where they are the input's edges
+    auto edge = [](float qmin, float qmax, int32_t n, size_t i) -> float
+    {
+        if (i == 0)
+        {
+            return qmin;
+        }
+        if (i == size_t(n-1))
+        {
+            return qmax;
+        }
+        return qmin + (double(qmax) - qmin) * i / (n-1);
+    };
+
+    size_t npoints = sphi.count * srho.count * sz.count;
+    size_t vsize = cnuphys::value_size(opts.precision);
+    vector<byte> buf(header_size + 3 * vsize * npoints);
+
+    for (size_t i=0; i<header_words; i++)
+    {
+        put_word(buf, i, in.word(i));
+    }
+    put_float(buf, 6, edge(phimin, phimax, nphi, sphi.first));
+    put_float(buf, 7, edge(phimin, phimax, nphi, sphi.first + (sphi.count-1)*s));
+    put_int(buf, 8, sphi.count);
+    put_float(buf, 9, edge(rhomin, rhomax, nrho, srho.first));
+    put_float(buf, 10, edge(rhomin, rhomax, nrho, srho.first + (srho.count-1)*s));
+    put_int(buf, 11, srho.count);
+    put_float(buf, 12, edge(zmin, zmax, nz, sz.first));
+    put_float(buf, 13, edge(zmin, zmax, nz, sz.first + (sz.count-1)*s));
+    put_int(buf, 14, sz.count);
+    put_word(buf, cnuphys::key_word, uint32_t(key_hash >> 32));
+    put_word(buf, cnuphys::key_word+1, uint32_t(key_hash));
+    put_int(buf, cnuphys::value_type_word, opts.precision);
+
+    byte* out = buf.data() + header_size;
+    for (size_t ip=0; ip<sphi.count; ip++)
+    {
+        size_t jp = sphi.first + ip*s;
+        for (size_t ir=0; ir<srho.count; ir++)
+        {
+            size_t jr = srho.first + ir*s;
+            for (size_t iz=0; iz<sz.count; iz++)
+            {
+                size_t jz = sz.first + iz*s;
+                size_t src = (jp * nrho + jr) * nz + jz;
+
+                for (size_t c=0; c<3; c++)
+                {
+                    float v = in.value(vtype, 3*src + c);
+                    if (opts.precision == cnuphys::FLOAT16)
+                    {
+                        uint16_t h = cnuphys::float_to_half(v);
+                        if ((h & 0x7c00u) == 0x7c00u && std::isfinite(v))
+                        {
+                            throw runtime_error("field value too large for float16");
+                        }
+                        std::memcpy(out, &h, 2);
+                    }
+                    else
+                    {
+                        std::memcpy(out, &v, 4);
+                    }
+                    out += vsize;
+                }
+            }
+        }
+    }
+
+    return buf;
+}
+
+/**
+ * \brief a derived field map, made once and cached
+ *
+ * Derived maps are kept for the life of the process and written to
+ * the cache directory, named after a hash of the source file's path,
+ * size and modification time and of the options, so that later
+ * processes map the file instead of deriving it again. If the cache
+ * directory can not be written to, the map is only kept in memory. An
+ * empty directory disables the file cache.
+ *
+ * \param [in] full the full field map file
+ * \param [in] opts what to keep
+ * \param [in] directory where derived maps are cached
+ * \return view of the derived map, or full if opts is the identity
+ **/
+FieldMapView derived_field_map(const FieldMapView& full,
+                               const DerivedMapOptions& opts,
+                               const string& directory)
+{
+    if (opts.identity())
+    {
+        return full;
+    }
+
+    stringstream key;
+    key << "source=" << full.filename() << "\n";
+    boost::system::error_code ec;
+    fs::path source = fs::canonical(full.filename(), ec);
+    if (!ec)
+    {
+        key << "path=" << source.string() << "\n"
+            << "size=" << fs::file_size(source, ec) << "\n"
+            << "mtime=" << fs::last_write_time(source, ec) << "\n";
+    }
+    key << opts.key() << "\n";
+    uint64_t key_hash = hash::fnv1a(key.str());
+
+    lock_guard<mutex> lock(derived_maps_mutex);
+
+    auto d = derived_maps.find(key_hash);
+    if (d != derived_maps.end())
+    {
+        return d->second;
+    }
+
+    string filename;
+    if (!directory.empty())
+    {
+        filename = (fs::path(directory) / ("derived_" + hash::hex(key_hash) + ".dat")).string();
+        if (fs::exists(filename))
+        {
+            try
+            {
+                FieldMapView view = FieldMapStore::instance().get(filename);
+                if (has_key(view, key_hash))
+                {
+                    derived_maps[key_hash] = view;
+                    return view;
+                }
+            }
+            catch (runtime_error&)
+            {
+                // unreadable: derive again below
+            }
+            FieldMapStore::instance().release(filename);
+        }
+    }
+
+    vector<byte> buf = derive_field_map(full.data(), full.size(), opts, key_hash);
+
+    FieldMapView view;
+    if (!filename.empty())
+    {
+        try
+        {
+            fs::create_directories(directory);
+            write_file(filename, buf);
+            view = FieldMapStore::instance().get(filename);
+        }
+        catch (std::exception&)
+        {
+            // kept in memory only, below
+        }
+    }
+
+    if (view.empty())
+    {
+        // map an unlinked temporary file: the memory is then held
+        // like that of any other field map
+        fs::path tmp = fs::temp_directory_path() / fs::unique_path("clas12_magfield_%%%%-%%%%-%%%%-%%%%.dat");
+        write_file(tmp.string(), buf);
+        try
+        {
+            view = FieldMapView(make_shared<MappedFile>(tmp.string()));
+        }
+        catch (...)
+        {
+            fs::remove(tmp, ec);
+            throw;
+        }
+        fs::remove(tmp, ec);
+    }
+
+    derived_maps[key_hash] = view;
+    return view;
+}
+
+/**
+ * \brief compare a field map against a reference at random points
+ *
+ * The points are drawn uniformly in (phi, rho, z) over the grid of
+ * the map being compared, extended to the full azimuth for maps with
+ * sector or axial symmetry.
+ *
+ * \param [in] reference the map taken to be exact
+ * \param [in] approx the map to compare against it
+ * \param [in] npoints number of points
+ * \param [in] seed for the random number generator
+ * \return the largest and rms difference
+ **/
+FieldMapError field_map_error(const FieldMap& reference,
+                              const FieldMap& approx,
+                              size_t npoints,
+                              unsigned seed)
+{
+    double phi0 = -180.;
+    double phi1 = 180.;
+    if (approx.symmetry() == FieldMap::NONE)
+    {
+        phi0 = approx.phimin();
+        phi1 = approx.phimax();
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uphi(phi0, phi1);
+    std::uniform_real_distribution<double> urho(approx.rhomin(), approx.rhomax());
+    std::uniform_real_distribution<double> uz(approx.zmin(), approx.zmax());
+
+    const double deg2rad = M_PI / 180.;
+    vector<double> x(npoints), y(npoints), z(npoints);
+    for (size_t i=0; i<npoints; i++)
+    {
+        double phi = uphi(rng) * deg2rad;
+        double rho = urho(rng);
+        x[i] = rho * std::cos(phi);
+        y[i] = rho * std::sin(phi);
+        z[i] = uz(rng);
+    }
+
+    vector<double> rbx, rby, rbz, abx, aby, abz;
+    reference.B(x, y, z, rbx, rby, rbz);
+    approx.B(x, y, z, abx, aby, abz);
+
+    FieldMapError err = {npoints, 0., 0., 0.};
+    double sum2 = 0;
+    for (size_t i=0; i<npoints; i++)
+    {
+        double dx = abx[i] - rbx[i];
+        double dy = aby[i] - rby[i];
+        double dz = abz[i] - rbz[i];
+        double d2 = dx*dx + dy*dy + dz*dz;
+        double b2 = rbx[i]*rbx[i] + rby[i]*rby[i] + rbz[i]*rbz[i];
+        sum2 += d2;
+        err.max_abs = max(err.max_abs, d2);
+        err.max_field = max(err.max_field, b2);
+    }
+    err.max_abs = sqrt(err.max_abs);
+    err.max_field = sqrt(err.max_field);
+    err.rms = (npoints > 0) ? sqrt(sum2 / npoints) : 0.;
+    return err;
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
@@ -0,0 +1,89 @@
+#ifndef CLAS12_MAGFIELD_DERIVED_FIELD_MAP_HPP
+#define CLAS12_MAGFIELD_DERIVED_FIELD_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cnuphys_format.hpp"
+#include "field_map.hpp"
+#include "field_map_store.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+using std::string;
+using std::uint64_t;
+using std::vector;
+
+/**
+ * \brief how to derive a smaller field map from a full one
+ *
+ * The default options describe the full map itself.
+ **/
+struct DerivedMapOptions
+{
+    DerivedMapOptions();
+
+    void set_precision(const string& precision);
+    void set_stride(const string& stride);
+    void set_region(const string& region);
+
+    bool identity() const;
+    bool full_region() const;
+    string key() const;
+
+    /// \brief type of the stored field values
+    cnuphys::ValueType precision;
+
+    /// \brief keep every stride'th grid point along each axis
+    size_t stride;
+
+    /// \brief the part of the grid to keep (deg and cm), extended
+    /// outwards to the nearest grid points
+    double phimin;
+    double phimax;
+    double rhomin;
+    double rhomax;
+    double zmin;
+    double zmax;
+};
+
+/**
+ * \brief difference between a field map and a reference map
+ **/
+struct FieldMapError
+{
+    /// \brief number of points compared
+    size_t npoints;
+
+    /// \brief largest magnitude of the difference (kG)
+    double max_abs;
+
+    /// \brief root mean square magnitude of the difference (kG)
+    double rms;
+
+    /// \brief largest magnitude of the reference field (kG)
+    double max_field;
+};
+
+vector<byte> derive_field_map(const byte* data, size_t size,
+                              const DerivedMapOptions& opts,
+                              uint64_t key_hash = 0);
+
+FieldMapView derived_field_map(const FieldMapView& full,
+                               const DerivedMapOptions& opts,
+                               const string& directory = cache_directory());
+
+FieldMapError field_map_error(const FieldMap& reference,
+                              const FieldMap& approx,
+                              size_t npoints = 1000000,
+                              unsigned seed = 1);
+
+} // namespace clas12::magfield
+} // namespace clas12
+
+#endif // CLAS12_MAGFIELD_DERIVED_FIELD_MAP_HPP
@@ -0,0 +1,498 @@
+#include "field_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "clas12/hash.hpp"
+
+#include "cnuphys_format.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+using std::atan2;
+using std::cos;
+using std::sin;
+using std::sqrt;
+using std::floor;
+using std::fabs;
+using std::min;
+using std::memcpy;
+using std::runtime_error;
+
+using cnuphys::header_size;
+using cnuphys::WordReader;
+
+namespace
+{
+    const double rad2deg = 180. / M_PI;
+    const double deg2rad = M_PI / 180.;
+
+    /// \brief grid points slightly outside the grid (in units of the
+    /// grid spacing) are moved onto its edge to absorb rounding
+    const double grid_tolerance = 1.e-6;
+
+    /// \brief number of points converted to cylindrical coordinates
+    /// at a time in batch evaluation
+    const size_t batch_block = 64;
+
+    /**
+     * \brief find the grid cell holding q
+     *
+     * \param [out] i index of the lower edge of the cell
+     * \param [out] t position in the cell (0 to 1)
+     * \return false if q is outside of the grid
+     **/
+    inline bool locate(double q, double qmin, double dq, size_t n,
+                       size_t& i, double& t)
+    {
+        double u = (q - qmin) / dq;
+        double umax = n - 1;
+        if (!(u >= -grid_tolerance && u <= umax + grid_tolerance))
+        {
+            return false;
+        }
+        u = std::max(0., std::min(u, umax));
+        i = min(size_t(u), n-2);
+        t = u - i;
+        return true;
+    }
+
+    /**
+     * \brief rotate the transverse components of a vector about z
+     **/
+    inline void rotate(double angle, double& bx, double& by)
+    {
+        double c = cos(angle);
+        double s = sin(angle);
+        double x = c*bx - s*by;
+        double y = s*bx + c*by;
+        bx = x;
+        by = y;
+    }
+}
+
+/**
+ * \brief an empty map, to be filled by the caller
+ **/
+FieldMap::FieldMap()
+: _symmetry(NONE)
+, _phimin(0), _phimax(0), _dphi(0), _nphi(0)
+, _rhomin(0), _rhomax(0), _drho(0), _nrho(0)
+, _zmin(0), _zmax(0), _dz(0), _nz(0)
+, _bx(nullptr)
+, _by(nullptr)
+, _bz(nullptr)
+, _checksum(0)
+{
+}
+
+/**
+ * \brief load a field map from a mapped file
+ * \param [in] view the whole field map file (see FieldMapStore)
+ **/
+FieldMap::FieldMap(const FieldMapView& view)
+{
+    this->parse(view.data(), view.size());
+}
+
+/**
+ * \brief load a field map from memory
+ * \param [in] data the contents of a field map file
+ * \param [in] size number of bytes in data
+ **/
+FieldMap::FieldMap(const byte* data, size_t size)
+{
+    this->parse(data, size);
+}
+
+/**
+ * \brief parse the cnuphys binary format into the grids
+ **/
+void FieldMap::parse(const byte* data, size_t size)
+{
+    if (size < header_size)
+    {
+        throw runtime_error("field map too short for its header");
+    }
+
+    // the maps are written big-endian by java but may
+    // have been converted to the native byte order
+    bool valid;
+    WordReader in = cnuphys::reader(data, valid);
+    if (!valid)
+    {
+        throw runtime_error("not a field map: bad magic number");
+    }
+
+    int32_t grid_cs    = in.integer(1);
+    int32_t field_cs   = in.integer(2);
+    int32_t length_units = in.integer(3);
+    int32_t angle_units  = in.integer(4);
+    int32_t field_units  = in.integer(5);
+    int32_t value_type   = in.integer(cnuphys::value_type_word);
+
+    if (grid_cs != 0)
+    {
+        throw runtime_error("only field maps on a cylindrical grid are supported");
+    }
+
+    if (value_type != cnuphys::FLOAT32 && value_type != cnuphys::FLOAT16)
+    {
+        throw runtime_error("unknown field map value type");
+    }
+    cnuphys::ValueType vtype = cnuphys::ValueType(value_type);
+    size_t data_size = 3 * cnuphys::value_size(vtype);
+
+    double length_scale = (length_units == 1) ? 100. : 1.;
+    double angle_scale = (angle_units == 1) ? rad2deg : 1.;
+    double field_scale = 1.;
+    switch (field_units)
+    {
+        case 0: field_scale = 1.; break;
+        case 1: field_scale = 1.e-3; break;
+        case 2: field_scale = 10.; break;
+        default:
+            throw runtime_error("unknown field map units");
+    }
+
+    _phimin = angle_scale * in.real(6);
+    _phimax = angle_scale * in.real(7);
+    int32_t nphi = in.integer(8);
+    _rhomin = length_scale * in.real(9);
+    _rhomax = length_scale * in.real(10);
+    int32_t nrho = in.integer(11);
+    _zmin = length_scale * in.real(12);
+    _zmax = length_scale * in.real(13);
+    int32_t nz = in.integer(14);
+
+    if (nphi < 1 || nrho < 2 || nz < 2)
+    {
+        throw runtime_error("field map grid is too small");
+    }
+
+    _nphi = nphi;
+    _nrho = nrho;
+    _nz = nz;
+    this->set_grid_spacing();
+
+    size_t npoints = _nphi * _nrho * _nz;
+    if (size < header_size + data_size * npoints)
+    {
+        throw runtime_error("field map is truncated");
+    }
+
+    _checksum = hash::fnv1a(data, header_size + data_size * npoints);
+
+    struct Storage
+    {
+        vector<float> bx;
+        vector<float> by;
+        vector<float> bz;
+    };
+    shared_ptr<Storage> storage = std::make_shared<Storage>();
+    vector<float>& bx = storage->bx;
+    vector<float>& by = storage->by;
+    vector<float>& bz = storage->bz;
+    bx.resize(npoints);
+    by.resize(npoints);
+    bz.resize(npoints);
+
+    for (size_t ip=0; ip<_nphi; ip++)
+    {
+        double phi = (_phimin + ip * _dphi) * deg2rad;
+        double cphi = cos(phi);
+        double sphi = sin(phi);
+
+        for (size_t ir=0; ir<_nrho; ir++)
+        {
+            for (size_t iz=0; iz<_nz; iz++)
+            {
+                size_t idx = (ip * _nrho + ir) * _nz + iz;
+                double b1 = field_scale * in.value(vtype, 3*idx + 0);
+                double b2 = field_scale * in.value(vtype, 3*idx + 1);
+                double b3 = field_scale * in.value(vtype, 3*idx + 2);
+
+                if (field_cs == 0)
+                {
+                    // (Bphi, Brho, Bz) -> (Bx, By, Bz)
+                    bx[idx] = cphi*b2 - sphi*b1;
+                    by[idx] = sphi*b2 + cphi*b1;
+                }
+                else
+                {
+                    bx[idx] = b1;
+                    by[idx] = b2;
+                }
+                bz[idx] = b3;
+            }
+        }
+    }
+
+    _bx = bx.data();
+    _by = by.data();
+    _bz = bz.data();
+    _storage = storage;
+}
+
+/**
+ * \brief set the grid spacing and symmetry from the grid's extent
+ **/
+void FieldMap::set_grid_spacing()
+{
+    _dphi = (_nphi > 1) ? (_phimax - _phimin) / (_nphi - 1) : 0.f;
+    _drho = (_rhomax - _rhomin) / (_nrho - 1);
+    _dz = (_zmax - _zmin) / (_nz - 1);
+
+    static const float eps = 1.e-3f;
+    if (_nphi == 1)
+    {
+        _symmetry = AXIAL;
+    }
+    else if (fabs(_phimin) < eps && fabs(_phimax - 30.f) < eps)
+    {
+        _symmetry = SECTOR_MIRROR;
+    }
+    else if (fabs(_phimin) < eps && fabs(_phimax - 60.f) < eps)
+    {
+        _symmetry = SECTOR;
+    }
+    else
+    {
+        _symmetry = NONE;
+    }
+}
+
+/**
+ * \brief interpolate the stored field at a point in grid coordinates
+ *
+ * \param [in] phi azimuthal angle (deg) within the grid
+ * \param [in] rho distance from the beam line (cm)
+ * \param [in] z position along the beam line (cm)
+ * \param [out] bx,by,bz field (kG) as stored: cartesian components
+ *              in the frame of the grid
+ **/
+void FieldMap::grid_field(const double& phi, const double& rho, const double& z,
+                          double& bx, double& by, double& bz) const
+{
+    size_t ir, iz;
+    double tr, tz;
+    if (!locate(rho, _rhomin, _drho, _nrho, ir, tr)
+     || !locate(z, _zmin, _dz, _nz, iz, tz))
+    {
+        bx = by = bz = 0;
+        return;
+    }
+
+    // bilinear weights in (rho, z)
+    double w00 = (1-tr)*(1-tz);
+    double w01 = (1-tr)*tz;
+    double w10 = tr*(1-tz);
+    double w11 = tr*tz;
+
+    if (_nphi == 1)
+    {
+        size_t i00 = ir*_nz + iz;
+        size_t i10 = i00 + _nz;
+        bx = w00*_bx[i00] + w01*_bx[i00+1] + w10*_bx[i10] + w11*_bx[i10+1];
+        by = w00*_by[i00] + w01*_by[i00+1] + w10*_by[i10] + w11*_by[i10+1];
+        bz = w00*_bz[i00] + w01*_bz[i00+1] + w10*_bz[i10] + w11*_bz[i10+1];
+        return;
+    }
+
+    size_t ip;
+    double tp;
+    if (!locate(phi, _phimin, _dphi, _nphi, ip, tp))
+    {
+        bx = by = bz = 0;
+        return;
+    }
+
+    size_t i000 = (ip*_nrho + ir)*_nz + iz;
+    size_t i010 = i000 + _nz;
+    size_t i100 = i000 + _nrho*_nz;
+    size_t i110 = i100 + _nz;
+
+    double p0 = 1-tp;
+    double p1 = tp;
+
+    bx = p0 * (w00*_bx[i000] + w01*_bx[i000+1] + w10*_bx[i010] + w11*_bx[i010+1])
+       + p1 * (w00*_bx[i100] + w01*_bx[i100+1] + w10*_bx[i110] + w11*_bx[i110+1]);
+    by = p0 * (w00*_by[i000] + w01*_by[i000+1] + w10*_by[i010] + w11*_by[i010+1])
+       + p1 * (w00*_by[i100] + w01*_by[i100+1] + w10*_by[i110] + w11*_by[i110+1]);
+    bz = p0 * (w00*_bz[i000] + w01*_bz[i000+1] + w10*_bz[i010] + w11*_bz[i010+1])
+       + p1 * (w00*_bz[i100] + w01*_bz[i100+1] + w10*_bz[i110] + w11*_bz[i110+1]);
+}
+
+/**
+ * \brief the magnetic field at a point
+ *
+ * The point is moved into the part of the azimuth covered by the grid
+ * using the map's symmetry and the interpolated field is rotated (and
+ * for the mirrored half of a torus sector, reflected) back.
+ *
+ * Under the reflection y -> -y about the middle of a sector, the
+ * field (an axial vector) transforms as (Bx,By,Bz) -> (-Bx,By,-Bz).
+ *
+ * \param [in] x,y,z position (cm)
+ * \param [out] bx,by,bz magnetic field (kG)
+ **/
+void FieldMap::B(const double& x, const double& y, const double& z,
+                 double& bx, double& by, double& bz) const
+{
+    double rho = sqrt(x*x + y*y);
+    double phi = atan2(y, x) * rad2deg;
+
+    switch (_symmetry)
+    {
+        case AXIAL:
+        {
+            this->grid_field(_phimin, rho, z, bx, by, bz);
+            rotate((phi - _phimin) * deg2rad, bx, by);
+            break;
+        }
+        case SECTOR_MIRROR:
+        {
+            double sector_phi = 60. * floor(phi / 60. + 0.5);
+            double rel = phi - sector_phi;
+            this->grid_field(fabs(rel), rho, z, bx, by, bz);
+            if (rel < 0)
+            {
+                bx = -bx;
+                bz = -bz;
+            }
+            rotate(sector_phi * deg2rad, bx, by);
+            break;
+        }
+        case SECTOR:
+        {
+            double sector_phi = 60. * floor(phi / 60.);
+            this->grid_field(phi - sector_phi, rho, z, bx, by, bz);
+            rotate(sector_phi * deg2rad, bx, by);
+            break;
+        }
+        default:
+        {
+            if (phi < _phimin)
+            {
+                phi += 360.;
+            }
+            this->grid_field(phi, rho, z, bx, by, bz);
+            break;
+        }
+    }
+}
+
+/**
+ * \brief the magnetic field at many points
+ *
+ * Points are processed in blocks: the conversion to cylindrical
+ * coordinates is done for a whole block first in a loop the compiler
+ * can vectorize, followed by the interpolation which gathers from the
+ * grid arrays.
+ *
+ * \param [in] n number of points
+ * \param [in] x,y,z arrays of n positions (cm)
+ * \param [out] bx,by,bz arrays of n field values (kG)
+ **/
+void FieldMap::B(size_t n,
+                 const double* x, const double* y, const double* z,
+                 double* bx, double* by, double* bz) const
+{
+    double rho[batch_block];
+    double phi[batch_block];
+
+    for (size_t first=0; first<n; first+=batch_block)
+    {
+        size_t m = min(batch_block, n - first);
+        const double* xb = x + first;
+        const double* yb = y + first;
+
+        for (size_t i=0; i<m; i++)
+        {
+            rho[i] = sqrt(xb[i]*xb[i] + yb[i]*yb[i]);
+        }
+        for (size_t i=0; i<m; i++)
+        {
+            phi[i] = atan2(yb[i], xb[i]) * rad2deg;
+        }
+
+        for (size_t i=0; i<m; i++)
+        {
+            size_t k = first + i;
+            double sector_phi = 0;
+            bool mirror = false;
+            double gphi = phi[i];
+
+            switch (_symmetry)
+            {
+                case AXIAL:
+                    sector_phi = phi[i] - _phimin;
+                    gphi = _phimin;
+                    break;
+                case SECTOR_MIRROR:
+                    sector_phi = 60. * floor(phi[i] / 60. + 0.5);
+                    gphi = phi[i] - sector_phi;
+                    mirror = gphi < 0;
+                    gphi = fabs(gphi);
+                    break;
+                case SECTOR:
+                    sector_phi = 60. * floor(phi[i] / 60.);
+                    gphi = phi[i] - sector_phi;
+                    break;
+                default:
+                    if (gphi < _phimin)
+                    {
+                        gphi += 360.;
+                    }
+                    break;
+            }
+
+            this->grid_field(gphi, rho[i], z[k], bx[k], by[k], bz[k]);
+
+            if (mirror)
+            {
+                bx[k] = -bx[k];
+                bz[k] = -bz[k];
+            }
+            if (sector_phi != 0)
+            {
+                rotate(sector_phi * deg2rad, bx[k], by[k]);
+            }
+        }
+    }
+}
+
+/**
+ * \brief the magnetic field at many points
+ *
+ * \param [in] x,y,z positions (cm), all of the same length
+ * \param [out] bx,by,bz magnetic field (kG), resized to match
+ **/
+void FieldMap::B(const vector<double>& x,
+                 const vector<double>& y,
+                 const vector<double>& z,
+                 vector<double>& bx,
+                 vector<double>& by,
+                 vector<double>& bz) const
+{
+    if (y.size() != x.size() || z.size() != x.size())
+    {
+        throw runtime_error("x, y and z must have the same number of points");
+    }
+    bx.resize(x.size());
+    by.resize(x.size());
+    bz.resize(x.size());
+    this->B(x.size(), x.data(), y.data(), z.data(),
+            bx.data(), by.data(), bz.data());
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
@@ -0,0 +1,287 @@
+#ifndef CLAS12_MAGFIELD_FIELD_MAP_HPP
+#define CLAS12_MAGFIELD_FIELD_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "field_map_store.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+/**
+ * \brief a magnetic field map on a regular (phi, rho, z) grid
+ *
+ * The maps are read from the binary format written by cnuphys
+ * (clas12_torus_fieldmap_binary.dat, solenoid-srr.dat): an 80 byte
+ * header followed by three floats per grid point, with phi running
+ * slowest and z fastest. The header is:
+ *
+ *     int   magic (0xced, used to detect the byte order)
+ *     int   grid coordinate system (0 = cylindrical)
+ *     int   field coordinate system (0 = cylindrical, 1 = cartesian)
+ *     int   length units (0 = cm, 1 = m)
+ *     int   angle units (0 = deg, 1 = rad)
+ *     int   field units (0 = kG, 1 = G, 2 = T)
+ *     float phimin, phimax; int nphi
+ *     float rhomin, rhomax; int nrho
+ *     float zmin, zmax; int nz
+ *     int   creation time (high and low words)
+ *     int   reserved x 2
+ *     int   value type (0 = float, 1 = half precision float)
+ *
+ * The value type is an extension used by derived maps (see
+ * derive_field_map()); it is zero in the files written by cnuphys.
+ *
+ * On loading, the grid is converted to cm and degrees, the field to
+ * kG in cartesian components and each component is stored in its own
+ * contiguous array (structure of arrays).
+ *
+ * Maps with a single phi value (the solenoid) are taken to be
+ * symmetric about the beam axis and are interpolated bilinearly in
+ * (rho, z). Maps covering phi = 0 to 30 degrees (the torus) are taken
+ * to have the six-fold symmetry of the coils and to be mirror
+ * symmetric about the middle of each sector; maps covering 0 to 60
+ * degrees have only the six-fold symmetry. These are interpolated
+ * trilinearly in (phi, rho, z).
+ *
+ * Outside of the grid, the field is zero. All positions are in cm and
+ * fields in kG, in the CLAS coordinate system.
+ *
+ * The grid arrays are shared between copies of a FieldMap. They are
+ * either owned by the map or, for maps returned by
+ * shared_field_map(), live in a shared memory segment.
+ **/
+class FieldMap
+{
+  public:
+    /// \brief how the grid is extended to the full azimuth
+    enum Symmetry
+    {
+        /// \brief field does not depend on phi (solenoid)
+        AXIAL,
+
+        /// \brief six sectors, each mirror symmetric (torus)
+        SECTOR_MIRROR,
+
+        /// \brief six identical sectors
+        SECTOR,
+
+        /// \brief grid covers all phi needed
+        NONE
+    };
+
+    FieldMap(const FieldMapView& view);
+    FieldMap(const byte* data, size_t size);
+
+    // inline methods
+    const Symmetry& symmetry() const;
+    size_t nphi() const;
+    size_t nrho() const;
+    size_t nz() const;
+    size_t npoints() const;
+    const float& phimin() const;
+    const float& phimax() const;
+    const float& rhomin() const;
+    const float& rhomax() const;
+    const float& zmin() const;
+    const float& zmax() const;
+    const uint64_t& checksum() const;
+
+    // methods in cpp file
+    void B(const double& x, const double& y, const double& z,
+           double& bx, double& by, double& bz) const;
+
+    void B(size_t n,
+           const double* x, const double* y, const double* z,
+           double* bx, double* by, double* bz) const;
+
+    void B(const vector<double>& x,
+           const vector<double>& y,
+           const vector<double>& z,
+           vector<double>& bx,
+           vector<double>& by,
+           vector<double>& bz) const;
+
+  private:
+    /// \brief how the grid is extended to the full azimuth
+    Symmetry _symmetry;
+
+    /// \brief grid in phi (deg)
+    float _phimin;
+    float _phimax;
+    float _dphi;
+    size_t _nphi;
+
+    /// \brief grid in rho (cm)
+    float _rhomin;
+    float _rhomax;
+    float _drho;
+    size_t _nrho;
+
+    /// \brief grid in z (cm)
+    float _zmin;
+    float _zmax;
+    float _dz;
+    size_t _nz;
+
+    /// \brief field components (kG) at each grid point indexed
+    /// by (iphi * nrho + irho) * nz + iz
+    const float* _bx;
+    const float* _by;
+    const float* _bz;
+
+    /// \brief keeps the memory holding the field components alive
+    shared_ptr<const void> _storage;
+
+    /// \brief FNV-1a hash of the whole field map file
+    uint64_t _checksum;
+
+    FieldMap();
+
+    void parse(const byte* data, size_t size);
+    void set_grid_spacing();
+
+    /// \brief publishes and attaches to maps in shared memory
+    friend FieldMap shared_field_map(const string& filename, const string& prefix);
+
+    void grid_field(const double& phi, const double& rho, const double& z,
+                    double& bx, double& by, double& bz) const;
+};
+
+/**
+ * \brief how the grid is extended to the full azimuth
+ * \return const reference to FieldMap::_symmetry
+ **/
+inline
+const FieldMap::Symmetry& FieldMap::symmetry() const
+{
+    return _symmetry;
+}
+
+/**
+ * \brief number of grid points in phi
+ * \return FieldMap::_nphi
+ **/
+inline
+size_t FieldMap::nphi() const
+{
+    return _nphi;
+}
+
+/**
+ * \brief number of grid points in rho
+ * \return FieldMap::_nrho
+ **/
+inline
+size_t FieldMap::nrho() const
+{
+    return _nrho;
+}
+
+/**
+ * \brief number of grid points in z
+ * \return FieldMap::_nz
+ **/
+inline
+size_t FieldMap::nz() const
+{
+    return _nz;
+}
+
+/**
+ * \brief total number of grid points
+ * \return nphi * nrho * nz
+ **/
+inline
+size_t FieldMap::npoints() const
+{
+    return _nphi * _nrho * _nz;
+}
+
+/**
+ * \brief lower edge of the grid in phi (deg)
+ * \return const reference to FieldMap::_phimin
+ **/
+inline
+const float& FieldMap::phimin() const
+{
+    return _phimin;
+}
+
+/**
+ * \brief upper edge of the grid in phi (deg)
+ * \return const reference to FieldMap::_phimax
+ **/
+inline
+const float& FieldMap::phimax() const
+{
+    return _phimax;
+}
+
+/**
+ * \brief lower edge of the grid in rho (cm)
+ * \return const reference to FieldMap::_rhomin
+ **/
+inline
+const float& FieldMap::rhomin() const
+{
+    return _rhomin;
+}
+
+/**
+ * \brief upper edge of the grid in rho (cm)
+ * \return const reference to FieldMap::_rhomax
+ **/
+inline
+const float& FieldMap::rhomax() const
+{
+    return _rhomax;
+}
+
+/**
+ * \brief lower edge of the grid in z (cm)
+ * \return const reference to FieldMap::_zmin
+ **/
+inline
+const float& FieldMap::zmin() const
+{
+    return _zmin;
+}
+
+/**
+ * \brief upper edge of the grid in z (cm)
+ * \return const reference to FieldMap::_zmax
+ **/
+inline
+const float& FieldMap::zmax() const
+{
+    return _zmax;
+}
+
+/**
+ * \brief hash of the field map file this was loaded from
+ *
+ * Identifies the field map, for example in cache keys.
+ *
+ * \return const reference to FieldMap::_checksum
+ **/
+inline
+const uint64_t& FieldMap::checksum() const
+{
+    return _checksum;
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
+
+#endif // CLAS12_MAGFIELD_FIELD_MAP_HPP
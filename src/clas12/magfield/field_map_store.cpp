@@ -0,0 +1,184 @@
+#include "field_map_store.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+namespace clas12
+{
+namespace magfield
+{
+
+namespace fs = boost::filesystem;
+
+using std::lock_guard;
+using std::make_shared;
+using std::runtime_error;
+using std::strerror;
+
+/**
+ * \brief map a whole file into memory read-only
+ * \param [in] filename the file to map
+ **/
+MappedFile::MappedFile(const string& filename)
+: _filename(filename)
+, _data(nullptr)
+, _size(0)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("could not open file: " + filename
+                            + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        throw runtime_error("could not stat file: " + filename
+                            + ": " + strerror(err));
+    }
+
+    // mmap() refuses zero-length mappings
+    if (st.st_size > 0)
+    {
+        void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            int err = errno;
+            ::close(fd);
+            throw runtime_error("could not map file: " + filename
+                                + ": " + strerror(err));
+        }
+        _data = static_cast<const byte*>(addr);
+        _size = st.st_size;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+/**
+ * \brief unmap the file
+ **/
+MappedFile::~MappedFile()
+{
+    if (_data)
+    {
+        ::munmap(const_cast<byte*>(_data), _size);
+    }
+}
+
+/**
+ * \brief default constructor: an empty view
+ **/
+FieldMapView::FieldMapView()
+{
+}
+
+/**
+ * \brief a view of the whole of a mapped file
+ * \param [in] file the mapped file, kept alive by this view
+ **/
+FieldMapView::FieldMapView(const shared_ptr<const MappedFile>& file)
+: _file(file)
+{
+}
+
+/**
+ * \brief the store shared by everything in this process
+ * \return reference to the one FieldMapStore object
+ **/
+FieldMapStore& FieldMapStore::instance()
+{
+    static FieldMapStore store;
+    return store;
+}
+
+/**
+ * \brief get a view of a field map file, mapping it if needed
+ *
+ * Only the first call for a given file touches the file system.
+ *
+ * \param [in] filename the field map file
+ * \return zero-copy view of the whole file
+ **/
+FieldMapView FieldMapStore::get(const string& filename)
+{
+    lock_guard<mutex> lock(_mutex);
+
+    auto f = _files.find(filename);
+    if (f == _files.end())
+    {
+        shared_ptr<const MappedFile> file = make_shared<MappedFile>(filename);
+        f = _files.emplace(filename, file).first;
+    }
+    return FieldMapView(f->second);
+}
+
+/**
+ * \brief forget the mapping of a file
+ *
+ * The file is mapped again the next time it is asked for. Views
+ * handed out before this call stay valid.
+ *
+ * \param [in] filename the field map file
+ **/
+void FieldMapStore::release(const string& filename)
+{
+    lock_guard<mutex> lock(_mutex);
+    _files.erase(filename);
+}
+
+/**
+ * \brief the number of files currently mapped by the store
+ * \return number of entries in FieldMapStore::_files
+ **/
+size_t FieldMapStore::size() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _files.size();
+}
+
+/**
+ * \brief where field maps computed from other field maps are kept
+ *
+ * This is $CLAS12_MAGFIELD_CACHE_DIR if set, otherwise
+ * $XDG_CACHE_HOME/clas12_magfield, ~/.cache/clas12_magfield or
+ * clas12_magfield in the system's temporary directory.
+ *
+ * \return path to the cache directory
+ **/
+string cache_directory()
+{
+    if (const char* dir = std::getenv("CLAS12_MAGFIELD_CACHE_DIR"))
+    {
+        return dir;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"))
+    {
+        return (fs::path(xdg) / "clas12_magfield").string();
+    }
+    if (const char* home = std::getenv("HOME"))
+    {
+        return (fs::path(home) / ".cache" / "clas12_magfield").string();
+    }
+    return (fs::temp_directory_path() / "clas12_magfield").string();
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
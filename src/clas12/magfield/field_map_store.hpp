@@ -0,0 +1,219 @@
+#ifndef CLAS12_MAGFIELD_FIELD_MAP_STORE_HPP
+#define CLAS12_MAGFIELD_FIELD_MAP_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace clas12
+{
+namespace magfield
+{
+
+using std::map;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+
+typedef uint8_t byte;
+
+/**
+ * \brief a read-only memory mapping of a whole file
+ *
+ * The file is mapped with mmap(PROT_READ, MAP_SHARED) on construction
+ * and unmapped on destruction. An empty file is represented by a
+ * null pointer and a size of zero.
+ **/
+class MappedFile
+{
+  public:
+    MappedFile(const string& filename);
+    ~MappedFile();
+
+    // inline methods
+    const string& filename() const;
+    const byte* data() const;
+    size_t size() const;
+
+  private:
+    /// \brief the file that was mapped
+    string _filename;
+
+    /// \brief start of the mapping
+    const byte* _data;
+
+    /// \brief length of the mapping in bytes
+    size_t _size;
+
+    /// \brief deleted copy constructor
+    MappedFile(const MappedFile&) = delete;
+
+    /// \brief deleted assignment operator
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+/**
+ * \brief a zero-copy view of a field map file
+ *
+ * Views are cheap to copy and keep the underlying mapping alive
+ * for as long as they exist.
+ **/
+class FieldMapView
+{
+  public:
+    FieldMapView();
+    FieldMapView(const shared_ptr<const MappedFile>& file);
+
+    // inline methods
+    const byte* data() const;
+    size_t size() const;
+    bool empty() const;
+    const byte* begin() const;
+    const byte* end() const;
+    const string& filename() const;
+
+  private:
+    /// \brief the mapped file (null for an empty view)
+    shared_ptr<const MappedFile> _file;
+};
+
+/**
+ * \brief process-wide cache of memory-mapped field map files
+ *
+ * Each file is mapped the first time it is asked for and the mapping
+ * is then shared by every later request in the process, so serving
+ * a field map never reads or copies the file. The pages are shared
+ * with every other process mapping the same file through the page
+ * cache.
+ *
+ * All methods may be called from several threads at once.
+ *
+ * Field map files are not expected to change while mapped. A file
+ * replaced on disk (by rename) is only picked up after
+ * FieldMapStore::release() is called for it.
+ **/
+class FieldMapStore
+{
+  public:
+    static FieldMapStore& instance();
+
+    FieldMapView get(const string& filename);
+    void release(const string& filename);
+    size_t size() const;
+
+  private:
+    FieldMapStore() = default;
+
+    /// \brief the mappings by file name
+    map<string, shared_ptr<const MappedFile>> _files;
+
+    /// \brief guards FieldMapStore::_files
+    mutable mutex _mutex;
+
+    /// \brief deleted copy constructor
+    FieldMapStore(const FieldMapStore&) = delete;
+
+    /// \brief deleted assignment operator
+    FieldMapStore& operator=(const FieldMapStore&) = delete;
+};
+
+string cache_directory();
+
+/**
+ * \brief the name of the mapped file
+ * \return const reference to MappedFile::_filename
+ **/
+inline
+const string& MappedFile::filename() const
+{
+    return _filename;
+}
+
+/**
+ * \brief start of the file contents in memory
+ * \return MappedFile::_data
+ **/
+inline
+const byte* MappedFile::data() const
+{
+    return _data;
+}
+
+/**
+ * \brief the size of the file in bytes
+ * \return MappedFile::_size
+ **/
+inline
+size_t MappedFile::size() const
+{
+    return _size;
+}
+
+/**
+ * \brief start of the field map in memory
+ * \return pointer to the first byte or null for an empty view
+ **/
+inline
+const byte* FieldMapView::data() const
+{
+    return _file ? _file->data() : nullptr;
+}
+
+/**
+ * \brief size of the field map in bytes
+ * \return number of bytes in the view
+ **/
+inline
+size_t FieldMapView::size() const
+{
+    return _file ? _file->size() : 0;
+}
+
+/**
+ * \brief check if the view holds no data
+ * \return true if FieldMapView::size() is zero
+ **/
+inline
+bool FieldMapView::empty() const
+{
+    return this->size() == 0;
+}
+
+/**
+ * \brief iterator to the first byte of the field map
+ * \return FieldMapView::data()
+ **/
+inline
+const byte* FieldMapView::begin() const
+{
+    return this->data();
+}
+
+/**
+ * \brief iterator to one past the last byte of the field map
+ * \return FieldMapView::data() + FieldMapView::size()
+ **/
+inline
+const byte* FieldMapView::end() const
+{
+    return this->data() + this->size();
+}
+
+/**
+ * \brief the name of the field map file
+ * \return file name or an empty string for an empty view
+ **/
+inline
+const string& FieldMapView::filename() const
+{
+    static const string none;
+    return _file ? _file->filename() : none;
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
+
+#endif // CLAS12_MAGFIELD_FIELD_MAP_STORE_HPP
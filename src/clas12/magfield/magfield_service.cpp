@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -22,6 +23,7 @@ namespace magfield
 using std::clog;
 using std::endl;
 
+using std::map;
 using std::string;
 using std::stringstream;
 using std::vector;
@@ -63,17 +65,30 @@ string MagFieldService::usage() const
 
 CioSerial::UniquePtr MagFieldService::executeService(const PropertyList& plist)
 {
-    CioSerial::UniquePtr out;
+    CioSerial::UniquePtr out = make_unique<CioSerial>();
 
     try
     {
         auto p = plist.findProperty("request");
         if (p != plist.end())
         {
-            Request req(p->getValue());
-            vector<unsigned char> buff = req.generate_buffer();
-
-            out->setData(buff, MimeType::BYTE_ARRAY);
+            map<string,string> reqmap;
+            for (const auto& key : {"request", "precision", "stride", "region"})
+            {
+                auto o = plist.findProperty(key);
+                if (o != plist.end())
+                {
+                    reqmap[key] = o->getValue();
+                }
+            }
+
+            // the field map is mapped once per process; the only
+            // copy made here is into the payload which owns its data.
+            Request req(reqmap);
+            FieldMapView view = req.view();
+
+            out->setData(vector<unsigned char>(view.begin(), view.end()),
+                         MimeType::BYTE_ARRAY);
             out->setDataDescription("Byte Buffer");
             out->setStatus("Success");
         }
@@ -2,7 +2,6 @@
 
 #include <cstdint>
 #include <iostream>
-#include <fstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -19,9 +18,6 @@ using std::noboolalpha;
 using std::clog;
 using std::endl;
 
-using std::ifstream;
-using std::ios;
-
 using std::string;
 using std::vector;
 
@@ -32,18 +28,66 @@ using boost::to_lower_copy;
 const string Request::desc =
 R"(Returns the magnetic field map as a byte array.
 
+A smaller map can be requested with the precision, stride and
+region options. It is derived from the full map on the first such
+request and cached (see derived_field_map()). Half precision maps
+mark this in the last reserved header word which readers other than
+clas12::magfield::FieldMap will not understand. Use the
+clas12magfield-compare program to see the interpolation error of
+each variant.
+
 Input options:
     request (only one of the following per request):
               solenoid
               torus
 
+    precision: (float32|float16)    [default: float32]
+    stride:    <int>                [default: 1]
+                keep every n'th grid point in phi, rho and z
+    region:    <axis:min:max,...>   [default: <whole map>]
+                part of the grid to keep, axis being phi (deg),
+                rho (cm) or z (cm). Example: rho:0:300,z:100:500
+
 Output type:
     Byte array of magnetic field
 )";
 
+/**
+ * \brief a request for the full torus or solenoid map
+ * \param [in] req "torus" or "solenoid"
+ **/
 Request::Request(const string& req)
+: Request(map<string,string>{{"request", req}})
 {
-    request = to_lower_copy(req);
+}
+
+/**
+ * \brief a request with options
+ * \param [in] req the options described in Request::desc
+ **/
+Request::Request(const map<string,string>& req)
+{
+    for (const auto& r : req)
+    {
+        string key = to_lower_copy(r.first);
+        if (key == "request")
+        {
+            request = to_lower_copy(r.second);
+        }
+        else if (key == "precision")
+        {
+            options.set_precision(r.second);
+        }
+        else if (key == "stride")
+        {
+            options.set_stride(r.second);
+        }
+        else if (key == "region")
+        {
+            options.set_region(r.second);
+        }
+    }
+
     string clara_services_dir = "/group/clas12/clara_services";
     string data_dir = clara_services_dir + "/data";
     string magfield_dir = data_dir + "/magfield";
@@ -51,38 +95,45 @@ Request::Request(const string& req)
     magfield_files["solenoid"] = magfield_dir + "/solenoid-srr.dat";
 }
 
-vector<byte> Request::generate_buffer()
+/**
+ * \brief the requested field map as a zero-copy view
+ *
+ * The file is mapped into memory by the process-wide FieldMapStore
+ * the first time it is requested and shared by all later requests.
+ * Derived maps are made once and cached in the same way.
+ *
+ * \return view of the whole field map file
+ **/
+FieldMapView Request::view()
 {
     if (request == "torus" || request == "solenoid")
     {
-        return this->generate_buffer(magfield_files[request]);
+        FieldMapView full = FieldMapStore::instance().get(magfield_files[request]);
+        return derived_field_map(full, options);
     }
     throw runtime_error("Error: no magnetic field: " + request + "\n" + Request::desc);
 }
 
-vector<byte> Request::generate_buffer(const string& filename)
+/**
+ * \brief a copy of the requested field map
+ *
+ * Prefer Request::view() which does not copy the data.
+ *
+ * \return the bytes of the field map file
+ **/
+vector<byte> Request::generate_buffer()
 {
-    ifstream fin(filename, ios::binary);
-
-    if (fin.is_open())
-    {
-        // get the data size in bytes
-        fin.seekg(0, ios::end);
-        size_t file_size = fin.tellg();
-        fin.seekg(0, ios::beg);
-
-        // read the data into buffer
-        std::vector<byte> buff(file_size);
-        fin.read(reinterpret_cast<char*>(&buff[0]), file_size);
-
-        return buff;
-    }
-    throw runtime_error("could not open file: " + filename);
+    FieldMapView v = this->view();
+    return vector<byte>(v.begin(), v.end());
 }
 
 string Request::info()
 {
     string msg = "Request: " + request;
+    if (!options.identity())
+    {
+        msg += " (" + options.key() + ")";
+    }
     return msg;
 }
 
@@ -5,6 +5,9 @@
 #include <string>
 #include <vector>
 
+#include "derived_field_map.hpp"
+#include "field_map_store.hpp"
+
 namespace clas12
 {
 namespace magfield
@@ -14,20 +17,22 @@ using std::map;
 using std::string;
 using std::vector;
 
-typedef uint8_t byte;
-
 class Request
 {
   public:
     static const string desc;
     Request(const string& req);
+    Request(const map<string,string>& req);
+    FieldMapView view();
     vector<byte> generate_buffer();
     string info();
 
   private:
     map<string,string> magfield_files;
     string request;
-    vector<byte> generate_buffer(const string& filename);
+
+    /// \brief how to derive the served map from the full one
+    DerivedMapOptions options;
 };
 
 } // namespace clas12::magfield
@@ -0,0 +1,511 @@
+#include "shared_field_map.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/hash.hpp"
+
+#include "field_map_store.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+namespace fs = boost::filesystem;
+
+using std::atomic;
+using std::clog;
+using std::endl;
+using std::runtime_error;
+using std::shared_ptr;
+using std::stringstream;
+using std::uint32_t;
+using std::uint64_t;
+using std::int64_t;
+
+namespace
+{
+    /// \brief layout version of the shared segment. Part of the
+    /// segment name so that incompatible libraries never share one.
+    const uint32_t layout_version = 1;
+
+    const char segment_magic[8] = {'C','1','2','F','M','S','H','M'};
+
+    /// \brief segment states
+    const uint32_t state_publishing = 0;
+    const uint32_t state_ready = 1;
+
+    /// \brief how long to wait for another process to publish
+    const std::chrono::seconds publish_timeout(120);
+
+    /// \brief how long a new segment may stay without the header
+    /// and publisher's process id before it is taken as abandoned
+    const std::chrono::seconds claim_timeout(2);
+
+    /// \brief interval between checks while waiting
+    const std::chrono::milliseconds poll_interval(10);
+
+    /// \brief the arrays are aligned to cache lines
+    const size_t alignment = 64;
+
+    /**
+     * \brief start of the shared segment, followed by the arrays
+     * bx, by and bz at data_offset + k * array_stride
+     **/
+    struct SegmentHeader
+    {
+        char magic[8];
+        uint32_t version;
+
+        /// \brief state_publishing until the arrays are filled
+        atomic<uint32_t> state;
+
+        /// \brief process id of the publisher
+        int64_t publisher;
+
+        /// \brief identity of the source file
+        uint64_t source_size;
+        int64_t source_mtime;
+        uint64_t source_checksum;
+
+        /// \brief the grid
+        float phimin;
+        float phimax;
+        float rhomin;
+        float rhomax;
+        float zmin;
+        float zmax;
+        uint64_t nphi;
+        uint64_t nrho;
+        uint64_t nz;
+
+        /// \brief where the arrays are (bytes from the segment start)
+        uint64_t data_offset;
+        uint64_t array_stride;
+
+        /// \brief FNV-1a hash of everything above except
+        /// state and publisher
+        uint64_t header_checksum;
+    };
+
+    inline size_t align(size_t n)
+    {
+        return (n + alignment - 1) / alignment * alignment;
+    }
+
+    template <class T>
+    inline uint64_t hash_field(const T& v, uint64_t h)
+    {
+        return hash::fnv1a(&v, sizeof(v), h);
+    }
+
+    uint64_t header_hash(const SegmentHeader& hdr)
+    {
+        uint64_t h = hash::fnv1a(hdr.magic, sizeof(hdr.magic));
+        h = hash_field(hdr.version, h);
+        h = hash_field(hdr.source_size, h);
+        h = hash_field(hdr.source_mtime, h);
+        h = hash_field(hdr.source_checksum, h);
+        h = hash_field(hdr.phimin, h);
+        h = hash_field(hdr.phimax, h);
+        h = hash_field(hdr.rhomin, h);
+        h = hash_field(hdr.rhomax, h);
+        h = hash_field(hdr.zmin, h);
+        h = hash_field(hdr.zmax, h);
+        h = hash_field(hdr.nphi, h);
+        h = hash_field(hdr.nrho, h);
+        h = hash_field(hdr.nz, h);
+        h = hash_field(hdr.data_offset, h);
+        h = hash_field(hdr.array_stride, h);
+        return h;
+    }
+
+    /**
+     * \brief a read-only mapping of a whole segment, unmapped when
+     * the last FieldMap using it goes away
+     **/
+    shared_ptr<const void> map_segment(int fd, size_t size)
+    {
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            return shared_ptr<const void>();
+        }
+        return shared_ptr<const void>(addr,
+            [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+    }
+
+    /// \brief outcome of waiting for a segment
+    enum AttachResult
+    {
+        ATTACHED,
+        STALE,
+        FAILED
+    };
+
+    /**
+     * \brief a segment being published by this process
+     *
+     * The descriptor is closed on destruction and, unless published()
+     * was called, the segment is removed so that other processes do
+     * not wait for it, also when an exception is thrown.
+     **/
+    class Publication
+    {
+      public:
+        Publication(const string& name, int fd)
+        : _name(name)
+        , _fd(fd)
+        , _published(false)
+        {}
+
+        ~Publication()
+        {
+            if (!_published)
+            {
+                ::shm_unlink(_name.c_str());
+            }
+            ::close(_fd);
+        }
+
+        Publication(const Publication&) = delete;
+        Publication& operator=(const Publication&) = delete;
+
+        void published()
+        {
+            _published = true;
+        }
+
+      private:
+        string _name;
+        int _fd;
+        bool _published;
+    };
+}
+
+/**
+ * \brief the name of the shared memory segment for a field map file
+ *
+ * \param [in] filename the field map file
+ * \param [in] prefix the start of the segment's name
+ * \return segment name suitable for shm_open()
+ **/
+string shared_field_map_name(const string& filename, const string& prefix)
+{
+    struct stat st;
+    if (::stat(filename.c_str(), &st) != 0)
+    {
+        throw runtime_error("could not stat file: " + filename
+                            + ": " + std::strerror(errno));
+    }
+
+    stringstream id;
+    id << fs::canonical(filename).string() << "\n"
+       << st.st_size << "\n"
+       << st.st_mtime << "\n"
+       << layout_version;
+
+    return "/" + prefix + "_" + hash::hex(hash::fnv1a(id.str()));
+}
+
+/**
+ * \brief remove the shared memory segment for a field map file
+ *
+ * Processes already attached keep their mapping.
+ *
+ * \param [in] filename the field map file
+ * \param [in] prefix the start of the segment's name
+ * \return true if a segment was removed
+ **/
+bool unlink_shared_field_map(const string& filename, const string& prefix)
+{
+    return ::shm_unlink(shared_field_map_name(filename, prefix).c_str()) == 0;
+}
+
+namespace
+{
+    /**
+     * \brief wait for a segment to be ready and map it
+     *
+     * \param [in] fd read-only descriptor of the segment
+     * \param [in] st the source file's status
+     * \param [out] mapping the whole segment, on success
+     * \param [out] hdr the segment header, on success
+     **/
+    AttachResult attach(int fd, const struct stat& st,
+                        shared_ptr<const void>& mapping, const SegmentHeader*& hdr)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + publish_timeout;
+
+        // wait for the publisher to size the header and claim the
+        // segment with its process id, which it does before parsing
+        shared_ptr<const void> header;
+        const SegmentHeader* claimed = nullptr;
+        struct stat sst;
+        while (true)
+        {
+            if (::fstat(fd, &sst) != 0)
+            {
+                return FAILED;
+            }
+            if (!header && size_t(sst.st_size) >= sizeof(SegmentHeader))
+            {
+                header = map_segment(fd, sizeof(SegmentHeader));
+                if (!header)
+                {
+                    return FAILED;
+                }
+                claimed = static_cast<const SegmentHeader*>(header.get());
+            }
+            if (claimed && claimed->publisher > 0)
+            {
+                break;
+            }
+            if (std::chrono::steady_clock::now() > start + claim_timeout)
+            {
+                return STALE;
+            }
+            std::this_thread::sleep_for(poll_interval);
+        }
+
+        // wait for the publisher to fill the segment
+        while (claimed->state.load(std::memory_order_acquire) != state_ready)
+        {
+            int64_t pid = claimed->publisher;
+            if (::kill(pid, 0) != 0 && errno == ESRCH)
+            {
+                return STALE;
+            }
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return FAILED;
+            }
+            std::this_thread::sleep_for(poll_interval);
+        }
+
+        // the segment has its full size once it is ready
+        if (::fstat(fd, &sst) != 0)
+        {
+            return FAILED;
+        }
+        mapping = map_segment(fd, sst.st_size);
+        if (!mapping)
+        {
+            return FAILED;
+        }
+        hdr = static_cast<const SegmentHeader*>(mapping.get());
+
+        size_t npoints = hdr->nphi * hdr->nrho * hdr->nz;
+        if (std::memcmp(hdr->magic, segment_magic, sizeof(segment_magic)) != 0
+         || hdr->version != layout_version
+         || hdr->header_checksum != header_hash(*hdr)
+         || hdr->source_size != uint64_t(st.st_size)
+         || hdr->source_mtime != int64_t(st.st_mtime)
+         || hdr->array_stride < npoints * sizeof(float)
+         || size_t(sst.st_size) < hdr->data_offset + 3 * hdr->array_stride)
+        {
+            return FAILED;
+        }
+
+        return ATTACHED;
+    }
+}
+
+/**
+ * \brief a field map whose grid is shared by all processes on the node
+ *
+ * See the description in shared_field_map.hpp.
+ *
+ * \param [in] filename the field map file (cnuphys binary format)
+ * \param [in] prefix the start of the shared memory segment's name
+ * \return field map backed by the shared segment
+ **/
+FieldMap shared_field_map(const string& filename, const string& prefix)
+{
+    struct stat st;
+    if (::stat(filename.c_str(), &st) != 0)
+    {
+        throw runtime_error("could not stat file: " + filename
+                            + ": " + std::strerror(errno));
+    }
+
+    string name = shared_field_map_name(filename, prefix);
+
+    // fills a FieldMap from a mapped, validated segment
+    auto from_segment = [](const shared_ptr<const void>& mapping,
+                           const SegmentHeader* hdr)
+    {
+        const char* base = static_cast<const char*>(mapping.get());
+
+        FieldMap fmap;
+        fmap._phimin = hdr->phimin;
+        fmap._phimax = hdr->phimax;
+        fmap._nphi = hdr->nphi;
+        fmap._rhomin = hdr->rhomin;
+        fmap._rhomax = hdr->rhomax;
+        fmap._nrho = hdr->nrho;
+        fmap._zmin = hdr->zmin;
+        fmap._zmax = hdr->zmax;
+        fmap._nz = hdr->nz;
+        fmap.set_grid_spacing();
+        fmap._bx = reinterpret_cast<const float*>(base + hdr->data_offset);
+        fmap._by = reinterpret_cast<const float*>(base + hdr->data_offset + hdr->array_stride);
+        fmap._bz = reinterpret_cast<const float*>(base + hdr->data_offset + 2*hdr->array_stride);
+        fmap._storage = mapping;
+        fmap._checksum = hdr->source_checksum;
+        return fmap;
+    };
+
+    for (int attempt=0; attempt<3; attempt++)
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0)
+        {
+            // this process publishes the map
+            Publication publication(name, fd);
+
+            // claim the segment before parsing, which may take a
+            // while, so that others can tell if this process dies
+            int error = 0;
+            void* claim = MAP_FAILED;
+            if (::ftruncate(fd, sizeof(SegmentHeader)) == 0)
+            {
+                claim = ::mmap(nullptr, sizeof(SegmentHeader),
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            if (claim == MAP_FAILED)
+            {
+                error = errno;
+            }
+            else
+            {
+                static_cast<SegmentHeader*>(claim)->publisher = ::getpid();
+                ::munmap(claim, sizeof(SegmentHeader));
+            }
+
+            FieldMap parsed(FieldMapStore::instance().get(filename));
+            FieldMapStore::instance().release(filename);
+
+            size_t npoints = parsed.npoints();
+            size_t data_offset = align(sizeof(SegmentHeader));
+            size_t array_stride = align(npoints * sizeof(float));
+            size_t size = data_offset + 3 * array_stride;
+
+            void* addr = MAP_FAILED;
+            if (!error)
+            {
+                if (::ftruncate(fd, size) == 0)
+                {
+                    addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                }
+                if (addr == MAP_FAILED)
+                {
+                    error = errno;
+                }
+            }
+            if (addr == MAP_FAILED)
+            {
+                clog << "could not publish field map in shared memory: "
+                     << std::strerror(error) << endl;
+                return parsed;
+            }
+
+            SegmentHeader* hdr = static_cast<SegmentHeader*>(addr);
+            std::memcpy(hdr->magic, segment_magic, sizeof(segment_magic));
+            hdr->version = layout_version;
+            hdr->source_size = st.st_size;
+            hdr->source_mtime = st.st_mtime;
+            hdr->source_checksum = parsed.checksum();
+            hdr->phimin = parsed.phimin();
+            hdr->phimax = parsed.phimax();
+            hdr->rhomin = parsed.rhomin();
+            hdr->rhomax = parsed.rhomax();
+            hdr->zmin = parsed.zmin();
+            hdr->zmax = parsed.zmax();
+            hdr->nphi = parsed.nphi();
+            hdr->nrho = parsed.nrho();
+            hdr->nz = parsed.nz();
+            hdr->data_offset = data_offset;
+            hdr->array_stride = array_stride;
+            hdr->header_checksum = header_hash(*hdr);
+
+            char* base = static_cast<char*>(addr);
+            std::memcpy(base + data_offset, parsed._bx, npoints * sizeof(float));
+            std::memcpy(base + data_offset + array_stride, parsed._by, npoints * sizeof(float));
+            std::memcpy(base + data_offset + 2*array_stride, parsed._bz, npoints * sizeof(float));
+
+            hdr->state.store(state_ready, std::memory_order_release);
+            ::munmap(addr, size);
+            publication.published();
+
+            // drop the private copy in favour of the shared one
+            shared_ptr<const void> mapping = map_segment(fd, size);
+            if (!mapping)
+            {
+                return parsed;
+            }
+            return from_segment(mapping, static_cast<const SegmentHeader*>(mapping.get()));
+        }
+
+        if (errno != EEXIST)
+        {
+            break;
+        }
+
+        fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            if (errno == ENOENT)
+            {
+                // removed in the meantime: try to publish it again
+                continue;
+            }
+            break;
+        }
+
+        shared_ptr<const void> mapping;
+        const SegmentHeader* hdr = nullptr;
+        AttachResult result = attach(fd, st, mapping, hdr);
+        ::close(fd);
+
+        if (result == ATTACHED)
+        {
+            return from_segment(mapping, hdr);
+        }
+        if (result == STALE)
+        {
+            clog << "removing field map segment left unfinished: "
+                 << name << endl;
+            mapping.reset();
+            ::shm_unlink(name.c_str());
+            continue;
+        }
+        break;
+    }
+
+    clog << "could not use shared field map " << name
+         << ", loading privately: " << filename << endl;
+    return FieldMap(FieldMapStore::instance().get(filename));
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
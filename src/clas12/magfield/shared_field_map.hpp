@@ -0,0 +1,60 @@
+#ifndef CLAS12_MAGFIELD_SHARED_FIELD_MAP_HPP
+#define CLAS12_MAGFIELD_SHARED_FIELD_MAP_HPP
+
+#include <string>
+
+#include "field_map.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+using std::string;
+
+/**
+ * \brief a field map whose grid is shared by all processes on the node
+ *
+ * The first process to ask for a field map file parses it and
+ * publishes the interpolation-ready grid in a named POSIX shared
+ * memory segment (see shm_open(3)). Every later process, and the
+ * publisher itself once done, maps the segment read-only instead of
+ * holding its own copy of the grid.
+ *
+ * The segment is named after the prefix and a hash of the file's
+ * path, size and modification time, so a changed file gets a new
+ * segment. The segment header holds a magic string, a layout version,
+ * the identity of the source file and a checksum of the header which
+ * are all checked before a segment is used.
+ *
+ * Several processes may start at once: exactly one creates the
+ * segment (O_CREAT|O_EXCL) while the others wait for it to be marked
+ * ready. The publisher writes its process id to the segment before
+ * parsing the file. A segment left unfinished by a publisher that has
+ * died, or that gets no process id within a few seconds, is removed
+ * and published again. A publisher that fails, for example on a
+ * corrupt file, removes the segment itself.
+ *
+ * If shared memory is not available for any reason the map is loaded
+ * privately, as with FieldMap(FieldMapStore::instance().get(filename)).
+ *
+ * Segments persist until removed with unlink_shared_field_map() (or
+ * by deleting the file in /dev/shm) or until the node reboots.
+ *
+ * \param [in] filename the field map file (cnuphys binary format)
+ * \param [in] prefix the start of the shared memory segment's name
+ * \return field map backed by the shared segment
+ **/
+FieldMap shared_field_map(const string& filename,
+                          const string& prefix = "clas12_magfield");
+
+string shared_field_map_name(const string& filename,
+                             const string& prefix = "clas12_magfield");
+
+bool unlink_shared_field_map(const string& filename,
+                             const string& prefix = "clas12_magfield");
+
+} // namespace clas12::magfield
+} // namespace clas12
+
+#endif // CLAS12_MAGFIELD_SHARED_FIELD_MAP_HPP
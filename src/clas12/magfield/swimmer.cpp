@@ -0,0 +1,443 @@
+#include "swimmer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace clas12
+{
+namespace magfield
+{
+
+using std::atan2;
+using std::fabs;
+using std::max;
+using std::min;
+using std::pair;
+using std::pow;
+using std::runtime_error;
+using std::sqrt;
+using std::thread;
+
+namespace
+{
+    /// \brief (GeV/c) / (kG cm)
+    const double kappa_unit = 2.99792458e-4;
+
+    const double rad2deg = 180. / M_PI;
+
+    /// \brief step lengths (cm)
+    const double initial_step = 1.;
+    const double min_step = 1.e-4;
+    const double max_step = 50.;
+
+    /// \brief how close to a plane a crossing must be (cm)
+    const double plane_tolerance = 1.e-5;
+
+    /// \brief iterations allowed to find a crossing
+    const int max_crossing_iterations = 30;
+
+    /// \brief the world volume (cm)
+    const double world_rho = 1000.;
+    const double world_zmin = -500.;
+    const double world_zmax = 1500.;
+
+    /// \brief Cash-Karp Runge-Kutta coefficients
+    const double b21 = 1./5.;
+    const double b31 = 3./40.,       b32 = 9./40.;
+    const double b41 = 3./10.,       b42 = -9./10.,   b43 = 6./5.;
+    const double b51 = -11./54.,     b52 = 5./2.,     b53 = -70./27.,
+                 b54 = 35./27.;
+    const double b61 = 1631./55296., b62 = 175./512., b63 = 575./13824.,
+                 b64 = 44275./110592., b65 = 253./4096.;
+
+    /// \brief fifth order weights
+    const double c1 = 37./378., c3 = 250./621., c4 = 125./594., c6 = 512./1771.;
+
+    /// \brief difference to the fourth order weights
+    const double dc1 = c1 - 2825./27648.;
+    const double dc3 = c3 - 18575./48384.;
+    const double dc4 = c4 - 13525./55296.;
+    const double dc5 = -277./14336.;
+    const double dc6 = c6 - 1./4.;
+
+    TrackState make_state(const double y[6], double p, int charge, double path)
+    {
+        TrackState st;
+        st.x = y[0];
+        st.y = y[1];
+        st.z = y[2];
+        st.px = p * y[3];
+        st.py = p * y[4];
+        st.pz = p * y[5];
+        st.charge = charge;
+        st.path = path;
+        return st;
+    }
+
+    bool in_world(const double y[6])
+    {
+        return (y[0]*y[0] + y[1]*y[1]) < world_rho*world_rho
+            && y[2] > world_zmin
+            && y[2] < world_zmax;
+    }
+}
+
+/**
+ * \brief a swimmer through a magnetic field
+ *
+ * \param [in] field the magnetic field (torus and solenoid)
+ * \param [in] tolerance largest estimated position error of a step (cm)
+ * \param [in] max_path longest path length to swim (cm)
+ **/
+Swimmer::Swimmer(const shared_ptr<const CompositeField>& field,
+                 double tolerance,
+                 double max_path)
+: _field(field)
+, _tolerance(tolerance)
+, _max_path(max_path)
+{
+    if (!_field)
+    {
+        throw runtime_error("Swimmer needs a magnetic field");
+    }
+    if (!(_tolerance > 0))
+    {
+        throw runtime_error("Swimmer tolerance must be positive");
+    }
+}
+
+/**
+ * \brief add a plane to stop tracks at
+ *
+ * \param [in] surface the plane (cm, CLAS coordinates)
+ * \param [in] id identifies the plane in SurfaceCrossing::surface
+ * \param [in] sector only count crossings in this sector (0 to 5)
+ *             or -1 for all
+ * \param [in] stop end the swim at this plane
+ **/
+void Swimmer::add_surface(const plane<double>& surface, int id,
+                          int sector, bool stop)
+{
+    Surface s;
+    s.point[0] = surface.point().x();
+    s.point[1] = surface.point().y();
+    s.point[2] = surface.point().z();
+    s.normal[0] = surface.normal().x();
+    s.normal[1] = surface.normal().y();
+    s.normal[2] = surface.normal().z();
+    s.id = id;
+    s.sector = sector;
+    s.stop = stop;
+    _surfaces.push_back(s);
+}
+
+/**
+ * \brief swim one track
+ *
+ * \param [in] start the track at its starting point
+ * \param [out] crossings the track at each surface crossed, appended
+ * \param [in] track index of the track written into the crossings
+ * \return the track where the swim ended
+ **/
+TrackState Swimmer::swim(const TrackState& start,
+                         vector<SurfaceCrossing>& crossings,
+                         size_t track) const
+{
+    double p = sqrt(start.px*start.px + start.py*start.py + start.pz*start.pz);
+    if (!(p > 0))
+    {
+        throw runtime_error("can not swim a track without momentum");
+    }
+    double kappa = kappa_unit * start.charge / p;
+
+    double y[6] = {start.x, start.y, start.z,
+                   start.px/p, start.py/p, start.pz/p};
+    double ynew[6];
+    double s = 0;
+    double h = initial_step;
+
+    size_t nsurf = _surfaces.size();
+    vector<double> dist(nsurf);
+    vector<double> dist_new(nsurf);
+    for (size_t i=0; i<nsurf; i++)
+    {
+        dist[i] = this->distance(_surfaces[i], y);
+    }
+
+    // (fraction of the step, surface) of crossings in a step
+    vector<pair<double,size_t>> candidates;
+
+    while (s < _max_path && in_world(y))
+    {
+        h = min(h, _max_path - s);
+
+        double err;
+        this->step(y, kappa, h, ynew, err);
+        if (err > _tolerance && h > min_step)
+        {
+            h = max(min_step, h * max(0.1, 0.9 * pow(_tolerance / err, 0.25)));
+            continue;
+        }
+
+        candidates.clear();
+        for (size_t i=0; i<nsurf; i++)
+        {
+            dist_new[i] = this->distance(_surfaces[i], ynew);
+            double d0 = dist[i];
+            double d1 = dist_new[i];
+            if ((d0 < 0 && d1 >= 0) || (d0 > 0 && d1 <= 0))
+            {
+                candidates.emplace_back(d0 / (d0 - d1), i);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        for (const auto& c : candidates)
+        {
+            const Surface& surf = _surfaces[c.second];
+
+            // regula falsi (Illinois) on the length of a step
+            // from the start of this one
+            double lo = 0;
+            double dlo = dist[c.second];
+            double hi = h;
+            double dhi = dist_new[c.second];
+            double t = h * c.first;
+            double yc[6];
+            double e;
+            int side = 0;
+            for (int it=0; it<max_crossing_iterations; it++)
+            {
+                this->step(y, kappa, t, yc, e);
+                double dc = this->distance(surf, yc);
+                if (fabs(dc) < plane_tolerance)
+                {
+                    break;
+                }
+                if ((dc < 0) == (dlo < 0))
+                {
+                    lo = t;
+                    dlo = dc;
+                    if (side == -1)
+                    {
+                        dhi /= 2;
+                    }
+                    side = -1;
+                }
+                else
+                {
+                    hi = t;
+                    dhi = dc;
+                    if (side == 1)
+                    {
+                        dlo /= 2;
+                    }
+                    side = 1;
+                }
+                t = lo + (hi - lo) * dlo / (dlo - dhi);
+            }
+
+            if (this->in_sector(surf, yc))
+            {
+                SurfaceCrossing crossing;
+                crossing.track = track;
+                crossing.surface = surf.id;
+                crossing.state = make_state(yc, p, start.charge, start.path + s + t);
+                crossings.push_back(crossing);
+
+                if (surf.stop)
+                {
+                    return crossing.state;
+                }
+            }
+        }
+
+        std::copy(ynew, ynew+6, y);
+        dist.swap(dist_new);
+        s += h;
+
+        double grow = (err > 0) ? 0.9 * pow(_tolerance / err, 0.2) : 5.;
+        h = min(max_step, h * min(5., grow));
+    }
+
+    return make_state(y, p, start.charge, start.path + s);
+}
+
+/**
+ * \brief swim many tracks
+ *
+ * The tracks are split into as many contiguous blocks as there are
+ * threads. The crossings are ordered by track.
+ *
+ * \param [in] tracks the tracks at their starting points
+ * \param [out] crossings the tracks at each surface crossed
+ * \param [out] finals the tracks where their swims ended
+ * \param [in] nthreads number of threads to use
+ **/
+void Swimmer::swim(const vector<TrackState>& tracks,
+                   vector<SurfaceCrossing>& crossings,
+                   vector<TrackState>& finals,
+                   size_t nthreads) const
+{
+    size_t ntracks = tracks.size();
+    nthreads = max(size_t(1), min(nthreads, ntracks));
+
+    crossings.clear();
+    finals.resize(ntracks);
+
+    vector<vector<SurfaceCrossing>> partial(nthreads);
+    auto work = [&](size_t ithread)
+    {
+        size_t first = ntracks * ithread / nthreads;
+        size_t last = ntracks * (ithread + 1) / nthreads;
+        for (size_t i=first; i<last; i++)
+        {
+            finals[i] = this->swim(tracks[i], partial[ithread], i);
+        }
+    };
+
+    if (nthreads == 1)
+    {
+        work(0);
+        crossings.swap(partial[0]);
+        return;
+    }
+
+    vector<thread> threads;
+    for (size_t i=0; i<nthreads; i++)
+    {
+        threads.emplace_back(work, i);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    for (const auto& part : partial)
+    {
+        crossings.insert(crossings.end(), part.begin(), part.end());
+    }
+}
+
+/**
+ * \brief one Cash-Karp Runge-Kutta step
+ *
+ * \param [in] y position (cm) and unit direction
+ * \param [in] kappa k q / p (1 / (kG cm))
+ * \param [in] h step length (cm)
+ * \param [out] yout position and direction after the step
+ * \param [out] err estimated error in position (cm)
+ **/
+void Swimmer::step(const double y[6], double kappa, double h,
+                   double yout[6], double& err) const
+{
+    double k1[6], k2[6], k3[6], k4[6], k5[6], k6[6], yt[6];
+
+    this->derivative(y, kappa, k1);
+
+    for (int i=0; i<6; i++)
+    {
+        yt[i] = y[i] + h * b21*k1[i];
+    }
+    this->derivative(yt, kappa, k2);
+
+    for (int i=0; i<6; i++)
+    {
+        yt[i] = y[i] + h * (b31*k1[i] + b32*k2[i]);
+    }
+    this->derivative(yt, kappa, k3);
+
+    for (int i=0; i<6; i++)
+    {
+        yt[i] = y[i] + h * (b41*k1[i] + b42*k2[i] + b43*k3[i]);
+    }
+    this->derivative(yt, kappa, k4);
+
+    for (int i=0; i<6; i++)
+    {
+        yt[i] = y[i] + h * (b51*k1[i] + b52*k2[i] + b53*k3[i] + b54*k4[i]);
+    }
+    this->derivative(yt, kappa, k5);
+
+    for (int i=0; i<6; i++)
+    {
+        yt[i] = y[i] + h * (b61*k1[i] + b62*k2[i] + b63*k3[i] + b64*k4[i] + b65*k5[i]);
+    }
+    this->derivative(yt, kappa, k6);
+
+    double err2 = 0;
+    for (int i=0; i<6; i++)
+    {
+        yout[i] = y[i] + h * (c1*k1[i] + c3*k3[i] + c4*k4[i] + c6*k6[i]);
+        if (i < 3)
+        {
+            double e = h * (dc1*k1[i] + dc3*k3[i] + dc4*k4[i] + dc5*k5[i] + dc6*k6[i]);
+            err2 += e*e;
+        }
+    }
+    err = sqrt(err2);
+
+    // keep the direction a unit vector
+    double norm = sqrt(yout[3]*yout[3] + yout[4]*yout[4] + yout[5]*yout[5]);
+    yout[3] /= norm;
+    yout[4] /= norm;
+    yout[5] /= norm;
+}
+
+/**
+ * \brief the equations of motion
+ *
+ * \param [in] y position (cm) and unit direction
+ * \param [in] kappa k q / p (1 / (kG cm))
+ * \param [out] dyds derivative with respect to the path length
+ **/
+void Swimmer::derivative(const double y[6], double kappa, double dyds[6]) const
+{
+    double bx = 0;
+    double by = 0;
+    double bz = 0;
+    if (kappa != 0)
+    {
+        _field->B(y[0], y[1], y[2], bx, by, bz);
+    }
+
+    dyds[0] = y[3];
+    dyds[1] = y[4];
+    dyds[2] = y[5];
+    dyds[3] = kappa * (y[4]*bz - y[5]*by);
+    dyds[4] = kappa * (y[5]*bx - y[3]*bz);
+    dyds[5] = kappa * (y[3]*by - y[4]*bx);
+}
+
+/**
+ * \brief signed distance from a plane along its normal (cm)
+ **/
+double Swimmer::distance(const Surface& s, const double y[6]) const
+{
+    return s.normal[0] * (y[0] - s.point[0])
+         + s.normal[1] * (y[1] - s.point[1])
+         + s.normal[2] * (y[2] - s.point[2]);
+}
+
+/**
+ * \brief check if a position is in the sector of a plane
+ * \return true if within 30 degrees of the sector's mid-plane
+ **/
+bool Swimmer::in_sector(const Surface& s, const double y[6]) const
+{
+    if (s.sector < 0)
+    {
+        return true;
+    }
+    double phi = atan2(y[1], y[0]) * rad2deg - 60. * s.sector;
+    phi -= 360. * std::floor((phi + 180.) / 360.);
+    return fabs(phi) <= 30.;
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
@@ -0,0 +1,195 @@
+#ifndef CLAS12_MAGFIELD_SWIMMER_HPP
+#define CLAS12_MAGFIELD_SWIMMER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "geometry/plane.hpp"
+
+#include "composite_field.hpp"
+
+namespace clas12
+{
+namespace magfield
+{
+
+using std::shared_ptr;
+using std::size_t;
+using std::vector;
+
+using ::geometry::plane;
+
+/**
+ * \brief position and momentum of a charged track
+ **/
+struct TrackState
+{
+    /// \brief position (cm, CLAS coordinates)
+    double x;
+    double y;
+    double z;
+
+    /// \brief momentum (GeV/c)
+    double px;
+    double py;
+    double pz;
+
+    /// \brief charge in units of e
+    int charge;
+
+    /// \brief path length from the start of the swim (cm)
+    double path;
+};
+
+/**
+ * \brief a track crossing one of the swimmer's surfaces
+ **/
+struct SurfaceCrossing
+{
+    /// \brief index of the track in the batch
+    size_t track;
+
+    /// \brief id of the surface given to Swimmer::add_surface()
+    int surface;
+
+    /// \brief the track at the surface
+    TrackState state;
+};
+
+/**
+ * \brief propagates charged tracks through the magnetic field
+ *
+ * The equations of motion in terms of the path length s,
+ *
+ *     dr/ds = u,   du/ds = (k q / p) u x B,   k = 2.99792458e-4
+ *
+ * with u the unit direction, p in GeV/c, B in kG and lengths in cm,
+ * are integrated with the embedded Runge-Kutta 4(5) method of Cash
+ * and Karp. The step length is adapted so that the estimated error in
+ * position of each step stays below the tolerance. Energy loss and
+ * multiple scattering are not included.
+ *
+ * The swimmer stops tracks at planes given to add_surface(), for
+ * example the DC wire planes, FTOF panels and calorimeter faces (see
+ * clas12::geometry::forward_detector_planes()). A crossing is found
+ * from the change in sign of the distance to the plane over a step
+ * and refined by repeating the step from its start with a shorter
+ * length until the track is on the plane. A plane may belong to a
+ * sector, in which case only crossings within 30 degrees of the
+ * sector's mid-plane count.
+ *
+ * A track is swum until it crosses a stopping surface, its path
+ * length exceeds the maximum, or it leaves the world volume (rho >
+ * 1000 cm, z outside -500 to 1500 cm).
+ *
+ * Swimming does not change the swimmer, so one swimmer can be shared
+ * by many threads.
+ **/
+class Swimmer
+{
+  public:
+    Swimmer(const shared_ptr<const CompositeField>& field,
+            double tolerance = 1.e-3,
+            double max_path = 1500.);
+
+    // inline methods
+    const CompositeField& field() const;
+    const double& tolerance() const;
+    const double& max_path() const;
+    size_t nsurfaces() const;
+
+    // methods in cpp file
+    void add_surface(const plane<double>& surface, int id,
+                     int sector = -1, bool stop = false);
+
+    TrackState swim(const TrackState& start,
+                    vector<SurfaceCrossing>& crossings,
+                    size_t track = 0) const;
+
+    void swim(const vector<TrackState>& tracks,
+              vector<SurfaceCrossing>& crossings,
+              vector<TrackState>& finals,
+              size_t nthreads = 1) const;
+
+  private:
+    /**
+     * \brief a plane the tracks are stopped at
+     **/
+    struct Surface
+    {
+        double point[3];
+        double normal[3];
+        int id;
+
+        /// \brief sector index or -1 for any
+        int sector;
+
+        /// \brief end the swim here
+        bool stop;
+    };
+
+    /// \brief the magnetic field
+    shared_ptr<const CompositeField> _field;
+
+    /// \brief largest estimated position error of a step (cm)
+    double _tolerance;
+
+    /// \brief longest path length to swim (cm)
+    double _max_path;
+
+    /// \brief the planes tracks are stopped at
+    vector<Surface> _surfaces;
+
+    void step(const double y[6], double kappa, double h,
+              double yout[6], double& err) const;
+    void derivative(const double y[6], double kappa, double dydt[6]) const;
+
+    double distance(const Surface& s, const double y[6]) const;
+    bool in_sector(const Surface& s, const double y[6]) const;
+};
+
+/**
+ * \brief the magnetic field tracks are swum through
+ * \return const reference to the CompositeField
+ **/
+inline
+const CompositeField& Swimmer::field() const
+{
+    return *_field;
+}
+
+/**
+ * \brief largest estimated position error of a step (cm)
+ * \return const reference to Swimmer::_tolerance
+ **/
+inline
+const double& Swimmer::tolerance() const
+{
+    return _tolerance;
+}
+
+/**
+ * \brief longest path length to swim (cm)
+ * \return const reference to Swimmer::_max_path
+ **/
+inline
+const double& Swimmer::max_path() const
+{
+    return _max_path;
+}
+
+/**
+ * \brief number of planes added with Swimmer::add_surface()
+ * \return size of Swimmer::_surfaces
+ **/
+inline
+size_t Swimmer::nsurfaces() const
+{
+    return _surfaces.size();
+}
+
+} // namespace clas12::magfield
+} // namespace clas12
+
+#endif // CLAS12_MAGFIELD_SWIMMER_HPP
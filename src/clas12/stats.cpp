@@ -0,0 +1,342 @@
+#include "stats.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace clas12
+{
+namespace stats
+{
+
+using std::fixed;
+using std::left;
+using std::right;
+using std::setprecision;
+using std::setw;
+using std::stringstream;
+
+/**
+ * \brief add time to a stage
+ * \param [in] stage name of the stage
+ * \param [in] seconds time spent in one call of the stage
+ **/
+void Stats::add_time(const string& stage, double seconds)
+{
+    Stage& s = _stages[stage];
+    s.calls++;
+    s.seconds += seconds;
+}
+
+/**
+ * \brief add to a counter
+ * \param [in] counter name of the counter
+ * \param [in] n amount to add
+ **/
+void Stats::count(const string& counter, size_t n)
+{
+    _counters[counter] += n;
+}
+
+/**
+ * \brief add the stages and counters of another Stats to these
+ * \param [in] that the Stats to add
+ **/
+void Stats::merge(const Stats& that)
+{
+    for (const auto& s : that._stages)
+    {
+        Stage& mine = _stages[s.first];
+        mine.calls += s.second.calls;
+        mine.seconds += s.second.seconds;
+    }
+    for (const auto& c : that._counters)
+    {
+        _counters[c.first] += c.second;
+    }
+}
+
+/**
+ * \brief forget all stages and counters
+ **/
+void Stats::clear()
+{
+    _stages.clear();
+    _counters.clear();
+}
+
+/**
+ * \brief a table of the stages and counters, one per line
+ * \return the table as a string
+ **/
+string Stats::report() const
+{
+    stringstream ss;
+    ss << "Stats:\n";
+    for (const auto& s : _stages)
+    {
+        ss << "  " << left << setw(32) << s.first
+           << right << setw(12) << fixed << setprecision(3)
+           << 1.e3 * s.second.seconds << " ms"
+           << setw(8) << s.second.calls << " calls\n";
+    }
+    for (const auto& c : _counters)
+    {
+        ss << "  " << left << setw(32) << c.first
+           << right << setw(12) << c.second << "\n";
+    }
+    return ss.str();
+}
+
+/**
+ * \brief the stages and counters on one line
+ *
+ * Stages are given in ms. Spaces in names are replaced with
+ * underscores, for example:
+ *
+ *     ccdb_load=12.345ms ccdb_tables=4 ccdb_rows=37
+ *
+ * \return the summary as a string
+ **/
+string Stats::summary() const
+{
+    auto name = [](string n)
+    {
+        for (auto& c : n)
+        {
+            if (c == ' ')
+            {
+                c = '_';
+            }
+        }
+        return n;
+    };
+
+    stringstream ss;
+    ss << fixed << setprecision(3);
+    bool first = true;
+    for (const auto& s : _stages)
+    {
+        ss << (first ? "" : " ") << name(s.first) << "=" << 1.e3 * s.second.seconds << "ms";
+        first = false;
+    }
+    for (const auto& c : _counters)
+    {
+        ss << (first ? "" : " ") << name(c.first) << "=" << c.second;
+        first = false;
+    }
+    return ss.str();
+}
+
+/// \brief number of buckets of a Histogram: 0.1 ms up to about 14 min
+static const size_t histogram_nbuckets = 24;
+
+Histogram::Histogram()
+: _buckets(histogram_nbuckets, 0)
+, _count(0)
+, _sum(0)
+, _max(0)
+{}
+
+/**
+ * \brief the longest duration held by a bucket
+ * \param [in] i the bucket index
+ * \return the limit in seconds, infinity for the last bucket
+ **/
+double Histogram::bucket_limit(size_t i)
+{
+    if (i + 1 >= histogram_nbuckets)
+    {
+        return HUGE_VAL;
+    }
+    return 1.e-4 * std::ldexp(1., int(i));
+}
+
+/**
+ * \brief add one duration
+ * \param [in] seconds the duration
+ **/
+void Histogram::record(double seconds)
+{
+    size_t i = 0;
+    while (seconds > bucket_limit(i))
+    {
+        i++;
+    }
+    _buckets[i]++;
+    _count++;
+    _sum += seconds;
+    _max = std::max(_max, seconds);
+}
+
+/**
+ * \brief add the durations of another Histogram to this one
+ * \param [in] that the Histogram to add
+ **/
+void Histogram::merge(const Histogram& that)
+{
+    for (size_t i=0; i<_buckets.size(); i++)
+    {
+        _buckets[i] += that._buckets[i];
+    }
+    _count += that._count;
+    _sum += that._sum;
+    _max = std::max(_max, that._max);
+}
+
+/**
+ * \brief forget all durations
+ **/
+void Histogram::clear()
+{
+    *this = Histogram();
+}
+
+/**
+ * \return the mean duration or zero if nothing was recorded
+ **/
+double Histogram::mean() const
+{
+    return (_count > 0) ? _sum / _count : 0;
+}
+
+/**
+ * \brief an upper bound of a quantile
+ * \param [in] q the quantile, for example 0.99
+ * \return the limit of the bucket holding the quantile, at most
+ *          max(), in seconds
+ **/
+double Histogram::quantile(double q) const
+{
+    if (_count == 0)
+    {
+        return 0;
+    }
+    double target = q * _count;
+    size_t sum = 0;
+    for (size_t i=0; i<_buckets.size(); i++)
+    {
+        sum += _buckets[i];
+        if (sum >= target && sum > 0)
+        {
+            return std::min(bucket_limit(i), _max);
+        }
+    }
+    return _max;
+}
+
+/**
+ * \brief the non-empty buckets, one per line, with a bar of their size
+ * \return the table as a string
+ **/
+string Histogram::report() const
+{
+    stringstream ss;
+    ss << fixed << setprecision(1);
+    for (size_t i=0; i<_buckets.size(); i++)
+    {
+        if (_buckets[i] == 0)
+        {
+            continue;
+        }
+        ss << "  <= ";
+        if (i + 1 < _buckets.size())
+        {
+            ss << right << setw(10) << 1.e3 * bucket_limit(i) << " ms";
+        }
+        else
+        {
+            ss << right << setw(13) << "inf";
+        }
+        ss << setw(10) << _buckets[i] << "  "
+           << string(size_t(40. * _buckets[i] / _count + 0.5), '#') << "\n";
+    }
+    return ss.str();
+}
+
+/**
+ * \brief count, mean, quantiles and maximum on one line, in ms
+ *
+ *     n=120 mean=3.2ms p50=1.6ms p90=6.4ms p99=12.8ms max=18.3ms
+ *
+ * \return the summary as a string
+ **/
+string Histogram::summary() const
+{
+    stringstream ss;
+    ss << fixed << setprecision(1)
+       << "n=" << _count
+       << " mean=" << 1.e3 * this->mean() << "ms"
+       << " p50=" << 1.e3 * this->quantile(0.5) << "ms"
+       << " p90=" << 1.e3 * this->quantile(0.9) << "ms"
+       << " p99=" << 1.e3 * this->quantile(0.99) << "ms"
+       << " max=" << 1.e3 * _max << "ms";
+    return ss.str();
+}
+
+/**
+ * \brief start timing a stage
+ * \param [in] stage name of the stage
+ **/
+ScopedTimer::ScopedTimer(const string& stage)
+: _stage(stage)
+, _start(clock_type::now())
+{}
+
+/**
+ * \brief add the time since construction to the stage
+ **/
+ScopedTimer::~ScopedTimer()
+{
+    std::chrono::duration<double> dt = clock_type::now() - _start;
+    thread_stats().add_time(_stage, dt.count());
+}
+
+/**
+ * \brief start collecting this thread's stages and counters
+ * \param [in] target where the records are added on destruction
+ **/
+Collector::Collector(Stats& target)
+: _target(target)
+{
+    std::swap(_saved, thread_stats());
+}
+
+/**
+ * \brief add what was recorded to the target and restore the
+ * earlier records
+ **/
+Collector::~Collector()
+{
+    Stats& current = thread_stats();
+    _target.merge(current);
+    _saved.merge(current);
+    std::swap(_saved, current);
+}
+
+/**
+ * \brief the Stats timers and counters of this thread record into
+ * \return reference to a thread local Stats
+ **/
+Stats& thread_stats()
+{
+    static thread_local Stats stats;
+    return stats;
+}
+
+/**
+ * \brief add to a counter of this thread's Stats
+ * \param [in] counter name of the counter
+ * \param [in] n amount to add
+ **/
+void count(const string& counter, size_t n)
+{
+    thread_stats().count(counter, n);
+}
+
+} // namespace clas12::stats
+} // namespace clas12
@@ -0,0 +1,227 @@
+#ifndef CLAS12_STATS_HPP
+#define CLAS12_STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace clas12
+{
+namespace stats
+{
+
+using std::map;
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * \brief time spent in one stage of a request
+ **/
+struct Stage
+{
+    /// \brief number of times the stage was entered
+    size_t calls;
+
+    /// \brief wall-clock time summed over all calls
+    double seconds;
+};
+
+/**
+ * \brief timers and counters of the stages of a request
+ *
+ * Stages are named by what they do, for example "ccdb load",
+ * "fetch dc" or "output dc/wire_endpoints", and may nest: the time
+ * of "fetch dc" includes the "ccdb load" of its tables. Counters
+ * count things handled, for example "ccdb rows" or "xml bytes".
+ *
+ * Each thread records into its own Stats (see thread_stats()) so
+ * the timers and counters need no locking. A Collector gathers what
+ * one thread records over a scope, such as one request.
+ **/
+class Stats
+{
+  public:
+    // inline methods
+    const map<string,Stage>& stages() const;
+    const map<string,size_t>& counters() const;
+    bool empty() const;
+
+    // methods in cpp file
+    void add_time(const string& stage, double seconds);
+    void count(const string& counter, size_t n = 1);
+    void merge(const Stats& that);
+    void clear();
+
+    string report() const;
+    string summary() const;
+
+  private:
+    /// \brief time spent by stage name
+    map<string,Stage> _stages;
+
+    /// \brief counters by name
+    map<string,size_t> _counters;
+};
+
+/**
+ * \brief adds the time from construction to destruction to a stage
+ * of this thread's Stats
+ **/
+class ScopedTimer
+{
+  public:
+    explicit ScopedTimer(const string& stage);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  private:
+    typedef std::chrono::steady_clock clock_type;
+
+    string _stage;
+    clock_type::time_point _start;
+};
+
+/**
+ * \brief gathers everything this thread records from construction to
+ * destruction into a Stats
+ *
+ * What was recorded before is set aside and restored, with the new
+ * records added, on destruction so that collectors can nest.
+ **/
+class Collector
+{
+  public:
+    explicit Collector(Stats& target);
+    ~Collector();
+
+    Collector(const Collector&) = delete;
+    Collector& operator=(const Collector&) = delete;
+
+  private:
+    Stats& _target;
+    Stats _saved;
+};
+
+/**
+ * \brief distribution of durations, for example request latencies
+ *
+ * Bucket i holds durations up to 0.1 ms times 2^i, the last bucket
+ * everything longer. Quantiles are therefore good to a factor of two,
+ * which is enough to tell a cache hit from a database round trip.
+ * Not thread safe.
+ **/
+class Histogram
+{
+  public:
+    Histogram();
+
+    // inline methods
+    size_t count() const;
+    double sum() const;
+    double max() const;
+    const vector<size_t>& buckets() const;
+
+    // methods in cpp file
+    static double bucket_limit(size_t i);
+
+    void record(double seconds);
+    void merge(const Histogram& that);
+    void clear();
+
+    double mean() const;
+    double quantile(double q) const;
+
+    string report() const;
+    string summary() const;
+
+  private:
+    /// \brief number of durations by bucket
+    vector<size_t> _buckets;
+
+    size_t _count;
+    double _sum;
+    double _max;
+};
+
+Stats& thread_stats();
+void count(const string& counter, size_t n = 1);
+
+/**
+ * \brief the time spent in each stage
+ * \return const reference to Stats::_stages
+ **/
+inline
+const map<string,Stage>& Stats::stages() const
+{
+    return _stages;
+}
+
+/**
+ * \brief the counters
+ * \return const reference to Stats::_counters
+ **/
+inline
+const map<string,size_t>& Stats::counters() const
+{
+    return _counters;
+}
+
+/**
+ * \brief check if nothing has been recorded
+ * \return true if there are no stages and no counters
+ **/
+inline
+bool Stats::empty() const
+{
+    return _stages.empty() && _counters.empty();
+}
+
+/**
+ * \brief number of durations recorded
+ * \return copy of Histogram::_count
+ **/
+inline
+size_t Histogram::count() const
+{
+    return _count;
+}
+
+/**
+ * \brief sum of all durations recorded
+ * \return copy of Histogram::_sum
+ **/
+inline
+double Histogram::sum() const
+{
+    return _sum;
+}
+
+/**
+ * \brief the longest duration recorded
+ * \return copy of Histogram::_max
+ **/
+inline
+double Histogram::max() const
+{
+    return _max;
+}
+
+/**
+ * \brief number of durations by bucket (see bucket_limit())
+ * \return const reference to Histogram::_buckets
+ **/
+inline
+const vector<size_t>& Histogram::buckets() const
+{
+    return _buckets;
+}
+
+} // namespace clas12::stats
+} // namespace clas12
+
+#endif // CLAS12_STATS_HPP
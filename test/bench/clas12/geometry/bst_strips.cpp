@@ -0,0 +1,164 @@
+/**
+ * Benchmark of the BST strip queries on synthetic events:
+ *
+ *   - Layer::hit_strips(): crossing points -> strip numbers
+ *   - Sector::strip_crossings(): top/bottom strip pairs -> points
+ *
+ * The hits are made by picking a random strip in a random module and
+ * a random point along it so that the strip number found can be
+ * checked against the one used to make the hit.
+ **/
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options.hpp"
+
+#include "geometry.hpp"
+
+#include "clas12/ccdb/constants_table.hpp"
+#include "clas12/geometry/central_tracker.hpp"
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace clas12::geometry;
+using namespace clas12::geometry::central_tracker;
+
+using ::geometry::euclid_vector;
+using ::geometry::line_segment;
+
+typedef chrono::steady_clock clock_type;
+
+double elapsed(const clock_type::time_point& start)
+{
+    return chrono::duration<double>(clock_type::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    string connstr = "mysql://clas12reader@clasdb.jlab.org/clas12";
+    size_t nevents = 10000;
+    size_t nhits = 10;
+    unsigned seed = 12345;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h",
+            "produce help message")
+        ("connection,c",
+            po::value<string>(&connstr)->default_value(connstr),
+            "CCDB connection string (mysql://... or sqlite://...)")
+        ("events,n",
+            po::value<size_t>(&nevents)->default_value(nevents),
+            "number of synthetic events")
+        ("hits",
+            po::value<size_t>(&nhits)->default_value(nhits),
+            "number of hit strips per module and layer in each event")
+        ("seed",
+            po::value<unsigned>(&seed)->default_value(seed),
+            "random number seed")
+    ;
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        cout << options << endl;
+        return 0;
+    }
+
+    auto calib = clas12::ccdb::get_calibration(connstr, clas12::ccdb::ConstantSetInfo());
+    CentralTracker svt(calib.get());
+    const BarrelSVT& bst = svt.bst();
+
+    mt19937 gen(seed);
+    uniform_real_distribution<double> uniform(0,1);
+
+    // all modules (sectors) of the BST
+    vector<const barrel_svt::Sector*> sectors;
+    for (const auto& region : bst.regions())
+    {
+        for (const auto& sector : region->sectors())
+        {
+            sectors.push_back(sector.get());
+        }
+    }
+
+    // synthetic events: for each event, one module with nhits
+    // strips hit in each of its two layers.
+    vector<const barrel_svt::Sector*> event_sector(nevents);
+    vector<vector<int>> top_strips(nevents);
+    vector<vector<int>> bottom_strips(nevents);
+    vector<vector<euclid_vector<double,3>>> top_points(nevents);
+    for (size_t evt=0; evt<nevents; evt++)
+    {
+        const barrel_svt::Sector& sector = *sectors[gen() % sectors.size()];
+        event_sector[evt] = &sector;
+        const barrel_svt::Layer& top = sector.layer(1);
+
+        for (size_t h=0; h<nhits; h++)
+        {
+            int is = gen() % top.nstrips();
+            top_strips[evt].push_back(is);
+            bottom_strips[evt].push_back(gen() % sector.layer(0).nstrips());
+
+            line_segment<double,3> strip = top.siliconStrip(is);
+            euclid_vector<double,3> d = strip.end_point() - strip.begin_point();
+            double f = uniform(gen);
+            top_points[evt].push_back(euclid_vector<double,3>{
+                strip.begin_point().x() + f * d.x(),
+                strip.begin_point().y() + f * d.y(),
+                strip.begin_point().z() + f * d.z() });
+        }
+    }
+
+    // hit point -> strip
+    {
+        size_t nfound = 0;
+        size_t nmatched = 0;
+        clock_type::time_point start = clock_type::now();
+        for (size_t evt=0; evt<nevents; evt++)
+        {
+            vector<int> strips = event_sector[evt]->layer(1).hit_strips(top_points[evt]);
+            for (size_t h=0; h<strips.size(); h++)
+            {
+                nfound += (strips[h] >= 0);
+                nmatched += (strips[h] == top_strips[evt][h]);
+            }
+        }
+        double t = elapsed(start);
+        size_t n = nevents * nhits;
+        cout << "hit_strips:      " << n << " hits in " << t << " s, "
+             << 1.e9 * t / n << " ns/hit, "
+             << nfound << " on active area, "
+             << nmatched << " matched" << endl;
+    }
+
+    // stereo crosses
+    {
+        size_t ncrosses = 0;
+        vector<euclid_vector<double,3>> points;
+        vector<pair<size_t,size_t>> pairs;
+        clock_type::time_point start = clock_type::now();
+        for (size_t evt=0; evt<nevents; evt++)
+        {
+            ncrosses += event_sector[evt]->strip_crossings(
+                top_strips[evt], bottom_strips[evt], points, pairs);
+        }
+        double t = elapsed(start);
+        size_t n = nevents * nhits * nhits;
+        cout << "strip_crossings: " << n << " pairs in " << t << " s, "
+             << 1.e9 * t / n << " ns/pair, "
+             << ncrosses << " crosses" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,526 @@
+/**
+ * Benchmark of building and serving the detector geometry, for each
+ * detector:
+ *
+ *   - tables:    loading its CCDB tables into ConstantsTables
+ *   - construct: the detector constructor (tables and core parameters)
+ *   - generate:  DC wires, FTOF paddles, PCal strips, BST strip
+ *                table or the HTCC ray tracer surfaces (EC has no
+ *                strip geometry yet)
+ *   - volumes:   the gemc volume maps (DC, FTOF, PCal)
+ *   - serialize: the XML served by clas12geom, built and saved to a
+ *                string (DC, FTOF, BST)
+ *   - <codec> encode, <codec> decode:
+ *                the serialized XML compressed and decompressed with
+ *                each codec available in this build; the count of
+ *                the encode stage is the compressed size
+ *   - naive read, client read:
+ *                the wire, paddle and strip coordinates read back out
+ *                of the serialized XML, by walking the pugixml tree
+ *                and parsing each text node with a stringstream, and
+ *                with client::Reader
+ *
+ * By default the tables are read from the fixture in test/fixtures so
+ * that the benchmark runs without a database and the results can be
+ * compared between builds. Each stage is repeated and the minimum,
+ * median and mean times are reported, optionally as JSON.
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/algorithm/string.hpp"
+#include "boost/program_options.hpp"
+
+#include "pugixml.hpp"
+
+#include "geometry.hpp"
+
+#include "clas12/ccdb/constants_table.hpp"
+#include "clas12/compression.hpp"
+#include "clas12/geometry/client.hpp"
+#include "clas12/geometry/ccdb_tables.hpp"
+#include "clas12/geometry/central_tracker.hpp"
+#include "clas12/geometry/drift_chamber.hpp"
+#include "clas12/geometry/electromagnetic_cal.hpp"
+#include "clas12/geometry/forward_tof.hpp"
+#include "clas12/geometry/preshower_cal.hpp"
+#include "clas12/geometry/output.hpp"
+#include "clas12/geometry/output/pcal_volumes.hpp"
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace clas12::geometry;
+using namespace clas12::geometry::output;
+
+using clas12::ccdb::ConstantsTable;
+
+typedef chrono::steady_clock clock_type;
+
+double elapsed(const clock_type::time_point& start)
+{
+    return chrono::duration<double>(clock_type::now() - start).count();
+}
+
+/**
+ * \brief the times of one stage of one detector
+ **/
+struct Timing
+{
+    string detector;
+    string stage;
+
+    /// \brief what the stage produces (rows, wires, bytes...)
+    string unit;
+
+    /// \brief number of units produced in one repetition
+    size_t count;
+
+    /// \brief time of each repetition
+    vector<double> seconds;
+
+    double min() const
+    {
+        return *min_element(seconds.begin(), seconds.end());
+    }
+
+    double median() const
+    {
+        vector<double> s = seconds;
+        sort(s.begin(), s.end());
+        size_t n = s.size();
+        return (n % 2) ? s[n/2] : 0.5 * (s[n/2 - 1] + s[n/2]);
+    }
+
+    double mean() const
+    {
+        return accumulate(seconds.begin(), seconds.end(), 0.) / seconds.size();
+    }
+};
+
+/**
+ * \brief time a stage
+ * \param [in] work does the stage once and returns the count produced
+ **/
+Timing time_stage(const string& detector, const string& stage,
+                  const string& unit, size_t nrepeat,
+                  const function<size_t()>& work)
+{
+    Timing t;
+    t.detector = detector;
+    t.stage = stage;
+    t.unit = unit;
+    t.count = 0;
+    for (size_t r=0; r<nrepeat; r++)
+    {
+        clock_type::time_point start = clock_type::now();
+        t.count = work();
+        t.seconds.push_back(elapsed(start));
+    }
+    return t;
+}
+
+size_t load_tables(Calibration* calib, const string& detector)
+{
+    size_t nrows = 0;
+    for (const auto& path : ccdb_tables().at(detector))
+    {
+        ConstantsTable table(calib, path);
+        nrows += table.nrows();
+    }
+    return nrows;
+}
+
+/// \brief the XML of the serialize stage by detector
+map<string,string> served_xml;
+
+size_t serialize(const xml_document& doc, const string& detector)
+{
+    stringstream ss;
+    doc.save(ss);
+    served_xml[detector] = ss.str();
+    return served_xml[detector].size();
+}
+
+/**
+ * \brief read the coordinates in a document the way most clients do:
+ * load it into a pugixml tree and parse the text of every x, y, z and
+ * paddle_lengths node with a stringstream
+ * \return the number of values read
+ **/
+size_t naive_read(const string& xml)
+{
+    xml_document doc;
+    doc.load(xml.c_str());
+
+    vector<double> values;
+    function<void(const xml_node&)> walk = [&](const xml_node& node)
+    {
+        for (xml_node child : node.children())
+        {
+            string name = child.name();
+            if (name == "x" || name == "y" || name == "z" || name == "paddle_lengths")
+            {
+                stringstream ss(child.child_value());
+                double v;
+                while (ss >> v)
+                {
+                    values.push_back(v);
+                }
+            }
+            else
+            {
+                walk(child);
+            }
+        }
+    };
+    walk(doc);
+    return values.size();
+}
+
+/**
+ * \brief read the coordinates in a document with client::Reader
+ * \return the number of values read
+ **/
+size_t client_read(const string& xml)
+{
+    clas12::geometry::client::Reader reader(xml);
+    return 6 * reader.wire_endpoints().size()
+         + 6 * reader.strip_endpoints().size()
+         + 4 * reader.paddles().size();
+}
+
+void bench_dc(Calibration* calib, size_t nrepeat, vector<Timing>& results)
+{
+    results.push_back(time_stage("dc", "construct", "sectors", nrepeat, [&]()
+    {
+        DriftChamber dc(calib);
+        return dc.sectors().size();
+    }));
+
+    DriftChamber dc(calib);
+
+    results.push_back(time_stage("dc", "generate", "wires", nrepeat, [&]()
+    {
+        size_t nwires = 0;
+        for (const auto& sector : dc.sectors())
+        {
+            for (const auto& region : sector->regions())
+            {
+                for (const auto& superlayer : region->superlayers())
+                {
+                    for (const auto& senselayer : superlayer->senselayers())
+                    {
+                        nwires += senselayer->wires(COORDSYS::CLAS).size();
+                    }
+                }
+            }
+        }
+        return nwires;
+    }));
+
+    results.push_back(time_stage("dc", "volumes", "volumes", nrepeat, [&]()
+    {
+        return dc_volumes_map(dc).size();
+    }));
+
+    results.push_back(time_stage("dc", "serialize", "bytes", nrepeat, [&]()
+    {
+        xml_document doc;
+        dc_wire_endpoints_xml(doc, dc, "clas", "cm");
+        dc_volumes_xml(doc, dc);
+        return serialize(doc, "dc");
+    }));
+}
+
+void bench_ftof(Calibration* calib, size_t nrepeat, vector<Timing>& results)
+{
+    results.push_back(time_stage("ftof", "construct", "sectors", nrepeat, [&]()
+    {
+        ForwardTOF ftof(calib);
+        return ftof.sectors().size();
+    }));
+
+    ForwardTOF ftof(calib);
+
+    results.push_back(time_stage("ftof", "generate", "paddles", nrepeat, [&]()
+    {
+        size_t npaddles = 0;
+        for (const auto& sector : ftof.sectors())
+        {
+            for (const auto& panel : sector->panels())
+            {
+                npaddles += panel->paddle_centers(COORDSYS::CLAS).size();
+                npaddles += panel->paddle_lengths().size();
+            }
+        }
+        return npaddles / 2;
+    }));
+
+    results.push_back(time_stage("ftof", "volumes", "volumes", nrepeat, [&]()
+    {
+        return ftof_volumes_map(ftof).size();
+    }));
+
+    results.push_back(time_stage("ftof", "serialize", "bytes", nrepeat, [&]()
+    {
+        xml_document doc;
+        ftof_panels_parms_xml(doc, ftof, "clas", "cm");
+        ftof_volumes_xml(doc, ftof);
+        return serialize(doc, "ftof");
+    }));
+}
+
+void bench_pcal(Calibration* calib, size_t nrepeat, vector<Timing>& results)
+{
+    results.push_back(time_stage("pcal", "construct", "sectors", nrepeat, [&]()
+    {
+        PreshowerCal pcal(calib);
+        return pcal.sectors().size();
+    }));
+
+    PreshowerCal pcal(calib);
+
+    results.push_back(time_stage("pcal", "generate", "strips", nrepeat, [&]()
+    {
+        size_t nstrips = 0;
+        double sum = 0;
+        for (const auto& sector : pcal.sectors())
+        {
+            for (const auto& layer : sector->layers())
+            {
+                for (const auto& view : layer->views())
+                {
+                    for (size_t s=0; s<view->nstrips(); s++)
+                    {
+                        sum += view->strip_length(s);
+                        nstrips++;
+                    }
+                }
+            }
+        }
+        return (sum > 0) ? nstrips : 0;
+    }));
+
+    results.push_back(time_stage("pcal", "volumes", "volumes", nrepeat, [&]()
+    {
+        return pcal_volumes_map(pcal).size();
+    }));
+}
+
+void bench_ec(Calibration* calib, size_t nrepeat, vector<Timing>& results)
+{
+    results.push_back(time_stage("ec", "construct", "sectors", nrepeat, [&]()
+    {
+        ElectromagneticCal ec(calib);
+        return ec.sectors().size();
+    }));
+}
+
+void bench_bst(Calibration* calib, size_t nrepeat, vector<Timing>& results)
+{
+    results.push_back(time_stage("bst", "construct", "regions", nrepeat, [&]()
+    {
+        CentralTracker svt(calib);
+        return svt.bst().regions().size();
+    }));
+
+    CentralTracker svt(calib);
+
+    results.push_back(time_stage("bst", "generate", "strips", nrepeat, [&]()
+    {
+        central_tracker::barrel_svt::StripTable table;
+        table.fill(svt.bst());
+        return table.size();
+    }));
+
+    results.push_back(time_stage("bst", "serialize", "bytes", nrepeat, [&]()
+    {
+        xml_document doc;
+        bst_strip_endpoints_xml(doc, svt.bst(), "LAB", "cm");
+        return serialize(doc, "bst");
+    }));
+}
+
+string json_string(const string& s)
+{
+    string ret = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            ret += '\\';
+        }
+        ret += c;
+    }
+    return ret + "\"";
+}
+
+void write_json(ostream& out, const string& connstr, size_t nrepeat,
+                const vector<Timing>& results)
+{
+    out << "{\n"
+        << "  \"benchmark\": \"clas12-geometry-bench\",\n"
+        << "  \"connection\": " << json_string(connstr) << ",\n"
+        << "  \"repeat\": " << nrepeat << ",\n"
+        << "  \"results\": [\n";
+    out << setprecision(6);
+    for (size_t i=0; i<results.size(); i++)
+    {
+        const Timing& t = results[i];
+        out << "    {"
+            << "\"detector\": " << json_string(t.detector) << ", "
+            << "\"stage\": " << json_string(t.stage) << ", "
+            << "\"unit\": " << json_string(t.unit) << ", "
+            << "\"count\": " << t.count << ", "
+            << "\"min_ms\": " << 1.e3 * t.min() << ", "
+            << "\"median_ms\": " << 1.e3 * t.median() << ", "
+            << "\"mean_ms\": " << 1.e3 * t.mean()
+            << "}" << (i+1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n"
+        << "}\n";
+}
+
+int main(int argc, char** argv)
+{
+    string connstr = "fixture://test/fixtures/geometry_tables.txt";
+    string detectors = "dc,ftof,pcal,ec,bst";
+    size_t nrepeat = 10;
+    string json = "";
+
+    string codecs = "";
+    for (auto c : clas12::compression::available_codecs())
+    {
+        codecs += (codecs == "" ? "" : ",") + clas12::compression::name(c);
+    }
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h",
+            "produce help message")
+        ("connection,c",
+            po::value<string>(&connstr)->default_value(connstr),
+            "CCDB connection string (mysql://..., sqlite://... or fixture://...)")
+        ("detectors,d",
+            po::value<string>(&detectors)->default_value(detectors),
+            "comma separated detectors to benchmark")
+        ("codecs,z",
+            po::value<string>(&codecs)->default_value(codecs),
+            "comma separated codecs the serialized XML is compressed with")
+        ("repeat,n",
+            po::value<size_t>(&nrepeat)->default_value(nrepeat),
+            "number of times each stage is repeated")
+        ("json,o",
+            po::value<string>(&json),
+            "write the results as JSON to this file (- for stdout)")
+    ;
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help") || nrepeat < 1)
+    {
+        cout << options << endl;
+        return 0;
+    }
+
+    auto calib = clas12::ccdb::get_calibration(connstr, clas12::ccdb::ConstantSetInfo());
+
+    const map<string,function<void(Calibration*,size_t,vector<Timing>&)>> benches{
+        {"bst", bench_bst},
+        {"dc", bench_dc},
+        {"ec", bench_ec},
+        {"ftof", bench_ftof},
+        {"pcal", bench_pcal},
+    };
+
+    vector<string> dets;
+    boost::split(dets, detectors, boost::is_any_of(", "), boost::token_compress_on);
+
+    vector<Timing> results;
+    for (const auto& det : dets)
+    {
+        if (!benches.count(det))
+        {
+            cerr << "unknown detector: " << det << endl;
+            return 1;
+        }
+        results.push_back(time_stage(det, "tables", "rows", nrepeat, [&]()
+        {
+            return load_tables(calib.get(), det);
+        }));
+        benches.at(det)(calib.get(), nrepeat, results);
+
+        if (served_xml.count(det) && codecs != "")
+        {
+            vector<string> names;
+            boost::split(names, codecs, boost::is_any_of(", "), boost::token_compress_on);
+            for (const auto& n : names)
+            {
+                auto codec = clas12::compression::codec(n);
+                const string& xml = served_xml[det];
+                string bytes;
+                results.push_back(time_stage(det, n + " encode", "bytes", nrepeat, [&]()
+                {
+                    bytes = clas12::compression::compress(xml, codec);
+                    return bytes.size();
+                }));
+                results.push_back(time_stage(det, n + " decode", "bytes", nrepeat, [&]()
+                {
+                    return clas12::compression::decompress(bytes, codec).size();
+                }));
+            }
+        }
+
+        if (served_xml.count(det))
+        {
+            const string& xml = served_xml[det];
+            results.push_back(time_stage(det, "naive read", "values", nrepeat, [&]()
+            {
+                return naive_read(xml);
+            }));
+            results.push_back(time_stage(det, "client read", "values", nrepeat, [&]()
+            {
+                return client_read(xml);
+            }));
+        }
+    }
+
+    cout << left << setw(6) << "det" << setw(13) << "stage"
+         << right << setw(10) << "count" << "  " << left << setw(9) << "unit"
+         << right << setw(12) << "min ms" << setw(12) << "median ms"
+         << setw(12) << "mean ms" << endl;
+    cout << fixed << setprecision(3);
+    for (const auto& t : results)
+    {
+        cout << left << setw(6) << t.detector << setw(13) << t.stage
+             << right << setw(10) << t.count << "  " << left << setw(9) << t.unit
+             << right << setw(12) << 1.e3 * t.min()
+             << setw(12) << 1.e3 * t.median()
+             << setw(12) << 1.e3 * t.mean() << endl;
+    }
+
+    if (json == "-")
+    {
+        write_json(cout, connstr, nrepeat, results);
+    }
+    else if (json != "")
+    {
+        ofstream fout(json);
+        write_json(fout, connstr, nrepeat, results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * Benchmark of the HTCC photon ray tracer on synthetic photons:
+ *
+ *   - RayTracer::trace(): photon origin and direction -> PMT hit
+ *
+ * Photons are emitted along straight tracks from the target with
+ * polar angles between 5 and 35 degrees, in random directions within
+ * a cone around the track so that most of them head for the mirrors.
+ *
+ * The mirror tables are not in the database, so the default is the
+ * synthetic test/fixtures/htcc_mirrors.txt (see
+ * HighThresholdCerenkov::fetch_mirror_parameters()).
+ **/
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "boost/program_options.hpp"
+
+#include "geometry.hpp"
+
+#include "clas12/ccdb/constants_table.hpp"
+#include "clas12/geometry/high_threshold_cerenkov.hpp"
+#include "clas12/geometry/high_threshold_cerenkov/ray_tracer.hpp"
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace clas12::geometry;
+using namespace clas12::geometry::high_threshold_cerenkov;
+
+typedef chrono::steady_clock clock_type;
+
+double elapsed(const clock_type::time_point& start)
+{
+    return chrono::duration<double>(clock_type::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    static const double deg2rad = ::geometry::cons::pi<double>() / 180.;
+
+    string connstr = "fixture://test/fixtures/htcc_mirrors.txt";
+    size_t nphotons = 1000000;
+    int max_reflections = 4;
+    double cone = 20.;
+    unsigned seed = 12345;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h",
+            "produce help message")
+        ("connection,c",
+            po::value<string>(&connstr)->default_value(connstr),
+            "CCDB connection string with the HTCC mirror tables (fixture://..., mysql://... or sqlite://...)")
+        ("photons,n",
+            po::value<size_t>(&nphotons)->default_value(nphotons),
+            "number of photons to trace")
+        ("reflections",
+            po::value<int>(&max_reflections)->default_value(max_reflections),
+            "maximum number of mirror reflections")
+        ("cone",
+            po::value<double>(&cone)->default_value(cone),
+            "opening angle (deg) of photons around the track")
+        ("seed",
+            po::value<unsigned>(&seed)->default_value(seed),
+            "random number seed")
+    ;
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        cout << options << endl;
+        return 0;
+    }
+
+    auto calib = clas12::ccdb::get_calibration(connstr, clas12::ccdb::ConstantSetInfo());
+    HighThresholdCerenkov htcc;
+    htcc.fetch_mirror_parameters(calib.get());
+
+    clock_type::time_point build_start = clock_type::now();
+    RayTracer tracer(htcc, max_reflections);
+    cout << "build:  " << tracer.nsurfaces() << " surfaces, "
+         << tracer.nnodes() << " nodes in "
+         << 1.e3 * elapsed(build_start) << " ms" << endl;
+
+    mt19937 gen(seed);
+    uniform_real_distribution<double> uniform(0,1);
+
+    vector<double> origins(3*nphotons);
+    vector<double> directions(3*nphotons);
+    for (size_t i=0; i<nphotons; i++)
+    {
+        // track from the target
+        double th = (5. + 30.*uniform(gen)) * deg2rad;
+        double ph = 2. * ::geometry::cons::pi<double>() * uniform(gen);
+        double tx = sin(th)*cos(ph);
+        double ty = sin(th)*sin(ph);
+        double tz = cos(th);
+
+        // emission point along the first 50 cm of the track
+        double s = 50. * uniform(gen);
+        origins[3*i+0] = s * tx;
+        origins[3*i+1] = s * ty;
+        origins[3*i+2] = s * tz;
+
+        // photon direction in a cone around the track
+        double a = cone * deg2rad * sqrt(uniform(gen));
+        double b = 2. * ::geometry::cons::pi<double>() * uniform(gen);
+        ::geometry::direction_vector<double,3> d(b, a);
+        double dx = d.x();
+        double dy = d.y();
+        double dz = d.z();
+
+        // rotate (dx,dy,dz) from the z-axis onto the track
+        directions[3*i+0] = cos(th)*cos(ph)*dx - sin(ph)*dy + tx*dz;
+        directions[3*i+1] = cos(th)*sin(ph)*dx + cos(ph)*dy + ty*dz;
+        directions[3*i+2] = -sin(th)*dx + tz*dz;
+    }
+
+    vector<PhotonHit> hits;
+    clock_type::time_point start = clock_type::now();
+    size_t nhits = tracer.trace(origins, directions, hits);
+    double t = elapsed(start);
+
+    vector<size_t> nreflections(max_reflections+1, 0);
+    for (const PhotonHit& hit : hits)
+    {
+        if (hit.sector >= 0)
+        {
+            nreflections[hit.nreflections]++;
+        }
+    }
+
+    cout << "trace:  " << nphotons << " photons in " << t << " s, "
+         << nphotons / t << " photons/s, "
+         << nhits << " on PMTs ("
+         << 100. * nhits / nphotons << "%)" << endl;
+    for (size_t n=0; n<nreflections.size(); n++)
+    {
+        cout << "        " << n << " reflections: " << nreflections[n] << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * Benchmark of the magnetic field map interpolation:
+ *
+ *   - FieldMap::B(x,y,z): one point at a time
+ *   - FieldMap::B(n,x,y,z): batch evaluation
+ *   - CompositeField::B(): torus + solenoid, summed at each point
+ *     and precomputed on one grid
+ *
+ * Points are spread uniformly over a cylinder covering the forward
+ * detector (torus) or the central detector (solenoid).
+ **/
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "boost/program_options.hpp"
+
+#include "clas12/magfield/composite_field.hpp"
+#include "clas12/magfield/field_map.hpp"
+#include "clas12/magfield/field_map_store.hpp"
+#include "clas12/magfield/request.hpp"
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace clas12::magfield;
+
+typedef chrono::steady_clock clock_type;
+
+double elapsed(const clock_type::time_point& start)
+{
+    return chrono::duration<double>(clock_type::now() - start).count();
+}
+
+template <class Field>
+void bench(const string& name, const Field& field, const FieldMap& fmap,
+           size_t npoints, size_t nrepeat, unsigned seed)
+{
+    mt19937 gen(seed);
+    uniform_real_distribution<double> uniform(0,1);
+
+    vector<double> x(npoints), y(npoints), z(npoints);
+    for (size_t i=0; i<npoints; i++)
+    {
+        double rho = fmap.rhomin() + (fmap.rhomax() - fmap.rhomin()) * uniform(gen);
+        double phi = 2 * M_PI * uniform(gen);
+        x[i] = rho * cos(phi);
+        y[i] = rho * sin(phi);
+        z[i] = fmap.zmin() + (fmap.zmax() - fmap.zmin()) * uniform(gen);
+    }
+
+    vector<double> bx(npoints), by(npoints), bz(npoints);
+
+    // keep the results live so the loops are not optimized away
+    double sum = 0;
+
+    clock_type::time_point start = clock_type::now();
+    for (size_t r=0; r<nrepeat; r++)
+    {
+        for (size_t i=0; i<npoints; i++)
+        {
+            field.B(x[i], y[i], z[i], bx[i], by[i], bz[i]);
+        }
+        sum += bx[r % npoints];
+    }
+    double t_single = elapsed(start);
+
+    start = clock_type::now();
+    for (size_t r=0; r<nrepeat; r++)
+    {
+        field.B(npoints, x.data(), y.data(), z.data(), bx.data(), by.data(), bz.data());
+        sum += bx[r % npoints];
+    }
+    double t_batch = elapsed(start);
+
+    double n = double(npoints) * nrepeat;
+    cout << name << endl
+         << "    single: " << n / t_single << " evaluations/s" << endl
+         << "    batch:  " << n / t_batch << " evaluations/s" << endl
+         << "    (checksum " << sum << ")" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    string torus = "";
+    string solenoid = "";
+    size_t npoints = 100000;
+    size_t nrepeat = 10;
+    unsigned seed = 12345;
+    double torus_scale = 1.;
+    double solenoid_scale = 1.;
+    string cache_dir = CompositeField::default_directory();
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h",
+            "produce help message")
+        ("torus",
+            po::value<string>(&torus),
+            "torus field map file (default: the one served by clas12magfield)")
+        ("solenoid",
+            po::value<string>(&solenoid),
+            "solenoid field map file (default: the one served by clas12magfield)")
+        ("points,n",
+            po::value<size_t>(&npoints)->default_value(npoints),
+            "number of points per pass")
+        ("repeat",
+            po::value<size_t>(&nrepeat)->default_value(nrepeat),
+            "number of passes over the points")
+        ("seed",
+            po::value<unsigned>(&seed)->default_value(seed),
+            "random number seed")
+        ("torus-scale",
+            po::value<double>(&torus_scale)->default_value(torus_scale),
+            "torus scale factor for the combined field")
+        ("solenoid-scale",
+            po::value<double>(&solenoid_scale)->default_value(solenoid_scale),
+            "solenoid scale factor for the combined field")
+        ("cache",
+            po::value<string>(&cache_dir)->default_value(cache_dir),
+            "directory for the precomputed combined field (empty: no cache)")
+    ;
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        cout << options << endl;
+        return 0;
+    }
+
+    FieldMapView torus_view = torus.empty()
+        ? Request("torus").view()
+        : FieldMapStore::instance().get(torus);
+    FieldMapView solenoid_view = solenoid.empty()
+        ? Request("solenoid").view()
+        : FieldMapStore::instance().get(solenoid);
+
+    clock_type::time_point start = clock_type::now();
+    auto torus_map = make_shared<const FieldMap>(torus_view);
+    auto solenoid_map = make_shared<const FieldMap>(solenoid_view);
+    cout << "load: " << 1.e3 * elapsed(start) << " ms" << endl;
+
+    bench("torus", *torus_map, *torus_map, npoints, nrepeat, seed);
+    bench("solenoid", *solenoid_map, *solenoid_map, npoints, nrepeat, seed);
+
+    CompositeField composite(torus_map, solenoid_map, torus_scale, solenoid_scale);
+    bench("torus + solenoid (summed)", composite, *torus_map, npoints, nrepeat, seed);
+
+    start = clock_type::now();
+    composite.precompute(cache_dir);
+    cout << "precompute: " << 1.e3 * elapsed(start) << " ms" << endl;
+    bench("torus + solenoid (precomputed)", composite, *torus_map, npoints, nrepeat, seed);
+
+    return 0;
+}
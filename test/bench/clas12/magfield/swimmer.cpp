@@ -0,0 +1,177 @@
+/**
+ * Benchmark of the Runge-Kutta swimmer through the forward detector:
+ *
+ *   - Swimmer::swim(): tracks from the target through the torus and
+ *     solenoid fields, stopped at every DC sense layer, FTOF panel
+ *     and calorimeter face of their sector and ending at the EC
+ *
+ * Tracks have momenta between 1 and 8 GeV/c, polar angles between 5
+ * and 35 degrees and random azimuth and charge. Batches are swum with
+ * one thread and then with the requested number of threads.
+ **/
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/program_options.hpp"
+
+#include "clas12/ccdb/constants_table.hpp"
+#include "clas12/geometry/detector_planes.hpp"
+#include "clas12/geometry/drift_chamber.hpp"
+#include "clas12/geometry/electromagnetic_cal.hpp"
+#include "clas12/geometry/forward_tof.hpp"
+#include "clas12/geometry/preshower_cal.hpp"
+#include "clas12/magfield/composite_field.hpp"
+#include "clas12/magfield/field_map.hpp"
+#include "clas12/magfield/field_map_store.hpp"
+#include "clas12/magfield/request.hpp"
+#include "clas12/magfield/swimmer.hpp"
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace clas12::magfield;
+
+typedef chrono::steady_clock clock_type;
+
+double elapsed(const clock_type::time_point& start)
+{
+    return chrono::duration<double>(clock_type::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    string connstr = "mysql://clas12reader@clasdb.jlab.org/clas12";
+    string torus = "";
+    string solenoid = "";
+    size_t ntracks = 10000;
+    size_t nthreads = thread::hardware_concurrency();
+    double tolerance = 1.e-3;
+    double torus_scale = 1.;
+    double solenoid_scale = 1.;
+    unsigned seed = 12345;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h",
+            "produce help message")
+        ("connection,c",
+            po::value<string>(&connstr)->default_value(connstr),
+            "CCDB connection string (mysql://... or sqlite://...)")
+        ("torus",
+            po::value<string>(&torus),
+            "torus field map file (default: the one served by clas12magfield)")
+        ("solenoid",
+            po::value<string>(&solenoid),
+            "solenoid field map file (default: the one served by clas12magfield)")
+        ("tracks,n",
+            po::value<size_t>(&ntracks)->default_value(ntracks),
+            "number of tracks to swim")
+        ("threads,j",
+            po::value<size_t>(&nthreads)->default_value(nthreads),
+            "number of threads for the parallel pass")
+        ("tolerance",
+            po::value<double>(&tolerance)->default_value(tolerance),
+            "largest estimated position error of a step (cm)")
+        ("torus-scale",
+            po::value<double>(&torus_scale)->default_value(torus_scale),
+            "torus scale factor")
+        ("solenoid-scale",
+            po::value<double>(&solenoid_scale)->default_value(solenoid_scale),
+            "solenoid scale factor")
+        ("seed",
+            po::value<unsigned>(&seed)->default_value(seed),
+            "random number seed")
+    ;
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        cout << options << endl;
+        return 0;
+    }
+
+    FieldMapView torus_view = torus.empty()
+        ? Request("torus").view()
+        : FieldMapStore::instance().get(torus);
+    FieldMapView solenoid_view = solenoid.empty()
+        ? Request("solenoid").view()
+        : FieldMapStore::instance().get(solenoid);
+
+    auto field = make_shared<const CompositeField>(
+        make_shared<const FieldMap>(torus_view),
+        make_shared<const FieldMap>(solenoid_view),
+        torus_scale, solenoid_scale);
+
+    auto calib = clas12::ccdb::get_calibration(connstr, clas12::ccdb::ConstantSetInfo());
+    clas12::geometry::DriftChamber dc(calib.get());
+    clas12::geometry::ForwardTOF ftof(calib.get());
+    clas12::geometry::PreshowerCal pcal(calib.get());
+    clas12::geometry::ElectromagneticCal ec(calib.get());
+
+    Swimmer swimmer(field, tolerance);
+    auto planes = clas12::geometry::forward_detector_planes(dc, ftof, pcal, ec);
+    for (size_t i=0; i<planes.size(); i++)
+    {
+        bool stop = (planes[i].detector == "ec");
+        swimmer.add_surface(planes[i].surface, i, planes[i].sector, stop);
+    }
+    cout << "surfaces: " << swimmer.nsurfaces() << endl;
+
+    mt19937 gen(seed);
+    uniform_real_distribution<double> uniform(0,1);
+
+    vector<TrackState> tracks(ntracks);
+    for (auto& t : tracks)
+    {
+        double p = 1. + 7. * uniform(gen);
+        double th = (5. + 30. * uniform(gen)) * M_PI / 180.;
+        double ph = 2. * M_PI * uniform(gen);
+        t.x = 0;
+        t.y = 0;
+        t.z = 0;
+        t.px = p * sin(th) * cos(ph);
+        t.py = p * sin(th) * sin(ph);
+        t.pz = p * cos(th);
+        t.charge = (uniform(gen) < 0.5) ? -1 : 1;
+        t.path = 0;
+    }
+
+    vector<SurfaceCrossing> crossings;
+    vector<TrackState> finals;
+
+    for (size_t n : {size_t(1), nthreads})
+    {
+        clock_type::time_point start = clock_type::now();
+        swimmer.swim(tracks, crossings, finals, n);
+        double t = elapsed(start);
+
+        size_t nstopped = 0;
+        for (const auto& c : crossings)
+        {
+            if (planes[c.surface].detector == "ec")
+            {
+                nstopped++;
+            }
+        }
+
+        cout << "threads: " << n << endl
+             << "    " << ntracks << " tracks in " << t << " s, "
+             << ntracks / t << " tracks/s" << endl
+             << "    " << crossings.size() << " crossings, "
+             << double(crossings.size()) / ntracks << " per track, "
+             << nstopped << " tracks reached the EC" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,196 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_ccdb_connection_pool
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/ccdb/connection_pool.hpp"
+#include "clas12/stats.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_ccdb_connection_pool)
+
+namespace
+{
+    namespace fs = boost::filesystem;
+
+    using std::string;
+    using std::vector;
+    using clas12::ccdb::ConnectionPool;
+    using clas12::ccdb::ConstantSetInfo;
+    using clas12::ccdb::ConstantsTable;
+    using clas12::ccdb::PooledCalibration;
+
+    /// writes a small fixture file, removed on destruction
+    struct Fixture
+    {
+        fs::path path;
+        string connstr;
+
+        Fixture()
+        : path(fs::temp_directory_path() / fs::unique_path("clas12-pool-%%%%%%.txt"))
+        , connstr("fixture://" + path.string())
+        {
+            std::ofstream fout(path.string());
+            fout << "[/geometry/dc/dc]\n"
+                 << "nsectors:int nregions:int\n"
+                 << "6 3\n";
+        }
+
+        ~Fixture()
+        {
+            fs::remove(path);
+        }
+    };
+}
+
+BOOST_AUTO_TEST_CASE(reuse)
+{
+    Fixture fix;
+    ConnectionPool pool(2);
+
+    clas12::ccdb::Calibration* first;
+    {
+        PooledCalibration calib = pool.acquire(fix.connstr, ConstantSetInfo());
+        BOOST_REQUIRE(calib);
+        first = calib.get();
+        BOOST_CHECK_EQUAL(ConstantsTable(calib.get(), "/geometry/dc/dc").elem<int>("nsectors"), 6);
+        BOOST_CHECK_EQUAL(pool.in_use(), size_t(1));
+    }
+    BOOST_CHECK_EQUAL(pool.idle(), size_t(1));
+    BOOST_CHECK_EQUAL(pool.in_use(), size_t(0));
+
+    PooledCalibration again = pool.acquire(fix.connstr, ConstantSetInfo());
+    BOOST_CHECK_EQUAL(again.get(), first);
+
+    // another run is a separate set of connections
+    PooledCalibration other = pool.acquire(fix.connstr, ConstantSetInfo(11));
+    BOOST_CHECK(other.get() != first);
+
+    BOOST_CHECK_EQUAL(pool.statistics().created, size_t(2));
+    BOOST_CHECK_EQUAL(pool.statistics().reused, size_t(1));
+
+    // moving a handle does not give back the connection
+    PooledCalibration moved(std::move(again));
+    BOOST_CHECK(!again);
+    BOOST_CHECK_EQUAL(pool.in_use(), size_t(2));
+    moved.reset();
+    other.reset();
+    BOOST_CHECK_EQUAL(pool.in_use(), size_t(0));
+
+    pool.clear();
+    BOOST_CHECK_EQUAL(pool.idle(), size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(bounded)
+{
+    Fixture fix;
+    ConnectionPool pool(2);
+
+    std::atomic<int> active(0);
+    std::atomic<int> most(0);
+
+    vector<std::thread> threads;
+    for (int i=0; i<8; i++)
+    {
+        threads.emplace_back([&]()
+        {
+            for (int j=0; j<5; j++)
+            {
+                PooledCalibration calib = pool.acquire(fix.connstr, ConstantSetInfo());
+                int n = ++active;
+                int m = most;
+                while (n > m && !most.compare_exchange_weak(m, n))
+                {}
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                --active;
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    BOOST_CHECK_LE(most.load(), 2);
+    BOOST_CHECK_LE(pool.statistics().created, size_t(2));
+    BOOST_CHECK_EQUAL(pool.statistics().created + pool.statistics().reused, size_t(40));
+    BOOST_CHECK_GT(pool.statistics().waits, size_t(0));
+    BOOST_CHECK_EQUAL(pool.idle(), pool.statistics().created);
+}
+
+BOOST_AUTO_TEST_CASE(total_bounded)
+{
+    Fixture fix;
+    ConnectionPool pool(2, std::chrono::minutes(5), 2);
+    BOOST_CHECK_EQUAL(pool.max_total(), size_t(2));
+
+    pool.acquire(fix.connstr, ConstantSetInfo(1)).reset();
+    pool.acquire(fix.connstr, ConstantSetInfo(2)).reset();
+    BOOST_CHECK_EQUAL(pool.idle(), size_t(2));
+
+    // the connection of run 1, idle the longest, makes room for run 3
+    PooledCalibration third = pool.acquire(fix.connstr, ConstantSetInfo(3));
+    BOOST_CHECK_EQUAL(pool.statistics().evicted, size_t(1));
+    BOOST_CHECK_EQUAL(pool.idle(), size_t(1));
+    BOOST_CHECK_EQUAL(pool.in_use(), size_t(1));
+
+    PooledCalibration second = pool.acquire(fix.connstr, ConstantSetInfo(2));
+    BOOST_CHECK_EQUAL(pool.statistics().reused, size_t(1));
+
+    // with all connections leased, another constant set waits
+    std::atomic<bool> done(false);
+    std::thread t([&]()
+    {
+        PooledCalibration calib = pool.acquire(fix.connstr, ConstantSetInfo(4));
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    BOOST_CHECK(!done);
+    third.reset();
+    t.join();
+    BOOST_CHECK(done);
+
+    BOOST_CHECK_EQUAL(pool.statistics().evicted, size_t(2));
+    BOOST_CHECK_EQUAL(pool.statistics().waits, size_t(1));
+    BOOST_CHECK_EQUAL(pool.idle() + pool.in_use(), size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(memory_never_stale)
+{
+    Fixture fix;
+    ConnectionPool pool(1, std::chrono::seconds(0));
+
+    clas12::stats::thread_stats().clear();
+    {
+        PooledCalibration calib = pool.acquire(fix.connstr, ConstantSetInfo());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    {
+        PooledCalibration calib = pool.acquire(fix.connstr, ConstantSetInfo());
+    }
+
+    // memory calibrations are never stale
+    BOOST_CHECK_EQUAL(pool.statistics().discarded, size_t(0));
+    BOOST_CHECK_EQUAL(clas12::stats::thread_stats().stages().at("ccdb pool wait").calls, size_t(2));
+    BOOST_CHECK_EQUAL(clas12::stats::thread_stats().counters().at("ccdb connections"), size_t(1));
+}
+
+BOOST_AUTO_TEST_CASE(bad_connection)
+{
+    ConnectionPool pool(1);
+    BOOST_CHECK_THROW(pool.acquire("fixture:///no/such/file", ConstantSetInfo()), std::runtime_error);
+    // the failed connection does not take up the slot
+    BOOST_CHECK_EQUAL(pool.in_use(), size_t(0));
+    BOOST_CHECK_THROW(pool.acquire("fixture:///no/such/file", ConstantSetInfo()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
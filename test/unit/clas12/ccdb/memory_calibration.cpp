@@ -0,0 +1,93 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_ccdb_memory_calibration
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "clas12/ccdb/constants_table.hpp"
+#include "clas12/ccdb/memory_calibration.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_ccdb_memory_calibration)
+
+namespace
+{
+    using std::string;
+    using std::stringstream;
+    using std::vector;
+    using clas12::ccdb::ConstantsTable;
+    using clas12::ccdb::MemoryCalibration;
+
+    const string fixture =
+        "# comment\n"
+        "[/geometry/dc/dc]\n"
+        "nsectors:int nregions:int\n"
+        "6 3\n"
+        "\n"
+        "[/geometry/dc/region]\n"
+        "nsuperlayers:int dist2tgt:double name:string\n"
+        "2 228.078 r1\n"
+        "2 409.311 r2\n"
+        "2 547.745 r3\n";
+}
+
+BOOST_AUTO_TEST_CASE(read_and_lookup)
+{
+    MemoryCalibration calib;
+    stringstream ss(fixture);
+    calib.read(ss);
+
+    BOOST_CHECK_EQUAL(calib.tables().size(), size_t(2));
+    BOOST_CHECK(calib.has_table("/geometry/dc/region"));
+    BOOST_CHECK(!calib.has_table("/geometry/dc/layer"));
+    BOOST_CHECK_THROW(calib.table("/geometry/dc/layer"), std::runtime_error);
+
+    ConstantsTable table(&calib, "/geometry/dc/region");
+    BOOST_CHECK_EQUAL(table.nrows(), size_t(3));
+    BOOST_CHECK_CLOSE(table.elem<double>("dist2tgt", 1), 409.311, 1e-9);
+    BOOST_CHECK_EQUAL(table.elem<string>("name", 2), "r3");
+    BOOST_CHECK_EQUAL(ConstantsTable(&calib, "/geometry/dc/dc").elem<int>("nsectors"), 6);
+}
+
+BOOST_AUTO_TEST_CASE(save_round_trip)
+{
+    MemoryCalibration calib;
+    stringstream in(fixture);
+    calib.read(in);
+
+    stringstream out;
+    calib.save(out);
+
+    MemoryCalibration copy;
+    copy.read(out);
+    BOOST_REQUIRE_EQUAL(copy.tables().size(), calib.tables().size());
+    for (const auto& t : calib.tables())
+    {
+        const auto& c = copy.table(t.first);
+        BOOST_CHECK(c.columns == t.second.columns);
+        BOOST_CHECK(c.types == t.second.types);
+        BOOST_CHECK(c.rows == t.second.rows);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    MemoryCalibration calib;
+
+    stringstream no_path("a:int\n1\n");
+    BOOST_CHECK_THROW(calib.read(no_path), std::runtime_error);
+
+    stringstream short_row("[/t]\na:int b:int\n1\n");
+    BOOST_CHECK_THROW(calib.read(short_row), std::runtime_error);
+
+    clas12::ccdb::MemoryTable bad;
+    bad.columns = vector<string>{"a", "b"};
+    bad.types = vector<string>{"int"};
+    BOOST_CHECK_THROW(calib.add_table("/t", bad), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,98 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_compression
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include "clas12/compression.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_compression)
+
+namespace
+{
+    using std::string;
+    using clas12::compression::Codec;
+    using clas12::compression::CompressedCopies;
+
+    namespace compression = clas12::compression;
+
+    // repetitive like the geometry XML, and larger than one chunk
+    string payload()
+    {
+        string xml = "<dc>\n";
+        for (int i=0; i<20000; i++)
+        {
+            xml += "  <wire sector=\"" + std::to_string(i % 6 + 1)
+                 + "\" id=\"" + std::to_string(i) + "\" x=\"1.2345\"/>\n";
+        }
+        return xml + "</dc>\n";
+    }
+}
+
+BOOST_AUTO_TEST_CASE(names)
+{
+    BOOST_CHECK(compression::codec("") == Codec::none);
+    BOOST_CHECK(compression::codec("none") == Codec::none);
+    BOOST_CHECK(compression::codec("ZLIB") == Codec::zlib);
+    BOOST_CHECK(compression::codec("zstd") == Codec::zstd);
+    BOOST_CHECK(compression::codec("lz4") == Codec::lz4);
+    BOOST_CHECK_THROW(compression::codec("gzip"), std::invalid_argument);
+
+    for (Codec c : {Codec::none, Codec::zlib, Codec::zstd, Codec::lz4})
+    {
+        BOOST_CHECK(compression::codec(compression::name(c)) == c);
+    }
+    BOOST_CHECK(compression::available(Codec::none));
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    const string xml = payload();
+    BOOST_CHECK_EQUAL(compression::compress(xml, Codec::none), xml);
+
+    for (Codec c : compression::available_codecs())
+    {
+        BOOST_TEST_CONTEXT(compression::name(c))
+        {
+            string bytes = compression::compress(xml, c);
+            BOOST_CHECK_LT(bytes.size(), xml.size() / 4);
+            BOOST_CHECK(compression::decompress(bytes, c) == xml);
+
+            BOOST_CHECK(compression::decompress(compression::compress("", c), c) == "");
+
+            // truncated data is an error, not a short payload
+            BOOST_CHECK_THROW(
+                compression::decompress(bytes.substr(0, bytes.size() / 2), c),
+                std::runtime_error);
+        }
+    }
+
+    for (Codec c : {Codec::zlib, Codec::zstd, Codec::lz4})
+    {
+        if (!compression::available(c))
+        {
+            BOOST_CHECK_THROW(compression::compress(xml, c), std::runtime_error);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compressed_copies)
+{
+    const string xml = payload();
+    CompressedCopies copies;
+    BOOST_CHECK_EQUAL(copies.size(), size_t(0));
+
+    for (Codec c : compression::available_codecs())
+    {
+        const string& first = copies.get(xml, c);
+        const string& second = copies.get(xml, c);
+        BOOST_CHECK_EQUAL(&first, &second);
+        BOOST_CHECK(compression::decompress(first, c) == xml);
+    }
+    BOOST_CHECK_EQUAL(copies.size(), compression::available_codecs().size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
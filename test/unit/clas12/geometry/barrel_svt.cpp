@@ -0,0 +1,312 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_barrel_svt
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "geometry/euclid_vector.hpp"
+#include "geometry/line_segment.hpp"
+
+#include "clas12/ccdb/memory_calibration.hpp"
+#include "clas12/geometry/central_tracker.hpp"
+
+#ifndef CLAS12_FIXTURES
+#define CLAS12_FIXTURES "test/fixtures"
+#endif
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_barrel_svt)
+
+namespace
+{
+    using std::pair;
+    using std::size_t;
+    using std::string;
+    using std::vector;
+    using ::geometry::euclid_vector;
+    using ::geometry::line_segment;
+    using clas12::ccdb::MemoryCalibration;
+    using clas12::geometry::CentralTracker;
+    using clas12::geometry::central_tracker::BarrelSVT;
+    using clas12::geometry::central_tracker::barrel_svt::Layer;
+    using clas12::geometry::central_tracker::barrel_svt::Sector;
+    using clas12::geometry::central_tracker::barrel_svt::StripTable;
+
+    // mm
+    const double tolerance = 1.e-9;
+
+    /// the central tracker built from the checked-in fixture
+    struct Fixture
+    {
+        MemoryCalibration calib;
+        CentralTracker ct;
+
+        Fixture()
+        : calib()
+        , ct((calib.load(string(CLAS12_FIXTURES) + "/geometry_tables.txt"), &calib))
+        {}
+    };
+
+    /// the point a fraction t along a line segment
+    euclid_vector<double,3> along(const line_segment<double,3>& seg, double t)
+    {
+        euclid_vector<double,3> p0 = seg.begin_point();
+        euclid_vector<double,3> p1 = seg.end_point();
+        return euclid_vector<double,3>{
+            p0.x() + t * (p1.x() - p0.x()),
+            p0.y() + t * (p1.y() - p0.y()),
+            p0.z() + t * (p1.z() - p0.z()) };
+    }
+
+    /// the direction of local x in the LAB frame
+    euclid_vector<double,3> local_x(const Sector& sector)
+    {
+        return euclid_vector<double,3>{-std::sin(sector.phi()), std::cos(sector.phi()), 0};
+    }
+
+    /// local x of a strip at local z
+    double strip_x(const Layer& layer, int s, double z)
+    {
+        euclid_vector<double,3> p0 = layer.stripFirstPoint(s);
+        euclid_vector<double,3> p1 = layer.stripSecondPoint(s);
+        return p0.x() + (p1.x() - p0.x()) * (z - p0.z()) / (p1.z() - p0.z());
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(strip_table, Fixture)
+{
+    const BarrelSVT& bst = ct.bst();
+    const StripTable& table = bst.strip_table();
+
+    BOOST_REQUIRE_EQUAL(table.nregions(), bst.regions().size());
+    BOOST_REQUIRE_GT(table.nregions(), size_t(0));
+
+    size_t nchecked = 0;
+    for (size_t reg=0; reg<table.nregions(); reg++)
+    {
+        for (size_t sec=0; sec<table.nsectors(reg); sec++)
+        {
+            for (size_t lyr=0; lyr<table.nlayers(reg); lyr++)
+            {
+                const Layer& layer = bst.region(reg).sector(sec).layer(lyr);
+                BOOST_REQUIRE_EQUAL(table.nstrips(reg,sec,lyr), layer.nstrips());
+
+                size_t begin = table.begin(reg,sec,lyr);
+                for (size_t s=0; s<layer.nstrips(); s++)
+                {
+                    size_t i = begin + s;
+
+                    // local frame
+                    euclid_vector<double,3> local0 = layer.stripFirstPoint(s);
+                    euclid_vector<double,3> local1 = layer.stripSecondPoint(s);
+                    BOOST_CHECK_SMALL(table.local_first_x()[i] - local0.x(), tolerance);
+                    BOOST_CHECK_SMALL(table.local_second_x()[i] - local1.x(), tolerance);
+                    BOOST_CHECK_SMALL(table.local_second_z()[i] - local1.z(), tolerance);
+
+                    // LAB frame, through Layer::TransformToLAB()
+                    line_segment<double,3> strip = layer.siliconStrip(s);
+                    euclid_vector<double,3> p0 = strip.begin_point();
+                    euclid_vector<double,3> p1 = strip.end_point();
+                    BOOST_CHECK_SMALL(table.first_x()[i] - p0.x(), tolerance);
+                    BOOST_CHECK_SMALL(table.first_y()[i] - p0.y(), tolerance);
+                    BOOST_CHECK_SMALL(table.first_z()[i] - p0.z(), tolerance);
+                    BOOST_CHECK_SMALL(table.second_x()[i] - p1.x(), tolerance);
+                    BOOST_CHECK_SMALL(table.second_y()[i] - p1.y(), tolerance);
+                    BOOST_CHECK_SMALL(table.second_z()[i] - p1.z(), tolerance);
+
+                    nchecked++;
+                }
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(nchecked, table.first_x().size());
+}
+
+BOOST_FIXTURE_TEST_CASE(hit_strip, Fixture)
+{
+    const BarrelSVT& bst = ct.bst();
+    for (size_t reg=0; reg<bst.regions().size(); reg++)
+    {
+        for (size_t sec=0; sec<bst.region(reg).sectors().size(); sec++)
+        {
+            for (size_t lyr=0; lyr<2; lyr++)
+            {
+                const Sector& sector = bst.region(reg).sector(sec);
+                const Layer& layer = sector.layer(lyr);
+                euclid_vector<double,3> ex = local_x(sector);
+
+                vector<euclid_vector<double,3>> points;
+                vector<int> expected;
+                for (int s=0; s<int(layer.nstrips()); s++)
+                {
+                    // half-way along the part of the strip on the first sensor
+                    euclid_vector<double,3> local0 = layer.stripFirstPoint(s);
+                    euclid_vector<double,3> local1 = layer.stripSecondPoint(s);
+                    double z = 0.5 * std::min(layer.activeSenLen(), local1.z());
+                    double t = z / local1.z();
+                    euclid_vector<double,3> point = along(layer.siliconStrip(s), t);
+
+                    // LAB -> local undoes TransformToLAB()
+                    euclid_vector<double,3> local = layer.TransformToLocal(point);
+                    BOOST_CHECK_SMALL(local.x() - (local0.x() + t * (local1.x() - local0.x())), tolerance);
+                    BOOST_CHECK_SMALL(local.y() - (local0.y() + t * (local1.y() - local0.y())), tolerance);
+                    BOOST_CHECK_SMALL(local.z() - z, tolerance);
+
+                    // the first strip of the bottom layer and the last of
+                    // the top layer are on the edge of the active area:
+                    // hit each strip a quarter pitch towards the middle
+                    double dx = (local.x() < 0.5*layer.activeSenWid() ? 0.25 : -0.25)
+                              * layer.readoutPitch();
+                    point = euclid_vector<double,3>{
+                        point.x() + dx * ex.x(),
+                        point.y() + dx * ex.y(),
+                        point.z() };
+
+                    BOOST_CHECK(layer.in_active_area(layer.TransformToLocal(point)));
+                    BOOST_CHECK_EQUAL(layer.hit_strip(point), s);
+
+                    points.push_back(point);
+                    expected.push_back(s);
+                }
+
+                vector<int> hits = layer.hit_strips(points);
+                BOOST_CHECK_EQUAL_COLLECTIONS(hits.begin(), hits.end(),
+                                              expected.begin(), expected.end());
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(hit_strip_outside, Fixture)
+{
+    const BarrelSVT& bst = ct.bst();
+    for (size_t reg=0; reg<bst.regions().size(); reg++)
+    {
+        const Sector& sector = bst.region(reg).sector(0);
+        for (size_t lyr=0; lyr<2; lyr++)
+        {
+            const Layer& layer = sector.layer(lyr);
+
+            euclid_vector<double,3> point = along(layer.siliconStrip(128), 0.1);
+            euclid_vector<double,3> local = layer.TransformToLocal(point);
+            BOOST_REQUIRE(layer.in_active_area(local));
+
+            euclid_vector<double,3> ex = local_x(sector);
+            auto shifted = [&](double x, double z)
+            {
+                return euclid_vector<double,3>{
+                    point.x() + (x - local.x()) * ex.x(),
+                    point.y() + (x - local.x()) * ex.y(),
+                    point.z() + (z - local.z()) };
+            };
+
+            double width = layer.activeSenWid();
+            double z1 = layer.activeSenLen();
+            double z2 = z1 + layer.deadZnSenLen2();
+            double z3 = z2 + layer.activeSenLen();
+            double z4 = z3 + layer.deadZnSenLen3();
+            double z5 = z4 + layer.activeSenLen();
+            double x = 0.5 * width;
+
+            vector<euclid_vector<double,3>> outside{
+                shifted(-1., 1.),                 // beside the sensors
+                shifted(width + 1., 1.),
+                shifted(x, -1.),                  // before the first sensor
+                shifted(x, 0.5 * (z1 + z2)),      // between the sensors
+                shifted(x, 0.5 * (z3 + z4)),
+                shifted(x, z5 + 1.) };            // after the last sensor
+
+            for (const auto& p : outside)
+            {
+                BOOST_CHECK(!layer.in_active_area(layer.TransformToLocal(p)));
+                BOOST_CHECK_EQUAL(layer.hit_strip(p), -1);
+            }
+            vector<int> hits = layer.hit_strips(outside);
+            BOOST_CHECK(std::count(hits.begin(), hits.end(), -1) == long(outside.size()));
+
+            // just inside each edge of the second sensor
+            BOOST_CHECK(layer.in_active_area(layer.TransformToLocal(shifted(x, z2 + 0.01))));
+            BOOST_CHECK(layer.in_active_area(layer.TransformToLocal(shifted(x, z3 - 0.01))));
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(strip_crossing, Fixture)
+{
+    const BarrelSVT& bst = ct.bst();
+    const vector<int> strips{0, 1, 17, 64, 128, 200, 254, 255};
+
+    size_t ncrossings = 0;
+    for (size_t reg=0; reg<bst.regions().size(); reg++)
+    {
+        for (size_t sec=0; sec<bst.region(reg).sectors().size(); sec++)
+        {
+            const Sector& sector = bst.region(reg).sector(sec);
+            const Layer& bottom = sector.layer(0);
+            const Layer& top = sector.layer(1);
+
+            vector<euclid_vector<double,3>> expected;
+            for (int t : strips)
+            {
+                for (int b : strips)
+                {
+                    euclid_vector<double,3> point{0, 0, 0};
+                    if (!sector.strip_crossing(t, b, point))
+                    {
+                        BOOST_CHECK_EQUAL(point.x(), 0.);
+                        continue;
+                    }
+                    expected.push_back(point);
+
+                    // the point is on both strips
+                    euclid_vector<double,3> ltop = top.TransformToLocal(point);
+                    euclid_vector<double,3> lbottom = bottom.TransformToLocal(point);
+                    BOOST_CHECK_SMALL(ltop.x() - strip_x(top, t, ltop.z()), 1.e-6);
+                    BOOST_CHECK_SMALL(lbottom.x() - strip_x(bottom, b, lbottom.z()), 1.e-6);
+
+                    // crossings with the first strips are on the edge
+                    // of the active area, which rounding may leave
+                    if (top.in_active_area(ltop) && bottom.in_active_area(lbottom))
+                    {
+                        BOOST_CHECK_EQUAL(top.hit_strip(point), t);
+                        BOOST_CHECK_EQUAL(bottom.hit_strip(point), b);
+                    }
+                }
+            }
+            ncrossings += expected.size();
+
+            // the first strips of both layers are parallel and the
+            // last strips are too far apart to cross
+            euclid_vector<double,3> point{0, 0, 0};
+            BOOST_CHECK(!sector.strip_crossing(0, 0, point));
+            BOOST_CHECK(!sector.strip_crossing(255, 255, point));
+
+            // the batch form gives the same points, top strip first
+            vector<euclid_vector<double,3>> points;
+            vector<pair<size_t,size_t>> pairs;
+            BOOST_REQUIRE_EQUAL(sector.strip_crossings(strips, strips, points, pairs),
+                                expected.size());
+            BOOST_REQUIRE_EQUAL(pairs.size(), points.size());
+            for (size_t i=0; i<points.size(); i++)
+            {
+                BOOST_CHECK_SMALL(points[i].x() - expected[i].x(), tolerance);
+                BOOST_CHECK_SMALL(points[i].y() - expected[i].y(), tolerance);
+                BOOST_CHECK_SMALL(points[i].z() - expected[i].z(), tolerance);
+
+                euclid_vector<double,3> p;
+                BOOST_REQUIRE(sector.strip_crossing(strips[pairs[i].first],
+                                                    strips[pairs[i].second], p));
+                BOOST_CHECK_SMALL(p.z() - points[i].z(), tolerance);
+            }
+        }
+    }
+    BOOST_CHECK_GT(ncrossings, size_t(0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,212 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_client
+
+#include <boost/test/unit_test.hpp>
+
+#include <clocale>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "pugixml.hpp"
+
+#include "clas12/geometry/client.hpp"
+#include "clas12/geometry/output/parametric.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_client)
+
+namespace
+{
+    using std::string;
+    using std::stringstream;
+    using std::vector;
+
+    using pugi::xml_document;
+    using pugi::xml_node;
+
+    using clas12::geometry::client::Reader;
+    using clas12::geometry::client::SegmentTable;
+    using clas12::geometry::output::set_values;
+
+    namespace client = clas12::geometry::client;
+
+    /// coordinate c of wire w in a layer
+    double coord(int layer, int c, int w)
+    {
+        return 100 * layer + 10 * c + 1.25 * w;
+    }
+
+    /**
+     * \brief a document laid out as dc_wire_endpoints_xml() and
+     * ftof_panels_parms_xml() write it: two sense layers of 112 wires
+     * and a guard layer of 113, and one panel of 23 paddles
+     **/
+    string document(bool parametric)
+    {
+        xml_document doc;
+        xml_node geom_node = doc.append_child("geometry");
+
+        xml_node wire_node = geom_node.append_child("drift_chamber").append_child("wire_endpoints");
+        wire_node.append_attribute("length_units") = "cm";
+        wire_node.append_attribute("coordinate_system") = "clas";
+        for (int lyr=0; lyr<3; lyr++)
+        {
+            xml_node layer_node = wire_node.append_child("layer");
+            layer_node.append_attribute("sector") = 1;
+            layer_node.append_attribute("region") = 2;
+            layer_node.append_attribute("superlayer") = 0;
+            layer_node.append_attribute(lyr < 2 ? "senselayer" : "guardlayer") = lyr % 2;
+
+            int nwires = (lyr < 2) ? 112 : 113;
+            int c = 0;
+            for (const char* end : {"left", "right"})
+            {
+                xml_node end_node = layer_node.append_child(end);
+                for (const char* axis : {"x", "y", "z"})
+                {
+                    vector<double> values;
+                    for (int w=0; w<nwires; w++)
+                    {
+                        values.push_back(coord(lyr, c, w));
+                    }
+                    if (c == 0)
+                    {
+                        values[7] += 0.5;
+                    }
+                    set_values(end_node.append_child(axis), values, parametric);
+                    c++;
+                }
+            }
+        }
+
+        xml_node panels_node = geom_node.append_child("forward_tof").append_child("panels_parms");
+        panels_node.append_attribute("length_units") = "cm";
+        panels_node.append_attribute("coordinate_system") = "clas";
+        xml_node panel_node = panels_node.append_child("panel");
+        panel_node.append_attribute("sector") = 3;
+        panel_node.append_attribute("panel") = "1a";
+        panel_node.append_attribute("npaddles") = 23;
+        panel_node.append_attribute("dist2tgt") = 684.808;
+        xml_node center_node = panel_node.append_child("paddle_centers");
+        for (const char* axis : {"x", "y", "z"})
+        {
+            set_values(center_node.append_child(axis), vector<double>(23, 2.5), parametric);
+        }
+        vector<double> lengths;
+        for (int p=0; p<23; p++)
+        {
+            lengths.push_back(32.28 + p * 15.85);
+        }
+        set_values(panel_node.append_child("paddle_lengths"), lengths, parametric);
+
+        stringstream ss;
+        doc.save(ss);
+        return ss.str();
+    }
+
+    /// a panel of two paddles with the given x centers and lengths
+    string panel(const string& x, const string& lengths,
+                 const string& length_attrs = "", const string& dist2tgt = "1.5")
+    {
+        return "<geometry><forward_tof>"
+               "<panels_parms length_units='cm' coordinate_system='clas'>"
+               "<panel sector='1' panel='1a' dist2tgt='" + dist2tgt + "'>"
+               "<paddle_centers><x>" + x + "</x><y>0 0</y><z>0 0</z></paddle_centers>"
+               "<paddle_lengths" + length_attrs + ">" + lengths + "</paddle_lengths>"
+               "</panel></panels_parms></forward_tof></geometry>";
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_xml)
+{
+    for (bool parametric : {false, true})
+    {
+        Reader reader(document(parametric));
+
+        const SegmentTable& wires = reader.wire_endpoints();
+        BOOST_CHECK_EQUAL(wires.length_units(), "cm");
+        BOOST_CHECK_EQUAL(wires.coordinate_system(), "clas");
+        BOOST_REQUIRE_EQUAL(wires.layers().size(), 3u);
+        BOOST_REQUIRE_EQUAL(wires.size(), 112u + 112u + 113u);
+
+        const client::Layer& guard = wires.layers()[2];
+        BOOST_CHECK(guard.guard);
+        BOOST_CHECK(!wires.layers()[1].guard);
+        BOOST_CHECK_EQUAL(wires.layers()[1].layer, 1);
+        BOOST_CHECK_EQUAL(guard.sector, 1);
+        BOOST_CHECK_EQUAL(guard.region, 2);
+        BOOST_CHECK_EQUAL(guard.superlayer, 0);
+        BOOST_CHECK_EQUAL(guard.begin, 224u);
+        BOOST_CHECK_EQUAL(guard.end, wires.size());
+
+        // the explicit text has six significant digits
+        BOOST_CHECK_CLOSE(wires.first_x()[guard.begin + 7], coord(2, 0, 7) + 0.5, 1.e-4);
+        BOOST_CHECK_CLOSE(wires.first_x()[guard.begin + 8], coord(2, 0, 8), 1.e-4);
+        BOOST_CHECK_CLOSE(wires.second_z()[guard.end - 1], coord(2, 5, 112), 1.e-4);
+
+        BOOST_CHECK_EQUAL(reader.strip_endpoints().size(), 0u);
+
+        const client::PaddleTable& paddles = reader.paddles();
+        BOOST_REQUIRE_EQUAL(paddles.panels().size(), 1u);
+        BOOST_CHECK_EQUAL(paddles.size(), 23u);
+        BOOST_CHECK_EQUAL(paddles.panels()[0].name, "1a");
+        BOOST_CHECK_EQUAL(paddles.panels()[0].sector, 3);
+        BOOST_CHECK_CLOSE(paddles.panels()[0].parms.at("dist2tgt"), 684.808, 1.e-6);
+        BOOST_CHECK_CLOSE(paddles.length()[22], 32.28 + 22 * 15.85, 1.e-4);
+        BOOST_CHECK_CLOSE(paddles.center_y()[5], 2.5, 1.e-6);
+    }
+
+    BOOST_CHECK_THROW(Reader("<geometry><drift_chamber>"), std::runtime_error);
+    BOOST_CHECK_THROW(Reader(
+        "<geometry><drift_chamber><wire_endpoints><layer>"
+        "<left><x>1 2</x><y>1 2</y><z>1</z></left>"
+        "</layer></wire_endpoints></drift_chamber></geometry>"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(read_numbers)
+{
+    auto check = [](const string& xml)
+    {
+        Reader reader(xml);
+        const client::PaddleTable& paddles = reader.paddles();
+        BOOST_REQUIRE_EQUAL(paddles.size(), 2u);
+        BOOST_CHECK_EQUAL(paddles.center_x()[1], 1.5);
+        BOOST_CHECK_EQUAL(paddles.length()[1], 2.25);
+        BOOST_CHECK_EQUAL(paddles.panels()[0].parms.at("dist2tgt"), 1.5);
+    };
+
+    const string parametric = " n='2' origin='1.5' stride='0.5'";
+    check(panel(" 0.5\n1.5 ", "1.5 2.25"));
+    check(panel("0.5 1.5", "1:0.25", parametric));
+
+    // the numbers are written with a '.' whatever the locale
+    for (const char* name : {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8"})
+    {
+        if (std::setlocale(LC_ALL, name))
+        {
+            check(panel("0.5 1.5", "1.5 2.25"));
+            check(panel("0.5 1.5", "1:0.25", parametric));
+            BOOST_CHECK_THROW(Reader(panel("0,5 1,5", "1.5 2.25")), std::runtime_error);
+            std::setlocale(LC_ALL, "C");
+            break;
+        }
+    }
+
+    // the whole text must be read
+    for (const char* x : {"0.5 1,5", "0.5 abc", "0.5 1.5x", "0.5; 1.5"})
+    {
+        BOOST_CHECK_THROW(Reader(panel(x, "1.5 2.25")), std::runtime_error);
+    }
+    for (const char* residuals : {"1:", "1:x", "1:0.25 x", "1 0.25", "2:0.25", "1:0.25,"})
+    {
+        BOOST_CHECK_THROW(Reader(panel("0.5 1.5", residuals, parametric)), std::runtime_error);
+    }
+    BOOST_CHECK_THROW(Reader(panel("0.5 1.5", "", " n='two' origin='1.5' stride='0.5'")), std::runtime_error);
+    BOOST_CHECK_THROW(Reader(panel("0.5 1.5", "", " origin='1.5' stride='0.5'")), std::runtime_error);
+    BOOST_CHECK_THROW(Reader(panel("0.5 1.5", "", " n='2' origin='1,5' stride='0.5'")), std::runtime_error);
+    BOOST_CHECK_THROW(Reader(panel("0.5 1.5", "1.5 2.25", "", "1,5")), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
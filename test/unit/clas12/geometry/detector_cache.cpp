@@ -0,0 +1,128 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_detector_cache
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clas12/ccdb/constants_table.hpp"
+#include "clas12/ccdb/memory_calibration.hpp"
+#include "clas12/geometry/ccdb_tables.hpp"
+#include "clas12/geometry/detector_cache.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_detector_cache)
+
+namespace
+{
+    using std::shared_ptr;
+    using std::string;
+    using std::vector;
+    using clas12::ccdb::ConstantsTable;
+    using clas12::ccdb::MemoryCalibration;
+    using clas12::ccdb::MemoryTable;
+    using clas12::geometry::DetectorCache;
+
+    /// stands in for a detector: reads one value and counts constructions
+    struct Counted
+    {
+        static int constructed;
+        int nsectors;
+
+        Counted(clas12::ccdb::Calibration* calib)
+        : nsectors(ConstantsTable(calib, "/geometry/dc/dc").elem<int>("nsectors"))
+        {
+            constructed++;
+        }
+    };
+    int Counted::constructed = 0;
+
+    /// the dc tables, each holding only the given number of sectors
+    MemoryCalibration tables(int nsectors)
+    {
+        MemoryCalibration calib;
+        for (const auto& path : clas12::geometry::ccdb_tables().at("dc"))
+        {
+            MemoryTable t;
+            t.columns = vector<string>{"nsectors"};
+            t.types = vector<string>{"int"};
+            t.rows = vector<vector<string>>{{std::to_string(nsectors)}};
+            calib.add_table(path, t);
+        }
+        return calib;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(table_fingerprints)
+{
+    MemoryCalibration a = tables(6);
+    MemoryCalibration b = tables(6);
+    MemoryCalibration c = tables(5);
+
+    ConstantsTable ta(&a, "/geometry/dc/dc");
+    ConstantsTable tb(&b, "/geometry/dc/dc");
+    ConstantsTable tc(&c, "/geometry/dc/dc");
+
+    BOOST_CHECK_EQUAL(ta.assignment_id(), -1);
+    BOOST_CHECK_EQUAL(ta.fingerprint().size(), size_t(16));
+    BOOST_CHECK_EQUAL(ta.fingerprint(), tb.fingerprint());
+    BOOST_CHECK(ta.fingerprint() != tc.fingerprint());
+    BOOST_CHECK_EQUAL(ta.fingerprint(), clas12::ccdb::fingerprint(a.table("/geometry/dc/dc")));
+
+    // columns and values are separated
+    BOOST_CHECK(clas12::ccdb::table_fingerprint({"ab"}, {"int"}, {{"1"}})
+             != clas12::ccdb::table_fingerprint({"a"}, {"bint"}, {{"1"}}));
+}
+
+BOOST_AUTO_TEST_CASE(shared_between_constant_sets)
+{
+    Counted::constructed = 0;
+    DetectorCache<Counted> cache("dc");
+
+    // e.g. two runs with the same geometry constants
+    MemoryCalibration run1 = tables(6);
+    MemoryCalibration run2 = tables(6);
+    MemoryCalibration run3 = tables(5);
+
+    shared_ptr<const Counted> d1 = cache.get(&run1);
+    shared_ptr<const Counted> d2 = cache.get(&run2);
+    shared_ptr<const Counted> d3 = cache.get(&run3);
+
+    BOOST_CHECK_EQUAL(d1.get(), d2.get());
+    BOOST_CHECK(d1.get() != d3.get());
+    BOOST_CHECK_EQUAL(d1->nsectors, 6);
+    BOOST_CHECK_EQUAL(d3->nsectors, 5);
+    BOOST_CHECK_EQUAL(Counted::constructed, 2);
+    BOOST_CHECK_EQUAL(cache.hits(), size_t(1));
+    BOOST_CHECK_EQUAL(cache.misses(), size_t(2));
+    BOOST_CHECK_EQUAL(cache.size(), size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(capacity)
+{
+    Counted::constructed = 0;
+    DetectorCache<Counted> cache("dc", 2);
+
+    MemoryCalibration c1 = tables(1);
+    MemoryCalibration c2 = tables(2);
+    MemoryCalibration c3 = tables(3);
+
+    cache.get(&c1);
+    cache.get(&c2);
+    cache.get(&c1); // c2 is now the least recently used
+    cache.get(&c3);
+    BOOST_CHECK_EQUAL(cache.size(), size_t(2));
+    BOOST_CHECK_EQUAL(Counted::constructed, 3);
+
+    cache.get(&c1);
+    BOOST_CHECK_EQUAL(Counted::constructed, 3);
+    cache.get(&c2);
+    BOOST_CHECK_EQUAL(Counted::constructed, 4);
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), size_t(0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
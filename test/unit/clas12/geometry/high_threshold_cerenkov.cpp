@@ -0,0 +1,437 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_high_threshold_cerenkov
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "geometry/constants.hpp"
+
+#include "clas12/geometry/high_threshold_cerenkov.hpp"
+#include "clas12/geometry/high_threshold_cerenkov/ray_tracer.hpp"
+
+// after the detectors, which name ::ccdb as ccdb
+#include "clas12/ccdb/memory_calibration.hpp"
+
+#ifndef CLAS12_FIXTURES
+#define CLAS12_FIXTURES "test/fixtures"
+#endif
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_high_threshold_cerenkov)
+
+namespace
+{
+    using std::size_t;
+    using std::string;
+    using std::vector;
+    using clas12::geometry::HighThresholdCerenkov;
+    using clas12::geometry::HTCCSector;
+    using clas12::geometry::high_threshold_cerenkov::Mirror;
+    using clas12::geometry::high_threshold_cerenkov::PhotonHit;
+    using clas12::geometry::high_threshold_cerenkov::RayTracer;
+
+    const double pi = ::geometry::cons::pi<double>();
+    const double sector_phi = pi / 3.;
+
+    /// the synthetic mirrors: the target is the near focus of every
+    /// facet and the center of its PMT the far one
+    HighThresholdCerenkov fixture_htcc()
+    {
+        clas12::ccdb::MemoryCalibration calib;
+        calib.load(string(CLAS12_FIXTURES) + "/htcc_mirrors.txt");
+        HighThresholdCerenkov htcc;
+        htcc.fetch_mirror_parameters(&calib);
+        return htcc;
+    }
+
+    double dot(const double a[3], const double b[3])
+    {
+        return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+    }
+
+    /// rotate (x,y) by phi about the z-axis
+    void rotate(double phi, const double in[3], double out[3])
+    {
+        out[0] = std::cos(phi)*in[0] - std::sin(phi)*in[1];
+        out[1] = std::sin(phi)*in[0] + std::cos(phi)*in[1];
+        out[2] = in[2];
+    }
+
+    /// the point where a mirror or PMT is first hit after tmin, in
+    /// the sector frame
+    struct Crossing
+    {
+        double t = std::numeric_limits<double>::max();
+        const Mirror* mirror = nullptr;
+        bool pmt = false;
+        int sector = -1;
+        int half = -1;
+    };
+
+    /**
+     * Test every facet and PMT window of every sector, in the sector
+     * frame, with the conic written as
+     *
+     *     |p|^2 + k (p.w)^2 - 2 R (p.w) = 0
+     *
+     * for p relative to the vertex and w the axis.
+     **/
+    Crossing brute_force_nearest(const HighThresholdCerenkov& htcc,
+                                 const double o[3], const double d[3], double tmin)
+    {
+        Crossing best;
+        for (const auto& sector : htcc.sectors())
+        {
+            const double phi = sector->index() * sector_phi;
+            double os[3], ds[3];
+            rotate(-phi, o, os);
+            rotate(-phi, d, ds);
+
+            for (int half=0; half<2; half++)
+            {
+                const auto& mirrors = half == 0 ? sector->mirrors_left() : sector->mirrors_right();
+                for (const auto& m : mirrors)
+                {
+                    const double w[3] = {m->axis().x(), m->axis().y(), m->axis().z()};
+                    const double p[3] = {os[0] - m->vertex().x(),
+                                         os[1] - m->vertex().y(),
+                                         os[2] - m->vertex().z()};
+                    const double k = m->conic();
+                    const double R = m->radius();
+                    const double pw = dot(p,w);
+                    const double dw = dot(ds,w);
+
+                    double a = 1 + k*dw*dw;
+                    double b = 2*dot(p,ds) + 2*k*pw*dw - 2*R*dw;
+                    double c = dot(p,p) + k*pw*pw - 2*R*pw;
+                    double disc = b*b - 4*a*c;
+                    if (disc >= 0)
+                    {
+                        for (double t : {(-b - std::sqrt(disc)) / (2*a),
+                                         (-b + std::sqrt(disc)) / (2*a)})
+                        {
+                            if (t <= tmin || t >= best.t)
+                            {
+                                continue;
+                            }
+                            double q[3] = {os[0]+t*ds[0], os[1]+t*ds[1], os[2]+t*ds[2]};
+                            double th = std::acos(q[2] / std::sqrt(dot(q,q)));
+                            double ph = std::atan2(q[1], q[0]);
+                            if (th >= m->thmin() && th <= m->thmax()
+                             && ph >= m->phimin() && ph <= m->phimax())
+                            {
+                                best.t = t;
+                                best.mirror = m.get();
+                                best.pmt = false;
+                                best.sector = sector->index();
+                                best.half = half;
+                                break;
+                            }
+                        }
+                    }
+
+                    const double n[3] = {m->pmt_normal().x(), m->pmt_normal().y(), m->pmt_normal().z()};
+                    const double pc[3] = {m->pmt_center().x() - os[0],
+                                          m->pmt_center().y() - os[1],
+                                          m->pmt_center().z() - os[2]};
+                    if (dot(ds,n) != 0)
+                    {
+                        double t = dot(pc,n) / dot(ds,n);
+                        double q[3] = {t*ds[0]-pc[0], t*ds[1]-pc[1], t*ds[2]-pc[2]};
+                        if (t > tmin && t < best.t
+                         && dot(q,q) <= m->pmt_radius()*m->pmt_radius())
+                        {
+                            best.t = t;
+                            best.mirror = m.get();
+                            best.pmt = true;
+                            best.sector = sector->index();
+                            best.half = half;
+                        }
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    /// RayTracer::trace() without the bounding volume hierarchy
+    bool brute_force_trace(const HighThresholdCerenkov& htcc, int max_reflections,
+                           const double origin[3], const double direction[3],
+                           PhotonHit& hit)
+    {
+        double o[3] = {origin[0], origin[1], origin[2]};
+        double d[3] = {direction[0], direction[1], direction[2]};
+        double l = std::sqrt(dot(d,d));
+        for (int k=0; k<3; k++)
+        {
+            d[k] /= l;
+        }
+
+        double path_length = 0;
+        double tmin = 0;
+        for (int nreflections=0; nreflections<=max_reflections; nreflections++)
+        {
+            Crossing x = brute_force_nearest(htcc, o, d, tmin);
+            if (!x.mirror)
+            {
+                return false;
+            }
+            for (int k=0; k<3; k++)
+            {
+                o[k] += x.t * d[k];
+            }
+            path_length += x.t;
+
+            if (x.pmt)
+            {
+                hit.sector = x.sector;
+                hit.half = x.half;
+                hit.ring = x.mirror->index();
+                hit.nreflections = nreflections;
+                hit.x = o[0];
+                hit.y = o[1];
+                hit.z = o[2];
+                hit.path_length = path_length;
+                return true;
+            }
+
+            // the gradient of the conic, rotated back to CLAS coordinates
+            const Mirror& m = *x.mirror;
+            const double phi = x.sector * sector_phi;
+            double os[3];
+            rotate(-phi, o, os);
+            const double w[3] = {m.axis().x(), m.axis().y(), m.axis().z()};
+            const double p[3] = {os[0] - m.vertex().x(),
+                                 os[1] - m.vertex().y(),
+                                 os[2] - m.vertex().z()};
+            const double pw = dot(p,w);
+            double gs[3], g[3];
+            for (int k=0; k<3; k++)
+            {
+                gs[k] = p[k] + (m.conic()*pw - m.radius()) * w[k];
+            }
+            rotate(phi, gs, g);
+            double gl = std::sqrt(dot(g,g));
+
+            double dn = dot(d,g) / gl;
+            for (int k=0; k<3; k++)
+            {
+                d[k] -= 2 * dn * g[k] / gl;
+            }
+            tmin = 1.e-6;
+        }
+        return false;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(surfaces)
+{
+    HighThresholdCerenkov htcc = fixture_htcc();
+    BOOST_REQUIRE_EQUAL(htcc.sectors().size(), size_t(6));
+    BOOST_REQUIRE_EQUAL(htcc.sector(0).mirrors_left().size(), size_t(4));
+
+    // one mirror and one PMT per ring and half-sector
+    RayTracer tracer(htcc);
+    BOOST_CHECK_EQUAL(tracer.nsurfaces(), size_t(6*2*4*2));
+    BOOST_CHECK_EQUAL(tracer.max_reflections(), 4);
+    BOOST_CHECK_GT(tracer.nnodes(), size_t(1));
+
+    // the target is the near focus of the first facet:
+    // |vertex| = a (1 - e), a = R/(1+k), e = sqrt(-k)
+    const Mirror& m = *htcc.sector(0).mirrors_left()[0];
+    double a = m.radius() / (1 + m.conic());
+    BOOST_CHECK_CLOSE(m.vertex().r(), a * (1 - std::sqrt(-m.conic())), 0.01);
+
+    // empty: nothing to hit
+    PhotonHit hit;
+    RayTracer empty{HighThresholdCerenkov()};
+    BOOST_CHECK_EQUAL(empty.nsurfaces(), size_t(0));
+    const double o[3] = {0,0,0};
+    const double d[3] = {0,0,1};
+    BOOST_CHECK(!empty.trace(o, d, hit));
+}
+
+BOOST_AUTO_TEST_CASE(pmt_axis)
+{
+    HighThresholdCerenkov htcc = fixture_htcc();
+    RayTracer tracer(htcc);
+
+    for (size_t sec : {0, 4})
+    {
+        for (int half=0; half<2; half++)
+        {
+            const auto& mirrors = half == 0 ? htcc.sector(sec).mirrors_left() : htcc.sector(sec).mirrors_right();
+            const Mirror& m = *mirrors[0];
+
+            double c[3], n[3];
+            const double cs[3] = {m.pmt_center().x(), m.pmt_center().y(), m.pmt_center().z()};
+            const double ns[3] = {m.pmt_normal().x(), m.pmt_normal().y(), m.pmt_normal().z()};
+            rotate(sec * sector_phi, cs, c);
+            rotate(sec * sector_phi, ns, n);
+
+            // along the axis of the window, from 10 cm in front of it
+            const double o[3] = {c[0] + 10*n[0], c[1] + 10*n[1], c[2] + 10*n[2]};
+            const double d[3] = {-n[0], -n[1], -n[2]};
+
+            PhotonHit hit;
+            BOOST_REQUIRE(tracer.trace(o, d, hit));
+            BOOST_CHECK_EQUAL(hit.sector, int(sec));
+            BOOST_CHECK_EQUAL(hit.half, half);
+            BOOST_CHECK_EQUAL(hit.ring, 0);
+            BOOST_CHECK_EQUAL(hit.nreflections, 0);
+            BOOST_CHECK_SMALL(hit.path_length - 10, 1.e-9);
+            BOOST_CHECK_SMALL(hit.x - c[0], 1.e-9);
+            BOOST_CHECK_SMALL(hit.y - c[1], 1.e-9);
+            BOOST_CHECK_SMALL(hit.z - c[2], 1.e-9);
+
+            // parallel to the axis but just outside the window: there is
+            // nothing behind the PMT
+            double u[3] = {n[1], -n[0], 0};
+            double ul = std::sqrt(dot(u,u));
+            double r = m.pmt_radius() + 0.1;
+            const double off[3] = {o[0] + r*u[0]/ul, o[1] + r*u[1]/ul, o[2]};
+            BOOST_CHECK(!tracer.trace(off, d, hit));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(misses)
+{
+    HighThresholdCerenkov htcc = fixture_htcc();
+    RayTracer tracer(htcc);
+    const double target[3] = {0,0,0};
+    PhotonHit hit;
+
+    // backwards, along the beam and inside the innermost ring
+    const double backwards[3] = {0,0,-1};
+    const double beam[3] = {0,0,1};
+    const double inside[3] = {std::sin(3*pi/180), 0, std::cos(3*pi/180)};
+    BOOST_CHECK(!tracer.trace(target, backwards, hit));
+    BOOST_CHECK(!tracer.trace(target, beam, hit));
+    BOOST_CHECK(!tracer.trace(target, inside, hit));
+
+    // beyond the outermost ring and between the PMTs
+    const double outside[3] = {std::sin(60*pi/180), 0, std::cos(60*pi/180)};
+    BOOST_CHECK(!tracer.trace(target, outside, hit));
+
+    vector<double> origins{0,0,0, 0,0,0};
+    vector<double> directions{0,0,-1, 0,0,1};
+    vector<PhotonHit> hits;
+    BOOST_CHECK_EQUAL(tracer.trace(origins, directions, hits), size_t(0));
+    BOOST_REQUIRE_EQUAL(hits.size(), size_t(2));
+    BOOST_CHECK_EQUAL(hits[0].sector, -1);
+    BOOST_CHECK_EQUAL(hits[1].sector, -1);
+
+    directions.pop_back();
+    BOOST_CHECK_THROW(tracer.trace(origins, directions, hits), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(focus_to_pmt)
+{
+    HighThresholdCerenkov htcc = fixture_htcc();
+    RayTracer tracer(htcc);
+    RayTracer no_reflections(htcc, 0);
+    const double target[3] = {0,0,0};
+
+    // a photon from the target is reflected to the far focus, the
+    // center of the paired PMT, after a path of 2 a, a = R/(1+k).
+    // Only the inner part of the first ring is used: light from the
+    // others crosses the inner facets and the overlapping PMT windows
+    // of this synthetic layout on its way to the focus.
+    for (const auto& sector : htcc.sectors())
+    {
+        const double phi = sector->index() * sector_phi;
+        for (int half=0; half<2; half++)
+        {
+            const auto& mirrors = half == 0 ? sector->mirrors_left() : sector->mirrors_right();
+            const Mirror& m = *mirrors[0];
+            double c[3];
+            const double cs[3] = {m.pmt_center().x(), m.pmt_center().y(), m.pmt_center().z()};
+            rotate(phi, cs, c);
+
+            for (double f : {0.1, 0.25})
+            {
+                double th = m.thmin() + f * (m.thmax() - m.thmin());
+                double ph = phi + m.phimin() + (1-f) * (m.phimax() - m.phimin());
+                const double d[3] = {std::sin(th)*std::cos(ph),
+                                     std::sin(th)*std::sin(ph),
+                                     std::cos(th)};
+
+                PhotonHit hit;
+                BOOST_REQUIRE(tracer.trace(target, d, hit));
+                BOOST_CHECK_EQUAL(hit.sector, int(sector->index()));
+                BOOST_CHECK_EQUAL(hit.half, half);
+                BOOST_CHECK_EQUAL(hit.ring, int(m.index()));
+                BOOST_CHECK_EQUAL(hit.nreflections, 1);
+                BOOST_CHECK_CLOSE(hit.path_length, 2 * m.radius() / (1 + m.conic()), 0.01);
+
+                // the fixture's values are rounded to 0.001 cm
+                BOOST_CHECK_SMALL(hit.x - c[0], 0.05);
+                BOOST_CHECK_SMALL(hit.y - c[1], 0.05);
+                BOOST_CHECK_SMALL(hit.z - c[2], 0.05);
+
+                // which is not followed without reflections
+                BOOST_CHECK(!no_reflections.trace(target, d, hit));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(brute_force)
+{
+    HighThresholdCerenkov htcc = fixture_htcc();
+    RayTracer tracer(htcc);
+
+    // photons from around the target, most of them towards the mirrors
+    std::mt19937 gen(4013);
+    std::uniform_real_distribution<double> pos(-3, 3);
+    std::uniform_real_distribution<double> costh(std::cos(60*pi/180), 1);
+    std::uniform_real_distribution<double> azim(-pi, pi);
+
+    size_t nhits = 0;
+    size_t nreflected = 0;
+    for (int i=0; i<20000; i++)
+    {
+        double th = std::acos(costh(gen));
+        double ph = azim(gen);
+        const double o[3] = {pos(gen), pos(gen), 2*pos(gen)};
+        const double d[3] = {std::sin(th)*std::cos(ph), std::sin(th)*std::sin(ph), std::cos(th)};
+
+        PhotonHit hit;
+        PhotonHit expected;
+        bool found = tracer.trace(o, d, hit);
+        BOOST_REQUIRE_EQUAL(found, brute_force_trace(htcc, tracer.max_reflections(), o, d, expected));
+        if (!found)
+        {
+            continue;
+        }
+
+        BOOST_CHECK_EQUAL(hit.sector, expected.sector);
+        BOOST_CHECK_EQUAL(hit.half, expected.half);
+        BOOST_CHECK_EQUAL(hit.ring, expected.ring);
+        BOOST_CHECK_EQUAL(hit.nreflections, expected.nreflections);
+        BOOST_CHECK_SMALL(hit.path_length - expected.path_length, 1.e-6);
+        BOOST_CHECK_SMALL(hit.x - expected.x, 1.e-6);
+        BOOST_CHECK_SMALL(hit.y - expected.y, 1.e-6);
+        BOOST_CHECK_SMALL(hit.z - expected.z, 1.e-6);
+
+        nhits++;
+        if (hit.nreflections > 0)
+        {
+            nreflected++;
+        }
+    }
+
+    // enough of both kinds to mean something
+    BOOST_CHECK_GT(nhits, size_t(2000));
+    BOOST_CHECK_GT(nreflected, size_t(1000));
+    BOOST_CHECK_GT(nhits - nreflected, size_t(100));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
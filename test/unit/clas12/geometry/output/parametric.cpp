@@ -0,0 +1,150 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_output_parametric
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "pugixml.hpp"
+
+#include "clas12/geometry/output/parametric.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_output_parametric)
+
+namespace
+{
+    using std::string;
+    using std::stringstream;
+    using std::vector;
+
+    using pugi::xml_document;
+    using pugi::xml_node;
+
+    using clas12::geometry::output::expand_parametric;
+    using clas12::geometry::output::get_values;
+    using clas12::geometry::output::set_values;
+
+    /// a layer of 112 wires, affine in the wire index
+    vector<double> layer()
+    {
+        vector<double> x;
+        for (int i=0; i<112; i++)
+        {
+            x.push_back(-123.456 + i * 1.0396);
+        }
+        return x;
+    }
+
+    string str(const xml_document& doc)
+    {
+        stringstream ss;
+        doc.save(ss);
+        return ss.str();
+    }
+
+    void check_close(const vector<double>& a, const vector<double>& b, double tolerance)
+    {
+        BOOST_REQUIRE_EQUAL(a.size(), b.size());
+        for (size_t i=0; i<a.size(); i++)
+        {
+            BOOST_CHECK_SMALL(a[i] - b[i], tolerance);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(affine)
+{
+    vector<double> x = layer();
+
+    xml_document doc;
+    xml_node node = doc.append_child("x");
+    set_values(node, x, true);
+
+    BOOST_CHECK_EQUAL(node.attribute("n").as_uint(), 112u);
+    BOOST_CHECK_EQUAL(string(node.child_value()), "");
+    check_close(get_values(node), x, 1.e-6);
+
+    xml_document explicit_doc;
+    set_values(explicit_doc.append_child("x"), x);
+    BOOST_CHECK_LT(str(doc).size() * 10, str(explicit_doc).size());
+}
+
+BOOST_AUTO_TEST_CASE(residuals)
+{
+    vector<double> x = layer();
+    x[0] += 0.25;
+    x[57] -= 1.e-3;
+    x[111] += 2.e-7;
+
+    xml_document doc;
+    xml_node node = doc.append_child("x");
+    set_values(node, x, true);
+
+    // the misplaced first element does not spoil the fit,
+    // and the last is within tolerance
+    string text = node.child_value();
+    BOOST_CHECK_EQUAL(text.substr(0, 2), "0:");
+    BOOST_CHECK(text.find(" 57:") != string::npos);
+    BOOST_CHECK(text.find("111:") == string::npos);
+    check_close(get_values(node), x, 1.e-6);
+
+    // residuals past the end of the list
+    xml_node bad = doc.append_copy(node);
+    bad.text().set("112:1");
+    BOOST_CHECK_THROW(get_values(bad), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(not_affine)
+{
+    // staggered like the paddles of FTOF panel 1b
+    vector<double> x = layer();
+    for (size_t i=0; i<x.size(); i+=2)
+    {
+        x[i] += 0.5;
+    }
+
+    xml_document doc;
+    xml_node node = doc.append_child("x");
+    set_values(node, x, true);
+    BOOST_CHECK(!node.attribute("stride"));
+    check_close(get_values(node), x, 1.e-3);
+}
+
+BOOST_AUTO_TEST_CASE(short_lists)
+{
+    for (const vector<double>& x : {vector<double>(), vector<double>{4.5}, vector<double>{1, 3}})
+    {
+        xml_document doc;
+        xml_node node = doc.append_child("x");
+        set_values(node, x, true);
+        check_close(get_values(node), x, 1.e-12);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(expand)
+{
+    vector<double> left = layer();
+    vector<double> right = layer();
+    right[3] = 1000;
+
+    xml_document explicit_doc;
+    xml_document parametric_doc;
+    for (xml_document* d : {&explicit_doc, &parametric_doc})
+    {
+        bool parametric = (d == &parametric_doc);
+        xml_node layer_node = d->append_child("geometry").append_child("layer");
+        layer_node.append_attribute("sector") = 1;
+        set_values(layer_node.append_child("left"), left, parametric);
+        set_values(layer_node.append_child("right"), right, parametric);
+    }
+    BOOST_CHECK(str(explicit_doc) != str(parametric_doc));
+
+    expand_parametric(parametric_doc);
+    BOOST_CHECK_EQUAL(str(explicit_doc), str(parametric_doc));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
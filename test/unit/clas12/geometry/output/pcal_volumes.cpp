@@ -0,0 +1,130 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_output_pcal_volumes
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "clas12/geometry/preshower_cal.hpp"
+#include "clas12/geometry/output/pcal_volumes.hpp"
+#include "clas12/geometry/request.hpp"
+
+// after the detectors, which name ::ccdb as ccdb
+#include "clas12/ccdb/memory_calibration.hpp"
+
+#ifndef CLAS12_FIXTURES
+#define CLAS12_FIXTURES "test/fixtures"
+#endif
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_output_pcal_volumes)
+
+namespace
+{
+    using std::map;
+    using std::size_t;
+    using std::string;
+    using std::stringstream;
+    using clas12::geometry::PreshowerCal;
+    using clas12::geometry::output::volmap_t;
+
+    const string fixture = string(CLAS12_FIXTURES) + "/geometry_tables.txt";
+
+    /// name of strip is (from one) of a view in the first layer of sector 1
+    string strip_name(char view, size_t is)
+    {
+        stringstream ss;
+        ss << "sec1_" << view << "_view_layer1_strip" << is;
+        return ss.str();
+    }
+
+    /// the y of a "x*cm y*cm z*cm" position
+    double pos_y(const map<string,string>& params)
+    {
+        stringstream ss(params.at("pos"));
+        string x, y;
+        ss >> x >> y;
+        return std::stod(y.substr(0, y.find('*')));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(strip_positions)
+{
+    using namespace clas12::geometry::output;
+    static const double pi = std::acos(-1.);
+
+    clas12::ccdb::MemoryCalibration calib;
+    calib.load(fixture);
+    PreshowerCal pcal(&calib);
+    volmap_t vols = pcal_volumes_map(pcal);
+
+    const auto& layer = pcal.sector(0).layer(0);
+    double width = layer.strip_width();
+    double wrapper = layer.wrapper_thick();
+    BOOST_REQUIRE_GT(wrapper, 0.);
+
+    // every strip takes its width plus a wrapper on each side
+    double pitch = width + 2*wrapper;
+
+    size_t nu = layer.view(0).nstrips();
+    size_t nvw = layer.view(1).nstrips();
+    double vw_height = layer.view(1).strip_length(nvw) * std::sin(pi - 2*layer.view_angle());
+
+    // first strip, and the sign of the steps along y
+    map<char,double> first{
+        {'U', -0.5*nu*pitch + 0.5*pitch},
+        {'V', 0.5*vw_height - 0.5*pitch},
+        {'W', -0.5*nvw*pitch + 0.5*pitch} };
+    map<char,double> step{{'U', pitch}, {'V', -pitch}, {'W', pitch}};
+    map<char,size_t> nstrips{{'U', nu}, {'V', nvw}, {'W', layer.view(2).nstrips()}};
+
+    for (char view : {'U', 'V', 'W'})
+    {
+        BOOST_REQUIRE(vols.count(strip_name(view, 1)));
+        BOOST_CHECK_SMALL(pos_y(vols.at(strip_name(view, 1))) - first[view], 1.e-3);
+        for (size_t is=2; is<=nstrips[view]; is++)
+        {
+            double dy = pos_y(vols.at(strip_name(view, is)))
+                      - pos_y(vols.at(strip_name(view, is-1)));
+            BOOST_CHECK_SMALL(dy - step[view], 1.e-3);
+        }
+    }
+
+    // the last U strip ends at the edge of the active height
+    BOOST_CHECK_SMALL(pos_y(vols.at(strip_name('U', nu))) + 0.5*pitch - 0.5*nu*pitch, 1.e-3);
+}
+
+BOOST_AUTO_TEST_CASE(request)
+{
+    using clas12::geometry::Request;
+
+    for (bool placements : {false, true})
+    {
+        Request req({
+            {"request", "pcal/volumes"},
+            {"placements", placements ? "true" : "false"},
+            {"fixture", fixture} });
+        volmap_t vols = req.generate_volmap();
+
+        // strips are sensitive, so each sector keeps its own, and the
+        // placed ones are numbered by their sector
+        for (size_t sec=1; sec<=6; sec++)
+        {
+            stringstream name;
+            name << "sec" << sec << "_U_view_layer1_strip1";
+            BOOST_REQUIRE(vols.count(name.str()));
+            BOOST_CHECK_EQUAL(vols.at(name.str()).at("ncopy"),
+                              placements ? std::to_string(sec) : string("1"));
+        }
+
+        string xml = req.generate_xml();
+        BOOST_CHECK(xml.compare(0, 5, "Error") != 0);
+        BOOST_CHECK(xml.find("sec6_W_view_layer1_strip1") != string::npos);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,268 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_output_volume_placements
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "clas12/geometry/drift_chamber.hpp"
+#include "clas12/geometry/forward_tof.hpp"
+#include "clas12/geometry/output/dc_volumes.hpp"
+#include "clas12/geometry/output/ftof_volumes.hpp"
+#include "clas12/geometry/output/volume_placements.hpp"
+
+// after the detectors, which name ::ccdb as ccdb
+#include "clas12/ccdb/memory_calibration.hpp"
+
+#ifndef CLAS12_FIXTURES
+#define CLAS12_FIXTURES "test/fixtures"
+#endif
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_output_volume_placements)
+
+namespace
+{
+    using std::map;
+    using std::string;
+    using std::stringstream;
+    using std::vector;
+    using clas12::geometry::output::volmap_t;
+
+    map<string,string> volume(
+        const string& mother,
+        const string& pos,
+        const string& dims,
+        const string& ids = "")
+    {
+        return {
+            {"mother", mother},
+            {"description", "test volume in " + mother},
+            {"pos", pos},
+            {"rotation", "0*deg 0*deg 0*deg"},
+            {"type", "Box"},
+            {"dimensions", dims},
+            {"material", "G4_AIR"},
+            {"ncopy", "1"},
+            {"sensitivity", "no"},
+            {"identifiers", ids}
+        };
+    }
+
+    /**
+     * \brief six identical sectors each with two different layers
+     * \param [in] copy_number_ids the layers take the sector from
+     *             their copy number, as the sensitive volumes do
+     **/
+    volmap_t six_sectors(bool copy_number_ids = false)
+    {
+        string ids = copy_number_ids ? "sector ncopy 0 " : "";
+        volmap_t vols;
+        for (int sec=1; sec<=6; sec++)
+        {
+            stringstream name;
+            name << "sec" << sec;
+            stringstream pos;
+            pos << sec << "*cm 0*cm 0*cm";
+            vols[name.str()] = volume("root", pos.str(), "10*cm 10*cm 10*cm");
+            vols[name.str() + "_layer1"] = volume(name.str(),
+                "0*cm 0*cm -1*cm", "5*cm 5*cm 1*cm", ids + "layer manual 1");
+            vols[name.str() + "_layer2"] = volume(name.str(),
+                "0*cm 0*cm 1*cm", "5*cm 5*cm 1*cm", ids + "layer manual 2");
+        }
+        return vols;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(identical_sectors)
+{
+    using namespace clas12::geometry::output;
+
+    volmap_t vols = volume_placements(six_sectors());
+
+    // one full sector plus five placements
+    BOOST_CHECK_EQUAL(vols.size(), 3 + 5);
+
+    BOOST_CHECK_EQUAL(vols.at("sec1").at("type"), "Box");
+    BOOST_CHECK_EQUAL(vols.at("sec1").at("ncopy"), "1");
+    BOOST_CHECK_EQUAL(vols.at("sec1_layer1").at("ncopy"), "1");
+    BOOST_CHECK_EQUAL(vols.at("sec1_layer2").at("ncopy"), "1");
+
+    for (int sec=2; sec<=6; sec++)
+    {
+        stringstream name;
+        name << "sec" << sec;
+        stringstream ncopy;
+        ncopy << sec;
+        stringstream pos;
+        pos << sec << "*cm 0*cm 0*cm";
+
+        BOOST_CHECK_EQUAL(vols.at(name.str()).at("type"), "CopyOf sec1");
+        BOOST_CHECK_EQUAL(vols.at(name.str()).at("ncopy"), ncopy.str());
+        BOOST_CHECK_EQUAL(vols.at(name.str()).at("pos"), pos.str());
+        BOOST_CHECK_EQUAL(vols.at(name.str()).at("mother"), "root");
+        BOOST_CHECK_EQUAL(vols.count(name.str() + "_layer1"), 0);
+        BOOST_CHECK_EQUAL(vols.count(name.str() + "_layer2"), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(different_daughters)
+{
+    using namespace clas12::geometry::output;
+
+    volmap_t input = six_sectors();
+
+    // moving a layer in sector 4 makes it a distinct logical volume
+    input["sec4_layer2"]["pos"] = "0*cm 0*cm 2*cm";
+
+    volmap_t vols = volume_placements(input);
+
+    BOOST_CHECK_EQUAL(vols.size(), 3 + 3 + 4);
+    BOOST_CHECK_EQUAL(vols.at("sec4").at("type"), "Box");
+    BOOST_CHECK_EQUAL(vols.at("sec5").at("type"), "CopyOf sec1");
+
+    // the copy number is the sector, whatever the other sectors are
+    for (int sec=1; sec<=6; sec++)
+    {
+        stringstream name;
+        name << "sec" << sec;
+        stringstream ncopy;
+        ncopy << sec;
+        BOOST_CHECK_EQUAL(vols.at(name.str()).at("ncopy"), ncopy.str());
+    }
+
+    // identical layers within the new prototype are still placements
+    BOOST_CHECK_EQUAL(vols.at("sec4_layer1").at("type"), "CopyOf sec1_layer1");
+    BOOST_CHECK_EQUAL(vols.at("sec4_layer1").at("ncopy"), "4");
+    BOOST_CHECK_EQUAL(vols.at("sec4_layer2").at("type"), "CopyOf sec1_layer2");
+    BOOST_CHECK_EQUAL(vols.at("sec4_layer2").at("pos"), "0*cm 0*cm 2*cm");
+}
+
+BOOST_AUTO_TEST_CASE(selected_sectors)
+{
+    using namespace clas12::geometry::output;
+
+    // sectors 1 and 2 selected out
+    volmap_t input = six_sectors();
+    for (const char* sec : {"sec1", "sec2"})
+    {
+        for (const char* suffix : {"", "_layer1", "_layer2"})
+        {
+            input.erase(string(sec) + suffix);
+        }
+    }
+
+    volmap_t vols = volume_placements(input);
+
+    BOOST_CHECK_EQUAL(vols.size(), 3 + 3);
+    BOOST_CHECK_EQUAL(vols.at("sec3").at("ncopy"), "3");
+    BOOST_CHECK_EQUAL(vols.at("sec3_layer2").at("ncopy"), "3");
+    BOOST_CHECK_EQUAL(vols.at("sec6").at("type"), "CopyOf sec3");
+    BOOST_CHECK_EQUAL(vols.at("sec6").at("ncopy"), "6");
+}
+
+BOOST_AUTO_TEST_CASE(sensitive_daughters)
+{
+    using namespace clas12::geometry::output;
+
+    // the layers of a placement would be those of sec1, with ncopy 1
+    volmap_t vols = volume_placements(six_sectors(true));
+
+    BOOST_CHECK_EQUAL(vols.size(), 6 * 3);
+    for (int sec=1; sec<=6; sec++)
+    {
+        stringstream name;
+        name << "sec" << sec;
+        stringstream ncopy;
+        ncopy << sec;
+
+        BOOST_CHECK_EQUAL(vols.at(name.str()).at("type"), "Box");
+        BOOST_CHECK_EQUAL(vols.at(name.str()).at("ncopy"), ncopy.str());
+        for (int lyr=1; lyr<=2; lyr++)
+        {
+            stringstream layer;
+            layer << name.str() << "_layer" << lyr;
+            stringstream ids;
+            ids << "sector ncopy 0 layer manual " << lyr;
+
+            const map<string,string>& params = vols.at(layer.str());
+            BOOST_CHECK_EQUAL(params.at("type"), "Box");
+            BOOST_CHECK_EQUAL(params.at("mother"), name.str());
+            BOOST_CHECK_EQUAL(params.at("identifiers"), ids.str());
+            BOOST_CHECK_EQUAL(params.at("ncopy"), ncopy.str());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sensitive_generated_volumes)
+{
+    using namespace clas12::geometry;
+    using namespace clas12::geometry::output;
+    using clas12::geometry::output::detail::sector_number;
+    using clas12::geometry::output::detail::uses_copy_number;
+
+    clas12::ccdb::MemoryCalibration calib;
+    calib.load(string(CLAS12_FIXTURES) + "/geometry_tables.txt");
+    DriftChamber dc(&calib);
+    ForwardTOF ftof(&calib);
+
+    vector<volmap_t> inputs{dc_volumes_map(dc), ftof_volumes_map(ftof)};
+    vector<volmap_t> outputs{dc_volumes_map(dc, true), ftof_volumes_map(ftof, true)};
+
+    for (size_t i=0; i<inputs.size(); i++)
+    {
+        size_t nsensitive = 0;
+        vector<size_t> sectors(7, 0);
+        for (const auto& vol : inputs[i])
+        {
+            if (!uses_copy_number(vol.second))
+            {
+                continue;
+            }
+            nsensitive++;
+
+            // every sensitive volume is listed with its own sector as
+            // copy number, and so is every volume it is in
+            size_t sec = sector_number(vol.first);
+            BOOST_REQUIRE(sec >= 1 && sec <= 6);
+            sectors[sec]++;
+
+            BOOST_REQUIRE(outputs[i].count(vol.first));
+            const map<string,string>& params = outputs[i].at(vol.first);
+            BOOST_CHECK_EQUAL(params.at("identifiers"), vol.second.at("identifiers"));
+            BOOST_CHECK_EQUAL(params.at("ncopy"), std::to_string(sec));
+
+            for (string m = params.at("mother"); outputs[i].count(m); m = outputs[i].at(m).at("mother"))
+            {
+                const string& type = outputs[i].at(m).at("type");
+                if (type.compare(0, 7, "CopyOf ") == 0)
+                {
+                    BOOST_CHECK_EQUAL(sector_number(type.substr(7)), sec);
+                }
+            }
+        }
+        BOOST_CHECK_GT(nsensitive, 0u);
+        for (size_t sec=1; sec<=6; sec++)
+        {
+            BOOST_CHECK_EQUAL(sectors[sec], nsensitive / 6);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sector_number)
+{
+    using clas12::geometry::output::detail::sector_number;
+
+    BOOST_CHECK_EQUAL(sector_number("sector5"), 5u);
+    BOOST_CHECK_EQUAL(sector_number("sec3_panel1b"), 3u);
+    BOOST_CHECK_EQUAL(sector_number("sec2_U_view_layer1_strip12"), 2u);
+    BOOST_CHECK_EQUAL(sector_number("R2_S4"), 4u);
+    BOOST_CHECK_EQUAL(sector_number("L6_SL2_R3_S6"), 6u);
+    BOOST_CHECK_EQUAL(sector_number("root"), 0u);
+    BOOST_CHECK_EQUAL(sector_number("second"), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,391 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_request_executor
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/ccdb/memory_calibration.hpp"
+#include "clas12/geometry/request_executor.hpp"
+
+#ifndef CLAS12_FIXTURES
+#define CLAS12_FIXTURES "test/fixtures"
+#endif
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_request_executor)
+
+namespace
+{
+    namespace fs = boost::filesystem;
+
+    using std::map;
+    using std::string;
+    using std::vector;
+    using clas12::ccdb::MemoryCalibration;
+    using clas12::ccdb::MemoryTable;
+    using clas12::geometry::RequestExecutor;
+
+    // answered without a database: the system is checked first
+    const map<string,string> unknown_system{{"request", "nosuchsystem/volumes"}};
+
+    // generated from the checked-in tables, so the result is kept
+    const map<string,string> fixture_request{
+        {"request", "dc/volumes"},
+        {"fixture", string(CLAS12_FIXTURES) + "/geometry_tables.txt"} };
+
+    /// fixture_request for one run
+    map<string,string> for_run(int run)
+    {
+        map<string,string> req = fixture_request;
+        req["run"] = std::to_string(run);
+        return req;
+    }
+
+    /// writes tables to a fixture file, removed on destruction
+    struct Fixture
+    {
+        fs::path path;
+
+        Fixture(const MemoryCalibration& calib)
+        : path(fs::temp_directory_path() / fs::unique_path("clas12-executor-%%%%%%.txt"))
+        {
+            std::ofstream fout(path.string());
+            calib.save(fout);
+        }
+
+        ~Fixture()
+        {
+            fs::remove(path);
+        }
+
+        /// fixture_request read from this file
+        map<string,string> request() const
+        {
+            map<string,string> req = fixture_request;
+            req["fixture"] = path.string();
+            return req;
+        }
+    };
+
+    /// wait for the executor to finish what was prefetched
+    void wait_idle(RequestExecutor& exec)
+    {
+        for (int i=0; i<10000 && exec.in_flight() > 0; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        BOOST_REQUIRE_EQUAL(exec.in_flight(), size_t(0));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(results)
+{
+    RequestExecutor exec(2, 4);
+    BOOST_CHECK_EQUAL(exec.nworkers(), size_t(2));
+    BOOST_CHECK_EQUAL(exec.max_pending(), size_t(4));
+
+    auto result = exec.execute(unknown_system);
+    BOOST_CHECK_EQUAL(result.xml.substr(0, 5), "Error");
+    BOOST_CHECK(result.xml.find("nosuchsystem") != string::npos);
+    BOOST_CHECK(result.info.find("nosuchsystem") != string::npos);
+
+    // invalid input throws from submit()
+    map<string,string> bad{{"request", "dc/volumes"}, {"mysql-port", "port"}};
+    BOOST_CHECK_THROW(exec.submit(bad), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(coalesce_and_latency)
+{
+    RequestExecutor exec(1, 2);
+
+    vector<RequestExecutor::future_type> futures;
+    for (int i=0; i<50; i++)
+    {
+        map<string,string> req = unknown_system;
+        req["units"] = (i % 2) ? "cm" : "mm";
+        futures.push_back(exec.submit(req));
+    }
+    for (auto& f : futures)
+    {
+        BOOST_CHECK_EQUAL(f.get().xml.substr(0, 5), "Error");
+    }
+
+    auto st = exec.statistics();
+    BOOST_CHECK_EQUAL(st.submitted, size_t(50));
+    BOOST_CHECK_EQUAL(st.completed + st.coalesced, size_t(50));
+    BOOST_CHECK_GE(st.completed, size_t(1));
+
+    // everyone waiting on a result is counted, coalesced or not
+    BOOST_CHECK_EQUAL(exec.latency().count(), size_t(50));
+    BOOST_CHECK_EQUAL(exec.pending(), size_t(0));
+    BOOST_CHECK_EQUAL(exec.in_flight(), size_t(0));
+    BOOST_CHECK(exec.report().find("submitted: 50") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(prewarm)
+{
+    RequestExecutor exec(1, 8);
+    exec.prefetch_ahead(2);
+
+    BOOST_CHECK_EQUAL(exec.prewarm(unknown_system, {4013, 4014, 4015}), size_t(3));
+
+    // invalid requests are not prefetched
+    map<string,string> bad{{"request", "dc/volumes"}, {"mysql-port", "port"}};
+    BOOST_CHECK(!exec.prefetch(bad));
+
+    for (int i=0; i<1000 && exec.statistics().completed < 3; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(3));
+    BOOST_CHECK_EQUAL(exec.statistics().prefetched, size_t(3));
+
+    // prefetches are not counted as requests
+    BOOST_CHECK_EQUAL(exec.statistics().submitted, size_t(0));
+    BOOST_CHECK_EQUAL(exec.latency().count(), size_t(0));
+
+    // errors are not kept and do not trigger prefetching of later runs
+    map<string,string> req = unknown_system;
+    req["run"] = "4013";
+    BOOST_CHECK_EQUAL(exec.execute(req).xml.substr(0, 5), "Error");
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(0));
+    BOOST_CHECK_EQUAL(exec.statistics().prefetched, size_t(3));
+    BOOST_CHECK_EQUAL(exec.prewarm(unknown_system, {4013}), size_t(1));
+}
+
+BOOST_AUTO_TEST_CASE(promote_prefetch)
+{
+    RequestExecutor exec(1, 64);
+
+    vector<int> runs;
+    for (int run=1; run<=50; run++)
+    {
+        runs.push_back(run);
+    }
+    BOOST_CHECK_EQUAL(exec.prewarm(unknown_system, runs), size_t(50));
+
+    // the last run is likely still waiting for the prefetch thread;
+    // if so it is handed to the worker instead of waiting behind the
+    // other prefetches
+    map<string,string> req = unknown_system;
+    req["run"] = "50";
+    BOOST_CHECK_EQUAL(exec.execute(req).xml.substr(0, 5), "Error");
+
+    auto st = exec.statistics();
+    BOOST_CHECK_LE(st.promoted, st.coalesced);
+    BOOST_CHECK_LE(st.promoted, size_t(1));
+
+    for (int i=0; i<1000 && exec.in_flight() > 0; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    BOOST_CHECK_EQUAL(exec.in_flight(), size_t(0));
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(51) - exec.statistics().coalesced);
+}
+
+BOOST_AUTO_TEST_CASE(cache_hit)
+{
+    RequestExecutor exec(1, 4);
+
+    auto first = exec.execute(fixture_request);
+    BOOST_REQUIRE(first.xml.compare(0, 5, "Error") != 0);
+    BOOST_CHECK_EQUAL(first.etag.size(), size_t(16));
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(1));
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(0));
+
+    // the second submission is answered from the kept result
+    auto second = exec.submit(fixture_request).get();
+    BOOST_CHECK_EQUAL(exec.statistics().submitted, size_t(2));
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(1));
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(1));
+    BOOST_CHECK(second.xml == first.xml);
+    BOOST_CHECK_EQUAL(second.etag, first.etag);
+    BOOST_CHECK_EQUAL(exec.etag(fixture_request), first.etag);
+
+    // so is one differing only in compression
+    map<string,string> req = fixture_request;
+    req["compression"] = "zlib";
+    exec.execute(req);
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(2));
+
+    exec.clear_cache();
+    exec.execute(fixture_request);
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(2));
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(cache_eviction)
+{
+    RequestExecutor exec(1, 4, 2);
+    BOOST_CHECK_EQUAL(exec.max_cached(), size_t(2));
+
+    for (int run : {1, 2, 3})
+    {
+        BOOST_REQUIRE(exec.execute(for_run(run)).xml.compare(0, 5, "Error") != 0);
+    }
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(3));
+    BOOST_CHECK(exec.report().find("2 results kept") != string::npos);
+
+    // the two most recent runs are kept, the first was dropped
+    exec.execute(for_run(3));
+    exec.execute(for_run(2));
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(2));
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(3));
+
+    exec.execute(for_run(1));
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(2));
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(4));
+
+    // run 2 was used last before run 1, so run 3 made room for it
+    exec.execute(for_run(2));
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(3));
+    exec.execute(for_run(3));
+    BOOST_CHECK_EQUAL(exec.statistics().cached, size_t(3));
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(5));
+
+    // nothing is kept with max_cached 0
+    RequestExecutor nocache(1, 4, 0);
+    nocache.execute(fixture_request);
+    nocache.execute(fixture_request);
+    BOOST_CHECK_EQUAL(nocache.statistics().cached, size_t(0));
+    BOOST_CHECK_EQUAL(nocache.statistics().completed, size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(prewarm_then_submit)
+{
+    // room for every run: a promoted run finishes before the others
+    RequestExecutor exec(1, 64, 32);
+
+    vector<int> runs;
+    for (int run=1; run<=20; run++)
+    {
+        runs.push_back(run);
+    }
+    BOOST_CHECK_EQUAL(exec.prewarm(fixture_request, runs), size_t(20));
+
+    // the last run is waiting for the prefetch thread (promoted),
+    // running (coalesced) or done (cached): it is never computed twice
+    auto result = exec.execute(for_run(20));
+    BOOST_CHECK(result.xml.compare(0, 5, "Error") != 0);
+
+    auto st = exec.statistics();
+    BOOST_CHECK_EQUAL(st.submitted, size_t(1));
+    BOOST_CHECK_EQUAL(st.coalesced + st.cached, size_t(1));
+    BOOST_CHECK_LE(st.promoted, st.coalesced);
+
+    wait_idle(exec);
+    BOOST_CHECK_EQUAL(exec.statistics().prefetched, size_t(20));
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(20));
+
+    // the prefetched results are kept
+    size_t cached = exec.statistics().cached;
+    BOOST_CHECK(exec.execute(for_run(16)).xml == result.xml);
+    BOOST_CHECK(exec.execute(for_run(20)).xml == result.xml);
+    BOOST_CHECK_EQUAL(exec.statistics().cached, cached + 2);
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(20));
+
+    // and are not prefetched again
+    BOOST_CHECK_EQUAL(exec.prewarm(fixture_request, {19, 20, 21}), size_t(1));
+}
+
+BOOST_AUTO_TEST_CASE(etag)
+{
+    RequestExecutor exec(1, 4);
+
+    string tag = exec.etag(unknown_system);
+    BOOST_CHECK_EQUAL(tag.size(), size_t(16));
+    BOOST_CHECK_EQUAL(exec.etag(unknown_system), tag);
+
+    // the constant set does not change the output of this request
+    map<string,string> req = unknown_system;
+    req["run"] = "4013";
+    req["variation"] = "other";
+    BOOST_CHECK_EQUAL(exec.etag(req), tag);
+
+    // the output options do
+    req["units"] = "mm";
+    BOOST_CHECK(exec.etag(req) != tag);
+    req = unknown_system;
+    req["placements"] = "true";
+    BOOST_CHECK(exec.etag(req) != tag);
+
+    // errors carry no etag
+    BOOST_CHECK_EQUAL(exec.execute(unknown_system).etag, "");
+}
+
+BOOST_AUTO_TEST_CASE(not_modified)
+{
+    RequestExecutor exec(1, 4);
+
+    string tag = exec.etag(fixture_request);
+    BOOST_REQUIRE_EQUAL(tag.size(), size_t(16));
+
+    // the client holds this output: nothing is generated
+    for (const string& held : {tag, "\"" + tag + "\""})
+    {
+        auto reply = exec.respond(fixture_request, held);
+        BOOST_CHECK_EQUAL(reply.status, "Not modified");
+        BOOST_CHECK_EQUAL(reply.data, "Not modified");
+        BOOST_CHECK(reply.description.find("etag: " + tag) != string::npos);
+        BOOST_CHECK_EQUAL(reply.info, "");
+    }
+    BOOST_CHECK_EQUAL(exec.statistics().submitted, size_t(0));
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(0));
+
+    // another etag gets the output, which carries this one
+    auto reply = exec.respond(fixture_request, "0123456789abcdef");
+    BOOST_CHECK_EQUAL(reply.status, "Success");
+    BOOST_CHECK(reply.description.find("etag: " + tag) != string::npos);
+    BOOST_CHECK(reply.data == exec.execute(fixture_request).xml);
+
+    // the kept result answers the etag from now on
+    BOOST_CHECK_EQUAL(exec.respond(fixture_request, tag).status, "Not modified");
+    BOOST_CHECK_EQUAL(exec.statistics().completed, size_t(1));
+}
+
+BOOST_AUTO_TEST_CASE(etag_follows_tables)
+{
+    RequestExecutor exec(1, 4);
+
+    MemoryCalibration calib;
+    calib.load(fixture_request.at("fixture"));
+
+    // the same tables in another file are the same output
+    Fixture same(calib);
+    string tag = exec.etag(fixture_request);
+    BOOST_CHECK_EQUAL(exec.etag(same.request()), tag);
+
+    // as are changes to tables the drift chambers are not built from
+    MemoryTable ftof = calib.table("/geometry/ftof/ftof");
+    ftof.rows.at(0).at(0) = "7";
+    calib.add_table("/geometry/ftof/ftof", ftof);
+    Fixture other_system(calib);
+    BOOST_CHECK_EQUAL(exec.etag(other_system.request()), tag);
+
+    // one value of a drift chamber table changes the output
+    MemoryTable region = calib.table("/geometry/dc/region");
+    region.rows.at(0).at(2) = "230.0";
+    calib.add_table("/geometry/dc/region", region);
+    Fixture modified(calib);
+    string new_tag = exec.etag(modified.request());
+    BOOST_CHECK_EQUAL(new_tag.size(), size_t(16));
+    BOOST_CHECK(new_tag != tag);
+
+    // a client holding the old output gets the new one
+    auto reply = exec.respond(modified.request(), tag);
+    BOOST_CHECK_EQUAL(reply.status, "Success");
+    BOOST_CHECK(reply.description.find("etag: " + new_tag) != string::npos);
+    BOOST_CHECK(reply.data != exec.execute(same.request()).xml);
+    BOOST_CHECK_EQUAL(exec.respond(modified.request(), new_tag).status, "Not modified");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
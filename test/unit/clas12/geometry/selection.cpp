@@ -0,0 +1,85 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_selection
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "clas12/geometry/request.hpp"
+#include "clas12/geometry/selection.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_selection)
+
+namespace
+{
+    using std::map;
+    using std::string;
+    using clas12::geometry::Request;
+    using clas12::geometry::Selection;
+}
+
+BOOST_AUTO_TEST_CASE(parse)
+{
+    Selection everything;
+    BOOST_CHECK(everything.all());
+    BOOST_CHECK(everything.selects("sector", 0));
+    BOOST_CHECK_EQUAL(everything.str(), "");
+    BOOST_CHECK(Selection("").all());
+
+    Selection sel("sector=2, superlayer=3-4");
+    BOOST_CHECK(!sel.all());
+
+    // indices count from zero, selectors from one
+    BOOST_CHECK(!sel.selects("sector", 0));
+    BOOST_CHECK(sel.selects("sector", 1));
+    BOOST_CHECK(!sel.selects("superlayer", 1));
+    BOOST_CHECK(sel.selects("superlayer", 2));
+    BOOST_CHECK(sel.selects("superlayer", 3));
+    BOOST_CHECK(!sel.selects("superlayer", 4));
+    BOOST_CHECK(sel.selects("region", 5));
+    BOOST_CHECK_EQUAL(sel.str(), "[sector=2,superlayer=3|4]");
+
+    Selection panels("panel=1b|2");
+    BOOST_CHECK(panels.selects("panel", string("1b")));
+    BOOST_CHECK(!panels.selects("panel", string("1a")));
+
+    // repeated keys and alternatives are the same
+    BOOST_CHECK_EQUAL(Selection("sector=1,sector=4").str(), Selection("sector=4|1").str());
+
+    BOOST_CHECK_THROW(Selection("sector"), std::invalid_argument);
+    BOOST_CHECK_THROW(Selection("sector=4-2"), std::invalid_argument);
+    BOOST_CHECK_THROW(Selection("sector=a-b"), std::invalid_argument);
+    BOOST_CHECK_THROW(Selection("sector=1-100000"), std::invalid_argument);
+
+    BOOST_CHECK_NO_THROW(sel.check_keys("dc/volumes", {"sector", "region", "superlayer"}));
+    BOOST_CHECK_THROW(sel.check_keys("ftof/volumes", {"sector", "panel"}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(request_items)
+{
+    typedef map<string,string> req_t;
+
+    // selectors are normalized in the cache key
+    Request a(req_t{{"request", "dc/wire_endpoints[superlayer=4|3,sector=2], ftof/volumes[panel=1B]"}});
+    Request b(req_t{{"request", "ftof/volumes[panel=1b] dc/wire_endpoints[sector=2,superlayer=3-4]"}});
+    BOOST_CHECK_EQUAL(a.cache_key(), b.cache_key());
+    BOOST_CHECK(a.cache_key().find("dc/wire_endpoints[sector=2,superlayer=3|4]") != string::npos);
+    BOOST_CHECK(a.info().find("volumes[panel=1b]") != string::npos);
+
+    Request all(req_t{{"request", "dc/wire_endpoints"}});
+    BOOST_CHECK(all.cache_key() != a.cache_key());
+
+    // keys the output does not know
+    BOOST_CHECK_THROW(Request(req_t{{"request", "ftof/volumes[superlayer=1]"}}), std::invalid_argument);
+    BOOST_CHECK_THROW(Request(req_t{{"request", "dc/core_params[sector=1]"}}), std::invalid_argument);
+
+    // unterminated or split selectors
+    BOOST_CHECK_THROW(Request(req_t{{"request", "dc/volumes[sector=1"}}), std::invalid_argument);
+    BOOST_CHECK_THROW(Request(req_t{{"request", "dc/volumes[sector=1],dc/volumes[sector=2]"}}), std::invalid_argument);
+    BOOST_CHECK_THROW(Request(req_t{{"request", "dc"}}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
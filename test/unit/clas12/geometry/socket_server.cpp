@@ -0,0 +1,251 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_socket_server
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/compression.hpp"
+#include "clas12/geometry/request_executor.hpp"
+#include "clas12/geometry/socket_server.hpp"
+
+#ifndef CLAS12_FIXTURES
+#define CLAS12_FIXTURES "test/fixtures"
+#endif
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_socket_server)
+
+namespace
+{
+    namespace fs = boost::filesystem;
+
+    using std::map;
+    using std::string;
+    using std::vector;
+    using clas12::geometry::RequestExecutor;
+    using clas12::geometry::SocketClient;
+    using clas12::geometry::SocketReply;
+    using clas12::geometry::SocketServer;
+
+    // answered without a database: the system is checked first
+    const map<string,string> unknown_system{{"request", "nosuchsystem/volumes"}};
+
+    // the database a server is given, not set by its clients
+    const map<string,string> fixture{
+        {"fixture", string(CLAS12_FIXTURES) + "/geometry_tables.txt"} };
+
+    /// the etag in the description of a reply
+    string etag_of(const SocketReply& reply)
+    {
+        size_t beg = reply.description.find("etag: ");
+        BOOST_REQUIRE(beg != string::npos);
+        beg += 6;
+        return reply.description.substr(beg, reply.description.find(';', beg) - beg);
+    }
+
+    /// a server running in its own thread, stopped on destruction
+    struct Running
+    {
+        SocketServer server;
+        std::thread thread;
+
+        Running(RequestExecutor& exec, const string& address,
+                size_t nconnections = 4,
+                std::chrono::seconds idle_timeout = std::chrono::seconds(60),
+                const map<string,string>& args = map<string,string>())
+        : server(exec, address, args, nconnections, idle_timeout)
+        , thread(&SocketServer::serve, &server)
+        {}
+
+        ~Running()
+        {
+            server.stop();
+            thread.join();
+        }
+    };
+
+    string socket_path()
+    {
+        return (fs::temp_directory_path() / fs::unique_path("clas12geom-%%%%%%.sock")).string();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(unix_socket)
+{
+    RequestExecutor exec(2);
+    string path = socket_path();
+    {
+        Running r(exec, "unix:" + path);
+        BOOST_CHECK_EQUAL(r.server.address(), "unix:" + path);
+        BOOST_CHECK_EQUAL(r.server.nconnections(), size_t(4));
+        BOOST_CHECK(fs::exists(path));
+
+        // several requests on one connection
+        SocketClient client(r.server.address());
+        for (int i=0; i<3; i++)
+        {
+            SocketReply reply = client.request(unknown_system);
+            BOOST_CHECK_EQUAL(reply.status, "Error");
+            BOOST_CHECK(reply.data.find("nosuchsystem") != string::npos);
+        }
+
+        // the database is set by the server
+        map<string,string> req = unknown_system;
+        req["sqlite"] = "/some/file";
+        SocketReply reply = client.request(req);
+        BOOST_CHECK_EQUAL(reply.status, "Error");
+        BOOST_CHECK(reply.data.find("unknown option: sqlite") != string::npos);
+
+        // bad input is reported, not thrown
+        req = unknown_system;
+        req["run"] = "last";
+        BOOST_CHECK_EQUAL(client.request(req).status, "Error");
+
+        BOOST_CHECK_THROW(client.request({{"request", "dc/volumes\nrun: 1"}}), std::invalid_argument);
+
+        BOOST_CHECK_EQUAL(r.server.served(), size_t(5));
+    }
+    BOOST_CHECK(!fs::exists(path));
+}
+
+BOOST_AUTO_TEST_CASE(tcp_socket)
+{
+    RequestExecutor exec(2);
+    Running r(exec, "tcp:localhost:0");
+    BOOST_CHECK(r.server.address() != "tcp:localhost:0");
+
+    // more clients than connection threads
+    vector<std::thread> clients;
+    vector<int> errors(8, 0);
+    for (int c=0; c<8; c++)
+    {
+        clients.emplace_back([&r, &errors, c]()
+        {
+            SocketClient client(r.server.address());
+            for (int i=0; i<10; i++)
+            {
+                map<string,string> req = unknown_system;
+                req["units"] = (i % 2) ? "cm" : "mm";
+                if (client.request(req).status == "Error")
+                {
+                    errors[c]++;
+                }
+            }
+        });
+    }
+    for (auto& t : clients)
+    {
+        t.join();
+    }
+    for (int e : errors)
+    {
+        BOOST_CHECK_EQUAL(e, 10);
+    }
+    BOOST_CHECK_EQUAL(r.server.served(), size_t(80));
+}
+
+BOOST_AUTO_TEST_CASE(fixture_replies)
+{
+    RequestExecutor exec(2);
+    Running r(exec, "unix:" + socket_path(), 4, std::chrono::seconds(60), fixture);
+
+    map<string,string> direct = fixture;
+    direct["request"] = "dc/volumes";
+    const string xml = exec.execute(direct).xml;
+    BOOST_REQUIRE(xml.compare(0, 5, "Error") != 0);
+
+    // the body is exactly the XML, newlines and all
+    SocketClient client(r.server.address());
+    SocketReply reply = client.request({{"request", "dc/volumes"}});
+    BOOST_CHECK_EQUAL(reply.status, "Success");
+    BOOST_CHECK_EQUAL(reply.description.compare(0, 18, "XML string; etag: "), 0);
+    BOOST_CHECK_EQUAL(reply.data.size(), xml.size());
+    BOOST_CHECK(reply.data == xml);
+    const string tag = etag_of(reply);
+    BOOST_CHECK_EQUAL(tag.size(), size_t(16));
+
+    // several requests on the same connection, compressed bodies too
+    for (const char* sys : {"ftof/volumes", "dc/volumes", "pcal/volumes"})
+    {
+        for (const char* units : {"cm", "mm"})
+        {
+            map<string,string> req{{"request", sys}, {"units", units}};
+            reply = client.request(req);
+            BOOST_CHECK_EQUAL(reply.status, "Success");
+            BOOST_CHECK(reply.data.find("<volume") != string::npos);
+
+            req["compression"] = "zlib";
+            SocketReply packed = client.request(req);
+            BOOST_CHECK_EQUAL(packed.status, "Success");
+            BOOST_CHECK_EQUAL(packed.description.compare(0, 31, "XML string compressed with zlib"), 0);
+            BOOST_CHECK(packed.data.size() < reply.data.size());
+            BOOST_CHECK(clas12::compression::decompress(packed.data, clas12::compression::Codec::zlib) == reply.data);
+            BOOST_CHECK_EQUAL(etag_of(packed), etag_of(reply));
+        }
+    }
+
+    // the client holds this output already, quoted or not
+    for (const string& held : {tag, "\"" + tag + "\""})
+    {
+        reply = client.request({{"request", "dc/volumes"}, {"if-none-match", held}});
+        BOOST_CHECK_EQUAL(reply.status, "Not modified");
+        BOOST_CHECK_EQUAL(reply.data, "Not modified");
+        BOOST_CHECK_EQUAL(etag_of(reply), tag);
+    }
+
+    // another output, or an old etag, is sent in full
+    reply = client.request({{"request", "dc/volumes"}, {"units", "mm"}, {"if-none-match", tag}});
+    BOOST_CHECK_EQUAL(reply.status, "Success");
+    BOOST_CHECK(etag_of(reply) != tag);
+    reply = client.request({{"request", "dc/volumes"}, {"if-none-match", "0123456789abcdef"}});
+    BOOST_CHECK_EQUAL(reply.status, "Success");
+    BOOST_CHECK(reply.data == xml);
+
+    BOOST_CHECK_EQUAL(r.server.served(), size_t(1 + 12 + 2 + 2));
+}
+
+BOOST_AUTO_TEST_CASE(idle_timeout)
+{
+    RequestExecutor exec(1);
+    Running r(exec, "unix:" + socket_path(), 1, std::chrono::seconds(1));
+    BOOST_CHECK_EQUAL(r.server.idle_timeout().count(), 1);
+
+    // an idle client holds the only connection thread until it is
+    // closed by the server
+    SocketClient idle(r.server.address());
+    BOOST_CHECK_EQUAL(idle.request(unknown_system).status, "Error");
+
+    auto start = std::chrono::steady_clock::now();
+    SocketClient other(r.server.address());
+    BOOST_CHECK_EQUAL(other.request(unknown_system).status, "Error");
+    double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    BOOST_CHECK_GT(waited, 0.5);
+    BOOST_CHECK_LT(waited, 10);
+
+    BOOST_CHECK_THROW(idle.request(unknown_system), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(stop_with_open_connections)
+{
+    RequestExecutor exec(1);
+    Running* r = new Running(exec, "unix:" + socket_path());
+    SocketClient client(r->server.address());
+    BOOST_CHECK_EQUAL(client.request(unknown_system).status, "Error");
+
+    // returns although the client is still connected
+    delete r;
+    BOOST_CHECK_THROW(client.request(unknown_system), std::runtime_error);
+
+    BOOST_CHECK_THROW(SocketServer(exec, "udp:localhost:1"), std::invalid_argument);
+    BOOST_CHECK_THROW(SocketClient("unix:" + socket_path()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_geometry_volmap_cache
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/geometry/volmap_cache.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_geometry_volmap_cache)
+
+namespace
+{
+    namespace fs = boost::filesystem;
+
+    using std::string;
+    using std::vector;
+    using clas12::geometry::VolmapCache;
+    using clas12::geometry::volmap_t;
+
+    /// a cache in its own directory, removed on destruction
+    struct Fixture
+    {
+        fs::path dir;
+        VolmapCache cache;
+
+        Fixture()
+        : dir(fs::temp_directory_path() / fs::unique_path("clas12-volmap-%%%%%%"))
+        , cache(dir.string())
+        {}
+
+        ~Fixture()
+        {
+            fs::remove_all(dir);
+        }
+    };
+
+    volmap_t some_volumes()
+    {
+        volmap_t vmap;
+        for (int i=0; i<2000; i++)
+        {
+            string name = "layer" + std::to_string(i);
+            vmap[name]["dimensions"] = std::to_string(i) + "*cm 2*cm 3*cm";
+            vmap[name]["mother"] = "root";
+        }
+        return vmap;
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(store_and_load, Fixture)
+{
+    volmap_t vmap;
+    BOOST_CHECK(!cache.load("etag=1", vmap));
+
+    cache.store("etag=1", some_volumes());
+    BOOST_REQUIRE(cache.load("etag=1", vmap));
+    BOOST_CHECK(vmap == some_volumes());
+
+    // another key is another entry
+    BOOST_CHECK(cache.path("etag=2") != cache.path("etag=1"));
+    BOOST_CHECK(!cache.load("etag=2", vmap));
+}
+
+BOOST_FIXTURE_TEST_CASE(concurrent_store, Fixture)
+{
+    const volmap_t expected = some_volumes();
+    cache.store("etag=1", expected);
+
+    // threads of one process storing the same entry at once while
+    // others read it: readers must always see a complete entry
+    std::atomic<int> bad(0);
+    vector<std::thread> threads;
+    for (int t=0; t<8; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (int i=0; i<20; i++)
+            {
+                if (t % 2)
+                {
+                    cache.store("etag=1", expected);
+                }
+                else
+                {
+                    volmap_t vmap;
+                    if (!cache.load("etag=1", vmap) || vmap != expected)
+                    {
+                        bad++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    BOOST_CHECK_EQUAL(bad.load(), 0);
+
+    volmap_t vmap;
+    BOOST_REQUIRE(cache.load("etag=1", vmap));
+    BOOST_CHECK(vmap == some_volumes());
+
+    // no temporary file is left behind
+    size_t nfiles = 0;
+    for (fs::directory_iterator f(dir); f != fs::directory_iterator(); ++f)
+    {
+        nfiles++;
+        BOOST_CHECK_EQUAL(f->path().string(), cache.path("etag=1"));
+    }
+    BOOST_CHECK_EQUAL(nfiles, size_t(1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
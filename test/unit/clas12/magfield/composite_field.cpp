@@ -0,0 +1,137 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_magfield_composite_field
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/magfield/composite_field.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_magfield_composite_field)
+
+namespace
+{
+    namespace fs = boost::filesystem;
+
+    using std::make_shared;
+    using std::shared_ptr;
+    using std::vector;
+    using clas12::magfield::byte;
+    using clas12::magfield::CompositeField;
+    using clas12::magfield::FieldMap;
+
+    void put(vector<byte>& buf, const void* v)
+    {
+        const byte* p = static_cast<const byte*>(v);
+        buf.insert(buf.end(), p, p+4);
+    }
+
+    void put_int(vector<byte>& buf, int32_t v) { put(buf, &v); }
+    void put_float(vector<byte>& buf, float v) { put(buf, &v); }
+
+    /// a map in native byte order on a 10 cm grid, with a field
+    /// linear in rho and z
+    shared_ptr<const FieldMap> make_map(float phimax, int nphi, float scale)
+    {
+        vector<byte> buf;
+        put_int(buf, 0xced);
+        put_int(buf, 0);
+        put_int(buf, 1);
+        put_int(buf, 0);
+        put_int(buf, 0);
+        put_int(buf, 0);
+        put_float(buf, 0); put_float(buf, phimax); put_int(buf, nphi);
+        put_float(buf, 0); put_float(buf, 100); put_int(buf, 11);
+        put_float(buf, 0); put_float(buf, 100); put_int(buf, 11);
+        for (int i=0; i<5; i++)
+        {
+            put_int(buf, 0);
+        }
+        for (int i=0; i<nphi*11*11; i++)
+        {
+            float rho = 10 * ((i / 11) % 11);
+            float z = 10 * (i % 11);
+            put_float(buf, scale * (0.01f * rho));
+            put_float(buf, scale * 1.f);
+            put_float(buf, scale * (2.f - 0.01f * z));
+        }
+        return make_shared<FieldMap>(buf.data(), buf.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(scaled_sum)
+{
+    CompositeField field(make_map(30, 31, 1), make_map(0, 1, 0.5), -0.5, 2.);
+
+    double x = 20, y = 35, z = 42;
+    double tx, ty, tz, sx, sy, sz, bx, by, bz;
+    field.torus().B(x, y, z, tx, ty, tz);
+    field.solenoid().B(x, y, z, sx, sy, sz);
+    field.B(x, y, z, bx, by, bz);
+
+    BOOST_CHECK(!field.precomputed());
+    BOOST_CHECK_CLOSE(bx, -0.5*tx + 2*sx, 1.e-9);
+    BOOST_CHECK_CLOSE(by, -0.5*ty + 2*sy, 1.e-9);
+    BOOST_CHECK_CLOSE(bz, -0.5*tz + 2*sz, 1.e-9);
+}
+
+BOOST_AUTO_TEST_CASE(precomputed_grid)
+{
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+
+    shared_ptr<const FieldMap> torus = make_map(30, 31, 1);
+    shared_ptr<const FieldMap> solenoid = make_map(0, 1, 0.5);
+
+    CompositeField direct(torus, solenoid, 0.8, 1.2);
+    CompositeField combined(torus, solenoid, 0.8, 1.2);
+
+    CompositeField::Grid grid = combined.default_grid();
+    BOOST_CHECK_EQUAL(grid.nphi, 61);
+    BOOST_CHECK_EQUAL(grid.nrho, 11);
+    BOOST_CHECK_EQUAL(grid.nz, 11);
+
+    combined.precompute(dir.string());
+    BOOST_CHECK(combined.precomputed());
+    BOOST_CHECK(fs::exists(dir));
+
+    // the field is linear in rho and z so the grids agree between
+    // grid points in those directions. phi is checked on grid points
+    // away from the sector edges (where the test torus field, being
+    // independent of phi, is not continuous).
+    for (int phi=-177; phi<180; phi+=6)
+    {
+        double x = 33.3 * cos(phi * M_PI / 180.);
+        double y = 33.3 * sin(phi * M_PI / 180.);
+        double ex, ey, ez, bx, by, bz;
+        direct.B(x, y, 55.5, ex, ey, ez);
+        combined.B(x, y, 55.5, bx, by, bz);
+        BOOST_CHECK_SMALL(bx - ex, 1.e-4);
+        BOOST_CHECK_SMALL(by - ey, 1.e-4);
+        BOOST_CHECK_SMALL(bz - ez, 1.e-4);
+    }
+
+    // a second object finds the grid on disk
+    CompositeField cached(torus, solenoid, 0.8, 1.2);
+    cached.precompute(dir.string());
+    double ax, ay, az, bx, by, bz;
+    cached.B(12, -34, 56, ax, ay, az);
+    combined.B(12, -34, 56, bx, by, bz);
+    BOOST_CHECK_EQUAL(ax, bx);
+    BOOST_CHECK_EQUAL(ay, by);
+    BOOST_CHECK_EQUAL(az, bz);
+
+    // different scale factors are a different grid
+    CompositeField other(torus, solenoid, 1.0, 1.2);
+    BOOST_CHECK(other.cache_key(grid) != combined.cache_key(grid));
+
+    fs::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,273 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_magfield_derived_field_map
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/magfield/cnuphys_format.hpp"
+#include "clas12/magfield/derived_field_map.hpp"
+#include "clas12/magfield/field_map.hpp"
+#include "clas12/magfield/field_map_store.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_magfield_derived_field_map)
+
+namespace
+{
+    namespace fs = boost::filesystem;
+    namespace cnuphys = clas12::magfield::cnuphys;
+
+    using std::string;
+    using std::vector;
+    using clas12::magfield::byte;
+    using clas12::magfield::DerivedMapOptions;
+    using clas12::magfield::FieldMap;
+    using clas12::magfield::FieldMapError;
+    using clas12::magfield::FieldMapStore;
+    using clas12::magfield::FieldMapView;
+
+    const double deg2rad = M_PI / 180.;
+
+    void put(vector<byte>& buf, uint32_t v)
+    {
+        buf.push_back((v >> 24) & 0xff);
+        buf.push_back((v >> 16) & 0xff);
+        buf.push_back((v >>  8) & 0xff);
+        buf.push_back(v & 0xff);
+    }
+
+    void put_int(vector<byte>& buf, int32_t v)
+    {
+        uint32_t u;
+        std::memcpy(&u, &v, 4);
+        put(buf, u);
+    }
+
+    void put_float(vector<byte>& buf, float v)
+    {
+        uint32_t u;
+        std::memcpy(&u, &v, 4);
+        put(buf, u);
+    }
+
+    /// test field, not linear so that a coarser grid makes a difference
+    double fx(double phi, double rho, double z) { return 10 * std::sin(0.1*phi) + 0.001*rho*rho; }
+    double fy(double phi, double rho, double z) { return 5 + 0.01*rho - 0.0002*z*z; }
+    double fz(double phi, double rho, double z) { return 20 * std::cos(0.02*z) - 0.05*phi; }
+
+    const int nphi = 31;
+    const int nrho = 21;
+    const int nz = 41;
+
+    /// a torus-like big-endian map: phi 0 to 30 deg, rho 0 to 200 cm
+    /// and z -100 to 300 cm, all with a spacing of 1 deg or 10 cm
+    vector<byte> make_map()
+    {
+        vector<byte> buf;
+        put_int(buf, 0xced);
+        put_int(buf, 0);
+        put_int(buf, 1);
+        put_int(buf, 0);
+        put_int(buf, 0);
+        put_int(buf, 0);
+        put_float(buf, 0); put_float(buf, 30); put_int(buf, nphi);
+        put_float(buf, 0); put_float(buf, 200); put_int(buf, nrho);
+        put_float(buf, -100); put_float(buf, 300); put_int(buf, nz);
+        for (int i=0; i<5; i++)
+        {
+            put_int(buf, 0);
+        }
+
+        for (int ip=0; ip<nphi; ip++)
+        {
+            for (int ir=0; ir<nrho; ir++)
+            {
+                for (int iz=0; iz<nz; iz++)
+                {
+                    double phi = ip;
+                    double rho = ir * 10.;
+                    double z = -100 + iz * 10.;
+                    put_float(buf, fx(phi,rho,z));
+                    put_float(buf, fy(phi,rho,z));
+                    put_float(buf, fz(phi,rho,z));
+                }
+            }
+        }
+        return buf;
+    }
+
+    void field(const FieldMap& fmap, double phi, double rho, double z,
+               double& bx, double& by, double& bz)
+    {
+        fmap.B(rho * std::cos(phi*deg2rad), rho * std::sin(phi*deg2rad), z, bx, by, bz);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(half_precision)
+{
+    BOOST_CHECK_EQUAL(cnuphys::float_to_half(0.f), 0x0000);
+    BOOST_CHECK_EQUAL(cnuphys::float_to_half(1.f), 0x3c00);
+    BOOST_CHECK_EQUAL(cnuphys::float_to_half(-2.f), 0xc000);
+    BOOST_CHECK_EQUAL(cnuphys::float_to_half(65504.f), 0x7bff);
+    BOOST_CHECK_EQUAL(cnuphys::float_to_half(1.e6f), 0x7c00);
+    BOOST_CHECK_EQUAL(cnuphys::float_to_half(std::ldexp(1.f, -24)), 0x0001);
+
+    // round to nearest even
+    BOOST_CHECK_EQUAL(cnuphys::float_to_half(1.f + std::ldexp(1.f, -11)), 0x3c00);
+    BOOST_CHECK_EQUAL(cnuphys::float_to_half(1.f + 3*std::ldexp(1.f, -11)), 0x3c02);
+
+    for (uint32_t h=0; h<0x7c00; h++)
+    {
+        float f = cnuphys::half_to_float(h);
+        BOOST_REQUIRE_EQUAL(cnuphys::float_to_half(f), h);
+        BOOST_REQUIRE_EQUAL(cnuphys::float_to_half(-f), h | 0x8000);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(float16)
+{
+    vector<byte> full = make_map();
+    FieldMap reference(full.data(), full.size());
+
+    DerivedMapOptions opts;
+    opts.set_precision("float16");
+    vector<byte> buf = clas12::magfield::derive_field_map(full.data(), full.size(), opts);
+    FieldMap half(buf.data(), buf.size());
+
+    BOOST_CHECK_EQUAL(buf.size(), cnuphys::header_size + 6 * nphi * nrho * nz);
+    BOOST_CHECK(half.symmetry() == FieldMap::SECTOR_MIRROR);
+    BOOST_CHECK_EQUAL(half.nphi(), size_t(nphi));
+
+    FieldMapError err = clas12::magfield::field_map_error(reference, half, 10000);
+    BOOST_CHECK_GT(err.max_abs, 0);
+    BOOST_CHECK_LT(err.max_abs, 1.e-3 * err.max_field);
+}
+
+BOOST_AUTO_TEST_CASE(stride)
+{
+    vector<byte> full = make_map();
+    FieldMap reference(full.data(), full.size());
+
+    DerivedMapOptions opts;
+    opts.set_stride("2");
+    vector<byte> buf = clas12::magfield::derive_field_map(full.data(), full.size(), opts);
+    FieldMap coarse(buf.data(), buf.size());
+
+    BOOST_CHECK_EQUAL(coarse.nphi(), size_t(16));
+    BOOST_CHECK_EQUAL(coarse.nrho(), size_t(11));
+    BOOST_CHECK_EQUAL(coarse.nz(), size_t(21));
+    BOOST_CHECK_EQUAL(coarse.phimax(), 30.f);
+    BOOST_CHECK_EQUAL(coarse.rhomax(), 200.f);
+    BOOST_CHECK_EQUAL(coarse.zmax(), 300.f);
+    BOOST_CHECK(coarse.symmetry() == FieldMap::SECTOR_MIRROR);
+
+    // the kept grid points are unchanged
+    for (double phi : {2., 14., 28.})
+    {
+        for (double rho : {20., 100., 180.})
+        {
+            for (double z : {-80., 0., 260.})
+            {
+                double ax, ay, az, bx, by, bz;
+                field(reference, phi, rho, z, ax, ay, az);
+                field(coarse, phi, rho, z, bx, by, bz);
+                BOOST_CHECK_SMALL(ax - bx, 1.e-9);
+                BOOST_CHECK_SMALL(ay - by, 1.e-9);
+                BOOST_CHECK_SMALL(az - bz, 1.e-9);
+            }
+        }
+    }
+
+    FieldMapError err = clas12::magfield::field_map_error(reference, coarse, 10000);
+    BOOST_CHECK_GT(err.max_abs, 1.e-3);
+
+    // 30 phi intervals can not be kept whole with a stride of 4
+    opts.set_stride("4");
+    BOOST_CHECK_THROW(
+        clas12::magfield::derive_field_map(full.data(), full.size(), opts),
+        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(region)
+{
+    vector<byte> full = make_map();
+    FieldMap reference(full.data(), full.size());
+
+    DerivedMapOptions opts;
+    opts.set_region("rho:35:101, z:0:200");
+    vector<byte> buf = clas12::magfield::derive_field_map(full.data(), full.size(), opts);
+    FieldMap part(buf.data(), buf.size());
+
+    // extended outwards to the nearest grid points
+    BOOST_CHECK_EQUAL(part.rhomin(), 30.f);
+    BOOST_CHECK_EQUAL(part.rhomax(), 110.f);
+    BOOST_CHECK_EQUAL(part.nrho(), size_t(9));
+    BOOST_CHECK_EQUAL(part.zmin(), 0.f);
+    BOOST_CHECK_EQUAL(part.zmax(), 200.f);
+    BOOST_CHECK_EQUAL(part.nz(), size_t(21));
+    BOOST_CHECK(part.symmetry() == FieldMap::SECTOR_MIRROR);
+
+    FieldMapError err = clas12::magfield::field_map_error(reference, part, 10000);
+    BOOST_CHECK_SMALL(err.max_abs, 1.e-9);
+
+    double bx, by, bz;
+    field(part, 10, 150, 100, bx, by, bz);
+    BOOST_CHECK_EQUAL(bx, 0);
+    BOOST_CHECK_EQUAL(by, 0);
+    BOOST_CHECK_EQUAL(bz, 0);
+
+    BOOST_CHECK_THROW(opts.set_region("r:0:1"), std::runtime_error);
+    opts.set_region("rho:500:600");
+    BOOST_CHECK_THROW(
+        clas12::magfield::derive_field_map(full.data(), full.size(), opts),
+        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(cached)
+{
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::path source = dir / "map.dat";
+    fs::create_directories(dir);
+    {
+        vector<byte> full = make_map();
+        std::ofstream fout(source.string(), std::ios::binary);
+        fout.write(reinterpret_cast<const char*>(full.data()), full.size());
+    }
+
+    FieldMapView full = FieldMapStore::instance().get(source.string());
+
+    DerivedMapOptions identity;
+    FieldMapView same = clas12::magfield::derived_field_map(full, identity, dir.string());
+    BOOST_CHECK_EQUAL(same.data(), full.data());
+
+    DerivedMapOptions opts;
+    opts.set_precision("float16");
+    opts.set_stride("3");
+    FieldMapView a = clas12::magfield::derived_field_map(full, opts, dir.string());
+    FieldMapView b = clas12::magfield::derived_field_map(full, opts, dir.string());
+    BOOST_CHECK_EQUAL(a.data(), b.data());
+    BOOST_CHECK_LT(a.size(), full.size() / 20);
+
+    size_t nfiles = 0;
+    for (fs::directory_iterator f(dir); f != fs::directory_iterator(); ++f)
+    {
+        nfiles++;
+    }
+    BOOST_CHECK_EQUAL(nfiles, size_t(2));
+
+    FieldMap fmap(a);
+    BOOST_CHECK_EQUAL(fmap.nphi(), size_t(11));
+
+    fs::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,195 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_magfield_field_map
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "clas12/magfield/field_map.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_magfield_field_map)
+
+namespace
+{
+    using std::vector;
+    using clas12::magfield::byte;
+    using clas12::magfield::FieldMap;
+
+    const double deg2rad = M_PI / 180.;
+
+    /// append a 32-bit word in big-endian (java) byte order
+    void put(vector<byte>& buf, uint32_t v)
+    {
+        buf.push_back((v >> 24) & 0xff);
+        buf.push_back((v >> 16) & 0xff);
+        buf.push_back((v >>  8) & 0xff);
+        buf.push_back(v & 0xff);
+    }
+
+    void put_int(vector<byte>& buf, int32_t v)
+    {
+        uint32_t u;
+        std::memcpy(&u, &v, 4);
+        put(buf, u);
+    }
+
+    void put_float(vector<byte>& buf, float v)
+    {
+        uint32_t u;
+        std::memcpy(&u, &v, 4);
+        put(buf, u);
+    }
+
+    /// test field, linear in each grid coordinate
+    double fx(double phi, double rho, double z) { return 1 + 0.10*phi + 0.01*rho + 0.001*z; }
+    double fy(double phi, double rho, double z) { return 2 - 0.05*phi + 0.02*rho - 0.002*z; }
+    double fz(double phi, double rho, double z) { return 3 + 0.02*phi - 0.03*rho + 0.004*z; }
+
+    /// a cnuphys-format map on a cylindrical grid with cartesian field in kG
+    vector<byte> make_map(float phimax, int nphi)
+    {
+        vector<byte> buf;
+        put_int(buf, 0xced);
+        put_int(buf, 0);  // cylindrical grid
+        put_int(buf, 1);  // cartesian field
+        put_int(buf, 0);  // cm
+        put_int(buf, 0);  // deg
+        put_int(buf, 0);  // kG
+        put_float(buf, 0); put_float(buf, phimax); put_int(buf, nphi);
+        put_float(buf, 0); put_float(buf, 100); put_int(buf, 11);
+        put_float(buf, -50); put_float(buf, 150); put_int(buf, 21);
+        for (int i=0; i<5; i++)
+        {
+            put_int(buf, 0);
+        }
+
+        for (int ip=0; ip<nphi; ip++)
+        {
+            double phi = nphi > 1 ? ip * phimax / (nphi-1) : 0;
+            for (int ir=0; ir<11; ir++)
+            {
+                for (int iz=0; iz<21; iz++)
+                {
+                    double rho = ir * 10.;
+                    double z = -50 + iz * 10.;
+                    put_float(buf, fx(phi,rho,z));
+                    put_float(buf, fy(phi,rho,z));
+                    put_float(buf, fz(phi,rho,z));
+                }
+            }
+        }
+        return buf;
+    }
+
+    void at(const FieldMap& fmap, double phi, double rho, double z,
+            double& bx, double& by, double& bz)
+    {
+        fmap.B(rho*cos(phi*deg2rad), rho*sin(phi*deg2rad), z, bx, by, bz);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(torus_interpolation)
+{
+    vector<byte> buf = make_map(30, 7);
+    FieldMap fmap(buf.data(), buf.size());
+
+    BOOST_CHECK(fmap.symmetry() == FieldMap::SECTOR_MIRROR);
+    BOOST_CHECK_EQUAL(fmap.npoints(), 7*11*21);
+
+    double bx, by, bz;
+    at(fmap, 12.5, 33.3, 47.1, bx, by, bz);
+    BOOST_CHECK_CLOSE(bx, fx(12.5, 33.3, 47.1), 1.e-4);
+    BOOST_CHECK_CLOSE(by, fy(12.5, 33.3, 47.1), 1.e-4);
+    BOOST_CHECK_CLOSE(bz, fz(12.5, 33.3, 47.1), 1.e-4);
+
+    // outside of the grid
+    at(fmap, 12.5, 33.3, 200, bx, by, bz);
+    BOOST_CHECK_EQUAL(bx, 0);
+    BOOST_CHECK_EQUAL(by, 0);
+    BOOST_CHECK_EQUAL(bz, 0);
+}
+
+BOOST_AUTO_TEST_CASE(torus_symmetry)
+{
+    vector<byte> buf = make_map(30, 7);
+    FieldMap fmap(buf.data(), buf.size());
+
+    double bx0, by0, bz0;
+    at(fmap, 12.5, 33.3, 47.1, bx0, by0, bz0);
+
+    // mirror image about the middle of the sector
+    double bx, by, bz;
+    at(fmap, -12.5, 33.3, 47.1, bx, by, bz);
+    BOOST_CHECK_CLOSE(bx, -bx0, 1.e-6);
+    BOOST_CHECK_CLOSE(by, by0, 1.e-6);
+    BOOST_CHECK_CLOSE(bz, -bz0, 1.e-6);
+
+    // same point in the third sector
+    at(fmap, 120 + 12.5, 33.3, 47.1, bx, by, bz);
+    double c = cos(120*deg2rad);
+    double s = sin(120*deg2rad);
+    BOOST_CHECK_CLOSE(bx, c*bx0 - s*by0, 1.e-6);
+    BOOST_CHECK_CLOSE(by, s*bx0 + c*by0, 1.e-6);
+    BOOST_CHECK_CLOSE(bz, bz0, 1.e-6);
+}
+
+BOOST_AUTO_TEST_CASE(solenoid_interpolation)
+{
+    vector<byte> buf = make_map(0, 1);
+    FieldMap fmap(buf.data(), buf.size());
+
+    BOOST_CHECK(fmap.symmetry() == FieldMap::AXIAL);
+
+    // at phi = 90 deg, the stored x component points along y
+    double bx, by, bz;
+    at(fmap, 90, 27.5, -12.5, bx, by, bz);
+    BOOST_CHECK_CLOSE(bx, -fy(0, 27.5, -12.5), 1.e-4);
+    BOOST_CHECK_CLOSE(by, fx(0, 27.5, -12.5), 1.e-4);
+    BOOST_CHECK_CLOSE(bz, fz(0, 27.5, -12.5), 1.e-4);
+}
+
+BOOST_AUTO_TEST_CASE(batch_matches_single)
+{
+    vector<byte> buf = make_map(30, 7);
+    FieldMap fmap(buf.data(), buf.size());
+
+    vector<double> x, y, z;
+    for (int i=0; i<200; i++)
+    {
+        double phi = -180 + 1.8*i;
+        double rho = 0.5*i;
+        x.push_back(rho*cos(phi*deg2rad));
+        y.push_back(rho*sin(phi*deg2rad));
+        z.push_back(-60 + i);
+    }
+
+    vector<double> bx, by, bz;
+    fmap.B(x, y, z, bx, by, bz);
+
+    for (size_t i=0; i<x.size(); i++)
+    {
+        double ex, ey, ez;
+        fmap.B(x[i], y[i], z[i], ex, ey, ez);
+        BOOST_CHECK_SMALL(bx[i] - ex, 1.e-9);
+        BOOST_CHECK_SMALL(by[i] - ey, 1.e-9);
+        BOOST_CHECK_SMALL(bz[i] - ez, 1.e-9);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bad_input)
+{
+    vector<byte> buf = make_map(30, 7);
+
+    BOOST_CHECK_THROW(FieldMap(buf.data(), 40), std::runtime_error);
+    BOOST_CHECK_THROW(FieldMap(buf.data(), buf.size() - 4), std::runtime_error);
+
+    buf[3] = 0;
+    BOOST_CHECK_THROW(FieldMap(buf.data(), buf.size()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,179 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_magfield_shared_field_map
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include "clas12/magfield/field_map_store.hpp"
+#include "clas12/magfield/shared_field_map.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_magfield_shared_field_map)
+
+namespace
+{
+    namespace fs = boost::filesystem;
+
+    using std::string;
+    using std::vector;
+    using clas12::magfield::FieldMap;
+    using clas12::magfield::FieldMapStore;
+
+    void put_int(std::ofstream& fout, int32_t v) { fout.write(reinterpret_cast<char*>(&v), 4); }
+    void put_float(std::ofstream& fout, float v) { fout.write(reinterpret_cast<char*>(&v), 4); }
+
+    /// write a small torus-like map in native byte order
+    void write_map(const string& filename)
+    {
+        std::ofstream fout(filename, std::ios::binary);
+        put_int(fout, 0xced);
+        put_int(fout, 0);
+        put_int(fout, 1);
+        put_int(fout, 0);
+        put_int(fout, 0);
+        put_int(fout, 0);
+        put_float(fout, 0); put_float(fout, 30); put_int(fout, 4);
+        put_float(fout, 0); put_float(fout, 100); put_int(fout, 6);
+        put_float(fout, 0); put_float(fout, 100); put_int(fout, 6);
+        for (int i=0; i<5; i++)
+        {
+            put_int(fout, 0);
+        }
+        for (int i=0; i<4*6*6; i++)
+        {
+            put_float(fout, 0.1f * i);
+            put_float(fout, 1.f + 0.01f * i);
+            put_float(fout, -0.2f * i);
+        }
+    }
+
+    /// a field map file and a unique segment prefix for one test
+    struct Fixture
+    {
+        Fixture()
+        : filename((fs::temp_directory_path() / fs::unique_path()).string())
+        , prefix("clas12_magfield_test_" + fs::unique_path().string())
+        {
+            write_map(filename);
+        }
+
+        ~Fixture()
+        {
+            clas12::magfield::unlink_shared_field_map(filename, prefix);
+            fs::remove(filename);
+        }
+
+        string filename;
+        string prefix;
+    };
+
+    bool same_field(const FieldMap& a, const FieldMap& b)
+    {
+        for (double x=-80; x<=80; x+=13)
+        {
+            for (double z=-10; z<=110; z+=17)
+            {
+                double ax, ay, az, bx, by, bz;
+                a.B(x, 0.7*x + 3, z, ax, ay, az);
+                b.B(x, 0.7*x + 3, z, bx, by, bz);
+                if (ax != bx || ay != by || az != bz)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(publish_and_attach, Fixture)
+{
+    FieldMap direct(FieldMapStore::instance().get(filename));
+
+    FieldMap published = clas12::magfield::shared_field_map(filename, prefix);
+    BOOST_CHECK(same_field(direct, published));
+    BOOST_CHECK_EQUAL(published.checksum(), direct.checksum());
+    BOOST_CHECK(published.symmetry() == FieldMap::SECTOR_MIRROR);
+
+    // a second load in another process attaches to the segment
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        FieldMap attached = clas12::magfield::shared_field_map(filename, prefix);
+        ::_exit(same_field(direct, attached) ? 0 : 1);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    BOOST_CHECK(WIFEXITED(status));
+    BOOST_CHECK_EQUAL(WEXITSTATUS(status), 0);
+
+    BOOST_CHECK(clas12::magfield::unlink_shared_field_map(filename, prefix));
+    BOOST_CHECK(!clas12::magfield::unlink_shared_field_map(filename, prefix));
+
+    // maps stay valid after the segment is removed
+    BOOST_CHECK(same_field(direct, published));
+}
+
+BOOST_FIXTURE_TEST_CASE(concurrent_first_load, Fixture)
+{
+    FieldMap direct(FieldMapStore::instance().get(filename));
+
+    vector<pid_t> children;
+    for (int i=0; i<8; i++)
+    {
+        pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            FieldMap fmap = clas12::magfield::shared_field_map(filename, prefix);
+            ::_exit(same_field(direct, fmap) ? 0 : 1);
+        }
+        children.push_back(pid);
+    }
+
+    for (pid_t pid : children)
+    {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        BOOST_CHECK(WIFEXITED(status));
+        BOOST_CHECK_EQUAL(WEXITSTATUS(status), 0);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(abandoned_segment, Fixture)
+{
+    FieldMap direct(FieldMapStore::instance().get(filename));
+
+    // a publisher that died right after creating the segment
+    string name = clas12::magfield::shared_field_map_name(filename, prefix);
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    ::close(fd);
+
+    FieldMap fmap = clas12::magfield::shared_field_map(filename, prefix);
+    BOOST_CHECK(same_field(direct, fmap));
+}
+
+BOOST_FIXTURE_TEST_CASE(failed_publisher, Fixture)
+{
+    {
+        std::ofstream fout(filename, std::ios::binary);
+        put_int(fout, 0x1234);
+    }
+    BOOST_CHECK_THROW(clas12::magfield::shared_field_map(filename, prefix), std::runtime_error);
+
+    // the segment was removed for the next process to publish
+    BOOST_CHECK(!clas12::magfield::unlink_shared_field_map(filename, prefix));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,225 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_magfield_swimmer
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "geometry/direction_vector.hpp"
+#include "geometry/euclid_vector.hpp"
+#include "geometry/plane.hpp"
+
+#include "clas12/magfield/composite_field.hpp"
+#include "clas12/magfield/swimmer.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_magfield_swimmer)
+
+namespace
+{
+    using std::make_shared;
+    using std::shared_ptr;
+    using std::vector;
+    using clas12::magfield::byte;
+    using clas12::magfield::CompositeField;
+    using clas12::magfield::FieldMap;
+    using clas12::magfield::SurfaceCrossing;
+    using clas12::magfield::Swimmer;
+    using clas12::magfield::TrackState;
+    using geometry::direction_vector;
+    using geometry::euclid_vector;
+    using geometry::plane;
+
+    const double k = 2.99792458e-4;
+
+    void put(vector<byte>& buf, const void* v)
+    {
+        const byte* p = static_cast<const byte*>(v);
+        buf.insert(buf.end(), p, p+4);
+    }
+
+    void put_int(vector<byte>& buf, int32_t v) { put(buf, &v); }
+    void put_float(vector<byte>& buf, float v) { put(buf, &v); }
+
+    /// a map in native byte order with a uniform field along z
+    shared_ptr<const FieldMap> make_map(
+        float phimax, int nphi,
+        float rhomax, int nrho,
+        float zmin, float zmax, int nz,
+        float bz)
+    {
+        vector<byte> buf;
+        put_int(buf, 0xced);
+        put_int(buf, 0);
+        put_int(buf, 1);
+        put_int(buf, 0);
+        put_int(buf, 0);
+        put_int(buf, 0);
+        put_float(buf, 0); put_float(buf, phimax); put_int(buf, nphi);
+        put_float(buf, 0); put_float(buf, rhomax); put_int(buf, nrho);
+        put_float(buf, zmin); put_float(buf, zmax); put_int(buf, nz);
+        for (int i=0; i<5; i++)
+        {
+            put_int(buf, 0);
+        }
+        for (int i=0; i<nphi*nrho*nz; i++)
+        {
+            put_float(buf, 0);
+            put_float(buf, 0);
+            put_float(buf, bz);
+        }
+        return make_shared<FieldMap>(buf.data(), buf.size());
+    }
+
+    /// no torus and a solenoid with a uniform field everywhere in
+    /// the swimmer's world volume
+    shared_ptr<const CompositeField> uniform_field(float bz)
+    {
+        return make_shared<CompositeField>(
+            make_map(30, 2, 100, 2, 0, 100, 2, 0),
+            make_map(0, 1, 1500, 16, -600, 1600, 23, bz));
+    }
+
+    plane<double> make_plane(double x, double y, double z,
+                             double nx, double ny, double nz)
+    {
+        return plane<double>(
+            euclid_vector<double,3>(x, y, z),
+            direction_vector<double,3>(nx, ny, nz));
+    }
+
+    TrackState make_track(double px, double py, double pz, int charge)
+    {
+        TrackState st;
+        st.x = 0;
+        st.y = 0;
+        st.z = 0;
+        st.px = px;
+        st.py = py;
+        st.pz = pz;
+        st.charge = charge;
+        st.path = 0;
+        return st;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(helix)
+{
+    double bz = 10;
+    double pt = 1;
+    double radius = pt / (k * bz);
+
+    Swimmer swimmer(uniform_field(bz), 1.e-5);
+    swimmer.add_surface(make_plane(200, 0, 0, 1, 0, 0), 1, -1, true);
+    BOOST_CHECK_EQUAL(swimmer.nsurfaces(), size_t(1));
+
+    vector<SurfaceCrossing> crossings;
+    TrackState final = swimmer.swim(make_track(pt, 0, 0.5, 1), crossings, 7);
+
+    BOOST_REQUIRE_EQUAL(crossings.size(), size_t(1));
+    const SurfaceCrossing& c = crossings[0];
+    BOOST_CHECK_EQUAL(c.track, size_t(7));
+    BOOST_CHECK_EQUAL(c.surface, 1);
+
+    // a positive track bends towards -y in a field along +z
+    double angle = std::asin(200. / radius);
+    BOOST_CHECK_SMALL(c.state.x - 200, 1.e-4);
+    BOOST_CHECK_CLOSE(c.state.y, -radius * (1 - std::cos(angle)), 1.e-3);
+    BOOST_CHECK_CLOSE(c.state.z, 0.5 * radius * angle, 1.e-3);
+    BOOST_CHECK_CLOSE(c.state.path, std::hypot(1, 0.5) * radius * angle, 1.e-3);
+
+    double p = std::sqrt(c.state.px*c.state.px + c.state.py*c.state.py + c.state.pz*c.state.pz);
+    BOOST_CHECK_CLOSE(p, std::hypot(1, 0.5), 1.e-6);
+    BOOST_CHECK_CLOSE(std::atan2(-c.state.py, c.state.px), angle, 1.e-3);
+
+    // stopped at the plane
+    BOOST_CHECK_EQUAL(final.x, c.state.x);
+    BOOST_CHECK_EQUAL(final.path, c.state.path);
+}
+
+BOOST_AUTO_TEST_CASE(planes_and_sectors)
+{
+    Swimmer swimmer(uniform_field(0), 1.e-5, 1000);
+    swimmer.add_surface(make_plane(0, 0, 300, 0, 0, 1), 3);
+    swimmer.add_surface(make_plane(0, 0, 100, 0, 0, 1), 1, 0);
+    swimmer.add_surface(make_plane(0, 0, 200, 0, 0, 1), 2, 1);
+    swimmer.add_surface(make_plane(0, 0, -100, 0, 0, 1), 4);
+
+    // a straight track along phi = 10 deg
+    double phi = 10 * M_PI / 180.;
+    vector<SurfaceCrossing> crossings;
+    TrackState final = swimmer.swim(
+        make_track(std::cos(phi), std::sin(phi), 1, 1), crossings);
+
+    // the plane in sector 1 does not count and the one behind
+    // the start is never reached
+    BOOST_REQUIRE_EQUAL(crossings.size(), size_t(2));
+    BOOST_CHECK_EQUAL(crossings[0].surface, 1);
+    BOOST_CHECK_EQUAL(crossings[1].surface, 3);
+    BOOST_CHECK_SMALL(crossings[0].state.z - 100, 1.e-4);
+    BOOST_CHECK_CLOSE(crossings[0].state.path, 100 * std::sqrt(2.), 1.e-6);
+    BOOST_CHECK_CLOSE(crossings[1].state.path, 300 * std::sqrt(2.), 1.e-6);
+
+    // not stopped: swum until the maximum path length
+    BOOST_CHECK_CLOSE(final.path, 1000, 1.e-9);
+    BOOST_CHECK_CLOSE(final.z, 1000 / std::sqrt(2.), 1.e-6);
+}
+
+BOOST_AUTO_TEST_CASE(batch)
+{
+    Swimmer swimmer(uniform_field(5), 1.e-4);
+    for (int i=0; i<10; i++)
+    {
+        swimmer.add_surface(make_plane(0, 0, 20 + 20*i, 0, 0, 1), i, -1, i == 9);
+    }
+
+    vector<TrackState> tracks;
+    for (int i=0; i<50; i++)
+    {
+        double phi = 2 * M_PI * i / 50.;
+        tracks.push_back(make_track(0.3 * std::cos(phi), 0.3 * std::sin(phi),
+                                    0.5 + 0.02 * i, (i % 2) ? 1 : -1));
+    }
+
+    vector<SurfaceCrossing> single;
+    vector<TrackState> single_finals;
+    for (size_t i=0; i<tracks.size(); i++)
+    {
+        single_finals.push_back(swimmer.swim(tracks[i], single, i));
+    }
+
+    vector<SurfaceCrossing> crossings;
+    vector<TrackState> finals;
+    swimmer.swim(tracks, crossings, finals, 4);
+
+    BOOST_CHECK_EQUAL(single.size(), size_t(500));
+    BOOST_REQUIRE_EQUAL(crossings.size(), single.size());
+    BOOST_REQUIRE_EQUAL(finals.size(), tracks.size());
+    for (size_t i=0; i<single.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(crossings[i].track, single[i].track);
+        BOOST_CHECK_EQUAL(crossings[i].surface, single[i].surface);
+        BOOST_CHECK_EQUAL(crossings[i].state.x, single[i].state.x);
+        BOOST_CHECK_EQUAL(crossings[i].state.path, single[i].state.path);
+    }
+    for (size_t i=0; i<finals.size(); i++)
+    {
+        BOOST_CHECK_SMALL(finals[i].z - 200, 1.e-4);
+        BOOST_CHECK_EQUAL(finals[i].path, single_finals[i].path);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    BOOST_CHECK_THROW(Swimmer(shared_ptr<const CompositeField>()), std::runtime_error);
+    BOOST_CHECK_THROW(Swimmer(uniform_field(1), 0), std::runtime_error);
+
+    Swimmer swimmer(uniform_field(1));
+    vector<SurfaceCrossing> crossings;
+    BOOST_CHECK_THROW(swimmer.swim(make_track(0, 0, 0, 1), crossings), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+#define BOOST_TEST_DYN_LINK
+
+#define BOOST_TEST_MODULE clas12_stats
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "clas12/stats.hpp"
+
+BOOST_AUTO_TEST_SUITE(clas12_stats)
+
+namespace
+{
+    using std::string;
+    using clas12::stats::Collector;
+    using clas12::stats::Histogram;
+    using clas12::stats::ScopedTimer;
+    using clas12::stats::Stats;
+}
+
+BOOST_AUTO_TEST_CASE(timers_and_counters)
+{
+    clas12::stats::thread_stats().clear();
+
+    Stats st;
+    {
+        Collector collector(st);
+        for (int i=0; i<3; i++)
+        {
+            ScopedTimer timer("sleep");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        clas12::stats::count("rows", 10);
+        clas12::stats::count("rows", 5);
+        clas12::stats::count("tables");
+    }
+
+    // also kept by the thread
+    BOOST_CHECK_EQUAL(clas12::stats::thread_stats().counters().at("rows"), size_t(15));
+    BOOST_REQUIRE_EQUAL(st.stages().size(), size_t(1));
+    BOOST_CHECK_EQUAL(st.stages().at("sleep").calls, size_t(3));
+    BOOST_CHECK_GE(st.stages().at("sleep").seconds, 0.006);
+    BOOST_CHECK_EQUAL(st.counters().at("rows"), size_t(15));
+    BOOST_CHECK_EQUAL(st.counters().at("tables"), size_t(1));
+
+    string summary = st.summary();
+    BOOST_CHECK(summary.find("rows=15") != string::npos);
+    BOOST_CHECK(summary.find("sleep=") != string::npos);
+    BOOST_CHECK(st.report().find("3 calls") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(nested_collectors)
+{
+    Stats outer;
+    Stats inner;
+    {
+        Collector c1(outer);
+        clas12::stats::count("ccdb rows", 1);
+        {
+            Collector c2(inner);
+            clas12::stats::count("ccdb rows", 2);
+        }
+        clas12::stats::count("ccdb rows", 4);
+    }
+    BOOST_CHECK_EQUAL(inner.counters().at("ccdb rows"), size_t(2));
+    BOOST_CHECK_EQUAL(outer.counters().at("ccdb rows"), size_t(7));
+    BOOST_CHECK_EQUAL(outer.summary(), "ccdb_rows=7");
+}
+
+BOOST_AUTO_TEST_CASE(per_thread)
+{
+    Stats st;
+    Collector collector(st);
+    std::thread t([]{ clas12::stats::count("other thread"); });
+    t.join();
+    clas12::stats::count("this thread");
+
+    BOOST_CHECK_EQUAL(clas12::stats::thread_stats().counters().count("other thread"), size_t(0));
+    BOOST_CHECK_EQUAL(clas12::stats::thread_stats().counters().at("this thread"), size_t(1));
+}
+
+BOOST_AUTO_TEST_CASE(histogram)
+{
+    Histogram h;
+    BOOST_CHECK_EQUAL(h.quantile(0.5), 0.);
+
+    // 90 fast (0.5 ms) and 10 slow (50 ms) requests
+    for (int i=0; i<90; i++)
+    {
+        h.record(0.0005);
+    }
+    for (int i=0; i<10; i++)
+    {
+        h.record(0.05);
+    }
+
+    BOOST_CHECK_EQUAL(h.count(), size_t(100));
+    BOOST_CHECK_CLOSE(h.mean(), 0.00545, 1e-6);
+    BOOST_CHECK_EQUAL(h.max(), 0.05);
+
+    // quantiles are bucket limits: within a factor of two
+    BOOST_CHECK_GE(h.quantile(0.5), 0.0005);
+    BOOST_CHECK_LT(h.quantile(0.5), 0.001);
+    BOOST_CHECK_GE(h.quantile(0.99), 0.025);
+    BOOST_CHECK_LE(h.quantile(0.99), 0.05);
+
+    Histogram other;
+    other.record(1.e6);
+    h.merge(other);
+    BOOST_CHECK_EQUAL(h.count(), size_t(101));
+    BOOST_CHECK_EQUAL(h.buckets().back(), size_t(1));
+    BOOST_CHECK(h.summary().find("n=101") != string::npos);
+    BOOST_CHECK(h.report().find("inf") != string::npos);
+
+    h.clear();
+    BOOST_CHECK_EQUAL(h.count(), size_t(0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
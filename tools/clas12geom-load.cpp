@@ -0,0 +1,257 @@
+/**
+ * \file
+ * \brief a load generator for clas12geom-server
+ *
+ * Opens a number of connections, each in its own thread, and sends
+ * requests on each as fast as the replies come back. Reports the
+ * throughput and the distribution of latencies.
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+#include "boost/program_options.hpp"
+
+#include "clas12/geometry/socket_server.hpp"
+#include "clas12/stats.hpp"
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace clas12;
+
+typedef chrono::steady_clock clock_type;
+
+/**
+ * \brief the etag in the description of a reply
+ * \param [in] description for example "XML string; etag: 1f2e...; stats: ..."
+ **/
+static string etag_of(const string& description)
+{
+    static const string key = "etag: ";
+    size_t begin = description.find(key);
+    if (begin == string::npos)
+    {
+        return "";
+    }
+    begin += key.size();
+    return description.substr(begin, description.find(';', begin) - begin);
+}
+
+/**
+ * \brief the q-quantile of sorted values, in ms
+ **/
+static double quantile_ms(const vector<double>& sorted, double q)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    size_t i = min(sorted.size() - 1, size_t(q * sorted.size()));
+    return 1.e3 * sorted[i];
+}
+
+int main(int argc, char** argv)
+{
+    string address = "unix:/tmp/clas12geom.sock";
+    size_t nconnections = 8;
+    size_t nrequests = 1000;
+    size_t nwarmup = 1;
+    int first_run = 0;
+    int nruns = 1;
+
+    map<string,string> req;
+    req["request"] = "dc/wire_endpoints";
+    req["units"] = "";
+    req["coordsys"] = "";
+    req["encoding"] = "";
+    req["compression"] = "";
+    req["variation"] = "";
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h",
+            "produce help message")
+        ("address,a",
+            po::value<string>(&address)->default_value(address),
+            "address of the server: unix:/path/to/socket or tcp:host:port")
+        ("connections,c",
+            po::value<size_t>(&nconnections)->default_value(nconnections),
+            "number of connections, each sending one request at a time")
+        ("requests,n",
+            po::value<size_t>(&nrequests)->default_value(nrequests),
+            "number of requests to time, over all connections")
+        ("warmup",
+            po::value<size_t>(&nwarmup)->default_value(nwarmup),
+            "number of requests per connection sent before timing")
+        ("revalidate",
+            "send the etag of the last reply for the same run, as a client holding the output would")
+        ("first-run",
+            po::value<int>(&first_run)->default_value(first_run),
+            "run number of the first request")
+        ("runs",
+            po::value<int>(&nruns)->default_value(nruns),
+            "number of runs the requests cycle through")
+
+        ("request,q",
+            po::value<string>(&req["request"])->default_value(req["request"]),
+            "system/values request string, comma separated")
+        ("units,u",
+            po::value<string>(&req["units"]),
+            "units of length")
+        ("coordsys",
+            po::value<string>(&req["coordsys"]),
+            "coordinate system")
+        ("encoding,e",
+            po::value<string>(&req["encoding"]),
+            "explicit or parametric")
+        ("compression,z",
+            po::value<string>(&req["compression"]),
+            "codec the replies are compressed with (zlib, zstd or lz4)")
+        ("variation,v",
+            po::value<string>(&req["variation"]),
+            "variation")
+    ;
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        cout << options << endl;
+        exit(0);
+    }
+
+    bool revalidate = vm.count("revalidate");
+    nconnections = max(nconnections, size_t(1));
+    nruns = max(nruns, 1);
+
+    for (auto i = req.begin(); i != req.end(); )
+    {
+        i = (i->second == "") ? req.erase(i) : ++i;
+    }
+
+    mutex mtx;
+    vector<double> latencies;
+    stats::Histogram histogram;
+    size_t nerrors = 0;
+    size_t nnotmodified = 0;
+    size_t nbytes = 0;
+    string first_error;
+
+    auto client = [&](size_t c, size_t n)
+    {
+        vector<double> lat;
+        stats::Histogram hist;
+        size_t errors = 0;
+        size_t notmodified = 0;
+        size_t bytes = 0;
+        string error;
+
+        try
+        {
+            geometry::SocketClient conn(address);
+            map<string,string> etags;
+            for (size_t i=0; i<nwarmup+n; i++)
+            {
+                map<string,string> r = req;
+                string run = boost::lexical_cast<string>(first_run + (c + i * nconnections) % nruns);
+                r["run"] = run;
+                if (revalidate && etags.count(run))
+                {
+                    r["if-none-match"] = etags[run];
+                }
+
+                auto start = clock_type::now();
+                geometry::SocketReply reply = conn.request(r);
+                double seconds = chrono::duration<double>(clock_type::now() - start).count();
+
+                if (reply.status != "Not modified")
+                {
+                    etags[run] = etag_of(reply.description);
+                }
+                if (i < nwarmup)
+                {
+                    continue;
+                }
+
+                lat.push_back(seconds);
+                hist.record(seconds);
+                bytes += reply.data.size();
+                if (reply.status == "Error")
+                {
+                    errors++;
+                    if (error == "")
+                    {
+                        error = reply.data;
+                    }
+                }
+                else if (reply.status == "Not modified")
+                {
+                    notmodified++;
+                }
+            }
+        }
+        catch (std::exception& e)
+        {
+            errors++;
+            error = e.what();
+        }
+
+        lock_guard<mutex> lock(mtx);
+        latencies.insert(latencies.end(), lat.begin(), lat.end());
+        histogram.merge(hist);
+        nerrors += errors;
+        nnotmodified += notmodified;
+        nbytes += bytes;
+        if (first_error == "")
+        {
+            first_error = error;
+        }
+    };
+
+    auto start = clock_type::now();
+    vector<thread> threads;
+    for (size_t c=0; c<nconnections; c++)
+    {
+        // the first connections take the remainder
+        size_t n = nrequests / nconnections + (c < nrequests % nconnections ? 1 : 0);
+        threads.emplace_back(client, c, n);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    double seconds = chrono::duration<double>(clock_type::now() - start).count();
+
+    sort(latencies.begin(), latencies.end());
+
+    printf("requests:     %zu (%zu errors, %zu not modified)\n",
+           latencies.size(), nerrors, nnotmodified);
+    printf("connections:  %zu\n", nconnections);
+    printf("seconds:      %.3f\n", seconds);
+    printf("throughput:   %.1f requests/s, %.1f MB/s\n",
+           latencies.size() / seconds, nbytes / seconds / 1.e6);
+    printf("latency (ms): p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, max %.3f\n",
+           quantile_ms(latencies, 0.5), quantile_ms(latencies, 0.9),
+           quantile_ms(latencies, 0.99), quantile_ms(latencies, 0.999),
+           latencies.empty() ? 0. : 1.e3 * latencies.back());
+    cout << endl << histogram.report();
+
+    if (first_error != "")
+    {
+        cerr << endl << "first error: " << first_error << endl;
+    }
+
+    return nerrors ? 1 : 0;
+}
@@ -1,21 +1,180 @@
+/**
+ * \file
+ * \brief a standalone geometry server
+ *
+ * Listens on a Unix domain or TCP socket and answers the same requests
+ * as clas12geom and the GeometryService (see SocketServer::desc).
+ * Requests are run on a pool of worker threads which share the
+ * detector, volume map and output caches; identical requests in flight
+ * are computed once and recent results are kept. Stops on SIGINT or
+ * SIGTERM and prints the executor statistics.
+ **/
+
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <map>
 #include <string>
-#include <unistd.h>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+#include "boost/program_options.hpp"
+
+#include "clas12/geometry/request.hpp"
+#include "clas12/geometry/request_executor.hpp"
+#include "clas12/geometry/socket_server.hpp"
+#include "clas12/log.hpp"
 
-#include "clas12/geometry/geometry_service.hpp"
+namespace po = boost::program_options;
 
-using namespace clas12::geometry;
+using namespace std;
+using namespace clas12;
 
 int main(int argc, char** argv)
 {
-    string platform_host = "ucla.jlab.org";
-    string platform_name = "GoetzPlatform";
-    //string platform_host = "129.57.28.27";
-    //string platform_name = "CLAS12_PLATFORM";
+    logging::add_console_log(clog);
+    logging::minimum_severity(logging::info);
+
+    string address = "unix:/tmp/clas12geom.sock";
+    size_t nworkers = 0;
+    size_t nconnections = 16;
+    size_t max_pending = 64;
+    size_t max_cached = 16;
+    size_t prefetch_ahead = 0;
+    size_t idle_timeout = 60;
+
+    map<string,string> args;
+    args["sqlite"] = "";
+    args["fixture"] = "";
+    args["mysql-host"] = "clasdb.jlab.org";
+    args["mysql-user"] = "clas12reader";
+    args["mysql-password"] = "";
+    args["mysql-database"] = "clas12";
+    args["mysql-port"] = "3306";
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h",
+            "produce help message")
+        ("verbose",
+            "log every request")
+        ("listen,l",
+            po::value<string>(&address)->default_value(address),
+            "address to listen on: unix:/path/to/socket or tcp:host:port (port 0 picks a free port)")
+        ("workers,w",
+            po::value<size_t>(&nworkers)->default_value(nworkers),
+            "number of threads generating geometry (0: one per core)")
+        ("connections,n",
+            po::value<size_t>(&nconnections)->default_value(nconnections),
+            "number of connections served at once; others wait to be accepted")
+        ("idle-timeout",
+            po::value<size_t>(&idle_timeout)->default_value(idle_timeout),
+            "seconds a connection may go without a request before it is closed (0: never)")
+        ("max-pending",
+            po::value<size_t>(&max_pending)->default_value(max_pending),
+            "number of requests queued before new ones are refused")
+        ("max-cached",
+            po::value<size_t>(&max_cached)->default_value(max_cached),
+            "number of results kept after they are sent")
+        ("prefetch-ahead",
+            po::value<size_t>(&prefetch_ahead)->default_value(prefetch_ahead),
+            "also generate each request for this many following runs, while idle")
 
-    GeometryService theService(platform_host, platform_name);
+        ("fixture",
+            po::value<string>(&args["fixture"]),
+            "fixture file written by clas12-ccdb-fixture, used in place of the database")
+        ("sqlite,f",
+            po::value<string>(&args["sqlite"]),
+            "SQLite file (may be relative path). Mutually exclusive with the MySQL options. If used, all MySQL options will be ignored.")
+        ("mysql-host",
+            po::value<string>(&args["mysql-host"]),
+            "Host name of the MySQL server.")
+        ("mysql-user",
+            po::value<string>(&args["mysql-user"]),
+            "User name to use when connectiong to the MySQL server.")
+        ("mysql-password",
+            po::value<string>(&args["mysql-password"]),
+            "Password to use when connectiong to the MySQL server.")
+        ("mysql-database",
+            po::value<string>(&args["mysql-database"]),
+            "Database name to use when connectiong to the MySQL server.")
+        ("mysql-port",
+            po::value<string>(&args["mysql-port"]),
+            "Port number to use when connectiong to the MySQL server.")
+    ;
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        cout << options << endl << endl;
+        cout << geometry::SocketServer::desc << endl;
+        cout << geometry::Request::desc;
+        exit(0);
+    }
+
+    if (vm.count("verbose"))
+    {
+        logging::minimum_severity(logging::debug);
+    }
 
-    while (true)
+    // a fixture or sqlite take precedence over mysql
+    if (args["fixture"] != "" || args["sqlite"] != "")
     {
-        sleep(5);
+        for (auto i : vector<string>{"host", "user", "password", "database", "port"})
+        {
+            args.erase("mysql-"+i);
+        }
     }
+
+    // remove all blank options
+    vector<string> remove;
+    for (auto i : args)
+    {
+        if (i.second == "")
+        {
+            remove.push_back(i.first);
+        }
+    }
+    for (auto k : remove)
+    {
+        args.erase(k);
+    }
+
+    // the signals are taken by sigwait() below, in every thread
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    geometry::RequestExecutor executor(nworkers, max_pending, max_cached);
+    executor.prefetch_ahead(prefetch_ahead);
+
+    geometry::SocketServer server(executor, address, args, nconnections,
+                                  chrono::seconds(idle_timeout));
+    LOG(info) << "listening on " << server.address() << " with "
+              << executor.nworkers() << " workers and "
+              << server.nconnections() << " connections";
+
+    std::thread waiter([&server, &signals]()
+    {
+        int sig;
+        sigwait(&signals, &sig);
+        LOG(info) << "stopping on signal " << sig;
+        server.stop();
+    });
+
+    server.serve();
+
+    // serve() only returns once stop() was called by the waiter
+    waiter.join();
+
+    LOG(info) << "served " << server.served() << " requests" << endl
+              << executor.report();
 }
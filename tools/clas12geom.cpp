@@ -1,27 +1,369 @@
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "boost/algorithm/string.hpp"
+#include "boost/filesystem.hpp"
+#include "boost/lexical_cast.hpp"
 #include "boost/program_options.hpp"
 
+#include "clas12/ccdb/connection_pool.hpp"
 #include "clas12/geometry/request.hpp"
+#include "clas12/geometry/request_executor.hpp"
 #include "clas12/log.hpp"
 
 namespace po = boost::program_options;
 
+namespace fs = boost::filesystem;
+
 using namespace std;
 using namespace clas12;
 
+/**
+ * \brief one output file of the batch mode
+ **/
+struct BatchItem
+{
+    /// \brief the options of the request, with the run of this item
+    map<string,string> req;
+
+    /// \brief the file written, in the output directory
+    string file;
+
+    /// \brief Request::etag(): items with the same etag have the
+    /// same output and are generated once
+    string etag;
+
+    /// \brief why the file was not written, empty on success
+    string error;
+};
+
+/**
+ * \brief read a list of runs
+ * \param [in] runs comma separated runs and ranges, for example
+ *             "4013-4100,4200"
+ **/
+static vector<int> parse_runs(const string& runs)
+{
+    vector<int> ret;
+    vector<string> items;
+    boost::split(items, runs, boost::is_any_of(","), boost::token_compress_on);
+    for (auto item : items)
+    {
+        boost::trim(item);
+        if (item == "")
+        {
+            continue;
+        }
+        try
+        {
+            size_t dash = item.find('-', 1);
+            int first = boost::lexical_cast<int>(item.substr(0, dash));
+            int last = (dash == string::npos) ? first : boost::lexical_cast<int>(item.substr(dash + 1));
+            if (last < first)
+            {
+                throw invalid_argument("");
+            }
+            for (int run=first; run<=last; run++)
+            {
+                ret.push_back(run);
+            }
+        }
+        catch (...)
+        {
+            throw invalid_argument("bad run or range of runs: " + item);
+        }
+    }
+    return ret;
+}
+
+/**
+ * \brief the name of the file a request is written to
+ *
+ * "run<run>.xml", with the variation and the digits of the timestamp
+ * when they are set, and the codec when the output is compressed.
+ **/
+static string batch_file_name(map<string,string>& req)
+{
+    string name = "run" + req["run"];
+    if (req.count("variation") && req["variation"] != "default")
+    {
+        name += "_" + req["variation"];
+    }
+    if (req.count("timestamp"))
+    {
+        string digits;
+        for (char c : req["timestamp"])
+        {
+            if (isdigit(c))
+            {
+                digits += c;
+            }
+        }
+        name += "_" + digits;
+    }
+    name += ".xml";
+    if (req.count("compression") && compression::codec(req["compression"]) != compression::Codec::none)
+    {
+        name += "." + req["compression"];
+    }
+    return name;
+}
+
+/**
+ * \brief the requests of the batch mode, one per run
+ * \param [in] args the request of the command line
+ * \param [in] runs the --runs option
+ * \param [in] run_list the --run-list option: a file with one constant
+ *             set per line, "run [variation [timestamp]]", where a
+ *             variation of "-" keeps the one of the command line and
+ *             "#" starts a comment
+ **/
+static vector<BatchItem> batch_items(const map<string,string>& args,
+                                     const string& runs,
+                                     const string& run_list)
+{
+    vector<map<string,string>> reqs;
+    for (int run : parse_runs(runs))
+    {
+        reqs.push_back(args);
+        reqs.back()["run"] = boost::lexical_cast<string>(run);
+    }
+
+    if (run_list != "")
+    {
+        ifstream fin(run_list);
+        if (!fin)
+        {
+            throw invalid_argument("could not open run list: " + run_list);
+        }
+        string line;
+        while (getline(fin, line))
+        {
+            line = boost::trim_copy(line.substr(0, line.find('#')));
+            if (line == "")
+            {
+                continue;
+            }
+
+            istringstream ss(line);
+            string run, variation, timestamp;
+            ss >> run >> variation;
+            getline(ss, timestamp);
+            boost::trim(timestamp);
+
+            reqs.push_back(args);
+            map<string,string>& req = reqs.back();
+            req["run"] = boost::lexical_cast<string>(parse_runs(run).at(0));
+            if (variation != "" && variation != "-")
+            {
+                req["variation"] = variation;
+            }
+            if (timestamp != "")
+            {
+                req["timestamp"] = timestamp;
+            }
+        }
+    }
+
+    vector<BatchItem> items;
+    set<string> files;
+    for (auto& req : reqs)
+    {
+        BatchItem item;
+        item.file = batch_file_name(req);
+        item.req = req;
+        if (files.insert(item.file).second)
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+/**
+ * \brief call f(0) ... f(n-1) on nthreads threads
+ **/
+static void parallel_for(size_t n, size_t nthreads, const function<void(size_t)>& f)
+{
+    atomic<size_t> next(0);
+    vector<thread> threads;
+    for (size_t t=0; t<min(n, nthreads); t++)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t i = next++; i < n; i = next++)
+            {
+                f(i);
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+/**
+ * \brief write the geometry of many runs, one file per run
+ *
+ * The etag of every run is computed first, which only reads the
+ * constants tables. Runs with the same etag have the same constants
+ * and the same output, which is generated once and written to each of
+ * their files. Distinct outputs are generated on njobs threads which
+ * share one RequestExecutor, so the detector and volume caches are
+ * shared by all runs.
+ *
+ * Database connections are made per run, so the connection pool is
+ * limited to one per job: the connection of a finished run is closed
+ * when the next run needs one instead of staying open until exit.
+ *
+ * \return the exit status: 0 if all files were written
+ **/
+static int batch(vector<BatchItem>& items, const string& output_dir, size_t njobs, bool print_stats)
+{
+    auto start = chrono::steady_clock::now();
+
+    if (njobs == 0)
+    {
+        njobs = max(thread::hardware_concurrency(), 1u);
+    }
+
+    fs::create_directories(output_dir);
+
+    // each job leases one connection at a time
+    clas12::ccdb::ConnectionPool& pool = clas12::ccdb::ConnectionPool::global();
+    pool.max_total(njobs);
+
+    geometry::RequestExecutor executor(njobs, max(njobs, size_t(64)), 1);
+
+    parallel_for(items.size(), njobs, [&](size_t i)
+    {
+        try
+        {
+            items[i].etag = executor.etag(items[i].req);
+        }
+        catch (exception& e)
+        {
+            items[i].error = e.what();
+        }
+    });
+
+    // items with identical output, in the order of the list
+    map<string,vector<size_t>> by_etag;
+    vector<vector<size_t>*> groups;
+    for (size_t i=0; i<items.size(); i++)
+    {
+        if (items[i].error != "")
+        {
+            continue;
+        }
+        auto g = by_etag.insert(make_pair(items[i].etag, vector<size_t>()));
+        if (g.second)
+        {
+            groups.push_back(&g.first->second);
+        }
+        g.first->second.push_back(i);
+    }
+
+    LOG(info) << items.size() << " runs, " << groups.size() << " distinct geometries";
+
+    parallel_for(groups.size(), njobs, [&](size_t g)
+    {
+        const vector<size_t>& group = *groups[g];
+
+        // binary output has no trailing newline, as in the single run mode
+        string bytes;
+        string error;
+        try
+        {
+            geometry::RequestResult result = executor.execute(items[group[0]].req);
+            if (result.xml.compare(0, 5, "Error") == 0)
+            {
+                error = result.xml;
+            }
+            else
+            {
+                auto c = items[group[0]].req.find("compression");
+                compression::Codec codec = (c == items[group[0]].req.end())
+                    ? compression::Codec::none : compression::codec(c->second);
+                bytes = (codec != compression::Codec::none && result.compressed)
+                    ? result.compressed->get(result.xml, codec)
+                    : result.xml + "\n";
+            }
+        }
+        catch (exception& e)
+        {
+            error = e.what();
+        }
+
+        for (size_t i : group)
+        {
+            if (error != "")
+            {
+                items[i].error = error;
+                continue;
+            }
+            string path = (fs::path(output_dir) / items[i].file).string();
+            ofstream fout(path, ios::binary);
+            fout.write(bytes.data(), bytes.size());
+            if (!fout)
+            {
+                items[i].error = "could not write " + path;
+            }
+        }
+    });
+
+    size_t nfailed = 0;
+    for (const auto& item : items)
+    {
+        if (item.error != "")
+        {
+            nfailed++;
+            LOG(error) << item.file << ": " << item.error;
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    LOG(info) << "wrote " << items.size() - nfailed << " files to " << output_dir
+              << " in " << seconds << " s";
+    if (print_stats)
+    {
+        clas12::ccdb::PoolStats ps = pool.statistics();
+        LOG(info) << endl << executor.report();
+        LOG(info) << "database connections: " << ps.created << " made, "
+                  << ps.reused << " reused, " << ps.evicted << " closed for another run";
+    }
+    return nfailed ? 1 : 0;
+}
+
 int main(int argc, char** argv)
 {
     logging::add_console_log(clog);
     logging::minimum_severity(logging::info);
 
+    string runs;
+    string run_list;
+    string output_dir = ".";
+    size_t njobs = 0;
+
     map<string,string> args;
 
     args["request"] = "";
 
+    args["encoding"] = "";
+    args["compression"] = "";
+
     args["units"] = "cm";
     args["coordsys"] = "sector";
 
@@ -30,6 +372,7 @@ int main(int argc, char** argv)
     args["timestamp"] = "";
 
     args["sqlite"] = "";
+    args["fixture"] = "";
     args["mysql-host"] = "clasdb.jlab.org";
     args["mysql-user"] = "clas12reader";
     args["mysql-password"] = "";
@@ -40,6 +383,14 @@ int main(int argc, char** argv)
     options.add_options()
         ("help,h",
             "produce help message")
+        ("stats",
+            "print the time spent in each stage (database, geometry, output) and the number of tables, rows, wires, volumes and bytes handled")
+        ("encoding,e",
+            po::value<string>(&args["encoding"]),
+            "explicit or parametric: send wire and strip positions as lines in the element index plus residuals")
+        ("compression,z",
+            po::value<string>(&args["compression"]),
+            "compress the XML written to stdout with this codec (zlib, zstd or lz4)")
         ("units,u",
             po::value<string>(&args["units"])->default_value(args["units"]),
             "units of length for all returned values")
@@ -60,6 +411,22 @@ int main(int argc, char** argv)
             po::value<string>(&args["timestamp"]),
             "timestamp in the form YY-MM-DD hh:mm:ss")
 
+        ("runs",
+            po::value<string>(&runs),
+            "batch mode: runs to write, one file per run, for example 4013-4100,4200")
+        ("run-list",
+            po::value<string>(&run_list),
+            "batch mode: file with one constant set per line, \"run [variation [timestamp]]\", written one file per line")
+        ("output-dir,o",
+            po::value<string>(&output_dir)->default_value(output_dir),
+            "batch mode: directory the files are written to, named run<run>[_<variation>][_<timestamp>].xml")
+        ("jobs,j",
+            po::value<size_t>(&njobs)->default_value(njobs),
+            "batch mode: number of geometries generated at once (0: one per core)")
+
+        ("fixture",
+            po::value<string>(&args["fixture"]),
+            "fixture file written by clas12-ccdb-fixture, used in place of the database")
         ("sqlite,f",
             po::value<string>(&args["sqlite"]),
             "SQLite file (may be relative path). Mutually exclusive with the MySQL options. If used, all MySQL options will be ignored.")
@@ -91,8 +458,8 @@ int main(int argc, char** argv)
         exit(0);
     }
 
-    // sqlite take precedence over mysql
-    if (args["sqlite"] != "")
+    // a fixture or sqlite take precedence over mysql
+    if (args["fixture"] != "" || args["sqlite"] != "")
     {
         for (auto i : vector<string>{"host", "user", "password", "database", "port"})
         {
@@ -102,6 +469,7 @@ int main(int argc, char** argv)
     else
     {
         args.erase("sqlite");
+        args.erase("fixture");
     }
 
     // remove all blank options
@@ -118,17 +486,49 @@ int main(int argc, char** argv)
         args.erase(k);
     }
 
+    if (runs != "" || run_list != "")
+    {
+        vector<BatchItem> items;
+        try
+        {
+            items = batch_items(args, runs, run_list);
+        }
+        catch (exception& e)
+        {
+            cout << e.what() << endl;
+            exit(1);
+        }
+        return batch(items, output_dir, njobs, vm.count("stats"));
+    }
+
     geometry::Request req(args);
     string xmlbuffer = req.generate_xml();
 
     LOG(info) << endl << req.info();
-    cout << xmlbuffer << endl;
+    if (vm.count("stats"))
+    {
+        LOG(info) << endl << req.statistics().report();
+    }
 
     static const string err_str = "Error";
     if (equal(err_str.begin(), err_str.end(), xmlbuffer.begin()))
     {
+        cout << xmlbuffer << endl;
         cout << options << endl << endl;
         cout << geometry::Request::desc;
         exit(1);
     }
+
+    if (req.codec() != compression::Codec::none)
+    {
+        // binary output: no trailing newline
+        string bytes = compression::compress(xmlbuffer, req.codec());
+        LOG(info) << "compressed with " << compression::name(req.codec()) << ": "
+                  << xmlbuffer.size() << " to " << bytes.size() << " bytes";
+        cout.write(bytes.data(), bytes.size());
+    }
+    else
+    {
+        cout << xmlbuffer << endl;
+    }
 }
@@ -0,0 +1,168 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "boost/algorithm/string.hpp"
+#include "boost/program_options.hpp"
+
+#include "clas12/magfield/derived_field_map.hpp"
+#include "clas12/magfield/field_map.hpp"
+#include "clas12/magfield/field_map_store.hpp"
+#include "clas12/magfield/request.hpp"
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace clas12::magfield;
+
+/**
+ * \brief options from a variant string like
+ * "precision=float16;stride=2;region=rho:0:300,z:100:500"
+ **/
+DerivedMapOptions parse_variant(const string& variant)
+{
+    DerivedMapOptions opts;
+
+    vector<string> items;
+    boost::split(items, variant, boost::is_any_of("; "), boost::token_compress_on);
+    for (const auto& item : items)
+    {
+        if (item.empty())
+        {
+            continue;
+        }
+        size_t eq = item.find('=');
+        if (eq == string::npos)
+        {
+            throw runtime_error("variant options must be key=value: " + item);
+        }
+        string key = item.substr(0, eq);
+        string value = item.substr(eq + 1);
+        if (key == "precision")
+        {
+            opts.set_precision(value);
+        }
+        else if (key == "stride")
+        {
+            opts.set_stride(value);
+        }
+        else if (key == "region")
+        {
+            opts.set_region(value);
+        }
+        else
+        {
+            throw runtime_error("unknown variant option: " + key);
+        }
+    }
+    return opts;
+}
+
+int main(int argc, char** argv)
+{
+    string request = "";
+    string filename = "";
+    vector<string> variants;
+    size_t npoints = 1000000;
+    unsigned seed = 1;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h",
+            "produce help message.")
+        ("request,r",
+            po::value<string>(&request),
+            "field map to compare variants of: torus or solenoid")
+        ("file,f",
+            po::value<string>(&filename),
+            "field map file to compare variants of (instead of a request)")
+        ("variant,v",
+            po::value<vector<string>>(&variants),
+            "variant to compare, may be repeated. Example: "
+            "\"precision=float16;stride=2;region=rho:0:300\". "
+            "Default: float32 and float16 at strides 1, 2 and 4.")
+        ("points,n",
+            po::value<size_t>(&npoints)->default_value(npoints),
+            "number of random points to compare at.")
+        ("seed",
+            po::value<unsigned>(&seed)->default_value(seed),
+            "seed for the random points.")
+    ;
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help") || (request == "" && filename == ""))
+    {
+        clog << "Reports the interpolation error of reduced field maps" << endl
+             << "against the full-resolution map." << endl
+             << endl
+             << options << endl;
+        exit(0);
+    }
+
+    if (variants.empty())
+    {
+        for (const char* precision : {"float32", "float16"})
+        {
+            for (const char* stride : {"1", "2", "4"})
+            {
+                variants.push_back(string("precision=") + precision + ";stride=" + stride);
+            }
+        }
+    }
+
+    FieldMapView full;
+    if (filename != "")
+    {
+        full = FieldMapStore::instance().get(filename);
+    }
+    else
+    {
+        full = Request(request).view();
+    }
+    FieldMap reference(full);
+
+    cout << "reference: " << full.filename() << endl
+         << "  size: " << full.size() << " bytes" << endl
+         << "  grid: " << reference.nphi() << " x " << reference.nrho()
+         << " x " << reference.nz() << endl
+         << "  points compared: " << npoints << endl
+         << endl;
+
+    cout << left << setw(50) << "variant"
+         << right << setw(14) << "bytes"
+         << setw(8) << "ratio"
+         << setw(14) << "max |dB| kG"
+         << setw(12) << "max rel"
+         << setw(14) << "rms |dB| kG"
+         << endl;
+
+    for (const auto& variant : variants)
+    {
+        try
+        {
+            DerivedMapOptions opts = parse_variant(variant);
+            vector<byte> buf = derive_field_map(full.data(), full.size(), opts);
+            FieldMap approx(buf.data(), buf.size());
+            FieldMapError err = field_map_error(reference, approx, npoints, seed);
+
+            double rel = (err.max_field > 0) ? err.max_abs / err.max_field : 0;
+            cout << left << setw(50) << opts.key()
+                 << right << setw(14) << buf.size()
+                 << setw(8) << fixed << setprecision(3) << double(buf.size()) / full.size()
+                 << setw(14) << scientific << setprecision(3) << err.max_abs
+                 << setw(12) << rel
+                 << setw(14) << err.rms
+                 << defaultfloat << endl;
+        }
+        catch (exception& e)
+        {
+            cout << left << setw(50) << variant << "  error: " << e.what() << endl;
+        }
+    }
+}
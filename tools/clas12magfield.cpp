@@ -12,11 +12,10 @@ namespace po = boost::program_options;
 
 using namespace std;
 
-typedef uint8_t byte;
-
 int main(int argc, char** argv)
 {
-    string request = "";
+    map<string,string> args;
+    args["request"] = "";
     string outfile = "out.dat";
 
     po::options_description options("Options");
@@ -24,8 +23,17 @@ int main(int argc, char** argv)
         ("help,h",
             "produce help message.")
         ("request,r",
-            po::value<string>(&request),
+            po::value<string>(&args["request"]),
             "field map request string. Example: torus,solenoid")
+        ("precision,p",
+            po::value<string>(),
+            "precision of the field values: float32 or float16.")
+        ("stride,s",
+            po::value<string>(),
+            "keep every n'th grid point in phi, rho and z.")
+        ("region",
+            po::value<string>(),
+            "part of the grid to keep. Example: rho:0:300,z:100:500")
         ("output,o",
             po::value<string>(&outfile)->default_value(outfile),
             "output file to put the field map.")
@@ -35,19 +43,27 @@ int main(int argc, char** argv)
     po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
     po::notify(vm);
 
-    if (vm.count("help") || request == "")
+    for (const auto& opt : {"precision", "stride", "region"})
+    {
+        if (vm.count(opt))
+        {
+            args[opt] = vm[opt].as<string>();
+        }
+    }
+
+    if (vm.count("help") || args["request"] == "")
     {
         clog << options << endl << endl;;
         clog << clas12::magfield::Request::desc;
         exit(0);
     }
 
-    clas12::magfield::Request req(request);
+    clas12::magfield::Request req(args);
     clog << req.info() << endl;
 
-    vector<byte> buff = req.generate_buffer();
+    clas12::magfield::FieldMapView view = req.view();
 
     ofstream fout(outfile, ios::binary);
-    fout.write(reinterpret_cast<char*>(&buff.front()), buff.size());
+    fout.write(reinterpret_cast<const char*>(view.data()), view.size());
     fout.close();
 }
@@ -1,25 +1,62 @@
+#include <cstdlib>
 #include <map>
 #include <string>
 
 #include "clas12/geometry/output/dc_volumes.hpp"
 #include "clas12/geometry/request.hpp"
+#include "clas12/geometry/volmap_cache.hpp"
+#include "clas12/log.hpp"
 
 using std::map;
 using std::string;
 using clas12::geometry::output::volmap_t;
 using clas12::geometry::Request;
+using clas12::geometry::VolmapCache;
+
+namespace
+{
+    /**
+     * \brief whether the on-disk cache is in use
+     *
+     * Set $CLAS12_GEOMETRY_CACHE_DIR to "none" (or an empty string)
+     * to disable it.
+     **/
+    bool cache_enabled()
+    {
+        const char* dir = std::getenv("CLAS12_GEOMETRY_CACHE_DIR");
+        return !(dir && (string(dir) == "" || string(dir) == "none"));
+    }
+}
 
 extern "C"
 {
 
 volmap_t get_volume_maps(const map<string,string>& request)
 {
-    static const string ccdb_host = "clasdb.jlab.org";
-    static const string ccdb_user = "clas12reader";
-    static const string ccdb_db = "clas12";
-
     Request req(request);
-    return req.generate_volmap();
+
+    if (!cache_enabled())
+    {
+        return req.generate_volmap();
+    }
+
+    // the etag hashes the contents of the constants tables, so the
+    // entry stays valid for as long as the constants do and runs with
+    // the same constants share it. Only the tables are read, which
+    // generate_volmap() then reuses.
+    VolmapCache cache;
+    string key = "volmap\netag=" + req.etag();
+
+    volmap_t vmap;
+    if (cache.load(key, vmap))
+    {
+        LOG(info) << "volumes loaded from cache: " << cache.path(key);
+        return vmap;
+    }
+
+    vmap = req.generate_volmap();
+    cache.store(key, vmap);
+    return vmap;
 }
 
 } // extern "C"